@@ -0,0 +1,557 @@
+#include "../common/common.h"
+#include "../common/GLExt.h"
+#include "../common/Graphic.h"
+#include "../common/GLState.h"
+#include "../common/Shader.h"
+#include "../common/BufferArena.h"
+#include "../common/ShaderCompiler.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+/*
+	Checks of the GL side of common that need a context but no window.
+
+	The context comes from EGL without a surface (Mesa's surfaceless
+	platform, so it runs on llvmpipe in CI), every check reads back what it
+	wrote through the GL and prints ok or FAILED. The exit code is the
+	number of failed checks. `./build headless` builds and runs it.
+*/
+
+static int failures = 0;
+
+static void Check(const char *name, bool passed)
+{
+	printf("%-52s %s\n", name, passed ? "ok" : "FAILED");
+
+	if (!passed)
+		failures++;
+}
+
+static bool CreateHeadlessContext(void)
+{
+	PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+	EGLDisplay display = eglGetPlatformDisplay
+		? eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL)
+		: eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+	{
+		fprintf(stderr, "[ERROR]: Failed to init EGL.\n");
+		return false;
+	}
+
+	eglBindAPI(EGL_OPENGL_API);
+
+	const EGLint attributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	// no config and no surface, everything draws into framebuffer objects
+	EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+
+	if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		fprintf(stderr, "[ERROR]: Failed to create a surfaceless GL 3.3 context.\n");
+		return false;
+	}
+
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+	{
+		fprintf(stderr, "Failed to init glad.\n");
+		return false;
+	}
+
+	GLExtLoad((GLADloadproc)eglGetProcAddress);
+
+	return true;
+}
+
+#define TARGET_SIZE 16
+
+typedef struct CheckTarget {
+	unsigned int framebuffer;
+	unsigned int renderbuffer;
+} CheckTarget;
+
+// a cleared TARGET_SIZE square framebuffer to draw into and read back
+static CheckTarget CreateCheckTarget(void)
+{
+	CheckTarget target;
+
+	glGenFramebuffers(1, &target.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+	glGenRenderbuffers(1, &target.renderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, target.renderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, TARGET_SIZE, TARGET_SIZE);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.renderbuffer);
+
+	glViewport(0, 0, TARGET_SIZE, TARGET_SIZE);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	return target;
+}
+
+static void DeleteCheckTarget(CheckTarget *target)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteRenderbuffers(1, &target->renderbuffer);
+	glDeleteFramebuffers(1, &target->framebuffer);
+}
+
+/*
+	/////////////////////////////////////
+	///
+	///	StreamBuffer
+	///
+	/////////////////////////////////////
+*/
+
+#define STREAM_FRAME 4096
+#define STREAM_FLOATS 100
+
+// every frame writes five blocks, reads them back and wraps the ring several times
+static void CheckStreamBuffer(bool persistent)
+{
+	bool storage = GLEXT_ARB_buffer_storage;
+	GLEXT_ARB_buffer_storage = storage && persistent;
+
+	StreamBuffer sb = CreateStreamBuffer(STREAM_FRAME);
+	bool mapped = true, aligned = true, overflow = true, same = true;
+
+	for (int frame = 0; frame < STREAM_BUFFER_REGIONS * 6; ++frame)
+	{
+		size_t offsets[5];
+
+		for (int k = 0; k < 5; ++k)
+		{
+			float *data = StreamBufferMap(&sb, STREAM_FLOATS * sizeof(float), 12, &offsets[k]);
+			if (data == NULL)
+			{
+				mapped = false;
+				continue;
+			}
+
+			for (int i = 0; i < STREAM_FLOATS; ++i)
+				data[i] = (float)(frame * 1000 + k * 100 + i);
+			StreamBufferUnmap(&sb);
+
+			aligned &= offsets[k] % 12 == 0;
+		}
+
+		// the region has 2000 bytes written, more than what is left must fail (and say so)
+		size_t offset;
+		if (frame == 0)
+			overflow &= StreamBufferMap(&sb, STREAM_FRAME, 1, &offset) == NULL;
+
+		GLStateBindBuffer(GL_ARRAY_BUFFER, sb.buffer.ID);
+		for (int k = 0; k < 5 && mapped; ++k)
+		{
+			float data[STREAM_FLOATS];
+			glGetBufferSubData(GL_ARRAY_BUFFER, offsets[k], sizeof(data), data);
+
+			for (int i = 0; i < STREAM_FLOATS; ++i)
+				same &= data[i] == (float)(frame * 1000 + k * 100 + i);
+		}
+
+		StreamBufferEndFrame(&sb);
+	}
+
+	Check(persistent ? "stream buffer persistent: readback" : "stream buffer orphaning: readback", mapped && same);
+	Check(persistent ? "stream buffer persistent: alignment" : "stream buffer orphaning: alignment", aligned);
+	Check(persistent ? "stream buffer persistent: overflow fails" : "stream buffer orphaning: overflow fails", overflow);
+	Check(persistent ? "stream buffer persistent: mode" : "stream buffer orphaning: mode", sb.persistent == (storage && persistent));
+
+	DeleteStreamBuffer(&sb);
+
+	GLEXT_ARB_buffer_storage = storage;
+}
+
+/*
+	/////////////////////////////////////
+	///
+	///	BufferArena
+	///
+	/////////////////////////////////////
+*/
+
+#define ARENA_MESHES 400
+#define ARENA_ROUNDS 2000
+
+typedef struct ArenaCheckMesh {
+	float *vertices;         // 3 floats per vertex
+	unsigned int *indices;
+	unsigned int vertexCount;
+	unsigned int indexCount;
+	int id;                  // -1 while not in the arena
+} ArenaCheckMesh;
+
+// every mesh in the arena reads back as it was added, wherever it moved
+static bool ArenaMatches(BufferArena *arena, const ArenaCheckMesh *meshes)
+{
+	bool same = true;
+
+	for (int k = 0; k < ARENA_MESHES; ++k)
+	{
+		const ArenaCheckMesh *check = &meshes[k];
+		if (check->id < 0)
+			continue;
+
+		ArenaMesh mesh = arena->meshes[check->id];
+		if (mesh.vertexCount != check->vertexCount || mesh.indexCount != check->indexCount)
+		{
+			same = false;
+			continue;
+		}
+
+		float *vertices = malloc(check->vertexCount * 3 * sizeof(float));
+		unsigned int *indices = malloc(check->indexCount * sizeof(unsigned int));
+
+		if (vertices == NULL || indices == NULL)
+		{
+			fprintf(stderr, "[ERROR]: Failed to allocate the arena readback.\n");
+			free(vertices);
+			free(indices);
+			return false;
+		}
+
+		GLStateBindBuffer(GL_COPY_READ_BUFFER, arena->vertices.ID);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, mesh.baseVertex * arena->stride, check->vertexCount * 3 * sizeof(float), vertices);
+		GLStateBindBuffer(GL_COPY_READ_BUFFER, arena->indices.ID);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, mesh.firstIndex * sizeof(unsigned int), check->indexCount * sizeof(unsigned int), indices);
+
+		same &= memcmp(vertices, check->vertices, check->vertexCount * 3 * sizeof(float)) == 0;
+		same &= memcmp(indices, check->indices, check->indexCount * sizeof(unsigned int)) == 0;
+
+		free(vertices);
+		free(indices);
+	}
+
+	return same;
+}
+
+// draws a quad in the lower left quarter of the target, 64 pixels
+static int ArenaDrawQuad(BufferArena *arena)
+{
+	const char *vertexShaderSource = "#version 330 core\nlayout(location = 0) in vec3 position;\nvoid main() { gl_Position = vec4(position, 1.0); }\n";
+	const char *fragmentShaderSource = "#version 330 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n";
+
+	Shader shader = CreateShaderFromSource(vertexShaderSource, fragmentShaderSource);
+	if (shader.shaderID == 0)
+		return -1;
+
+	CheckTarget target = CreateCheckTarget();
+
+	float quad[] = { -1.0f, -1.0f, 0.0f,  0.0f, -1.0f, 0.0f,  0.0f, 0.0f, 0.0f,  -1.0f, 0.0f, 0.0f };
+	unsigned int quadIndices[] = { 0, 1, 2, 0, 2, 3 };
+	int mesh = BufferArenaAddMesh(arena, quad, 4, quadIndices, 6);
+
+	ShaderBind(&shader);
+	BufferArenaBind(arena);
+	BufferArenaDraw(arena, mesh);
+
+	unsigned char pixels[TARGET_SIZE * TARGET_SIZE * 4];
+	glReadPixels(0, 0, TARGET_SIZE, TARGET_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+	int lit = 0;
+	for (int i = 0; i < TARGET_SIZE * TARGET_SIZE; ++i)
+		lit += pixels[i * 4] > 0;
+
+	BufferArenaRemoveMesh(arena, mesh);
+	DeleteCheckTarget(&target);
+	DeleteShader(&shader);
+
+	return lit;
+}
+
+// random adds and removes fragment the arena, then it is defragmented
+static void CheckBufferArena(void)
+{
+	ShaderElementKind kinds[] = { f3 };
+	ShaderElement elements = InitShaderElement(kinds, 1, GL_FLOAT, false);
+
+	// small enough that the churn has to defragment and grow on its own
+	BufferArena arena = CreateBufferArena(&elements, 2000, 6000);
+	ArenaCheckMesh *meshes = calloc(ARENA_MESHES, sizeof(ArenaCheckMesh));
+
+	if (meshes == NULL)
+	{
+		Check("buffer arena: allocate the meshes", false);
+		DeleteBufferArena(&arena);
+		return;
+	}
+
+	srand(12);
+
+	for (int k = 0; k < ARENA_MESHES; ++k)
+	{
+		ArenaCheckMesh *check = &meshes[k];
+		check->vertexCount = 3 + rand() % 60;
+		check->indexCount = 3 * (1 + rand() % 40);
+		check->vertices = malloc(check->vertexCount * 3 * sizeof(float));
+		check->indices = malloc(check->indexCount * sizeof(unsigned int));
+		check->id = -1;
+
+		if (check->vertices == NULL || check->indices == NULL)
+		{
+			Check("buffer arena: allocate the meshes", false);
+			goto cleanup;
+		}
+
+		for (unsigned int i = 0; i < check->vertexCount * 3; ++i)
+			check->vertices[i] = (float)(k * 1000 + i);
+		for (unsigned int i = 0; i < check->indexCount; ++i)
+			check->indices[i] = (unsigned int)rand() % check->vertexCount;
+	}
+
+	bool added = true, churned = true;
+
+	for (int round = 0; round < ARENA_ROUNDS; ++round)
+	{
+		ArenaCheckMesh *check = &meshes[rand() % ARENA_MESHES];
+
+		if (check->id >= 0)
+		{
+			BufferArenaRemoveMesh(&arena, check->id);
+			check->id = -1;
+		}
+		else
+		{
+			check->id = BufferArenaAddMesh(&arena, check->vertices, check->vertexCount, check->indices, check->indexCount);
+			added &= check->id >= 0;
+		}
+
+		if (round % 500 == 0)
+			churned &= ArenaMatches(&arena, meshes);
+	}
+
+	churned &= ArenaMatches(&arena, meshes);
+
+	BufferArenaDefragment(&arena);
+
+	Check("buffer arena: adds succeed", added);
+	Check("buffer arena: readback during churn", churned);
+	Check("buffer arena: readback after defragment", ArenaMatches(&arena, meshes));
+	Check("buffer arena: defragment leaves one free range", arena.vertexSpace.count <= 1 && arena.indexSpace.count <= 1);
+	Check("buffer arena: base vertex draw", ArenaDrawQuad(&arena) == 64);
+
+cleanup:
+	for (int k = 0; k < ARENA_MESHES; ++k)
+	{
+		free(meshes[k].vertices);
+		free(meshes[k].indices);
+	}
+	free(meshes);
+	DeleteBufferArena(&arena);
+}
+
+/*
+	/////////////////////////////////////
+	///
+	///	Instancing
+	///
+	/////////////////////////////////////
+*/
+
+// two instances of a quad at [0, 0.5] with their own scale and offset, red
+// comes from a per vertex attribute and green is the instance
+static void CheckInstancing(void)
+{
+	const char *vertexShaderSource =
+		"#version 330 core\n"
+		"layout(location = 0) in vec2 position;\nlayout(location = 1) in float shade;\nlayout(location = 2) in mat4 model;\n"
+		"out vec4 tint;\n"
+		"void main() { tint = vec4(shade, float(gl_InstanceID), 0.0, 1.0); gl_Position = model * vec4(position, 0.0, 1.0); }\n";
+	const char *fragmentShaderSource = "#version 330 core\nin vec4 tint;\nout vec4 color;\nvoid main() { color = tint; }\n";
+
+	Shader shader = CreateShaderFromSource(vertexShaderSource, fragmentShaderSource);
+
+	float vertices[] = {
+		0.0f, 0.0f, 1.0f,  0.5f, 0.0f, 1.0f,  0.5f, 0.5f, 1.0f,
+		0.0f, 0.0f, 1.0f,  0.5f, 0.5f, 1.0f,  0.0f, 0.5f, 1.0f
+	};
+
+	ShaderElementKind vertexKinds[] = { f2, f1 };
+	ShaderElement vertexLayout = InitShaderElement(vertexKinds, 2, GL_FLOAT, false);
+
+	ShaderElementKind instanceKinds[] = { m4 };
+	ShaderElement instanceLayout = InitShaderElement(instanceKinds, 1, GL_FLOAT, false);
+	ShaderElementSetLocation(&instanceLayout, 2);
+	ShaderElementSetDivisor(&instanceLayout, 1);
+
+	VertexArray va = CreateVertexArray();
+
+	VertexBuffer vb = CreateVertexBuffer(vertices, sizeof(vertices), STATIC);
+	VertexBufferSetLayout(&vb, &vertexLayout);
+	VertexArrayPointers(&va, &vb);
+
+	VertexBuffer instances = CreateVertexBuffer(NULL, 0, DYNAMIC);
+	VertexBufferSetLayout(&instances, &instanceLayout);
+	VertexArrayPointers(&va, &instances);
+
+	// the first is twice as tall in the lower left corner, the second twice as wide in the upper right
+	Mat4x4 world[2];
+	world[0] = Mat4x4Translation((Vec3) { -1.0f, -1.0f, 0.0f });
+	world[0].m5 = 2.0f;
+	world[1] = Mat4x4Translation((Vec3) { 0.0f, 0.5f, 0.0f });
+	world[1].m0 = 2.0f;
+
+	CheckTarget target = CreateCheckTarget();
+
+	ShaderBind(&shader);
+	VertexArrayDrawInstanced(&va, &instances, world, 2, 6);
+
+	unsigned char pixels[TARGET_SIZE * TARGET_SIZE * 4];
+	glReadPixels(0, 0, TARGET_SIZE, TARGET_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+	bool placed = shader.shaderID != 0;
+
+	for (int y = 0; y < TARGET_SIZE; ++y)
+	{
+		for (int x = 0; x < TARGET_SIZE; ++x)
+		{
+			const unsigned char *pixel = &pixels[(y * TARGET_SIZE + x) * 4];
+
+			bool first = x < 4 && y < 8;
+			bool second = x >= 8 && y >= 12;
+
+			placed &= (pixel[0] > 0) == (first || second);
+			placed &= (pixel[1] > 0) == second;
+		}
+	}
+
+	Check("instancing: per vertex and per instance attributes", placed);
+
+	DeleteCheckTarget(&target);
+	GLStateForgetBuffer(vb.ID);
+	GLStateForgetBuffer(instances.ID);
+	GLStateForgetVertexArray(va.ID);
+	glDeleteBuffers(1, &vb.ID);
+	glDeleteBuffers(1, &instances.ID);
+	glDeleteVertexArrays(1, &va.ID);
+	if (shader.shaderID)
+		DeleteShader(&shader);
+}
+
+/*
+	/////////////////////////////////////
+	///
+	///	ShaderCompiler
+	///
+	/////////////////////////////////////
+*/
+
+#define COMPILER_PROGRAMS 24
+
+typedef struct CompilerCheck {
+	int calls[COMPILER_PROGRAMS + 1];
+	int failed;
+} CompilerCheck;
+
+static void CompilerReady(void *userData, int handle, Shader *shader)
+{
+	CompilerCheck *check = userData;
+
+	if (handle >= 0 && handle <= COMPILER_PROGRAMS)
+		check->calls[handle]++;
+
+	if (shader == NULL)
+		check->failed++;
+}
+
+// a batch of programs and a broken one, polled the way a loading screen would
+static void CheckShaderCompiler(bool parallel)
+{
+	static char vertexShaderSources[COMPILER_PROGRAMS][512];
+	static char fragmentShaderSources[COMPILER_PROGRAMS][512];
+
+	// distinct sources so the driver cannot share compiles between them
+	for (int i = 0; i < COMPILER_PROGRAMS; ++i)
+	{
+		snprintf(vertexShaderSources[i], sizeof(vertexShaderSources[i]),
+			"#version 330 core\nlayout(location = 0) in vec3 position;\nuniform mat4 model;\nout vec3 shade;\n"
+			"void main() { shade = sin(position * %d.0); gl_Position = model * vec4(position, 1.0); }\n", i + 1);
+		snprintf(fragmentShaderSources[i], sizeof(fragmentShaderSources[i]),
+			"#version 330 core\nin vec3 shade;\nuniform vec3 color;\nout vec4 fragment;\n"
+			"void main() { fragment = vec4(color * shade + %d.0, 1.0); }\n", i);
+	}
+
+	ShaderCompiler compiler = CreateShaderCompiler();
+	compiler.parallel &= parallel;
+
+	CompilerCheck check = { 0 };
+	bool submitted = true;
+
+	for (int i = 0; i < COMPILER_PROGRAMS; ++i)
+		submitted &= ShaderCompilerSubmit(&compiler, vertexShaderSources[i], fragmentShaderSources[i], CompilerReady, &check) == i;
+
+	int broken = ShaderCompilerSubmit(&compiler, "#version 330 core\nvoid main() { broken }\n", fragmentShaderSources[0], CompilerReady, &check);
+
+	// without the extension a poll finishes a few programs and leaves the rest
+	int pending = ShaderCompilerPoll(&compiler);
+	bool bounded = compiler.parallel || pending == COMPILER_PROGRAMS + 1 - compiler.blockingPoll;
+
+	Shader placeholder = { 0 };
+	bool waiting = ShaderCompilerStatus(&compiler, COMPILER_PROGRAMS - 1) != SHADER_PENDING
+		|| ShaderCompilerGet(&compiler, COMPILER_PROGRAMS - 1, &placeholder) == &placeholder;
+
+	int polls = 1;
+	while (ShaderCompilerPoll(&compiler) > 0 && polls < 100000)
+		polls++;
+
+	bool once = true, ready = true;
+	for (int i = 0; i <= COMPILER_PROGRAMS; ++i)
+		once &= check.calls[i] == 1;
+
+	for (int i = 0; i < COMPILER_PROGRAMS; ++i)
+	{
+		Shader *shader = ShaderCompilerGet(&compiler, i, &placeholder);
+		ready &= ShaderCompilerStatus(&compiler, i) == SHADER_READY && shader != &placeholder
+			&& ShaderFindUniform(shader, "model") >= 0 && ShaderFindUniform(shader, "color") >= 0;
+	}
+
+	bool failed = broken == COMPILER_PROGRAMS && check.failed == 1
+		&& ShaderCompilerStatus(&compiler, broken) == SHADER_FAILED
+		&& ShaderCompilerGet(&compiler, broken, &placeholder) == &placeholder;
+
+	Check(parallel ? "shader compiler parallel: submit" : "shader compiler blocking: submit", submitted);
+	Check(parallel ? "shader compiler parallel: poll is bounded" : "shader compiler blocking: poll is bounded", bounded);
+	Check(parallel ? "shader compiler parallel: placeholder while pending" : "shader compiler blocking: placeholder while pending", waiting);
+	Check(parallel ? "shader compiler parallel: one callback each" : "shader compiler blocking: one callback each", once);
+	Check(parallel ? "shader compiler parallel: programs ready" : "shader compiler blocking: programs ready", ready);
+	Check(parallel ? "shader compiler parallel: broken program fails" : "shader compiler blocking: broken program fails", failed);
+
+	DeleteShaderCompiler(&compiler);
+}
+
+int main(void)
+{
+	if (!CreateHeadlessContext())
+		return 1;
+
+	printf("%s, GL %s\n\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+	CheckStreamBuffer(true);
+	CheckStreamBuffer(false);
+	CheckBufferArena();
+	CheckInstancing();
+	CheckShaderCompiler(true);
+	CheckShaderCompiler(false);
+
+	Check("no GL errors", glGetError() == GL_NO_ERROR);
+
+	if (failures)
+		fprintf(stderr, "[ERROR]: %d headless checks failed.\n", failures);
+
+	return failures;
+}
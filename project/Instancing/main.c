@@ -0,0 +1,166 @@
+#include "../common/common.h"
+#include "../common/Graphic.h"
+#include "../common/GLState.h"
+#include "../common/IO.h"
+#include "../common/Shader.h"
+#include "../common/ShaderCache.h"
+#include "../common/ShaderPermutation.h"
+#include "../common/UniformBuffer.h"
+#include "../common/Window.h"
+
+#define GRID 100
+
+// bit i turns on the define meshFeatures[i] in mesh.vs and mesh.fs
+enum { MESH_TEXTURED = 1 << 0, MESH_INSTANCED = 1 << 1, MESH_TINTED = 1 << 2 };
+static const char *meshFeatures[] = { "TEXTURED", "INSTANCED", "TINTED" };
+
+int main()
+{
+	GLFWwindow *window = InitWindow(800, 600, "Instancing");
+	ShaderCacheInit("bin/shader_cache");
+	GLStateEnable(GL_DEPTH_TEST);
+
+	int width, height, nrChannels;
+	unsigned char *data = stbi_load("assets/image/metalbox_diffuse.png", &width, &height, &nrChannels, 0);
+	if (data == NULL) printf("Failed to load image.\n");
+
+	unsigned int texture;
+	glGenTextures(1, &texture);
+
+	GLStateBindTexture(0, GL_TEXTURE_2D, texture);
+
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	stbi_image_free(data);
+
+	float vertices[] = {
+		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+		0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
+		0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
+		0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
+		-0.5f, 0.5f, -0.5f, 0.0f, 1.0f,
+		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+		-0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
+		0.5f, -0.5f, 0.5f, 1.0f, 0.0f,
+		0.5f, 0.5f, 0.5f, 1.0f, 1.0f,
+		0.5f, 0.5f, 0.5f, 1.0f, 1.0f,
+		-0.5f, 0.5f, 0.5f, 0.0f, 1.0f,
+		-0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
+		-0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
+		-0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
+		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+		-0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
+		-0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
+		0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
+		0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
+		0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+		0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+		0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
+		0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
+		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+		0.5f, -0.5f, -0.5f, 1.0f, 1.0f,
+		0.5f, -0.5f, 0.5f, 1.0f, 0.0f,
+		0.5f, -0.5f, 0.5f, 1.0f, 0.0f,
+		-0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
+		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+		-0.5f, 0.5f, -0.5f, 0.0f, 1.0f,
+		0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
+		0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
+		0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
+		-0.5f, 0.5f, 0.5f, 0.0f, 0.0f,
+		-0.5f, 0.5f, -0.5f, 0.0f, 1.0f
+	};
+
+	// per vertex: position and uv at locations 0 and 1
+	ShaderElementKind vertexKinds[] = { f3, f2 };
+	ShaderElement vertexLayout = InitShaderElement(vertexKinds, sizeof(vertexKinds) / sizeof(vertexKinds[0]), GL_FLOAT, GL_FALSE);
+
+	// per instance: the model matrix at locations 2 to 5
+	ShaderElementKind instanceKinds[] = { m4 };
+	ShaderElement instanceLayout = InitShaderElement(instanceKinds, 1, GL_FLOAT, GL_FALSE);
+	ShaderElementSetLocation(&instanceLayout, 2);
+	ShaderElementSetDivisor(&instanceLayout, 1);
+
+	VertexArray vao = CreateVertexArray();
+	VertexArrayBind(&vao);
+
+	VertexBuffer vbo = CreateVertexBuffer(vertices, sizeof(vertices), STATIC);
+	VertexBufferSetLayout(&vbo, &vertexLayout);
+	VertexArrayPointers(&vao, &vbo);
+
+	VertexBuffer instances = CreateVertexBuffer(NULL, 0, DYNAMIC);
+	VertexBufferSetLayout(&instances, &instanceLayout);
+	VertexArrayPointers(&vao, &instances);
+
+	ShaderSources sources = { 0 };
+	ShaderPermutations mesh = CreateShaderPermutations(&sources, "assets/shader/mesh.vs", "assets/shader/mesh.fs", meshFeatures, 3);
+	ShaderPermutationsBindUniformBlock(&mesh, "Frame", UNIFORM_BINDING_FRAME);
+
+	if (ShaderPermutationGet(&mesh, MESH_TEXTURED | MESH_INSTANCED) == NULL)
+	{
+		fprintf(stderr, "[ERROR]: Failed to build the mesh shader, run from the project directory.\n");
+		glfwTerminate();
+		return 1;
+	}
+
+	UniformStream uniforms = CreateUniformStream(4 * 1024);
+
+	Mat4x4 *world = malloc(GRID * GRID * sizeof(Mat4x4));
+
+	Vec3 eye = (Vec3) { 0.0f, 60.0f, 90.0f };
+	Mat4x4 view = Mat4x4LookAt(eye, (Vec3) { 0.0f, 0.0f, 0.0f }, (Vec3) { 0.0f, 1.0f, 0.0f });
+	Mat4x4 proj = Mat4x4Prespective(DEG2RAD * 45.0f, 800.0f / 600.0f, 0.1f, 500.0f);
+
+	float lastReport = 0.0f;
+	int frames = 0;
+
+	while (!glfwWindowShouldClose(window))
+	{
+		float cf = glfwGetTime();
+
+		ClearBackground((Color) { 23, 23, 23, 255 });
+		if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+			glfwSetWindowShouldClose(window, true);
+
+		for (int z = 0; z < GRID; ++z) for (int x = 0; x < GRID; ++x)
+		{
+			Mat4x4 rotation = Mat4x4Rotate((Vec3){ 0.5f, 1.0f, 0.0f }, DEG2RAD * 50.0f * cf + (x + z) * 0.1f);
+			Mat4x4 translation = Mat4x4Translation((Vec3) { (x - GRID / 2) * 1.5f, 0.0f, (z - GRID / 2) * 1.5f });
+
+			world[z * GRID + x] = Mat4x4Multiply(rotation, translation);
+		}
+
+		// built before the loop, found again every frame
+		Shader *shader = ShaderPermutationGet(&mesh, MESH_TEXTURED | MESH_INSTANCED);
+		ShaderBind(shader);
+
+		FrameUniforms frame = CreateFrameUniforms(view, proj, eye, cf);
+		UniformStreamPushBind(&uniforms, UNIFORM_BINDING_FRAME, &frame, sizeof(frame));
+
+		GLStateBindTexture(0, GL_TEXTURE_2D, texture);
+
+		// every cube in one draw call
+		VertexArrayDrawInstanced(&vao, &instances, world, GRID * GRID, 36);
+
+		UniformStreamEndFrame(&uniforms);
+		UpdateWindow(window);
+
+		++frames;
+		if (cf - lastReport >= 1.0f)
+		{
+			printf("%d cubes, 1 draw call, %.2f ms per frame\n", GRID * GRID, 1000.0f * (cf - lastReport) / frames);
+			lastReport = cf;
+			frames = 0;
+		}
+	}
+
+	DeleteUniformStream(&uniforms);
+	DeleteShaderPermutations(&mesh);
+	DeleteShaderSources(&sources);
+	free(world);
+	glfwTerminate();
+	
+	return 0;
+}
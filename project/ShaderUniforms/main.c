@@ -46,6 +46,9 @@ int main()
 
 	Vec3 color = { 0.2f, 0.5f, 0.4f };
 
+	// resolved once, the setter below never looks the name up
+	int colorUniform = ShaderFindUniform(&shaderProgram, "Ucolor");
+
 	while (!glfwWindowShouldClose(window))
 	{
 		ClearBackground((Color) { 23, 23, 23, 255 });
@@ -58,7 +61,8 @@ int main()
 		// glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
 		ShaderBind(&shaderProgram);
-		ShaderSetFloat3(&shaderProgram, "Ucolor", color);
+		// the color never changes, only the first frame reaches GL
+		ShaderSetFloat3At(&shaderProgram, colorUniform, color);
 
 		glBindVertexArray(VAO);
 		glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT, 0);
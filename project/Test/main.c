@@ -1,5 +1,18 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cmath.h"
+#include "cmath_soa.h"
+#include "cmath_cull.h"
+#include "BVH.h"
+#include "Scene.h"
+#include "RenderQueue.h"
+#include "Job.h"
+#include "Mesh.h"
+#include "MeshImport.h"
+#include "MeshCache.h"
 
 /*
 		// Column-major order
@@ -8,12 +21,879 @@
 		z' = c20 * x + c21 * y + c22 * z;
 */
 
-float *MatrixMultiply(float *A, float *B, size_t Ar, size_t Ac, size_t Br, size_t Bc)
+// textbook triple loop, kept as the baseline for the benchmark
+void MatrixMultiplyNaive(float *result, const float *A, const float *B, size_t Ar, size_t Ac, size_t Bc)
+{
+	for (size_t i = 0; i < Ar; ++i) for (size_t j = 0; j < Bc; ++j)
+	{
+		float sum = 0.0f;
+		for (size_t k = 0; k < Ac; ++k) sum += A[i * Ac + k] * B[k * Bc + j];
+		result[i * Bc + j] = sum;
+	}
+}
+
+double Now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+#define BACKEND_SAMPLES 10000
+
+static float RandomUnit(void)
+{
+	return (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+static Mat4x4 RandomMatrix(void)
+{
+	Mat4x4 m;
+	float *f = &m.m0;
+	for (int i = 0; i < 16; ++i) f[i] = RandomUnit();
+
+	return m;
+}
+
+static Mat4x4 MatrixAbs(Mat4x4 m)
+{
+	float *f = &m.m0;
+	for (int i = 0; i < 16; ++i) f[i] = fabsf(f[i]);
+
+	return m;
+}
+
+static float Ulp(float x)
+{
+	x = fabsf(x);
+	return nextafterf(x, INFINITY) - x;
+}
+
+// largest |a - b| over the matrix in ulps of scale, per element or for the whole matrix
+static float MatrixUlps(Mat4x4 a, Mat4x4 b, Mat4x4 scale, float factor)
+{
+	float16 fa = Mat4x4ToFloat(a), fb = Mat4x4ToFloat(b), fs = Mat4x4ToFloat(scale);
+	float worst = 0.0f;
+
+	for (int i = 0; i < 16; ++i)
+		worst = fmaxf(worst, fabsf(fa.v[i] - fb.v[i]) / (Ulp(fs.v[i]) * factor));
+
+	return worst;
+}
+
+static float MatrixNormInf(Mat4x4 m)
+{
+	float16 f = Mat4x4ToFloat(m);
+	float norm = 0.0f;
+
+	for (int row = 0; row < 4; ++row)
+		norm = fmaxf(norm, fabsf(f.v[row]) + fabsf(f.v[row + 4]) + fabsf(f.v[row + 8]) + fabsf(f.v[row + 12]));
+
+	return norm;
+}
+
+// every backend against the scalar path, with the bounds cmath.h documents
+bool CheckBackends(void)
+{
+	CMathBackend current = CMathGetBackend();
+	bool passed = true;
+
+	for (CMathBackend backend = CMATH_BACKEND_SCALAR; backend <= CMATH_BACKEND_NEON; ++backend)
+	{
+		if (!CMathSetBackend(backend))
+			continue;
+
+		// the fused backend rounds each multiply-add once instead of twice
+		float productBound = backend == CMATH_BACKEND_FMA ? 8.0f : 0.0f;
+		float multiply = 0.0f, transform = 0.0f, quaternion = 0.0f, invert = 0.0f;
+
+		srand(7);
+
+		for (int i = 0; i < BACKEND_SAMPLES; ++i)
+		{
+			Mat4x4 a = RandomMatrix(), b = RandomMatrix();
+			Vec3 v = { RandomUnit(), RandomUnit(), RandomUnit() };
+
+			// the sum of the absolute terms, the scale a rounding error is measured against
+			Mat4x4 terms = Mat4x4MultiplyScalar(MatrixAbs(a), MatrixAbs(b));
+			multiply = fmaxf(multiply, MatrixUlps(Mat4x4Multiply(a, b), Mat4x4MultiplyScalar(a, b), terms, 1.0f));
+
+			Vec3 p = Vec3Transform(v, a), q = Vec3TransformScalar(v, a);
+			Vec3 pTerms = Vec3TransformScalar((Vec3) { fabsf(v.x), fabsf(v.y), fabsf(v.z) }, MatrixAbs(a));
+			transform = fmaxf(transform, fmaxf(fabsf(p.x - q.x) / Ulp(pTerms.x),
+				fmaxf(fabsf(p.y - q.y) / Ulp(pTerms.y), fabsf(p.z - q.z) / Ulp(pTerms.z))));
+
+			Quaternion r = QuaternionNormalize((Quaternion) { RandomUnit(), RandomUnit(), RandomUnit(), RandomUnit() });
+			Mat4x4 rotation = QuaternionToMatrixScalar(r);
+			quaternion = fmaxf(quaternion, MatrixUlps(QuaternionToMatrix(r), rotation, MatrixAbs(rotation), 1.0f));
+
+			// a random matrix pulled away from singular, its inverse scales the bound
+			Mat4x4 m = a;
+			float *diagonal[4] = { &m.m0, &m.m5, &m.m10, &m.m15 };
+			for (int k = 0; k < 4; ++k) *diagonal[k] += *diagonal[k] < 0.0f ? -2.0f : 2.0f;
+
+			Mat4x4 inverse = Mat4x4InvertScalar(m);
+			float16 fi = Mat4x4ToFloat(inverse);
+			float largest = 0.0f;
+			for (int k = 0; k < 16; ++k) largest = fmaxf(largest, fabsf(fi.v[k]));
+
+			float condition = MatrixNormInf(m) * MatrixNormInf(inverse);
+			Mat4x4 scale;
+			for (int k = 0; k < 16; ++k) (&scale.m0)[k] = largest;
+			invert = fmaxf(invert, MatrixUlps(Mat4x4Invert(m), inverse, scale, condition));
+		}
+
+		bool ok = multiply <= productBound && transform <= productBound && quaternion == 0.0f && invert <= 8.0f;
+		passed &= ok;
+
+		printf("backend %-8s multiply %4.2f ulp  transform %4.2f ulp  quaternion %4.2f ulp  invert %4.2f ulp x cond  %s\n",
+				CMathBackendName(backend), multiply, transform, quaternion, invert, ok ? "ok" : "OUT OF BOUNDS");
+	}
+
+	CMathSetBackend(current);
+
+	return passed;
+}
+
+void BenchmarkGemm(size_t n, int runs)
+{
+	float *A = malloc(n * n * sizeof(float));
+	float *B = malloc(n * n * sizeof(float));
+	float *naive = malloc(n * n * sizeof(float));
+	float *gemm = malloc(n * n * sizeof(float));
+	size_t workspaceSize = MatrixMultiplyWorkspaceSize(n, n, n);
+	void *workspace = CMathAlignedAlloc(workspaceSize, 64);
+
+	for (size_t i = 0; i < n * n; ++i)
+	{
+		A[i] = (float)rand() / RAND_MAX - 0.5f;
+		B[i] = (float)rand() / RAND_MAX - 0.5f;
+	}
+
+	double start = Now();
+	for (int r = 0; r < runs; ++r) MatrixMultiplyNaive(naive, A, B, n, n, n);
+	double naiveTime = (Now() - start) / runs;
+
+	start = Now();
+	for (int r = 0; r < runs; ++r) MatrixMultiplyTo(gemm, workspace, workspaceSize, A, B, n, n, n, n);
+	double gemmTime = (Now() - start) / runs;
+
+	float maxError = 0.0f;
+	for (size_t i = 0; i < n * n; ++i) maxError = fmaxf(maxError, fabsf(naive[i] - gemm[i]));
+
+	double flops = 2.0 * n * n * n;
+	printf("%4zu x %-4zu naive %8.3f ms (%5.1f GFLOPS)  gemm %8.3f ms (%5.1f GFLOPS)  x%.1f  max diff %g\n",
+			n, n,
+			naiveTime * 1e3, flops / naiveTime * 1e-9,
+			gemmTime * 1e3, flops / gemmTime * 1e-9,
+			naiveTime / gemmTime, maxError);
+
+	free(A);
+	free(B);
+	free(naive);
+	free(gemm);
+	CMathAlignedFree(workspace);
+}
+
+#define FAST_MATH_COUNT (1 << 20)
+
+// keeps the timed results from being optimized away
+volatile float sink;
+
+// time count calls of expr (which may use i), the sum keeps the calls alive
+#define TIME_LOOP(seconds, expr) do { \
+	float sum = 0.0f; \
+	double start = Now(); \
+	for (int i = 0; i < FAST_MATH_COUNT; ++i) sum += (expr); \
+	seconds = Now() - start; \
+	sink = sum; \
+} while (0)
+
+void PrintFastMath(const char *name, double libmTime, double fastTime, double maxError)
+{
+	printf("%-24s libm %6.2f ns  fast %6.2f ns  x%.1f  max error %.3g\n",
+			name,
+			libmTime / FAST_MATH_COUNT * 1e9,
+			fastTime / FAST_MATH_COUNT * 1e9,
+			libmTime / fastTime, maxError);
+}
+
+void BenchmarkFastMath(void)
+{
+	float *x = malloc(FAST_MATH_COUNT * sizeof(float));
+	Vec3 *v = malloc(FAST_MATH_COUNT * sizeof(Vec3));
+	Quaternion *q = malloc(FAST_MATH_COUNT * sizeof(Quaternion));
+
+	for (int i = 0; i < FAST_MATH_COUNT; ++i)
+	{
+		x[i] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+		v[i] = (Vec3) { x[i] * 10.0f, (float)rand() / RAND_MAX, 0.5f };
+		q[i] = QuaternionNormalize((Quaternion) { x[i], (float)rand() / RAND_MAX - 0.5f, (float)rand() / RAND_MAX - 0.5f, (float)rand() / RAND_MAX - 0.5f });
+	}
+
+	double libmTime, fastTime, maxError;
+
+	TIME_LOOP(libmTime, 1.0f / sqrtf(x[i] + 2.0f));
+	TIME_LOOP(fastTime, FastRsqrt(x[i] + 2.0f));
+	maxError = 0.0;
+	for (int i = 0; i < FAST_MATH_COUNT; ++i) maxError = fmax(maxError, fabs(FastRsqrt(x[i] + 2.0f) * sqrt(x[i] + 2.0) - 1.0));
+	PrintFastMath("rsqrt (relative)", libmTime, fastTime, maxError);
+
+	TIME_LOOP(libmTime, sinf(x[i] * 50.0f));
+	TIME_LOOP(fastTime, FastSin(x[i] * 50.0f));
+	maxError = 0.0;
+	for (int i = 0; i < FAST_MATH_COUNT; ++i) maxError = fmax(maxError, fabs(FastSin(x[i] * 50.0f) - sin(x[i] * 50.0f)));
+	PrintFastMath("sin", libmTime, fastTime, maxError);
+
+	TIME_LOOP(libmTime, cosf(x[i] * 50.0f));
+	TIME_LOOP(fastTime, FastCos(x[i] * 50.0f));
+	maxError = 0.0;
+	for (int i = 0; i < FAST_MATH_COUNT; ++i) maxError = fmax(maxError, fabs(FastCos(x[i] * 50.0f) - cos(x[i] * 50.0f)));
+	PrintFastMath("cos", libmTime, fastTime, maxError);
+
+	TIME_LOOP(libmTime, acosf(x[i]));
+	TIME_LOOP(fastTime, FastAcos(x[i]));
+	maxError = 0.0;
+	for (int i = 0; i < FAST_MATH_COUNT; ++i) maxError = fmax(maxError, fabs(FastAcos(x[i]) - acos(x[i])));
+	PrintFastMath("acos", libmTime, fastTime, maxError);
+
+	TIME_LOOP(libmTime, Vec3Normalize(v[i]).x);
+	TIME_LOOP(fastTime, Vec3NormalizeFast(v[i]).x);
+	maxError = 0.0;
+	for (int i = 0; i < FAST_MATH_COUNT; ++i) maxError = fmax(maxError, fabs(Vec3NormalizeFast(v[i]).x - Vec3Normalize(v[i]).x));
+	PrintFastMath("Vec3Normalize", libmTime, fastTime, maxError);
+
+	TIME_LOOP(libmTime, QuaternionNormalize(q[i]).w);
+	TIME_LOOP(fastTime, QuaternionNormalizeFast(q[i]).w);
+	maxError = 0.0;
+	for (int i = 0; i < FAST_MATH_COUNT; ++i) maxError = fmax(maxError, fabs(QuaternionNormalizeFast(q[i]).w - QuaternionNormalize(q[i]).w));
+	PrintFastMath("QuaternionNormalize", libmTime, fastTime, maxError);
+
+	int last = FAST_MATH_COUNT - 1;
+	TIME_LOOP(libmTime, QuaternionSlerp(q[i], q[last - i], 0.3f).x);
+	TIME_LOOP(fastTime, QuaternionSlerpFast(q[i], q[last - i], 0.3f).x);
+	maxError = 0.0;
+	for (int i = 0; i < FAST_MATH_COUNT; ++i) maxError = fmax(maxError, fabs(QuaternionSlerpFast(q[i], q[last - i], 0.3f).x - QuaternionSlerp(q[i], q[last - i], 0.3f).x));
+	PrintFastMath("QuaternionSlerp", libmTime, fastTime, maxError);
+
+	free(x);
+	free(v);
+	free(q);
+}
+
+// one pose blend for a crowd: 1000 characters of 100 bones each
+#define POSE_COUNT (1000 * 100)
+
+void BenchmarkPoseBlend(int runs)
 {
-	float *result = malloc((Ar * Br) * sizeof(float));
-	for (int i = 0; i < Bc; ++i) for (int j = 0; j < Ac; ++j) for (int k = 0; k < Ar; ++k) result[j] += A[k + j * Ac] * B[k + i * Br];
+	Quaternion *from = malloc(POSE_COUNT * sizeof(Quaternion));
+	Quaternion *to = malloc(POSE_COUNT * sizeof(Quaternion));
+	float *amount = malloc(POSE_COUNT * sizeof(float));
+	Mat4x4 *bones = malloc(POSE_COUNT * sizeof(Mat4x4));
 
-	return result;
+	for (int i = 0; i < POSE_COUNT; ++i)
+	{
+		from[i] = QuaternionNormalize((Quaternion) { (float)rand() / RAND_MAX - 0.5f, (float)rand() / RAND_MAX - 0.5f, (float)rand() / RAND_MAX - 0.5f, (float)rand() / RAND_MAX - 0.5f });
+		to[i] = QuaternionNormalize((Quaternion) { (float)rand() / RAND_MAX - 0.5f, (float)rand() / RAND_MAX - 0.5f, (float)rand() / RAND_MAX - 0.5f, (float)rand() / RAND_MAX - 0.5f });
+		amount[i] = (float)rand() / RAND_MAX;
+	}
+
+	QuaternionSoA a = Vec4SoAAlloc(POSE_COUNT), b = Vec4SoAAlloc(POSE_COUNT), pose = Vec4SoAAlloc(POSE_COUNT);
+	if (!Vec4SoAFromArray(&a, from, POSE_COUNT) || !Vec4SoAFromArray(&b, to, POSE_COUNT))
+	{
+		Vec4SoAFree(&a); Vec4SoAFree(&b); Vec4SoAFree(&pose);
+		free(from); free(to); free(amount); free(bones);
+		return;
+	}
+
+	double start = Now();
+	for (int r = 0; r < runs; ++r)
+		for (int i = 0; i < POSE_COUNT; ++i) bones[i] = QuaternionToMatrix(QuaternionSlerp(from[i], to[i], amount[i]));
+	double scalarTime = (Now() - start) / runs;
+
+	start = Now();
+	for (int r = 0; r < runs; ++r)
+	{
+		QuaternionSoASlerpEach(&pose, &a, &b, amount);
+		QuaternionSoAToMatrix(bones, &pose);
+	}
+	double soaTime = (Now() - start) / runs;
+
+	float maxError = 0.0f;
+	for (int i = 0; i < POSE_COUNT; ++i)
+	{
+		Quaternion q = QuaternionSlerp(from[i], to[i], amount[i]);
+		Quaternion p = Vec4SoAGet(&pose, i);
+		maxError = fmaxf(maxError, fmaxf(fmaxf(fabsf(q.x - p.x), fabsf(q.y - p.y)), fmaxf(fabsf(q.z - p.z), fabsf(q.w - p.w))));
+	}
+
+	printf("pose blend %d bones  scalar %6.2f ms  soa %6.2f ms  x%.1f  max error %.3g\n",
+			POSE_COUNT, scalarTime * 1e3, soaTime * 1e3, scalarTime / soaTime, maxError);
+
+	Vec4SoAFree(&a);
+	Vec4SoAFree(&b);
+	Vec4SoAFree(&pose);
+	free(from);
+	free(to);
+	free(amount);
+	free(bones);
+}
+
+#define CULL_COUNT 100000
+
+void BenchmarkCulling(int runs)
+{
+	Mat4x4 proj = Mat4x4Prespective(DEG2RAD * 60.0f, 16.0 / 9.0, 0.1, 100.0);
+	Mat4x4 view = Mat4x4LookAt((Vec3) { 3.0f, 2.0f, 10.0f }, (Vec3) { 0.0f, 0.0f, 0.0f }, (Vec3) { 0.0f, 1.0f, 0.0f });
+	Frustum frustum = FrustumFromMatrix(Mat4x4Multiply(view, proj));
+
+	Vec4SoA spheres = Vec4SoAAlloc(CULL_COUNT);
+	if (!Vec4SoAResize(&spheres, CULL_COUNT))
+	{
+		Vec4SoAFree(&spheres);
+		return;
+	}
+	for (int i = 0; i < CULL_COUNT; ++i)
+	{
+		Vec3 center = { (float)rand() / RAND_MAX * 200.0f - 100.0f, (float)rand() / RAND_MAX * 200.0f - 100.0f, (float)rand() / RAND_MAX * 200.0f - 100.0f };
+		Vec4SoASet(&spheres, i, (Vec4) { center.x, center.y, center.z, (float)rand() / RAND_MAX * 3.0f });
+	}
+
+	unsigned int *visible = malloc(CULL_COUNT * sizeof(unsigned int));
+	size_t count = 0;
+
+	double start = Now();
+	for (int r = 0; r < runs; ++r)
+	{
+		count = 0;
+		for (int i = 0; i < CULL_COUNT; ++i)
+			if (FrustumSphereVisible(&frustum, (Vec3) { spheres.x[i], spheres.y[i], spheres.z[i] }, spheres.w[i])) visible[count++] = i;
+	}
+	double loopTime = (Now() - start) / runs;
+
+	start = Now();
+	for (int r = 0; r < runs; ++r) count = FrustumCullSpheres(visible, &frustum, &spheres);
+	double batchTime = (Now() - start) / runs;
+
+	printf("cull %d spheres  loop %6.3f ms  batch %6.3f ms  x%.1f  visible %zu\n",
+			CULL_COUNT, loopTime * 1e3, batchTime * 1e3, loopTime / batchTime, count);
+
+	Vec4SoAFree(&spheres);
+	free(visible);
+}
+
+#define BVH_TRIANGLES 300000
+#define BVH_RAYS 1000
+
+// brute force picking, what the demos did before the BVH
+int PickBruteForce(const Vec3 *vertices, size_t triangleCount, Vec3 origin, Vec3 direction, float *distance)
+{
+	int found = 0;
+
+	for (size_t i = 0; i < triangleCount; ++i)
+	{
+		const Vec3 *v = vertices + i * 3;
+		Vec3 e1 = Vec3Sub(v[1], v[0]), e2 = Vec3Sub(v[2], v[0]);
+		Vec3 p = Vec3CrossProduct(direction, e2);
+		float det = Vec3DotProduct(e1, p);
+		if (det == 0.0f) continue;
+
+		Vec3 s = Vec3Sub(origin, v[0]), q = Vec3CrossProduct(s, e1);
+		float u = Vec3DotProduct(s, p) / det, w = Vec3DotProduct(direction, q) / det, t = Vec3DotProduct(e2, q) / det;
+
+		if (u >= 0.0f && w >= 0.0f && u + w <= 1.0f && t > 0.0f && t < *distance)
+		{
+			*distance = t;
+			found = 1;
+		}
+	}
+
+	return found;
+}
+
+void BenchmarkBVH(void)
+{
+	Vec3 *vertices = malloc(BVH_TRIANGLES * 3 * sizeof(Vec3));
+
+	for (int i = 0; i < BVH_TRIANGLES; ++i)
+	{
+		Vec3 center = { (float)rand() / RAND_MAX * 200.0f - 100.0f, (float)rand() / RAND_MAX * 10.0f, (float)rand() / RAND_MAX * 200.0f - 100.0f };
+		for (int k = 0; k < 3; ++k)
+			vertices[i * 3 + k] = Vec3Add(center, (Vec3) { (float)rand() / RAND_MAX - 0.5f, (float)rand() / RAND_MAX - 0.5f, (float)rand() / RAND_MAX - 0.5f });
+	}
+
+	double start = Now();
+	BVH bvh = BVHBuildTriangles(vertices, NULL, BVH_TRIANGLES);
+	double buildTime = Now() - start;
+
+	Vec3 origin = { 0.0f, 50.0f, 0.0f };
+	Vec3 *directions = malloc(BVH_RAYS * sizeof(Vec3));
+	for (int i = 0; i < BVH_RAYS; ++i)
+		directions[i] = (Vec3) { (float)rand() / RAND_MAX - 0.5f, -1.0f, (float)rand() / RAND_MAX - 0.5f };
+
+	int hits = 0;
+	start = Now();
+	for (int i = 0; i < BVH_RAYS; ++i)
+	{
+		BVHHit hit;
+		hits += BVHRayFirstHit(&bvh, origin, directions[i], INFINITY, &hit);
+	}
+	double bvhTime = (Now() - start) / BVH_RAYS;
+
+	// brute force is slow, a few rays are enough
+	start = Now();
+	for (int i = 0; i < 10; ++i)
+	{
+		float distance = INFINITY;
+		PickBruteForce(vertices, BVH_TRIANGLES, origin, directions[i], &distance);
+	}
+	double bruteTime = (Now() - start) / 10;
+
+	printf("bvh %d triangles  build %6.1f ms  pick %7.2f us  brute force %7.2f us  x%.0f  hits %d/%d\n",
+			BVH_TRIANGLES, buildTime * 1e3, bvhTime * 1e6, bruteTime * 1e6, bruteTime / bvhTime, hits, BVH_RAYS);
+
+	BVHFree(&bvh);
+	free(vertices);
+	free(directions);
+}
+
+#define SCENE_NODES 50000
+
+void BenchmarkScene(int frames)
+{
+	SceneGraph scene = SceneGraphCreate(SCENE_NODES);
+
+	// a wide, shallow hierarchy: every node hangs under one of the 64 before it
+	for (int i = 0; i < SCENE_NODES; ++i)
+	{
+		Transform local = TransformIdentity();
+		local.translation = (Vec3) { (float)(i % 7), 1.0f, 0.0f };
+		local.rotation = QuaternionFromAxisAngle((Vec3) { 0.0f, 1.0f, 0.0f }, i * 0.01f);
+		SceneGraphAddNode(&scene, i ? i - 1 - rand() % (i < 64 ? i : 64) : SCENE_NO_PARENT, local);
+	}
+	SceneGraphUpdate(&scene);
+
+	double start = Now();
+	for (int f = 0; f < frames; ++f) SceneGraphUpdate(&scene);
+	double staticTime = (Now() - start) / frames;
+
+	// a handful of nodes near the end move every frame
+	size_t updated = 0;
+	start = Now();
+	for (int f = 0; f < frames; ++f)
+	{
+		for (int k = 0; k < 16; ++k)
+		{
+			int node = SCENE_NODES - 1 - k * 97;
+			Transform local = SceneGraphGetLocal(&scene, node);
+			local.translation.y += 0.01f;
+			SceneGraphSetLocal(&scene, node, local);
+		}
+		updated += SceneGraphUpdate(&scene);
+	}
+	double movingTime = (Now() - start) / frames;
+
+	// moving the root rebuilds everything
+	start = Now();
+	for (int f = 0; f < frames; ++f)
+	{
+		Transform local = SceneGraphGetLocal(&scene, 0);
+		local.translation.x += 0.01f;
+		SceneGraphSetLocal(&scene, 0, local);
+		SceneGraphUpdate(&scene);
+	}
+	double fullTime = (Now() - start) / frames;
+
+	printf("scene %d nodes  static %7.2f us  16 moving %7.2f us (%zu nodes)  root moving %7.2f us\n",
+			SCENE_NODES, staticTime * 1e6, movingTime * 1e6, updated / frames, fullTime * 1e6);
+
+	SceneGraphFree(&scene);
+}
+
+#define QUEUE_COMMANDS 100000
+
+static int CompareKeys(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+bool BenchmarkRenderQueue(int runs)
+{
+	RenderQueue queue = CreateRenderQueue(QUEUE_COMMANDS);
+	RenderCommand *commands = calloc(QUEUE_COMMANDS, sizeof(RenderCommand));
+	uint64_t *reference = malloc(QUEUE_COMMANDS * sizeof(uint64_t));
+
+	// a scene of 8 shaders, 64 meshes and 256 textures, some of it transparent
+	for (int i = 0; i < QUEUE_COMMANDS; ++i)
+	{
+		commands[i].program = 1 + rand() % 8;
+		commands[i].vertexArray = 1 + rand() % 64;
+		commands[i].textures[0] = 1 + rand() % 256;
+		commands[i].depth = (float)rand() / RAND_MAX;
+		commands[i].transparent = rand() % 20 == 0;
+	}
+
+	double submitTime = 0.0, sortTime = 0.0, qsortTime = 0.0;
+	int sorted = 1;
+
+	for (int run = 0; run < runs; ++run)
+	{
+		RenderQueueClear(&queue);
+
+		double start = Now();
+		for (int i = 0; i < QUEUE_COMMANDS; ++i)
+			RenderQueueSubmit(&queue, &commands[i]);
+		submitTime += Now() - start;
+
+		memcpy(reference, queue.items, QUEUE_COMMANDS * sizeof(uint64_t));
+
+		start = Now();
+		RenderQueueSort(&queue);
+		sortTime += Now() - start;
+
+		start = Now();
+		qsort(reference, QUEUE_COMMANDS, sizeof(uint64_t), CompareKeys);
+		qsortTime += Now() - start;
+
+		sorted &= memcmp(reference, queue.items, QUEUE_COMMANDS * sizeof(uint64_t)) == 0;
+	}
+
+	printf("render queue %d commands  submit %6.3f ms  radix sort %6.3f ms  qsort %6.3f ms  x%.1f  %s\n",
+			QUEUE_COMMANDS, submitTime / runs * 1e3, sortTime / runs * 1e3, qsortTime / runs * 1e3, qsortTime / sortTime,
+			sorted ? "same order" : "MISMATCH");
+
+	free(reference);
+	free(commands);
+	DeleteRenderQueue(&queue);
+
+	return sorted;
+}
+
+// per draw uniforms are packed into the queue along with the command
+static void RecordCommands(void *userData, RenderQueue *queue, size_t begin, size_t end)
+{
+	const RenderCommand *commands = userData;
+
+	for (size_t i = begin; i < end; ++i)
+	{
+		RenderCommand command = commands[i];
+		float tint[4] = { command.depth, 0.0f, 0.0f, 1.0f };
+
+		command.uniformOffset = RenderQueuePushUniforms(queue, tint, sizeof(tint));
+		command.uniformSize = sizeof(tint);
+		RenderQueueSubmit(queue, &command);
+	}
+}
+
+bool BenchmarkRenderRecord(int runs)
+{
+	enum { SLICES = 16 };
+
+	RenderQueue serial = CreateRenderQueue(QUEUE_COMMANDS);
+	RenderQueue merged = CreateRenderQueue(QUEUE_COMMANDS);
+	RenderQueue slices[SLICES];
+	for (int i = 0; i < SLICES; ++i)
+		slices[i] = CreateRenderQueue(QUEUE_COMMANDS / SLICES + 1);
+
+	RenderCommand *commands = calloc(QUEUE_COMMANDS, sizeof(RenderCommand));
+	for (int i = 0; i < QUEUE_COMMANDS; ++i)
+	{
+		commands[i].program = 1 + rand() % 8;
+		commands[i].vertexArray = 1 + rand() % 64;
+		commands[i].textures[0] = 1 + rand() % 256;
+		commands[i].depth = (float)rand() / RAND_MAX;
+		commands[i].transparent = rand() % 20 == 0;
+	}
+
+	double serialTime = 0.0, parallelTime = 0.0;
+	int same = 1;
+
+	for (int run = 0; run < runs; ++run)
+	{
+		RenderQueueClear(&serial);
+		RenderQueueClear(&merged);
+
+		double start = Now();
+		RecordCommands(commands, &serial, 0, QUEUE_COMMANDS);
+		RenderQueueSort(&serial);
+		serialTime += Now() - start;
+
+		start = Now();
+		RenderQueueRecord(&merged, slices, SLICES, QUEUE_COMMANDS, RecordCommands, commands);
+		RenderQueueSort(&merged);
+		parallelTime += Now() - start;
+
+		same &= merged.count == serial.count && memcmp(merged.items, serial.items, serial.count * sizeof(uint64_t)) == 0;
+		for (size_t i = 0; i < serial.count && same; ++i)
+		{
+			const RenderCommand *a = &serial.commands[i], *b = &merged.commands[i];
+			same &= memcmp(serial.uniforms + a->uniformOffset, merged.uniforms + b->uniformOffset, a->uniformSize) == 0;
+		}
+	}
+
+	printf("render record %d commands  serial %6.3f ms  %d slices on %d threads %6.3f ms  %s\n",
+			QUEUE_COMMANDS, serialTime / runs * 1e3, SLICES, JobSystemWorkerCount() + 1, parallelTime / runs * 1e3,
+			same ? "same order" : "MISMATCH");
+
+	free(commands);
+	for (int i = 0; i < SLICES; ++i)
+		DeleteRenderQueue(&slices[i]);
+	DeleteRenderQueue(&merged);
+	DeleteRenderQueue(&serial);
+
+	return same;
+}
+
+#define MESH_GRID 128
+
+typedef struct GridVertex {
+	float position[3];
+	float uv[2];
+} GridVertex;
+
+static int CompareTriangles(const void *a, const void *b)
+{
+	return memcmp(a, b, 3 * sizeof(GridVertex));
+}
+
+bool BenchmarkMesh(void)
+{
+	// a height field as a triangle soup in shuffled triangle order
+	size_t triangleCount = MESH_GRID * MESH_GRID * 2;
+	GridVertex *soup = malloc(triangleCount * 3 * sizeof(GridVertex));
+
+	for (int y = 0; y < MESH_GRID; ++y)
+	{
+		for (int x = 0; x < MESH_GRID; ++x)
+		{
+			GridVertex corner[4];
+			for (int k = 0; k < 4; ++k)
+			{
+				float u = (float)(x + (k & 1)) / MESH_GRID, v = (float)(y + (k >> 1)) / MESH_GRID;
+				corner[k] = (GridVertex) { { u, sinf(u * 8.0f) * cosf(v * 8.0f) * 0.1f, v }, { u, v } };
+			}
+
+			GridVertex *quad = soup + (y * MESH_GRID + x) * 6;
+			quad[0] = corner[0]; quad[1] = corner[2]; quad[2] = corner[1];
+			quad[3] = corner[1]; quad[4] = corner[2]; quad[5] = corner[3];
+		}
+	}
+
+	for (size_t t = triangleCount - 1; t > 0; --t)
+	{
+		size_t other = (size_t)rand() % (t + 1);
+		GridVertex swap[3];
+		memcpy(swap, soup + t * 3, sizeof(swap));
+		memcpy(soup + t * 3, soup + other * 3, sizeof(swap));
+		memcpy(soup + other * 3, swap, sizeof(swap));
+	}
+
+	MeshOptimizeStats stats;
+	double start = Now();
+	Mesh mesh = CreateMesh(soup, triangleCount * 3, sizeof(GridVertex), &stats);
+	double time = Now() - start;
+
+	// every triangle of the soup is still there, in some order
+	GridVertex *rebuilt = malloc(triangleCount * 3 * sizeof(GridVertex));
+	const unsigned short *indices = mesh.indices;
+	for (size_t i = 0; i < mesh.indexCount; ++i)
+	{
+		unsigned int v = mesh.indexType == GL_UNSIGNED_SHORT ? indices[i] : ((const unsigned int *)mesh.indices)[i];
+		memcpy(&rebuilt[i], mesh.vertices + v * mesh.stride, sizeof(GridVertex));
+	}
+
+	// rotate each triangle to start at its smallest vertex, the winding stays
+	GridVertex *sets[2] = { soup, rebuilt };
+	for (int s = 0; s < 2; ++s)
+	{
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			GridVertex *tri = sets[s] + t * 3;
+			while (memcmp(&tri[0], &tri[1], sizeof(GridVertex)) > 0 || memcmp(&tri[0], &tri[2], sizeof(GridVertex)) > 0)
+			{
+				GridVertex first = tri[0];
+				tri[0] = tri[1]; tri[1] = tri[2]; tri[2] = first;
+			}
+		}
+		qsort(sets[s], triangleCount, 3 * sizeof(GridVertex), CompareTriangles);
+	}
+
+	int same = mesh.indexCount == triangleCount * 3 && memcmp(soup, rebuilt, triangleCount * 3 * sizeof(GridVertex)) == 0;
+
+	printf("mesh %zu triangles  %zu -> %zu vertices  %s indices  ACMR %.3f -> %.3f  ATVR %.3f -> %.3f  %.3f ms  %s\n",
+			triangleCount, stats.soupVertices, stats.uniqueVertices, mesh.indexType == GL_UNSIGNED_SHORT ? "16 bit" : "32 bit",
+			stats.before.acmr, stats.after.acmr, stats.before.atvr, stats.after.atvr, time * 1e3,
+			same ? "same triangles" : "MISMATCH");
+
+	free(rebuilt);
+	free(soup);
+	DeleteMesh(&mesh);
+
+	return same;
+}
+
+#define LOD_GRID 708
+
+void BenchmarkLod(void)
+{
+	// a million triangle height field with uvs
+	size_t vertexCount = (LOD_GRID + 1) * (LOD_GRID + 1);
+	size_t indexCount = (size_t)LOD_GRID * LOD_GRID * 6;
+	GridVertex *vertices = malloc(vertexCount * sizeof(GridVertex));
+	unsigned int *indices = malloc(indexCount * sizeof(unsigned int));
+
+	for (int y = 0; y <= LOD_GRID; ++y)
+	{
+		for (int x = 0; x <= LOD_GRID; ++x)
+		{
+			float u = (float)x / LOD_GRID, v = (float)y / LOD_GRID;
+			float height = sinf(u * 6.0f) * cosf(v * 5.0f) * 0.1f + sinf(u * 40.0f) * 0.02f;
+			vertices[y * (LOD_GRID + 1) + x] = (GridVertex) { { u, height, v }, { u, v } };
+		}
+	}
+
+	size_t n = 0;
+	for (unsigned int y = 0; y < LOD_GRID; ++y)
+	{
+		for (unsigned int x = 0; x < LOD_GRID; ++x)
+		{
+			unsigned int a = y * (LOD_GRID + 1) + x, b = a + 1, c = a + LOD_GRID + 1, d = c + 1;
+			unsigned int quad[6] = { a, c, b, b, c, d };
+			for (int k = 0; k < 6; ++k) indices[n++] = quad[k];
+		}
+	}
+
+	MeshSimplifyDesc desc = { indices, indexCount, vertices, vertexCount, sizeof(GridVertex), 0.01f };
+
+	double start = Now();
+	MeshLodChain chain = CreateMeshLodChain(&desc, MESH_MAX_LODS, 0.5f);
+	double time = Now() - start;
+
+	printf("lod chain %zu triangles  %.3f s ", indexCount / 3, time);
+	for (int lod = 0; lod < chain.lodCount; ++lod)
+		printf(" %zu/%.4f", chain.lods[lod].indexCount / 3, chain.lods[lod].error);
+	printf("\n");
+
+	// which level a 600 pixel high 45 degree view picks for one pixel of error
+	Mat4x4 projection = Mat4x4Prespective(DEG2RAD * 45.0f, 800.0f / 600.0f, 0.1f, 100.0f);
+	float distances[] = { 0.5f, 1.0f, 2.0f, 5.0f, 10.0f, 50.0f };
+
+	printf("lod select ");
+	for (size_t i = 0; i < sizeof(distances) / sizeof(distances[0]); ++i)
+		printf(" %.1f->%d", distances[i], MeshLodSelect(&chain, projection, 600.0f, distances[i], 1.0f));
+	printf("\n");
+
+	DeleteMeshLodChain(&chain);
+	free(indices);
+	free(vertices);
+}
+
+#define IMPORT_GRID 512
+
+// a quad grid with positions, uvs and normals, written like an exporter would
+static char *GridOBJ(size_t *size)
+{
+	size_t capacity = (size_t)(IMPORT_GRID + 1) * (IMPORT_GRID + 1) * 96 + (size_t)IMPORT_GRID * IMPORT_GRID * 80;
+	char *text = malloc(capacity);
+	size_t length = 0;
+
+	for (int y = 0; y <= IMPORT_GRID; ++y)
+	{
+		for (int x = 0; x <= IMPORT_GRID; ++x)
+		{
+			float u = (float)x / IMPORT_GRID, v = (float)y / IMPORT_GRID;
+			length += sprintf(text + length, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.4f %.4f %.4f\n",
+				u, sinf(u * 8.0f) * cosf(v * 8.0f) * 0.1f, v, u, v, 0.0f, 1.0f, 0.0f);
+		}
+	}
+
+	for (int y = 0; y < IMPORT_GRID; ++y)
+	{
+		for (int x = 0; x < IMPORT_GRID; ++x)
+		{
+			int a = y * (IMPORT_GRID + 1) + x + 1, b = a + 1, c = a + IMPORT_GRID + 1, d = c + 1;
+			length += sprintf(text + length, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, c, c, c, d, d, d, b, b, b);
+		}
+	}
+
+	*size = length;
+
+	return text;
+}
+
+bool BenchmarkImport(int runs)
+{
+	size_t size;
+	char *text = GridOBJ(&size);
+
+	double best = 1e30;
+	int correct = 1;
+
+	for (int run = 0; run < runs; ++run)
+	{
+		double start = Now();
+		MeshImport import = ImportMeshOBJ(text, size);
+		double time = Now() - start;
+
+		if (time < best) best = time;
+
+		correct &= import.mesh.vertexCount == (size_t)(IMPORT_GRID + 1) * (IMPORT_GRID + 1);
+		correct &= import.mesh.indexCount == (size_t)IMPORT_GRID * IMPORT_GRID * 6;
+		correct &= import.hasNormals && import.hasUVs;
+
+		DeleteMeshImport(&import);
+	}
+
+	printf("obj import %.1f MB  %.3f s  %.0f MB/s  %d workers  %s\n", size / 1e6, best, size / 1e6 / best,
+		JobSystemWorkerCount(), correct ? "ok" : "WRONG");
+
+	free(text);
+
+	return correct;
+}
+
+bool BenchmarkMeshCache(void)
+{
+	const char *pathname = "mesh_cache_bench.obj";
+
+	size_t size;
+	char *text = GridOBJ(&size);
+
+	FILE *file = fopen(pathname, "wb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "[ERROR]: Failed to write %s.\n", pathname);
+		free(text);
+		return false;
+	}
+	fwrite(text, 1, size, file);
+	fclose(file);
+
+	// the first load imports, optimizes and simplifies, the second maps the cache
+	MeshCache cache;
+	double start = Now();
+	bool cold = LoadMeshCached(&cache, pathname, ".", 4);
+	double coldTime = Now() - start;
+	MeshCacheClose(&cache);
+
+	start = Now();
+	bool warm = LoadMeshCached(&cache, pathname, ".", 4);
+	double warmTime = Now() - start;
+
+	printf("mesh cache cold %.3f s  warm %.4f s  %zu vertices %zu indices %d lods  %s\n", coldTime, warmTime,
+		cache.vertexCount, cache.indexCount, cache.lods.lodCount, cold && warm ? "ok" : "WRONG");
+
+	MeshCacheClose(&cache);
+
+	char cachePath[64];
+	snprintf(cachePath, sizeof(cachePath), "./%016llx.mesh", (unsigned long long)MeshCacheKey(text, size, 4));
+	remove(cachePath);
+	remove(pathname);
+	free(text);
+
+	return cold && warm;
 }
 
 int main(void)
@@ -36,11 +916,42 @@ int main(void)
 	 * [ 30 * 100 + 60 * 200 + 90 * 300 ] -> 42,000
 	*/
 
-	float *result = MatrixMultiply(A, B, 3, 3, 3, 1);
+	float result[3 * 1];
+	MatrixMultiplyTo(result, NULL, 0, A, B, 3, 3, 3, 1);
 	for (int i = 0; i < 3 * 1; ++i)
 	{
 		printf("%f ", result[i]);
 	}
+	printf("\n\n");
+
+	printf("backend: %s\n", CMathBackendName(CMathGetBackend()));
+
+	// the benchmarks that check their results fail the run
+	bool passed = CheckBackends();
+	printf("\n");
+
+	BenchmarkGemm(64, 100);
+	BenchmarkGemm(256, 5);
+	BenchmarkGemm(512, 2);
+	BenchmarkGemm(1024, 1);
+	printf("\n");
+
+	BenchmarkFastMath();
+	printf("\n");
+
+	BenchmarkPoseBlend(10);
+	BenchmarkCulling(50);
+	BenchmarkBVH();
+	BenchmarkScene(100);
+	passed &= BenchmarkRenderQueue(20);
+	passed &= BenchmarkRenderRecord(20);
+	passed &= BenchmarkMesh();
+	BenchmarkLod();
+	passed &= BenchmarkImport(3);
+	passed &= BenchmarkMeshCache();
+
+	if (!passed)
+		fprintf(stderr, "[ERROR]: A benchmark produced wrong results.\n");
 
-	return 0;
+	return passed ? 0 : 1;
 }
@@ -1,14 +1,23 @@
 #include "../common/common.h"
 #include "../common/Graphic.h"
+#include "../common/GLState.h"
 #include "../common/IO.h"
+#include "../common/Mesh.h"
 #include "../common/Shader.h"
+#include "../common/ShaderCache.h"
+#include "../common/ShaderPermutation.h"
+#include "../common/UniformBuffer.h"
 #include "../common/Window.h"
 
+// bit i turns on the define meshFeatures[i] in mesh.vs and mesh.fs
+enum { MESH_TEXTURED = 1 << 0, MESH_INSTANCED = 1 << 1, MESH_TINTED = 1 << 2 };
+static const char *meshFeatures[] = { "TEXTURED", "INSTANCED", "TINTED" };
 
 int main()
 {
 	GLFWwindow *window = InitWindow(800, 600, "Texture");
-	glEnable(GL_DEPTH_TEST);
+	ShaderCacheInit("bin/shader_cache");
+	GLStateEnable(GL_DEPTH_TEST);
 
 	int width, height, nrChannels;
 	unsigned char *data = stbi_load("assets/image/metalbox_diffuse.png", &width, &height, &nrChannels, 0);
@@ -17,7 +26,7 @@ int main()
 	unsigned int texture;
 	glGenTextures(1, &texture);
 
-	glBindTexture(GL_TEXTURE_2D, texture);
+	GLStateBindTexture(0, GL_TEXTURE_2D, texture);
 
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
 	glGenerateMipmap(GL_TEXTURE_2D);
@@ -63,28 +72,45 @@ int main()
 		-0.5f, 0.5f, -0.5f, 0.0f, 1.0f
 	};
 
-	unsigned int indices[] = {
-		0, 1, 3,
-		1, 2, 3
-	};
+	// 36 soup vertices, faces sharing corners and uvs leave 16 distinct ones
+	MeshOptimizeStats stats;
+	Mesh cube = CreateMesh(vertices, 36, 5 * sizeof(float), &stats);
+	printf("cube: %zu -> %zu vertices, ACMR %.2f -> %.2f\n", stats.soupVertices, stats.uniqueVertices, stats.before.acmr, stats.after.acmr);
 
 	ShaderElementKind shaderElementKinds[] = { f3, f2 };
 	ShaderElement SE = InitShaderElement(shaderElementKinds, sizeof(shaderElementKinds) / sizeof(shaderElementKinds[0]), GL_FLOAT, GL_FALSE);
 
 	VertexBuffer vbo;
-	// ElementBuffer ebo;
 	VertexArray vao;
 
 	vao = CreateVertexArray();
 	VertexArrayBind(&vao);
 
-	vbo = CreateVertexBuffer(vertices, sizeof(vertices), STATIC);
-	// ebo = CreateElementBuffer(indices, sizeof(indices), STATIC);
+	vbo = CreateVertexBuffer((float *)cube.vertices, cube.vertexCount * cube.stride, STATIC);
+	// the VAO keeps the element buffer bound
+	CreateElementBuffer(cube.indices, cube.indexCount * MeshIndexSize(cube.indexType), STATIC);
 
 	VertexBufferSetLayout(&vbo, &SE);
 	VertexArrayPointers(&vao, &vbo);
 
-	Shader shaderProgram = CreateShader("assets/shader/texture.vs", "assets/shader/texture.fs");
+	ShaderSources sources = { 0 };
+	ShaderPermutations mesh = CreateShaderPermutations(&sources, "assets/shader/mesh.vs", "assets/shader/mesh.fs", meshFeatures, 3);
+	ShaderPermutationsBindUniformBlock(&mesh, "Frame", UNIFORM_BINDING_FRAME);
+	ShaderPermutationsBindUniformBlock(&mesh, "Draw", UNIFORM_BINDING_DRAW);
+
+	if (ShaderPermutationGet(&mesh, MESH_TEXTURED | MESH_TINTED) == NULL)
+	{
+		fprintf(stderr, "[ERROR]: Failed to build the mesh shader, run from the project directory.\n");
+		glfwTerminate();
+		return 1;
+	}
+
+	// layout (std140) uniform Draw { mat4 model; };
+	Std140Layout drawLayout = { 0 };
+	size_t modelOffset = Std140Add(&drawLayout, "model", STD140_MAT4, 0);
+	unsigned char drawBlock[64];
+
+	UniformStream uniforms = CreateUniformStream(64 * 1024);
 
 	Mat4x4 model = Mat4x4Identity();
 	Mat4x4 view = Mat4x4Identity();
@@ -128,22 +154,31 @@ int main()
 		// remove comment to enable wireframe mode.
 		// glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-		ShaderBind(&shaderProgram);
+		// built before the loop, found again every frame
+		Shader *shader = ShaderPermutationGet(&mesh, MESH_TEXTURED | MESH_TINTED);
+		ShaderBind(shader);
+
+		// view and proj once per frame for every program, model per draw
+		FrameUniforms frame = CreateFrameUniforms(view, proj, cameraPosition, cf);
+		UniformStreamPushBind(&uniforms, UNIFORM_BINDING_FRAME, &frame, sizeof(frame));
 
-		ShaderSetMat4(&shaderProgram, "model", model);
-		ShaderSetMat4(&shaderProgram, "view", view);
-		ShaderSetMat4(&shaderProgram, "proj", proj);
+		Std140SetMat4(drawBlock, modelOffset, model);
+		UniformStreamPushBind(&uniforms, UNIFORM_BINDING_DRAW, drawBlock, Std140Size(&drawLayout));
 
-		glBindTexture(GL_TEXTURE_2D, texture);
+		// both are already bound after the first frame, the state cache skips them
+		GLStateBindTexture(0, GL_TEXTURE_2D, texture);
 
 		VertexArrayBind(&vao);
-		// glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-		VertexArrayUnbind(&vao);
+		glDrawElements(GL_TRIANGLES, cube.indexCount, cube.indexType, 0);
 
+		UniformStreamEndFrame(&uniforms);
 		UpdateWindow(window);
 	}
 
+	DeleteUniformStream(&uniforms);
+	DeleteShaderPermutations(&mesh);
+	DeleteShaderSources(&sources);
+	DeleteMesh(&cube);
 	glfwTerminate();
 	
 	return 0;
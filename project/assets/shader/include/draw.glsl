@@ -0,0 +1,4 @@
+// per draw values, UNIFORM_BINDING_DRAW
+layout (std140) uniform Draw {
+	mat4 model;
+};
@@ -0,0 +1,8 @@
+// per frame values, UNIFORM_BINDING_FRAME, FrameUniforms on the C side
+layout (std140) uniform Frame {
+	mat4 view;
+	mat4 proj;
+	mat4 viewProj;
+	vec4 cameraPosition;
+	float time;
+};
@@ -0,0 +1,22 @@
+#version 330 core
+
+in vec2 VtexCoord;
+
+out vec4 OUTcolor;
+
+#ifdef TEXTURED
+uniform sampler2D INtexture;
+#endif
+
+void main()
+{
+#ifdef TEXTURED
+    OUTcolor = texture(INtexture, VtexCoord);
+#else
+    OUTcolor = vec4(VtexCoord, 0.5f, 1.0f);
+#endif
+
+#ifdef TINTED
+    OUTcolor.rgb *= vec3(0.4f, 0.5f, 0.3f);
+#endif
+}
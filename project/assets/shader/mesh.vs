@@ -0,0 +1,30 @@
+#version 330 core
+
+// features, each one a define set by ShaderPermutations
+// TEXTURED   sample INtexture
+// INSTANCED  model matrix per instance at location 2 instead of the Draw block
+// TINTED     darken the color
+
+#include "include/frame.glsl"
+
+layout (location = 0) in vec3 INposition;
+layout (location = 1) in vec2 INtexCoord;
+
+#ifdef INSTANCED
+layout (location = 2) in mat4 INmodel;
+#else
+#include "include/draw.glsl"
+#endif
+
+out vec2 VtexCoord;
+
+void main() {
+#ifdef INSTANCED
+	mat4 world = INmodel;
+#else
+	mat4 world = model;
+#endif
+
+    VtexCoord = INtexCoord;
+	gl_Position = viewProj * world * vec4(INposition.xyz, 1.0f);
+}
@@ -12,6 +12,7 @@
 
 #if __UNIX__
 #define GL_LIB "-l:dependencies/libglfw.so -lGL -lX11 -lpthread -lXrandr -lXi -ldl"
+#define HEADLESS_LIB "-lEGL -lpthread -ldl"
 #elif __WIN32__
 #define GL_LIB "-l:dependencies/libglfw3.a -lopengl32 -lgdi32 -lwinmm  -lpthread -ldl"
 #endif
@@ -21,7 +22,8 @@ const char *source[] = {
 	"TriangleWithEBO",
 	"Test",
 	"ShaderUniforms",
-	"Texture"
+	"Texture",
+	"Instancing"
 };
 
 const size_t src_len = sizeof(source) / sizeof(source[0]);
@@ -130,11 +132,45 @@ void make_source()
 	}
 }
 
+#if __UNIX__
+// GL checks on a surfaceless EGL context, built and run by `./build headless`
+void make_headless()
+{
+	int count;
+	char **files = get_files_from_directory("Headless/", &count);
+
+	if (needs_recompilation("bin/Headless", (const char**)files, count) || COMMON_LIB_STATUS_HAS_CHANGED)
+	{
+		CMD(
+				"gcc",
+				CFLAGS,
+				join(' ', (const char**)files, count),
+				VENDOR_INCLUDE,
+				COMMON_INCLUDE,
+				LIB_PATH,
+				GLAD_LIB,
+				COMMON_LIB,
+				HEADLESS_LIB,
+				"-lm",
+				"-o",
+				"bin/Headless"
+		);
+	}
+
+	CMD("bin/Headless");
+}
+#endif
+
 int main(int argc, char *argv[])
 {
 	make_glad();
 	make_common();
 	make_source();
 
+#	if __UNIX__
+	if (argc > 1 && strcmp(argv[1], "headless") == 0)
+		make_headless();
+#	endif
+
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,795 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <stdatomic.h>
+
+#include "BVH.h"
+#include "cmath_simd.h"
+#include "Job.h"
+
+#define BVH_BINS 12
+#define BVH_MAX_LEAF 8
+
+// deeper nodes become leaves, which bounds the traversal stacks
+#define BVH_MAX_DEPTH 64
+#define BVH_STACK_SIZE (BVH_MAX_DEPTH + 2)
+
+// SAH cost of visiting a node, relative to testing one primitive
+#define BVH_TRAVERSAL_COST 1.0f
+
+// smallest slice of primitives handed to a worker by the bounds pass
+#define BVH_MIN_CHUNK 4096
+
+// smallest subtree handed to a worker as a build task
+#define BVH_MIN_TASK 4096
+
+// plain compares, fminf / fmaxf end up as libm calls for their NaN rules
+static inline float BVHMinf(float a, float b)
+{
+	return a < b ? a : b;
+}
+
+static inline float BVHMaxf(float a, float b)
+{
+	return a > b ? a : b;
+}
+
+static inline Vec3 BVHMin(Vec3 a, Vec3 b)
+{
+	return (Vec3) { BVHMinf(a.x, b.x), BVHMinf(a.y, b.y), BVHMinf(a.z, b.z) };
+}
+
+static inline Vec3 BVHMax(Vec3 a, Vec3 b)
+{
+	return (Vec3) { BVHMaxf(a.x, b.x), BVHMaxf(a.y, b.y), BVHMaxf(a.z, b.z) };
+}
+
+static inline Vec3 BVHSub(Vec3 a, Vec3 b)
+{
+	return (Vec3) { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+static inline float BVHDot(Vec3 a, Vec3 b)
+{
+	return a.x*b.x + a.y*b.y + a.z*b.z;
+}
+
+static inline Vec3 BVHCross(Vec3 a, Vec3 b)
+{
+	return (Vec3) { a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x };
+}
+
+static inline float BVHAxis(Vec3 v, int axis)
+{
+	return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+// half the surface area, SAH only compares ratios
+static inline float BVHArea(Vec3 min, Vec3 max)
+{
+	Vec3 e = BVHSub(max, min);
+
+	return e.x*e.y + e.y*e.z + e.z*e.x;
+}
+
+static const Vec3 BVH_EMPTY_MIN = { INFINITY, INFINITY, INFINITY };
+static const Vec3 BVH_EMPTY_MAX = { -INFINITY, -INFINITY, -INFINITY };
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Build
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+typedef struct BVHTask {
+	unsigned int node;
+	int depth;
+} BVHTask;
+
+typedef struct BVHBuilder {
+	// input, either triangles or boxes
+	const Vec3 *vertices;
+	const unsigned int *indices;
+	const Vec3 *min;
+	const Vec3 *max;
+
+	// per primitive, indexed by build index
+	Vec3 *boundsMin;
+	Vec3 *boundsMax;
+	Vec3 *centroid;
+
+	// build indices, partitioned in place into leaf order
+	unsigned int *order;
+
+	BVHNode *nodes;
+	atomic_uint nodeCount;
+
+	// subtrees of at most taskLimit primitives are queued for the workers
+	// instead of being built right away, 0 builds everything in place
+	BVHTask *tasks;
+	size_t taskCount;
+	size_t taskLimit;
+} BVHBuilder;
+
+typedef struct BVHBin {
+	Vec3 min;
+	Vec3 max;
+	unsigned int count;
+} BVHBin;
+
+static inline Vec3 BVHTriangleVertex(const Vec3 *vertices, const unsigned int *indices, size_t triangle, int corner)
+{
+	return vertices[indices ? indices[triangle*3 + corner] : triangle*3 + corner];
+}
+
+static void BVHPrimitiveBounds(void *userData, size_t begin, size_t end)
+{
+	BVHBuilder *b = userData;
+
+	for (size_t i = begin; i < end; ++i)
+	{
+		Vec3 min, max;
+
+		if (b->vertices)
+		{
+			Vec3 v0 = BVHTriangleVertex(b->vertices, b->indices, i, 0);
+			Vec3 v1 = BVHTriangleVertex(b->vertices, b->indices, i, 1);
+			Vec3 v2 = BVHTriangleVertex(b->vertices, b->indices, i, 2);
+
+			min = BVHMin(v0, BVHMin(v1, v2));
+			max = BVHMax(v0, BVHMax(v1, v2));
+		}
+		else
+		{
+			min = b->min[i];
+			max = b->max[i];
+		}
+
+		b->boundsMin[i] = min;
+		b->boundsMax[i] = max;
+		b->centroid[i] = (Vec3) { (min.x + max.x)*0.5f, (min.y + max.y)*0.5f, (min.z + max.z)*0.5f };
+		b->order[i] = (unsigned int)i;
+	}
+}
+
+static inline int BVHBinIndex(float c, float min, float scale)
+{
+	int bin = (int)((c - min)*scale);
+
+	return bin < BVH_BINS - 1 ? bin : BVH_BINS - 1;
+}
+
+// node->first / node->count hold the primitive range on entry
+static void BVHBuildNode(BVHBuilder *b, unsigned int index, int depth)
+{
+	BVHNode *node = &b->nodes[index];
+	unsigned int first = node->first;
+	unsigned int count = node->count;
+	unsigned int end = first + count;
+
+	Vec3 min = BVH_EMPTY_MIN, max = BVH_EMPTY_MAX;
+	Vec3 cmin = BVH_EMPTY_MIN, cmax = BVH_EMPTY_MAX;
+
+	for (unsigned int i = first; i < end; ++i)
+	{
+		unsigned int p = b->order[i];
+
+		min = BVHMin(min, b->boundsMin[p]);
+		max = BVHMax(max, b->boundsMax[p]);
+		cmin = BVHMin(cmin, b->centroid[p]);
+		cmax = BVHMax(cmax, b->centroid[p]);
+	}
+
+	node->min = min;
+	node->max = max;
+
+	if (count == 1 || depth >= BVH_MAX_DEPTH) return;
+
+	// bin the centroids along every axis with some extent
+	BVHBin bins[3][BVH_BINS];
+	float scale[3];
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		float extent = BVHAxis(cmax, axis) - BVHAxis(cmin, axis);
+		scale[axis] = extent > 0.0f ? BVH_BINS/extent : 0.0f;
+
+		for (int k = 0; k < BVH_BINS; ++k)
+			bins[axis][k] = (BVHBin) { BVH_EMPTY_MIN, BVH_EMPTY_MAX, 0 };
+	}
+
+	for (unsigned int i = first; i < end; ++i)
+	{
+		unsigned int p = b->order[i];
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (scale[axis] == 0.0f) continue;
+
+			BVHBin *bin = &bins[axis][BVHBinIndex(BVHAxis(b->centroid[p], axis), BVHAxis(cmin, axis), scale[axis])];
+			bin->min = BVHMin(bin->min, b->boundsMin[p]);
+			bin->max = BVHMax(bin->max, b->boundsMax[p]);
+			bin->count++;
+		}
+	}
+
+	// sweep from both ends, a split after bin k costs
+	// area(left)*count(left) + area(right)*count(right)
+	int bestAxis = -1, bestBin = 0;
+	float bestCost = INFINITY;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (scale[axis] == 0.0f) continue;
+
+		float rightCost[BVH_BINS];
+		Vec3 rmin = BVH_EMPTY_MIN, rmax = BVH_EMPTY_MAX;
+		unsigned int rcount = 0;
+
+		for (int k = BVH_BINS - 1; k > 0; --k)
+		{
+			rmin = BVHMin(rmin, bins[axis][k].min);
+			rmax = BVHMax(rmax, bins[axis][k].max);
+			rcount += bins[axis][k].count;
+			rightCost[k] = rcount ? BVHArea(rmin, rmax)*rcount : 0.0f;
+		}
+
+		Vec3 lmin = BVH_EMPTY_MIN, lmax = BVH_EMPTY_MAX;
+		unsigned int lcount = 0;
+
+		for (int k = 0; k < BVH_BINS - 1; ++k)
+		{
+			lmin = BVHMin(lmin, bins[axis][k].min);
+			lmax = BVHMax(lmax, bins[axis][k].max);
+			lcount += bins[axis][k].count;
+
+			if (lcount == 0 || lcount == count) continue;
+
+			float cost = BVHArea(lmin, lmax)*lcount + rightCost[k + 1];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = k;
+			}
+		}
+	}
+
+	float area = BVHArea(min, max);
+	int split = bestAxis >= 0 && BVH_TRAVERSAL_COST*area + bestCost < area*count;
+
+	if (!split && count <= BVH_MAX_LEAF) return;
+
+	unsigned int mid = first;
+
+	if (bestAxis >= 0)
+	{
+		float axisMin = BVHAxis(cmin, bestAxis);
+		unsigned int j = end;
+
+		while (mid < j)
+		{
+			unsigned int p = b->order[mid];
+
+			if (BVHBinIndex(BVHAxis(b->centroid[p], bestAxis), axisMin, scale[bestAxis]) <= bestBin)
+				mid++;
+			else
+			{
+				b->order[mid] = b->order[--j];
+				b->order[j] = p;
+			}
+		}
+	}
+
+	// every centroid in one spot, any split is as good as another
+	if (mid == first || mid == end) mid = first + count/2;
+
+	unsigned int left = atomic_fetch_add(&b->nodeCount, 2);
+
+	b->nodes[left] = (BVHNode) { .first = first, .count = mid - first };
+	b->nodes[left + 1] = (BVHNode) { .first = mid, .count = end - mid };
+
+	node->first = left;
+	node->count = 0;
+
+	for (unsigned int child = left; child < left + 2; ++child)
+	{
+		if (b->taskLimit && b->nodes[child].count <= b->taskLimit)
+			b->tasks[b->taskCount++] = (BVHTask) { child, depth + 1 };
+		else
+			BVHBuildNode(b, child, depth + 1);
+	}
+}
+
+static void BVHBuildTasks(void *userData, size_t begin, size_t end)
+{
+	BVHBuilder *b = userData;
+
+	for (size_t i = begin; i < end; ++i)
+		BVHBuildNode(b, b->tasks[i].node, b->tasks[i].depth);
+}
+
+static void BVHBuilderFree(BVHBuilder *b)
+{
+	free(b->boundsMin);
+	free(b->boundsMax);
+	free(b->centroid);
+	free(b->tasks);
+}
+
+static BVH BVHBuild(BVHBuilder *b, size_t count)
+{
+	BVH bvh = { 0 };
+
+	if (count == 0) return bvh;
+
+	b->boundsMin = malloc(count*sizeof(Vec3));
+	b->boundsMax = malloc(count*sizeof(Vec3));
+	b->centroid = malloc(count*sizeof(Vec3));
+	b->order = malloc(count*sizeof(unsigned int));
+	b->nodes = malloc((2*count - 1)*sizeof(BVHNode));
+	b->tasks = malloc(count*sizeof(BVHTask));
+
+	if (!b->boundsMin || !b->boundsMax || !b->centroid || !b->order || !b->nodes || !b->tasks)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate BVH of %zu primitives.\n", count);
+		BVHBuilderFree(b);
+		free(b->order);
+		free(b->nodes);
+		return bvh;
+	}
+
+	int parallel = cmathParallelThreshold && count >= cmathParallelThreshold;
+
+	if (parallel)
+		JobParallelFor(count, BVH_MIN_CHUNK, BVHPrimitiveBounds, b);
+	else
+		BVHPrimitiveBounds(b, 0, count);
+
+	b->nodes[0] = (BVHNode) { .first = 0, .count = (unsigned int)count };
+	atomic_init(&b->nodeCount, 1);
+	b->taskCount = 0;
+	b->taskLimit = 0;
+
+	// split the top of the tree here, then hand a few subtrees per thread
+	// to the workers
+	if (parallel)
+	{
+		b->taskLimit = count/((size_t)(JobSystemWorkerCount() + 1)*4);
+		if (b->taskLimit < BVH_MIN_TASK) b->taskLimit = BVH_MIN_TASK;
+	}
+
+	BVHBuildNode(b, 0, 0);
+
+	if (b->taskCount)
+	{
+		b->taskLimit = 0;
+		JobParallelFor(b->taskCount, 1, BVHBuildTasks, b);
+	}
+
+	bvh.nodeCount = atomic_load(&b->nodeCount);
+	bvh.nodes = realloc(b->nodes, bvh.nodeCount*sizeof(BVHNode));
+	if (bvh.nodes == NULL) bvh.nodes = b->nodes;
+
+	bvh.primitives = b->order;
+	bvh.primitiveCount = count;
+
+	BVHBuilderFree(b);
+
+	return bvh;
+}
+
+// bounds of the primitive at leaf position i
+static inline void BVHLeafBounds(const BVH *bvh, size_t i, Vec3 *min, Vec3 *max)
+{
+	if (bvh->triangles)
+	{
+		const Vec3 *v = bvh->triangles + i*3;
+
+		*min = BVHMin(v[0], BVHMin(v[1], v[2]));
+		*max = BVHMax(v[0], BVHMax(v[1], v[2]));
+	}
+	else
+	{
+		*min = bvh->boxMin[i];
+		*max = bvh->boxMax[i];
+	}
+}
+
+// children always come after their parent, so a backwards walk sees every
+// child before the node that encloses it
+static void BVHRefitNodes(BVH *bvh)
+{
+	for (size_t i = bvh->nodeCount; i-- > 0;)
+	{
+		BVHNode *node = &bvh->nodes[i];
+
+		if (node->count)
+		{
+			Vec3 min = BVH_EMPTY_MIN, max = BVH_EMPTY_MAX;
+
+			for (unsigned int k = node->first; k < node->first + node->count; ++k)
+			{
+				Vec3 pmin, pmax;
+				BVHLeafBounds(bvh, k, &pmin, &pmax);
+
+				min = BVHMin(min, pmin);
+				max = BVHMax(max, pmax);
+			}
+
+			node->min = min;
+			node->max = max;
+		}
+		else
+		{
+			const BVHNode *left = &bvh->nodes[node->first];
+
+			node->min = BVHMin(left[0].min, left[1].min);
+			node->max = BVHMax(left[0].max, left[1].max);
+		}
+	}
+}
+
+BVH BVHBuildTriangles(const Vec3 *vertices, const unsigned int *indices, size_t triangleCount)
+{
+	BVHBuilder builder = { .vertices = vertices, .indices = indices };
+	BVH bvh = BVHBuild(&builder, triangleCount);
+
+	if (bvh.nodes == NULL) return bvh;
+
+	bvh.triangles = malloc(triangleCount*3*sizeof(Vec3));
+	if (bvh.triangles == NULL)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate BVH triangles.\n");
+		BVHFree(&bvh);
+		return bvh;
+	}
+
+	for (size_t i = 0; i < triangleCount; ++i)
+		for (int corner = 0; corner < 3; ++corner)
+			bvh.triangles[i*3 + corner] = BVHTriangleVertex(vertices, indices, bvh.primitives[i], corner);
+
+	return bvh;
+}
+
+BVH BVHBuildBoxes(const Vec3 *min, const Vec3 *max, size_t count)
+{
+	BVHBuilder builder = { .min = min, .max = max };
+	BVH bvh = BVHBuild(&builder, count);
+
+	if (bvh.nodes == NULL) return bvh;
+
+	bvh.boxMin = malloc(count*sizeof(Vec3));
+	bvh.boxMax = malloc(count*sizeof(Vec3));
+	if (bvh.boxMin == NULL || bvh.boxMax == NULL)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate BVH boxes.\n");
+		BVHFree(&bvh);
+		return bvh;
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		bvh.boxMin[i] = min[bvh.primitives[i]];
+		bvh.boxMax[i] = max[bvh.primitives[i]];
+	}
+
+	return bvh;
+}
+
+void BVHFree(BVH *bvh)
+{
+	free(bvh->nodes);
+	free(bvh->primitives);
+	free(bvh->triangles);
+	free(bvh->boxMin);
+	free(bvh->boxMax);
+
+	*bvh = (BVH) { 0 };
+}
+
+void BVHRefitTriangles(BVH *bvh, const Vec3 *vertices, const unsigned int *indices)
+{
+	if (bvh->triangles == NULL) return;
+
+	for (size_t i = 0; i < bvh->primitiveCount; ++i)
+		for (int corner = 0; corner < 3; ++corner)
+			bvh->triangles[i*3 + corner] = BVHTriangleVertex(vertices, indices, bvh->primitives[i], corner);
+
+	BVHRefitNodes(bvh);
+}
+
+void BVHRefitBoxes(BVH *bvh, const Vec3 *min, const Vec3 *max)
+{
+	if (bvh->boxMin == NULL) return;
+
+	for (size_t i = 0; i < bvh->primitiveCount; ++i)
+	{
+		bvh->boxMin[i] = min[bvh->primitives[i]];
+		bvh->boxMax[i] = max[bvh->primitives[i]];
+	}
+
+	BVHRefitNodes(bvh);
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Queries
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+typedef enum {
+	BVH_OUTSIDE,
+	BVH_INTERSECTS,
+	BVH_INSIDE
+} BVHFrustumState;
+
+static BVHFrustumState BVHClassifyBox(const Frustum *frustum, Vec3 min, Vec3 max)
+{
+	Vec3 center = { (min.x + max.x)*0.5f, (min.y + max.y)*0.5f, (min.z + max.z)*0.5f };
+	Vec3 extent = { (max.x - min.x)*0.5f, (max.y - min.y)*0.5f, (max.z - min.z)*0.5f };
+
+	BVHFrustumState state = BVH_INSIDE;
+
+	for (int p = 0; p < FRUSTUM_PLANE_COUNT; ++p)
+	{
+		const Vec4 plane = frustum->planes[p];
+
+		float distance = plane.x*center.x + plane.y*center.y + plane.z*center.z + plane.w;
+		float radius = fabsf(plane.x)*extent.x + fabsf(plane.y)*extent.y + fabsf(plane.z)*extent.z;
+
+		if (distance < -radius) return BVH_OUTSIDE;
+		if (distance < radius) state = BVH_INTERSECTS;
+	}
+
+	return state;
+}
+
+size_t BVHFrustumQuery(const BVH *bvh, const Frustum *frustum, unsigned int *result)
+{
+	if (bvh->nodeCount == 0) return 0;
+
+	struct { unsigned int node; int inside; } stack[BVH_STACK_SIZE];
+	size_t top = 0, count = 0;
+
+	stack[top].node = 0;
+	stack[top++].inside = 0;
+
+	while (top)
+	{
+		top--;
+		const BVHNode *node = &bvh->nodes[stack[top].node];
+		int inside = stack[top].inside;
+
+		// once a node is fully inside, nothing below it needs a test
+		if (!inside)
+		{
+			BVHFrustumState state = BVHClassifyBox(frustum, node->min, node->max);
+
+			if (state == BVH_OUTSIDE) continue;
+			inside = state == BVH_INSIDE;
+		}
+
+		if (node->count)
+		{
+			for (unsigned int i = node->first; i < node->first + node->count; ++i)
+			{
+				if (!inside)
+				{
+					Vec3 min, max;
+					BVHLeafBounds(bvh, i, &min, &max);
+
+					if (!FrustumAABBVisible(frustum, min, max)) continue;
+				}
+
+				result[count++] = bvh->primitives[i];
+			}
+
+			continue;
+		}
+
+		stack[top].node = node->first;
+		stack[top++].inside = inside;
+		stack[top].node = node->first + 1;
+		stack[top++].inside = inside;
+	}
+
+	return count;
+}
+
+typedef struct BVHRay {
+	Vec3 origin;
+	Vec3 direction;
+	Vec3 invDirection;
+} BVHRay;
+
+// 1/d, but finite for d = 0 so the slab test never computes 0*inf
+static inline float BVHInverse(float d)
+{
+	float inv = 1.0f/d;
+
+	return isinf(inv) ? copysignf(FLT_MAX, d) : inv;
+}
+
+static inline BVHRay BVHMakeRay(Vec3 origin, Vec3 direction)
+{
+	return (BVHRay) { origin, direction, { BVHInverse(direction.x), BVHInverse(direction.y), BVHInverse(direction.z) } };
+}
+
+// entry distance of the ray into the box clamped to [0, maxDistance],
+// INFINITY on a miss
+static inline float BVHRayBox(const BVHRay *ray, Vec3 min, Vec3 max, float maxDistance)
+{
+	float tx1 = (min.x - ray->origin.x)*ray->invDirection.x;
+	float tx2 = (max.x - ray->origin.x)*ray->invDirection.x;
+	float ty1 = (min.y - ray->origin.y)*ray->invDirection.y;
+	float ty2 = (max.y - ray->origin.y)*ray->invDirection.y;
+	float tz1 = (min.z - ray->origin.z)*ray->invDirection.z;
+	float tz2 = (max.z - ray->origin.z)*ray->invDirection.z;
+
+	float tmin = BVHMaxf(BVHMaxf(BVHMinf(tx1, tx2), BVHMinf(ty1, ty2)), BVHMaxf(BVHMinf(tz1, tz2), 0.0f));
+	float tmax = BVHMinf(BVHMinf(BVHMaxf(tx1, tx2), BVHMaxf(ty1, ty2)), BVHMinf(BVHMaxf(tz1, tz2), maxDistance));
+
+	return tmin <= tmax ? tmin : INFINITY;
+}
+
+// Moller-Trumbore
+static inline int BVHRayTriangle(const BVHRay *ray, const Vec3 *v, float maxDistance, BVHHit *hit)
+{
+	Vec3 e1 = BVHSub(v[1], v[0]);
+	Vec3 e2 = BVHSub(v[2], v[0]);
+
+	Vec3 p = BVHCross(ray->direction, e2);
+	float det = BVHDot(e1, p);
+	if (det == 0.0f) return 0;
+
+	float idet = 1.0f/det;
+	Vec3 s = BVHSub(ray->origin, v[0]);
+
+	float u = BVHDot(s, p)*idet;
+	if (u < 0.0f || u > 1.0f) return 0;
+
+	Vec3 q = BVHCross(s, e1);
+
+	float w = BVHDot(ray->direction, q)*idet;
+	if (w < 0.0f || u + w > 1.0f) return 0;
+
+	float t = BVHDot(e2, q)*idet;
+	if (!(t > 0.0f && t <= maxDistance)) return 0;
+
+	hit->distance = t;
+	hit->u = u;
+	hit->v = w;
+
+	return 1;
+}
+
+// test the primitive at leaf position i
+static inline int BVHRayPrimitive(const BVH *bvh, const BVHRay *ray, size_t i, float maxDistance, BVHHit *hit)
+{
+	int found;
+
+	if (bvh->triangles)
+		found = BVHRayTriangle(ray, bvh->triangles + i*3, maxDistance, hit);
+	else if (bvh->intersect)
+		found = bvh->intersect(bvh->userData, bvh->primitives[i], ray->origin, ray->direction, maxDistance, hit);
+	else
+	{
+		float t = BVHRayBox(ray, bvh->boxMin[i], bvh->boxMax[i], maxDistance);
+
+		found = t != INFINITY;
+		*hit = (BVHHit) { t, 0, 0.0f, 0.0f };
+	}
+
+	hit->primitive = bvh->primitives[i];
+
+	return found;
+}
+
+typedef struct BVHStackEntry {
+	unsigned int node;
+	float distance;
+} BVHStackEntry;
+
+int BVHRayFirstHit(const BVH *bvh, Vec3 origin, Vec3 direction, float maxDistance, BVHHit *hit)
+{
+	if (bvh->nodeCount == 0) return 0;
+
+	BVHRay ray = BVHMakeRay(origin, direction);
+	BVHHit best = { maxDistance, 0, 0.0f, 0.0f };
+	int found = 0;
+
+	BVHStackEntry stack[BVH_STACK_SIZE];
+	size_t top = 0;
+
+	float distance = BVHRayBox(&ray, bvh->nodes[0].min, bvh->nodes[0].max, maxDistance);
+	if (distance == INFINITY) return 0;
+
+	stack[top++] = (BVHStackEntry) { 0, distance };
+
+	while (top)
+	{
+		BVHStackEntry entry = stack[--top];
+
+		// something closer was found since this node was pushed
+		if (entry.distance > best.distance) continue;
+
+		const BVHNode *node = &bvh->nodes[entry.node];
+
+		if (node->count)
+		{
+			for (unsigned int i = node->first; i < node->first + node->count; ++i)
+			{
+				BVHHit candidate;
+
+				if (BVHRayPrimitive(bvh, &ray, i, best.distance, &candidate))
+				{
+					best = candidate;
+					found = 1;
+				}
+			}
+
+			continue;
+		}
+
+		unsigned int left = node->first;
+		float dl = BVHRayBox(&ray, bvh->nodes[left].min, bvh->nodes[left].max, best.distance);
+		float dr = BVHRayBox(&ray, bvh->nodes[left + 1].min, bvh->nodes[left + 1].max, best.distance);
+
+		// the far child goes on the stack first so the near one is visited next
+		if (dl <= dr)
+		{
+			if (dr != INFINITY) stack[top++] = (BVHStackEntry) { left + 1, dr };
+			if (dl != INFINITY) stack[top++] = (BVHStackEntry) { left, dl };
+		}
+		else
+		{
+			if (dl != INFINITY) stack[top++] = (BVHStackEntry) { left, dl };
+			stack[top++] = (BVHStackEntry) { left + 1, dr };
+		}
+	}
+
+	if (found) *hit = best;
+
+	return found;
+}
+
+int BVHRayAnyHit(const BVH *bvh, Vec3 origin, Vec3 direction, float maxDistance)
+{
+	if (bvh->nodeCount == 0) return 0;
+
+	BVHRay ray = BVHMakeRay(origin, direction);
+
+	unsigned int stack[BVH_STACK_SIZE];
+	size_t top = 0;
+
+	stack[top++] = 0;
+
+	while (top)
+	{
+		const BVHNode *node = &bvh->nodes[stack[--top]];
+
+		if (BVHRayBox(&ray, node->min, node->max, maxDistance) == INFINITY) continue;
+
+		if (node->count)
+		{
+			for (unsigned int i = node->first; i < node->first + node->count; ++i)
+			{
+				BVHHit hit;
+				if (BVHRayPrimitive(bvh, &ray, i, maxDistance, &hit)) return 1;
+			}
+
+			continue;
+		}
+
+		stack[top++] = node->first;
+		stack[top++] = node->first + 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,87 @@
+#ifndef __BVH_H__
+#define __BVH_H__
+
+#include "cmath.h"
+#include "cmath_cull.h"
+
+/*
+	Bounding volume hierarchy over triangles or boxes (instances).
+
+	The build bins primitive centroids (12 bins per axis) and picks the
+	split with the lowest surface area heuristic cost. Builds with at least
+	CMathSetParallelThreshold primitives finish their subtrees on the job
+	system.
+
+	Nodes are 32 bytes (two per cache line), the children of a node sit next
+	to each other and always after their parent. Primitive data is copied in
+	leaf order so every leaf reads one contiguous run.
+
+	Ray distances are in units of the direction length.
+*/
+
+typedef struct BVHHit {
+	float distance;
+	unsigned int primitive; // index given to the build
+	float u, v;             // barycentric coordinates on triangles, 0 on boxes
+} BVHHit;
+
+// exact test for a box primitive of an instance BVH, e.g. a query against
+// the instance's own mesh BVH. Returns 1 and fills hit for a hit closer than
+// maxDistance.
+typedef int (*BVHIntersectFunc)(void *userData, unsigned int primitive, Vec3 origin, Vec3 direction, float maxDistance, BVHHit *hit);
+
+typedef struct BVHNode {
+	Vec3 min;
+	unsigned int first; // inner node: left child (right is first + 1), leaf: first primitive
+	Vec3 max;
+	unsigned int count; // primitives in a leaf, 0 for inner nodes
+} BVHNode;
+
+typedef struct BVH {
+	BVHNode *nodes;
+	size_t nodeCount;
+
+	// leaf order -> index given to the build
+	unsigned int *primitives;
+	size_t primitiveCount;
+
+	// triangle BVH: 3 vertices per triangle, in leaf order
+	Vec3 *triangles;
+
+	// box BVH: bounds per primitive, in leaf order
+	Vec3 *boxMin;
+	Vec3 *boxMax;
+
+	// optional exact test for box primitives, without it a ray hits the box
+	BVHIntersectFunc intersect;
+	void *userData;
+} BVH;
+
+// build over triangleCount triangles, indices holds 3 vertex indices per
+// triangle or is NULL for a plain list of 3 vertices per triangle
+BVH BVHBuildTriangles(const Vec3 *vertices, const unsigned int *indices, size_t triangleCount);
+
+// build over count boxes
+BVH BVHBuildBoxes(const Vec3 *min, const Vec3 *max, size_t count);
+
+// release the BVH memory
+void BVHFree(BVH *bvh);
+
+// update the bounds after the vertices moved, the tree shape is kept
+void BVHRefitTriangles(BVH *bvh, const Vec3 *vertices, const unsigned int *indices);
+
+// update the bounds after the boxes moved, the tree shape is kept
+void BVHRefitBoxes(BVH *bvh, const Vec3 *min, const Vec3 *max);
+
+// write the indices of the primitives whose bounds overlap the frustum,
+// result must have room for bvh->primitiveCount indices. Returns how many.
+size_t BVHFrustumQuery(const BVH *bvh, const Frustum *frustum, unsigned int *result);
+
+// closest hit along origin + t*direction with 0 < t <= maxDistance, returns 0
+// on a miss. A ray starting inside a box primitive hits it at t = 0.
+int BVHRayFirstHit(const BVH *bvh, Vec3 origin, Vec3 direction, float maxDistance, BVHHit *hit);
+
+// 1 if anything is hit with 0 < t <= maxDistance (shadow / occlusion rays)
+int BVHRayAnyHit(const BVH *bvh, Vec3 origin, Vec3 direction, float maxDistance);
+
+#endif // __BVH_H__
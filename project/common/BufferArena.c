@@ -0,0 +1,431 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "BufferArena.h"
+#include "GLExt.h"
+#include "GLState.h"
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Free list
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// add a free range, merged with the ranges right before and after it
+static bool ArenaFreeListInsert(ArenaFreeList *list, unsigned int offset, unsigned int size)
+{
+	// first range past the new one
+	size_t lo = 0, hi = list->count;
+	while (lo < hi)
+	{
+		size_t mid = (lo + hi) / 2;
+		if (list->ranges[mid].offset < offset) lo = mid + 1;
+		else hi = mid;
+	}
+
+	ArenaRange *ranges = list->ranges;
+	size_t i = lo;
+
+	bool mergePrev = i > 0 && ranges[i - 1].offset + ranges[i - 1].size == offset;
+	bool mergeNext = i < list->count && offset + size == ranges[i].offset;
+
+	if (mergePrev && mergeNext)
+	{
+		ranges[i - 1].size += size + ranges[i].size;
+		memmove(&ranges[i], &ranges[i + 1], (list->count - i - 1) * sizeof(ArenaRange));
+		--list->count;
+	}
+	else if (mergePrev)
+	{
+		ranges[i - 1].size += size;
+	}
+	else if (mergeNext)
+	{
+		ranges[i].offset = offset;
+		ranges[i].size += size;
+	}
+	else
+	{
+		if (list->count == list->capacity)
+		{
+			size_t capacity = list->capacity ? list->capacity * 2 : 16;
+
+			ranges = realloc(list->ranges, capacity * sizeof(ArenaRange));
+			if (ranges == NULL)
+			{
+				fprintf(stderr, "[ERROR]: Failed to grow arena free list, %u elements lost.\n", size);
+				return false;
+			}
+
+			list->ranges = ranges;
+			list->capacity = capacity;
+		}
+
+		memmove(&ranges[i + 1], &ranges[i], (list->count - i) * sizeof(ArenaRange));
+		ranges[i] = (ArenaRange) { offset, size };
+		++list->count;
+	}
+
+	return true;
+}
+
+// best fit: the smallest free range that holds size
+static bool ArenaFreeListAlloc(ArenaFreeList *list, unsigned int size, unsigned int *offset)
+{
+	ArenaRange *ranges = list->ranges;
+	size_t best = list->count;
+
+	for (size_t i = 0; i < list->count; ++i)
+	{
+		if (ranges[i].size < size) continue;
+		if (best == list->count || ranges[i].size < ranges[best].size) best = i;
+		if (ranges[i].size == size) break;
+	}
+
+	if (best == list->count)
+		return false;
+
+	*offset = ranges[best].offset;
+	ranges[best].offset += size;
+	ranges[best].size -= size;
+
+	if (ranges[best].size == 0)
+	{
+		memmove(&ranges[best], &ranges[best + 1], (list->count - best - 1) * sizeof(ArenaRange));
+		--list->count;
+	}
+
+	list->used += size;
+
+	return true;
+}
+
+static void ArenaFreeListFree(ArenaFreeList *list, unsigned int offset, unsigned int size)
+{
+	list->used -= size;
+	ArenaFreeListInsert(list, offset, size);
+}
+
+static unsigned int ArenaFreeListLargest(const ArenaFreeList *list)
+{
+	unsigned int largest = 0;
+
+	for (size_t i = 0; i < list->count; ++i)
+		if (list->ranges[i].size > largest) largest = list->ranges[i].size;
+
+	return largest;
+}
+
+// everything below used is taken, the rest is one free range
+static void ArenaFreeListReset(ArenaFreeList *list, unsigned int used)
+{
+	list->count = 0;
+	list->used = used;
+
+	if (used < list->size)
+		ArenaFreeListInsert(list, used, list->size - used);
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Arena
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// uploads and copies go through the copy targets so the element buffer bound
+// to whatever VAO is current is left alone
+static unsigned int ArenaNewBuffer(size_t size)
+{
+	unsigned int ID;
+
+	glGenBuffers(1, &ID);
+	GLStateBindBuffer(GL_COPY_WRITE_BUFFER, ID);
+	glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STATIC_DRAW);
+
+	return ID;
+}
+
+// a bigger buffer with the content of the old one, which is deleted
+static unsigned int ArenaResizeBuffer(unsigned int ID, size_t oldSize, size_t newSize)
+{
+	unsigned int resized = ArenaNewBuffer(newSize);
+
+	GLStateBindBuffer(GL_COPY_READ_BUFFER, ID);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+	GLStateForgetBuffer(ID);
+	glDeleteBuffers(1, &ID);
+
+	return resized;
+}
+
+// point the VAO at the current buffers
+static void BufferArenaAttach(BufferArena *arena)
+{
+	VertexArrayBind(&arena->vao);
+	VertexArrayPointers(&arena->vao, &arena->vertices);
+	ElementBufferBind(&arena->indices);
+	VertexArrayUnbind(&arena->vao);
+}
+
+BufferArena CreateBufferArena(ShaderElement *elements, unsigned int vertexCapacity, unsigned int indexCapacity)
+{
+	BufferArena arena = { 0 };
+
+	if (!GLEXT_ARB_copy_buffer || !GLEXT_ARB_draw_elements_base_vertex)
+	{
+		fprintf(stderr, "[ERROR]: Buffer arenas need ARB_copy_buffer and ARB_draw_elements_base_vertex.\n");
+		return arena;
+	}
+
+	arena.stride = ShaderElementStride(elements);
+	if (arena.stride == 0)
+	{
+		fprintf(stderr, "[ERROR]: Buffer arena needs a vertex layout.\n");
+		return arena;
+	}
+
+	if (vertexCapacity == 0) vertexCapacity = 1024;
+	if (indexCapacity == 0) indexCapacity = 3 * vertexCapacity;
+
+	arena.vao = CreateVertexArray();
+	arena.vertices.ID = ArenaNewBuffer(vertexCapacity * arena.stride);
+	arena.vertices.elements = elements;
+	arena.indices.ID = ArenaNewBuffer(indexCapacity * sizeof(unsigned int));
+
+	arena.vertexSpace.size = vertexCapacity;
+	arena.indexSpace.size = indexCapacity;
+	ArenaFreeListReset(&arena.vertexSpace, 0);
+	ArenaFreeListReset(&arena.indexSpace, 0);
+
+	BufferArenaAttach(&arena);
+
+	return arena;
+}
+
+// make sure one free range holds vertexCount vertices and another
+// indexCount indices
+static void BufferArenaReserve(BufferArena *arena, unsigned int vertexCount, unsigned int indexCount)
+{
+	ArenaFreeList *vertexSpace = &arena->vertexSpace;
+	ArenaFreeList *indexSpace = &arena->indexSpace;
+
+	bool vertexFits = ArenaFreeListLargest(vertexSpace) >= vertexCount;
+	bool indexFits = ArenaFreeListLargest(indexSpace) >= indexCount;
+
+	if (vertexFits && indexFits)
+		return;
+
+	// the space is there, only scattered
+	if (vertexSpace->size - vertexSpace->used >= vertexCount && indexSpace->size - indexSpace->used >= indexCount)
+	{
+		BufferArenaDefragment(arena);
+		return;
+	}
+
+	if (!vertexFits)
+	{
+		unsigned int size = vertexSpace->size + (vertexCount > vertexSpace->size ? vertexCount : vertexSpace->size);
+
+		arena->vertices.ID = ArenaResizeBuffer(arena->vertices.ID, vertexSpace->size * arena->stride, size * arena->stride);
+		ArenaFreeListInsert(vertexSpace, vertexSpace->size, size - vertexSpace->size);
+		vertexSpace->size = size;
+	}
+
+	if (!indexFits)
+	{
+		unsigned int size = indexSpace->size + (indexCount > indexSpace->size ? indexCount : indexSpace->size);
+
+		arena->indices.ID = ArenaResizeBuffer(arena->indices.ID, indexSpace->size * sizeof(unsigned int), size * sizeof(unsigned int));
+		ArenaFreeListInsert(indexSpace, indexSpace->size, size - indexSpace->size);
+		indexSpace->size = size;
+	}
+
+	BufferArenaAttach(arena);
+}
+
+// returns the mesh index, indices are relative to the mesh's first vertex
+int BufferArenaAddMesh(BufferArena *arena, const void *vertices, unsigned int vertexCount, const unsigned int *indices, unsigned int indexCount)
+{
+	if (vertexCount == 0 || indexCount == 0)
+	{
+		fprintf(stderr, "[ERROR]: Arena meshes need vertices and indices.\n");
+		return -1;
+	}
+
+	BufferArenaReserve(arena, vertexCount, indexCount);
+
+	unsigned int baseVertex, firstIndex;
+	if (!ArenaFreeListAlloc(&arena->vertexSpace, vertexCount, &baseVertex))
+	{
+		fprintf(stderr, "[ERROR]: No arena space for %u vertices.\n", vertexCount);
+		return -1;
+	}
+
+	if (!ArenaFreeListAlloc(&arena->indexSpace, indexCount, &firstIndex))
+	{
+		fprintf(stderr, "[ERROR]: No arena space for %u indices.\n", indexCount);
+		ArenaFreeListFree(&arena->vertexSpace, baseVertex, vertexCount);
+		return -1;
+	}
+
+	size_t mesh = 0;
+	while (mesh < arena->meshCount && arena->meshes[mesh].used) ++mesh;
+
+	if (mesh == arena->meshCapacity)
+	{
+		size_t capacity = arena->meshCapacity ? arena->meshCapacity * 2 : 64;
+
+		ArenaMesh *meshes = realloc(arena->meshes, capacity * sizeof(ArenaMesh));
+		if (meshes == NULL)
+		{
+			fprintf(stderr, "[ERROR]: Failed to grow arena mesh table.\n");
+			ArenaFreeListFree(&arena->vertexSpace, baseVertex, vertexCount);
+			ArenaFreeListFree(&arena->indexSpace, firstIndex, indexCount);
+			return -1;
+		}
+
+		arena->meshes = meshes;
+		arena->meshCapacity = capacity;
+	}
+
+	if (mesh == arena->meshCount) ++arena->meshCount;
+
+	arena->meshes[mesh] = (ArenaMesh) { baseVertex, vertexCount, firstIndex, indexCount, true };
+
+	GLStateBindBuffer(GL_COPY_WRITE_BUFFER, arena->vertices.ID);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, baseVertex * arena->stride, vertexCount * arena->stride, vertices);
+
+	GLStateBindBuffer(GL_COPY_WRITE_BUFFER, arena->indices.ID);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, firstIndex * sizeof(unsigned int), indexCount * sizeof(unsigned int), indices);
+
+	return (int)mesh;
+}
+
+void BufferArenaRemoveMesh(BufferArena *arena, int mesh)
+{
+	if (mesh < 0 || (size_t)mesh >= arena->meshCount || !arena->meshes[mesh].used)
+	{
+		fprintf(stderr, "[ERROR]: Arena mesh %d does not exist.\n", mesh);
+		return;
+	}
+
+	ArenaMesh *m = &arena->meshes[mesh];
+
+	ArenaFreeListFree(&arena->vertexSpace, m->baseVertex, m->vertexCount);
+	ArenaFreeListFree(&arena->indexSpace, m->firstIndex, m->indexCount);
+	m->used = false;
+
+	while (arena->meshCount && !arena->meshes[arena->meshCount - 1].used) --arena->meshCount;
+}
+
+// pack every mesh to the front of fresh buffers, leaving one free range each
+void BufferArenaDefragment(BufferArena *arena)
+{
+	unsigned int vertices = ArenaNewBuffer(arena->vertexSpace.size * arena->stride);
+	unsigned int indices = ArenaNewBuffer(arena->indexSpace.size * sizeof(unsigned int));
+	unsigned int vertexHead = 0, indexHead = 0;
+
+	GLStateBindBuffer(GL_COPY_READ_BUFFER, arena->vertices.ID);
+	GLStateBindBuffer(GL_COPY_WRITE_BUFFER, vertices);
+
+	for (size_t i = 0; i < arena->meshCount; ++i)
+	{
+		ArenaMesh *m = &arena->meshes[i];
+		if (!m->used) continue;
+
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, m->baseVertex * arena->stride, vertexHead * arena->stride, m->vertexCount * arena->stride);
+
+		m->baseVertex = vertexHead;
+		vertexHead += m->vertexCount;
+	}
+
+	GLStateBindBuffer(GL_COPY_READ_BUFFER, arena->indices.ID);
+	GLStateBindBuffer(GL_COPY_WRITE_BUFFER, indices);
+
+	for (size_t i = 0; i < arena->meshCount; ++i)
+	{
+		ArenaMesh *m = &arena->meshes[i];
+		if (!m->used) continue;
+
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, m->firstIndex * sizeof(unsigned int), indexHead * sizeof(unsigned int), m->indexCount * sizeof(unsigned int));
+
+		m->firstIndex = indexHead;
+		indexHead += m->indexCount;
+	}
+
+	GLStateForgetBuffer(arena->vertices.ID);
+	GLStateForgetBuffer(arena->indices.ID);
+	glDeleteBuffers(1, &arena->vertices.ID);
+	glDeleteBuffers(1, &arena->indices.ID);
+	arena->vertices.ID = vertices;
+	arena->indices.ID = indices;
+
+	ArenaFreeListReset(&arena->vertexSpace, vertexHead);
+	ArenaFreeListReset(&arena->indexSpace, indexHead);
+
+	BufferArenaAttach(arena);
+}
+
+void BufferArenaBind(BufferArena *arena)
+{
+	VertexArrayBind(&arena->vao);
+}
+
+// the arena must be bound
+void BufferArenaDraw(BufferArena *arena, int mesh)
+{
+	const ArenaMesh *m = &arena->meshes[mesh];
+
+	glDrawElementsBaseVertex(
+		GL_TRIANGLES,
+		m->indexCount,
+		GL_UNSIGNED_INT,
+		(void*)((size_t)m->firstIndex * sizeof(unsigned int)),
+		m->baseVertex);
+}
+
+// the arena must be bound, per instance buffers are attached to arena->vao
+// with VertexArrayPointers at locations past the vertex layout
+void BufferArenaDrawInstanced(BufferArena *arena, int mesh, unsigned int instanceCount)
+{
+	static bool reported = false;
+
+	if (!GLEXT_ARB_draw_instanced)
+	{
+		if (!reported)
+			fprintf(stderr, "[ERROR]: Instanced draws need ARB_draw_instanced.\n");
+
+		reported = true;
+		return;
+	}
+
+	const ArenaMesh *m = &arena->meshes[mesh];
+
+	glDrawElementsInstancedBaseVertex(
+		GL_TRIANGLES,
+		m->indexCount,
+		GL_UNSIGNED_INT,
+		(void*)((size_t)m->firstIndex * sizeof(unsigned int)),
+		instanceCount,
+		m->baseVertex);
+}
+
+void DeleteBufferArena(BufferArena *arena)
+{
+	GLStateForgetBuffer(arena->vertices.ID);
+	GLStateForgetBuffer(arena->indices.ID);
+	glDeleteBuffers(1, &arena->vertices.ID);
+	glDeleteBuffers(1, &arena->indices.ID);
+	GLStateForgetVertexArray(arena->vao.ID);
+	glDeleteVertexArrays(1, &arena->vao.ID);
+
+	free(arena->vertexSpace.ranges);
+	free(arena->indexSpace.ranges);
+	free(arena->meshes);
+
+	*arena = (BufferArena) { 0 };
+}
@@ -0,0 +1,66 @@
+#ifndef __BUFFER_ARENA_H__
+#define __BUFFER_ARENA_H__
+
+#include "Graphic.h"
+
+/*
+	Many meshes in one vertex buffer and one element buffer.
+
+	All meshes of an arena share the vertex layout and a single VAO, so
+	drawing a different mesh is only a different glDrawElementsBaseVertex:
+	indices stay relative to the mesh and GL adds baseVertex.
+
+	Vertex and index space are handed out by a best-fit free list (in
+	vertices and indices, not bytes). Removing a mesh returns its ranges and
+	merges them with free neighbours. When no free range is big enough the
+	arena defragments if the total free space would do, otherwise it grows
+	the buffer; both copy on the GPU. Meshes are referred to by index, their
+	ranges may move when the arena defragments or grows.
+*/
+
+typedef struct ArenaRange {
+	unsigned int offset;
+	unsigned int size;
+} ArenaRange;
+
+// free ranges of one buffer, sorted by offset, never touching each other
+typedef struct ArenaFreeList {
+	ArenaRange *ranges;
+	size_t count;
+	size_t capacity;
+	unsigned int size;
+	unsigned int used;
+} ArenaFreeList;
+
+typedef struct ArenaMesh {
+	unsigned int baseVertex;
+	unsigned int vertexCount;
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	bool used;
+} ArenaMesh;
+
+typedef struct BufferArena {
+	VertexArray vao;
+	VertexBuffer vertices;
+	ElementBuffer indices;
+	size_t stride;
+
+	ArenaFreeList vertexSpace;
+	ArenaFreeList indexSpace;
+
+	ArenaMesh *meshes;
+	size_t meshCount;
+	size_t meshCapacity;
+} BufferArena;
+
+BufferArena CreateBufferArena(ShaderElement *elements, unsigned int vertexCapacity, unsigned int indexCapacity);
+int BufferArenaAddMesh(BufferArena *arena, const void *vertices, unsigned int vertexCount, const unsigned int *indices, unsigned int indexCount);
+void BufferArenaRemoveMesh(BufferArena *arena, int mesh);
+void BufferArenaDefragment(BufferArena *arena);
+void BufferArenaBind(BufferArena *arena);
+void BufferArenaDraw(BufferArena *arena, int mesh);
+void BufferArenaDrawInstanced(BufferArena *arena, int mesh, unsigned int instanceCount);
+void DeleteBufferArena(BufferArena *arena);
+
+#endif // __BUFFER_ARENA_H__
@@ -0,0 +1,194 @@
+#include <string.h>
+
+#include "GLExt.h"
+
+int GLEXT_ARB_sync = 0;
+PFNGLFENCESYNCPROC glext_glFenceSync = NULL;
+PFNGLDELETESYNCPROC glext_glDeleteSync = NULL;
+PFNGLCLIENTWAITSYNCPROC glext_glClientWaitSync = NULL;
+
+int GLEXT_ARB_buffer_storage = 0;
+PFNGLBUFFERSTORAGEPROC glext_glBufferStorage = NULL;
+
+int GLEXT_ARB_copy_buffer = 0;
+PFNGLCOPYBUFFERSUBDATAPROC glext_glCopyBufferSubData = NULL;
+
+int GLEXT_ARB_draw_elements_base_vertex = 0;
+PFNGLDRAWELEMENTSBASEVERTEXPROC glext_glDrawElementsBaseVertex = NULL;
+PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC glext_glDrawElementsInstancedBaseVertex = NULL;
+
+int GLEXT_ARB_draw_instanced = 0;
+PFNGLDRAWARRAYSINSTANCEDPROC glext_glDrawArraysInstanced = NULL;
+PFNGLDRAWELEMENTSINSTANCEDPROC glext_glDrawElementsInstanced = NULL;
+
+int GLEXT_ARB_instanced_arrays = 0;
+PFNGLVERTEXATTRIBDIVISORPROC glext_glVertexAttribDivisor = NULL;
+
+int GLEXT_ARB_uniform_buffer_object = 0;
+PFNGLGETUNIFORMBLOCKINDEXPROC glext_glGetUniformBlockIndex = NULL;
+PFNGLUNIFORMBLOCKBINDINGPROC glext_glUniformBlockBinding = NULL;
+PFNGLGETACTIVEUNIFORMBLOCKIVPROC glext_glGetActiveUniformBlockiv = NULL;
+PFNGLGETACTIVEUNIFORMBLOCKNAMEPROC glext_glGetActiveUniformBlockName = NULL;
+PFNGLGETUNIFORMINDICESPROC glext_glGetUniformIndices = NULL;
+PFNGLGETACTIVEUNIFORMSIVPROC glext_glGetActiveUniformsiv = NULL;
+
+int GLEXT_ARB_get_program_binary = 0;
+PFNGLGETPROGRAMBINARYPROC glext_glGetProgramBinary = NULL;
+PFNGLPROGRAMBINARYPROC glext_glProgramBinary = NULL;
+PFNGLPROGRAMPARAMETERIPROC glext_glProgramParameteri = NULL;
+
+int GLEXT_KHR_parallel_shader_compile = 0;
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glext_glMaxShaderCompilerThreadsKHR = NULL;
+
+int GLExtHasExtension(const char *name)
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+	for (GLint i = 0; i < count; ++i)
+	{
+		const char *extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		if (extension && strcmp(extension, name) == 0)
+			return 1;
+	}
+
+	return 0;
+}
+
+int GLExtHasVersion(int major, int minor)
+{
+	GLint contextMajor = 0, contextMinor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+	glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+
+	return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
+
+static void GLExtLoadSync(GLADloadproc load)
+{
+	if (!GLExtHasVersion(3, 2) && !GLExtHasExtension("GL_ARB_sync"))
+		return;
+
+	glext_glFenceSync = (PFNGLFENCESYNCPROC)load("glFenceSync");
+	glext_glDeleteSync = (PFNGLDELETESYNCPROC)load("glDeleteSync");
+	glext_glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)load("glClientWaitSync");
+
+	GLEXT_ARB_sync = glext_glFenceSync && glext_glDeleteSync && glext_glClientWaitSync;
+}
+
+static void GLExtLoadBufferStorage(GLADloadproc load)
+{
+	if (!GLExtHasVersion(4, 4) && !GLExtHasExtension("GL_ARB_buffer_storage"))
+		return;
+
+	glext_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+
+	GLEXT_ARB_buffer_storage = glext_glBufferStorage != NULL;
+}
+
+static void GLExtLoadCopyBuffer(GLADloadproc load)
+{
+	if (!GLExtHasVersion(3, 1) && !GLExtHasExtension("GL_ARB_copy_buffer"))
+		return;
+
+	glext_glCopyBufferSubData = (PFNGLCOPYBUFFERSUBDATAPROC)load("glCopyBufferSubData");
+
+	GLEXT_ARB_copy_buffer = glext_glCopyBufferSubData != NULL;
+}
+
+static void GLExtLoadDrawElementsBaseVertex(GLADloadproc load)
+{
+	if (!GLExtHasVersion(3, 2) && !GLExtHasExtension("GL_ARB_draw_elements_base_vertex"))
+		return;
+
+	glext_glDrawElementsBaseVertex = (PFNGLDRAWELEMENTSBASEVERTEXPROC)load("glDrawElementsBaseVertex");
+	glext_glDrawElementsInstancedBaseVertex = (PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC)load("glDrawElementsInstancedBaseVertex");
+
+	GLEXT_ARB_draw_elements_base_vertex = glext_glDrawElementsBaseVertex && glext_glDrawElementsInstancedBaseVertex;
+}
+
+static void GLExtLoadDrawInstanced(GLADloadproc load)
+{
+	if (!GLExtHasVersion(3, 1) && !GLExtHasExtension("GL_ARB_draw_instanced"))
+		return;
+
+	glext_glDrawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDPROC)load("glDrawArraysInstanced");
+	glext_glDrawElementsInstanced = (PFNGLDRAWELEMENTSINSTANCEDPROC)load("glDrawElementsInstanced");
+
+	GLEXT_ARB_draw_instanced = glext_glDrawArraysInstanced && glext_glDrawElementsInstanced;
+}
+
+static void GLExtLoadInstancedArrays(GLADloadproc load)
+{
+	if (!GLExtHasVersion(3, 3) && !GLExtHasExtension("GL_ARB_instanced_arrays"))
+		return;
+
+	glext_glVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC)load("glVertexAttribDivisor");
+
+	GLEXT_ARB_instanced_arrays = glext_glVertexAttribDivisor != NULL;
+}
+
+static void GLExtLoadUniformBufferObject(GLADloadproc load)
+{
+	if (!GLExtHasVersion(3, 1) && !GLExtHasExtension("GL_ARB_uniform_buffer_object"))
+		return;
+
+	glext_glGetUniformBlockIndex = (PFNGLGETUNIFORMBLOCKINDEXPROC)load("glGetUniformBlockIndex");
+	glext_glUniformBlockBinding = (PFNGLUNIFORMBLOCKBINDINGPROC)load("glUniformBlockBinding");
+	glext_glGetActiveUniformBlockiv = (PFNGLGETACTIVEUNIFORMBLOCKIVPROC)load("glGetActiveUniformBlockiv");
+	glext_glGetActiveUniformBlockName = (PFNGLGETACTIVEUNIFORMBLOCKNAMEPROC)load("glGetActiveUniformBlockName");
+	glext_glGetUniformIndices = (PFNGLGETUNIFORMINDICESPROC)load("glGetUniformIndices");
+	glext_glGetActiveUniformsiv = (PFNGLGETACTIVEUNIFORMSIVPROC)load("glGetActiveUniformsiv");
+
+	GLEXT_ARB_uniform_buffer_object = glext_glGetUniformBlockIndex && glext_glUniformBlockBinding
+		&& glext_glGetActiveUniformBlockiv && glext_glGetActiveUniformBlockName
+		&& glext_glGetUniformIndices && glext_glGetActiveUniformsiv;
+}
+
+static void GLExtLoadGetProgramBinary(GLADloadproc load)
+{
+	if (!GLExtHasVersion(4, 1) && !GLExtHasExtension("GL_ARB_get_program_binary"))
+		return;
+
+	glext_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+	glext_glProgramBinary = (PFNGLPROGRAMBINARYPROC)load("glProgramBinary");
+	glext_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+
+	// the extension may be there with nothing to save programs in
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+	GLEXT_ARB_get_program_binary = glext_glGetProgramBinary && glext_glProgramBinary
+		&& glext_glProgramParameteri && formats > 0;
+}
+
+static void GLExtLoadParallelShaderCompile(GLADloadproc load)
+{
+	if (GLExtHasExtension("GL_KHR_parallel_shader_compile"))
+		glext_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+	else if (GLExtHasExtension("GL_ARB_parallel_shader_compile"))
+		glext_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsARB");
+
+	GLEXT_KHR_parallel_shader_compile = glext_glMaxShaderCompilerThreadsKHR != NULL;
+}
+
+int GLExtLoad(GLADloadproc load)
+{
+	if (glGetIntegerv == NULL || glGetStringi == NULL)
+	{
+		fprintf(stderr, "[ERROR]: Load glad before the GL extensions.\n");
+		return 0;
+	}
+
+	GLExtLoadSync(load);
+	GLExtLoadBufferStorage(load);
+	GLExtLoadCopyBuffer(load);
+	GLExtLoadDrawElementsBaseVertex(load);
+	GLExtLoadDrawInstanced(load);
+	GLExtLoadInstancedArrays(load);
+	GLExtLoadUniformBufferObject(load);
+	GLExtLoadGetProgramBinary(load);
+	GLExtLoadParallelShaderCompile(load);
+
+	return 1;
+}
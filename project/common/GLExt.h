@@ -0,0 +1,188 @@
+#ifndef __GLEXT_H__
+#define __GLEXT_H__
+
+#include "common.h"
+
+/*
+	OpenGL entry points newer than the bundled glad loader (GL 3.0).
+
+	GLExtLoad is called by InitWindow once the context is current. Like glad,
+	every function is a pointer named glext_<name> with a macro mapping the
+	plain GL name to it, and every group has a flag saying whether the
+	context provides it (core version or extension). A group that is missing
+	leaves its pointers NULL.
+*/
+
+/* ARB_sync (core 3.2) */
+
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_CONDITION_SATISFIED 0x911C
+#define GL_WAIT_FAILED 0x911D
+#define GL_TIMEOUT_IGNORED 0xFFFFFFFFFFFFFFFFull
+
+typedef GLsync (APIENTRYP PFNGLFENCESYNCPROC)(GLenum condition, GLbitfield flags);
+typedef void (APIENTRYP PFNGLDELETESYNCPROC)(GLsync sync);
+typedef GLenum (APIENTRYP PFNGLCLIENTWAITSYNCPROC)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+
+extern int GLEXT_ARB_sync;
+extern PFNGLFENCESYNCPROC glext_glFenceSync;
+extern PFNGLDELETESYNCPROC glext_glDeleteSync;
+extern PFNGLCLIENTWAITSYNCPROC glext_glClientWaitSync;
+
+#define glFenceSync glext_glFenceSync
+#define glDeleteSync glext_glDeleteSync
+#define glClientWaitSync glext_glClientWaitSync
+
+/* ARB_buffer_storage (core 4.4) */
+
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
+extern int GLEXT_ARB_buffer_storage;
+extern PFNGLBUFFERSTORAGEPROC glext_glBufferStorage;
+
+#define glBufferStorage glext_glBufferStorage
+
+/* ARB_copy_buffer (core 3.1) */
+
+#define GL_COPY_READ_BUFFER 0x8F36
+#define GL_COPY_WRITE_BUFFER 0x8F37
+
+typedef void (APIENTRYP PFNGLCOPYBUFFERSUBDATAPROC)(GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size);
+
+extern int GLEXT_ARB_copy_buffer;
+extern PFNGLCOPYBUFFERSUBDATAPROC glext_glCopyBufferSubData;
+
+#define glCopyBufferSubData glext_glCopyBufferSubData
+
+/* ARB_draw_elements_base_vertex (core 3.2) */
+
+typedef void (APIENTRYP PFNGLDRAWELEMENTSBASEVERTEXPROC)(GLenum mode, GLsizei count, GLenum type, const void *indices, GLint basevertex);
+typedef void (APIENTRYP PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC)(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount, GLint basevertex);
+
+extern int GLEXT_ARB_draw_elements_base_vertex;
+extern PFNGLDRAWELEMENTSBASEVERTEXPROC glext_glDrawElementsBaseVertex;
+extern PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC glext_glDrawElementsInstancedBaseVertex;
+
+#define glDrawElementsBaseVertex glext_glDrawElementsBaseVertex
+#define glDrawElementsInstancedBaseVertex glext_glDrawElementsInstancedBaseVertex
+
+/* ARB_draw_instanced (core 3.1) */
+
+typedef void (APIENTRYP PFNGLDRAWARRAYSINSTANCEDPROC)(GLenum mode, GLint first, GLsizei count, GLsizei instancecount);
+typedef void (APIENTRYP PFNGLDRAWELEMENTSINSTANCEDPROC)(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount);
+
+extern int GLEXT_ARB_draw_instanced;
+extern PFNGLDRAWARRAYSINSTANCEDPROC glext_glDrawArraysInstanced;
+extern PFNGLDRAWELEMENTSINSTANCEDPROC glext_glDrawElementsInstanced;
+
+#define glDrawArraysInstanced glext_glDrawArraysInstanced
+#define glDrawElementsInstanced glext_glDrawElementsInstanced
+
+/* ARB_instanced_arrays (core 3.3) */
+
+typedef void (APIENTRYP PFNGLVERTEXATTRIBDIVISORPROC)(GLuint index, GLuint divisor);
+
+extern int GLEXT_ARB_instanced_arrays;
+extern PFNGLVERTEXATTRIBDIVISORPROC glext_glVertexAttribDivisor;
+
+#define glVertexAttribDivisor glext_glVertexAttribDivisor
+
+/* ARB_uniform_buffer_object (core 3.1), glBindBufferRange and glBindBufferBase are in glad */
+
+#define GL_UNIFORM_BUFFER 0x8A11
+#define GL_UNIFORM_BUFFER_BINDING 0x8A28
+#define GL_UNIFORM_BUFFER_START 0x8A29
+#define GL_UNIFORM_BUFFER_SIZE 0x8A2A
+#define GL_MAX_UNIFORM_BUFFER_BINDINGS 0x8A2F
+#define GL_MAX_UNIFORM_BLOCK_SIZE 0x8A30
+#define GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 0x8A34
+#define GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH 0x8A35
+#define GL_ACTIVE_UNIFORM_BLOCKS 0x8A36
+#define GL_UNIFORM_TYPE 0x8A37
+#define GL_UNIFORM_SIZE 0x8A38
+#define GL_UNIFORM_NAME_LENGTH 0x8A39
+#define GL_UNIFORM_BLOCK_INDEX 0x8A3A
+#define GL_UNIFORM_OFFSET 0x8A3B
+#define GL_UNIFORM_ARRAY_STRIDE 0x8A3C
+#define GL_UNIFORM_MATRIX_STRIDE 0x8A3D
+#define GL_UNIFORM_IS_ROW_MAJOR 0x8A3E
+#define GL_UNIFORM_BLOCK_BINDING 0x8A3F
+#define GL_UNIFORM_BLOCK_DATA_SIZE 0x8A40
+#define GL_UNIFORM_BLOCK_NAME_LENGTH 0x8A41
+#define GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS 0x8A42
+#define GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES 0x8A43
+#define GL_INVALID_INDEX 0xFFFFFFFFu
+
+typedef GLuint (APIENTRYP PFNGLGETUNIFORMBLOCKINDEXPROC)(GLuint program, const GLchar *uniformBlockName);
+typedef void (APIENTRYP PFNGLUNIFORMBLOCKBINDINGPROC)(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding);
+typedef void (APIENTRYP PFNGLGETACTIVEUNIFORMBLOCKIVPROC)(GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint *params);
+typedef void (APIENTRYP PFNGLGETACTIVEUNIFORMBLOCKNAMEPROC)(GLuint program, GLuint uniformBlockIndex, GLsizei bufSize, GLsizei *length, GLchar *uniformBlockName);
+typedef void (APIENTRYP PFNGLGETUNIFORMINDICESPROC)(GLuint program, GLsizei uniformCount, const GLchar *const *uniformNames, GLuint *uniformIndices);
+typedef void (APIENTRYP PFNGLGETACTIVEUNIFORMSIVPROC)(GLuint program, GLsizei uniformCount, const GLuint *uniformIndices, GLenum pname, GLint *params);
+
+extern int GLEXT_ARB_uniform_buffer_object;
+extern PFNGLGETUNIFORMBLOCKINDEXPROC glext_glGetUniformBlockIndex;
+extern PFNGLUNIFORMBLOCKBINDINGPROC glext_glUniformBlockBinding;
+extern PFNGLGETACTIVEUNIFORMBLOCKIVPROC glext_glGetActiveUniformBlockiv;
+extern PFNGLGETACTIVEUNIFORMBLOCKNAMEPROC glext_glGetActiveUniformBlockName;
+extern PFNGLGETUNIFORMINDICESPROC glext_glGetUniformIndices;
+extern PFNGLGETACTIVEUNIFORMSIVPROC glext_glGetActiveUniformsiv;
+
+#define glGetUniformBlockIndex glext_glGetUniformBlockIndex
+#define glUniformBlockBinding glext_glUniformBlockBinding
+#define glGetActiveUniformBlockiv glext_glGetActiveUniformBlockiv
+#define glGetActiveUniformBlockName glext_glGetActiveUniformBlockName
+#define glGetUniformIndices glext_glGetUniformIndices
+#define glGetActiveUniformsiv glext_glGetActiveUniformsiv
+
+/* ARB_get_program_binary (core 4.1) */
+
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+// also 0 when the driver offers no binary format
+extern int GLEXT_ARB_get_program_binary;
+extern PFNGLGETPROGRAMBINARYPROC glext_glGetProgramBinary;
+extern PFNGLPROGRAMBINARYPROC glext_glProgramBinary;
+extern PFNGLPROGRAMPARAMETERIPROC glext_glProgramParameteri;
+
+#define glGetProgramBinary glext_glGetProgramBinary
+#define glProgramBinary glext_glProgramBinary
+#define glProgramParameteri glext_glProgramParameteri
+
+/* KHR_parallel_shader_compile, or the ARB one of the same values */
+
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+extern int GLEXT_KHR_parallel_shader_compile;
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glext_glMaxShaderCompilerThreadsKHR;
+
+#define glMaxShaderCompilerThreadsKHR glext_glMaxShaderCompilerThreadsKHR
+
+// load the entry points of the current context, returns 0 without a context
+int GLExtLoad(GLADloadproc load);
+
+// 1 if the current context reports the extension
+int GLExtHasExtension(const char *name);
+
+// 1 if the current context is at least version major.minor
+int GLExtHasVersion(int major, int minor);
+
+#endif // __GLEXT_H__
@@ -0,0 +1,366 @@
+#include <string.h>
+
+#include "GLState.h"
+#include "GLExt.h"
+
+enum {
+	KNOWN_PROGRAM = 1 << 0,
+	KNOWN_VERTEX_ARRAY = 1 << 1,
+	KNOWN_ACTIVE_TEXTURE = 1 << 2,
+	KNOWN_BLEND_FUNC = 1 << 3,
+	KNOWN_DEPTH_FUNC = 1 << 4,
+	KNOWN_DEPTH_MASK = 1 << 5,
+	KNOWN_VIEWPORT = 1 << 6
+};
+
+static const unsigned int glStateBufferTargets[] = {
+	GL_ARRAY_BUFFER,
+	GL_ELEMENT_ARRAY_BUFFER,
+	GL_COPY_READ_BUFFER,
+	GL_COPY_WRITE_BUFFER
+};
+
+#define GLSTATE_BUFFER_TARGETS (sizeof(glStateBufferTargets) / sizeof(glStateBufferTargets[0]))
+#define GLSTATE_ELEMENT_TARGET 1
+
+static const unsigned int glStateCapabilities[] = {
+	GL_BLEND,
+	GL_DEPTH_TEST,
+	GL_CULL_FACE,
+	GL_SCISSOR_TEST
+};
+
+#define GLSTATE_CAPABILITIES (sizeof(glStateCapabilities) / sizeof(glStateCapabilities[0]))
+
+// zero means nothing is known, which is also the state before the first call
+static struct {
+	unsigned int known;
+	unsigned int knownBuffers;      // bit per glStateBufferTargets entry
+	unsigned int knownTextures;     // bit per unit
+	unsigned int knownRanges;       // bit per uniform buffer binding
+	unsigned int knownCapabilities; // bit per glStateCapabilities entry
+	unsigned int enabledCapabilities;
+
+	unsigned int program;
+	unsigned int vertexArray;
+	unsigned int buffers[GLSTATE_BUFFER_TARGETS];
+	struct { unsigned int buffer; size_t offset, size; } ranges[GLSTATE_UNIFORM_BINDINGS];
+	unsigned int activeTexture;
+	unsigned int textureTargets[GLSTATE_TEXTURE_UNITS];
+	unsigned int textures[GLSTATE_TEXTURE_UNITS];
+	unsigned int blendSource, blendDestination;
+	unsigned int depthFunc;
+	bool depthMask;
+	int viewport[4];
+
+	GLStateStats stats;
+} glState;
+
+static inline void GLStateIssued(GLStateCall call)
+{
+	++glState.stats.issued[call];
+	++glState.stats.issuedTotal;
+}
+
+static inline void GLStateSkipped(GLStateCall call)
+{
+	++glState.stats.skipped[call];
+	++glState.stats.skippedTotal;
+}
+
+void GLStateInvalidate(void)
+{
+	GLStateStats stats = glState.stats;
+
+	memset(&glState, 0, sizeof(glState));
+	glState.stats = stats;
+}
+
+void GLStateUseProgram(unsigned int program)
+{
+	if ((glState.known & KNOWN_PROGRAM) && glState.program == program)
+	{
+		GLStateSkipped(GLSTATE_CALL_PROGRAM);
+		return;
+	}
+
+	glUseProgram(program);
+	GLStateIssued(GLSTATE_CALL_PROGRAM);
+
+	glState.program = program;
+	glState.known |= KNOWN_PROGRAM;
+}
+
+void GLStateBindVertexArray(unsigned int vertexArray)
+{
+	if ((glState.known & KNOWN_VERTEX_ARRAY) && glState.vertexArray == vertexArray)
+	{
+		GLStateSkipped(GLSTATE_CALL_VERTEX_ARRAY);
+		return;
+	}
+
+	glBindVertexArray(vertexArray);
+	GLStateIssued(GLSTATE_CALL_VERTEX_ARRAY);
+
+	glState.vertexArray = vertexArray;
+	glState.known |= KNOWN_VERTEX_ARRAY;
+
+	// each vertex array has its own element buffer
+	glState.knownBuffers &= ~(1u << GLSTATE_ELEMENT_TARGET);
+}
+
+static int GLStateBufferTarget(unsigned int target)
+{
+	for (size_t i = 0; i < GLSTATE_BUFFER_TARGETS; ++i)
+		if (glStateBufferTargets[i] == target) return (int)i;
+
+	return -1;
+}
+
+void GLStateBindBuffer(unsigned int target, unsigned int buffer)
+{
+	int slot = GLStateBufferTarget(target);
+
+	if (slot >= 0 && (glState.knownBuffers & (1u << slot)) && glState.buffers[slot] == buffer)
+	{
+		GLStateSkipped(GLSTATE_CALL_BUFFER);
+		return;
+	}
+
+	glBindBuffer(target, buffer);
+	GLStateIssued(GLSTATE_CALL_BUFFER);
+
+	if (slot < 0)
+		return;
+
+	glState.buffers[slot] = buffer;
+	glState.knownBuffers |= 1u << slot;
+}
+
+void GLStateBindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, size_t offset, size_t size)
+{
+	bool tracked = target == GL_UNIFORM_BUFFER && index < GLSTATE_UNIFORM_BINDINGS;
+
+	if (tracked && (glState.knownRanges & (1u << index)) && glState.ranges[index].buffer == buffer
+		&& glState.ranges[index].offset == offset && glState.ranges[index].size == size)
+	{
+		GLStateSkipped(GLSTATE_CALL_BUFFER_RANGE);
+		return;
+	}
+
+	glBindBufferRange(target, index, buffer, (GLintptr)offset, (GLsizeiptr)size);
+	GLStateIssued(GLSTATE_CALL_BUFFER_RANGE);
+
+	if (!tracked)
+		return;
+
+	glState.ranges[index].buffer = buffer;
+	glState.ranges[index].offset = offset;
+	glState.ranges[index].size = size;
+	glState.knownRanges |= 1u << index;
+}
+
+void GLStateActiveTexture(unsigned int unit)
+{
+	if ((glState.known & KNOWN_ACTIVE_TEXTURE) && glState.activeTexture == unit)
+	{
+		GLStateSkipped(GLSTATE_CALL_ACTIVE_TEXTURE);
+		return;
+	}
+
+	glActiveTexture(GL_TEXTURE0 + unit);
+	GLStateIssued(GLSTATE_CALL_ACTIVE_TEXTURE);
+
+	glState.activeTexture = unit;
+	glState.known |= KNOWN_ACTIVE_TEXTURE;
+}
+
+void GLStateBindTexture(unsigned int unit, unsigned int target, unsigned int texture)
+{
+	if (unit >= GLSTATE_TEXTURE_UNITS)
+	{
+		GLStateActiveTexture(unit);
+		glBindTexture(target, texture);
+		GLStateIssued(GLSTATE_CALL_TEXTURE);
+		return;
+	}
+
+	if ((glState.knownTextures & (1u << unit)) && glState.textureTargets[unit] == target && glState.textures[unit] == texture)
+	{
+		GLStateSkipped(GLSTATE_CALL_TEXTURE);
+		return;
+	}
+
+	GLStateActiveTexture(unit);
+	glBindTexture(target, texture);
+	GLStateIssued(GLSTATE_CALL_TEXTURE);
+
+	glState.textureTargets[unit] = target;
+	glState.textures[unit] = texture;
+	glState.knownTextures |= 1u << unit;
+}
+
+static int GLStateCapability(unsigned int capability)
+{
+	for (size_t i = 0; i < GLSTATE_CAPABILITIES; ++i)
+		if (glStateCapabilities[i] == capability) return (int)i;
+
+	return -1;
+}
+
+static void GLStateSetCapability(unsigned int capability, bool enable)
+{
+	int slot = GLStateCapability(capability);
+
+	if (slot >= 0 && (glState.knownCapabilities & (1u << slot)) && ((glState.enabledCapabilities >> slot) & 1) == enable)
+	{
+		GLStateSkipped(GLSTATE_CALL_CAPABILITY);
+		return;
+	}
+
+	if (enable) glEnable(capability);
+	else glDisable(capability);
+	GLStateIssued(GLSTATE_CALL_CAPABILITY);
+
+	if (slot < 0)
+		return;
+
+	glState.knownCapabilities |= 1u << slot;
+	if (enable) glState.enabledCapabilities |= 1u << slot;
+	else glState.enabledCapabilities &= ~(1u << slot);
+}
+
+void GLStateEnable(unsigned int capability)
+{
+	GLStateSetCapability(capability, true);
+}
+
+void GLStateDisable(unsigned int capability)
+{
+	GLStateSetCapability(capability, false);
+}
+
+void GLStateBlendFunc(unsigned int source, unsigned int destination)
+{
+	if ((glState.known & KNOWN_BLEND_FUNC) && glState.blendSource == source && glState.blendDestination == destination)
+	{
+		GLStateSkipped(GLSTATE_CALL_BLEND_FUNC);
+		return;
+	}
+
+	glBlendFunc(source, destination);
+	GLStateIssued(GLSTATE_CALL_BLEND_FUNC);
+
+	glState.blendSource = source;
+	glState.blendDestination = destination;
+	glState.known |= KNOWN_BLEND_FUNC;
+}
+
+void GLStateDepthFunc(unsigned int func)
+{
+	if ((glState.known & KNOWN_DEPTH_FUNC) && glState.depthFunc == func)
+	{
+		GLStateSkipped(GLSTATE_CALL_DEPTH_FUNC);
+		return;
+	}
+
+	glDepthFunc(func);
+	GLStateIssued(GLSTATE_CALL_DEPTH_FUNC);
+
+	glState.depthFunc = func;
+	glState.known |= KNOWN_DEPTH_FUNC;
+}
+
+void GLStateDepthMask(bool write)
+{
+	if ((glState.known & KNOWN_DEPTH_MASK) && glState.depthMask == write)
+	{
+		GLStateSkipped(GLSTATE_CALL_DEPTH_MASK);
+		return;
+	}
+
+	glDepthMask(write ? GL_TRUE : GL_FALSE);
+	GLStateIssued(GLSTATE_CALL_DEPTH_MASK);
+
+	glState.depthMask = write;
+	glState.known |= KNOWN_DEPTH_MASK;
+}
+
+void GLStateViewport(int x, int y, int width, int height)
+{
+	int *v = glState.viewport;
+
+	if ((glState.known & KNOWN_VIEWPORT) && v[0] == x && v[1] == y && v[2] == width && v[3] == height)
+	{
+		GLStateSkipped(GLSTATE_CALL_VIEWPORT);
+		return;
+	}
+
+	glViewport(x, y, width, height);
+	GLStateIssued(GLSTATE_CALL_VIEWPORT);
+
+	v[0] = x;
+	v[1] = y;
+	v[2] = width;
+	v[3] = height;
+	glState.known |= KNOWN_VIEWPORT;
+}
+
+void GLStateForgetProgram(unsigned int program)
+{
+	if (glState.program == program)
+		glState.known &= ~KNOWN_PROGRAM;
+}
+
+void GLStateForgetVertexArray(unsigned int vertexArray)
+{
+	if (glState.vertexArray != vertexArray)
+		return;
+
+	glState.known &= ~KNOWN_VERTEX_ARRAY;
+	glState.knownBuffers &= ~(1u << GLSTATE_ELEMENT_TARGET);
+}
+
+void GLStateForgetBuffer(unsigned int buffer)
+{
+	for (size_t i = 0; i < GLSTATE_BUFFER_TARGETS; ++i)
+		if (glState.buffers[i] == buffer) glState.knownBuffers &= ~(1u << i);
+
+	for (unsigned int index = 0; index < GLSTATE_UNIFORM_BINDINGS; ++index)
+		if (glState.ranges[index].buffer == buffer) glState.knownRanges &= ~(1u << index);
+}
+
+void GLStateForgetTexture(unsigned int texture)
+{
+	for (unsigned int unit = 0; unit < GLSTATE_TEXTURE_UNITS; ++unit)
+		if (glState.textures[unit] == texture) glState.knownTextures &= ~(1u << unit);
+}
+
+GLStateStats GLStateGetStats(void)
+{
+	return glState.stats;
+}
+
+void GLStateResetStats(void)
+{
+	memset(&glState.stats, 0, sizeof(glState.stats));
+}
+
+const char *GLStateCallName(GLStateCall call)
+{
+	switch (call)
+	{
+		case GLSTATE_CALL_PROGRAM: return "program";
+		case GLSTATE_CALL_VERTEX_ARRAY: return "vertex array";
+		case GLSTATE_CALL_BUFFER: return "buffer";
+		case GLSTATE_CALL_BUFFER_RANGE: return "buffer range";
+		case GLSTATE_CALL_ACTIVE_TEXTURE: return "active texture";
+		case GLSTATE_CALL_TEXTURE: return "texture";
+		case GLSTATE_CALL_CAPABILITY: return "enable";
+		case GLSTATE_CALL_BLEND_FUNC: return "blend func";
+		case GLSTATE_CALL_DEPTH_FUNC: return "depth func";
+		case GLSTATE_CALL_DEPTH_MASK: return "depth mask";
+		case GLSTATE_CALL_VIEWPORT: return "viewport";
+		default: return "unknown";
+	}
+}
@@ -0,0 +1,90 @@
+#ifndef __GLSTATE_H__
+#define __GLSTATE_H__
+
+#include "common.h"
+
+/*
+	Shadow copy of the GL state the engine changes most: program, vertex
+	array, buffer bindings, texture units, blend / depth state and viewport.
+
+	Every GLState call compares against the shadow copy and only reaches GL
+	when the value changes. Nothing is assumed about a fresh context, the
+	first call for each state always goes through. Code that changes this
+	state with raw GL calls must call GLStateInvalidate afterwards, and
+	deleting an object must go through the GLStateForget functions so a
+	recycled name is not mistaken for the bound one.
+
+	Every call issued and every call skipped is counted per kind until
+	GLStateResetStats, so a frame can report how much was saved.
+*/
+
+#define GLSTATE_TEXTURE_UNITS 32
+#define GLSTATE_UNIFORM_BINDINGS 16
+
+typedef enum {
+	GLSTATE_CALL_PROGRAM,
+	GLSTATE_CALL_VERTEX_ARRAY,
+	GLSTATE_CALL_BUFFER,
+	GLSTATE_CALL_BUFFER_RANGE,
+	GLSTATE_CALL_ACTIVE_TEXTURE,
+	GLSTATE_CALL_TEXTURE,
+	GLSTATE_CALL_CAPABILITY,
+	GLSTATE_CALL_BLEND_FUNC,
+	GLSTATE_CALL_DEPTH_FUNC,
+	GLSTATE_CALL_DEPTH_MASK,
+	GLSTATE_CALL_VIEWPORT,
+	GLSTATE_CALL_COUNT
+} GLStateCall;
+
+typedef struct GLStateStats {
+	unsigned int issued[GLSTATE_CALL_COUNT];
+	unsigned int skipped[GLSTATE_CALL_COUNT];
+	unsigned int issuedTotal;
+	unsigned int skippedTotal;
+} GLStateStats;
+
+// forget everything, the next call for every state reaches GL
+void GLStateInvalidate(void);
+
+// glUseProgram
+void GLStateUseProgram(unsigned int program);
+
+// glBindVertexArray, the element buffer binding belongs to the vertex array
+void GLStateBindVertexArray(unsigned int vertexArray);
+
+// glBindBuffer, array, element and copy targets are tracked
+void GLStateBindBuffer(unsigned int target, unsigned int buffer);
+
+// glBindBufferRange, the first GLSTATE_UNIFORM_BINDINGS uniform buffer bindings
+// are tracked. It also binds the generic target, which is not tracked.
+void GLStateBindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, size_t offset, size_t size);
+
+// glActiveTexture with a unit index (0 for GL_TEXTURE0)
+void GLStateActiveTexture(unsigned int unit);
+
+// bind texture to unit, the active unit only changes when the binding does
+void GLStateBindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+
+// glEnable / glDisable, blend, depth test, cull face and scissor test are tracked
+void GLStateEnable(unsigned int capability);
+void GLStateDisable(unsigned int capability);
+
+void GLStateBlendFunc(unsigned int source, unsigned int destination);
+void GLStateDepthFunc(unsigned int func);
+void GLStateDepthMask(bool write);
+void GLStateViewport(int x, int y, int width, int height);
+
+// call after deleting objects, GL unbinds them and may hand the name out again
+void GLStateForgetProgram(unsigned int program);
+void GLStateForgetVertexArray(unsigned int vertexArray);
+void GLStateForgetBuffer(unsigned int buffer);
+void GLStateForgetTexture(unsigned int texture);
+
+// counters since the last GLStateResetStats
+GLStateStats GLStateGetStats(void);
+void GLStateResetStats(void);
+
+// short name of a call kind for printing stats
+const char *GLStateCallName(GLStateCall call);
+
+#endif // __GLSTATE_H__
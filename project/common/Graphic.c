@@ -1,4 +1,6 @@
 #include "Graphic.h"
+#include "GLExt.h"
+#include "GLState.h"
 
 int GetElementCount(ShaderElementKind kind)
 {
@@ -23,12 +25,34 @@ int GetElementCount(ShaderElementKind kind)
         case ui4:
         case f4:
             return 4;
+
+        case m3:
+            return 9;
+
+        case m4:
+            return 16;
         
         default:
             return -1;
     }
 }
 
+// attribute locations taken by a kind, one per matrix column
+int GetElementLocations(ShaderElementKind kind)
+{
+    switch (kind)
+    {
+        case m3:
+            return 3;
+
+        case m4:
+            return 4;
+
+        default:
+            return 1;
+    }
+}
+
 size_t GetElementSize(ShaderElementKind kind)
 {
     switch (kind)
@@ -49,6 +73,8 @@ size_t GetElementSize(ShaderElementKind kind)
         case f2:
         case f3:
         case f4:
+        case m3:
+        case m4:
             return sizeof(float);
         
         default:
@@ -72,6 +98,25 @@ ShaderElement InitShaderElement(ShaderElementKind *kinds, size_t kind_size, unsi
     return se;
 }
 
+void ShaderElementSetLocation(ShaderElement *se, unsigned int location)
+{
+    se->location = location;
+}
+
+void ShaderElementSetDivisor(ShaderElement *se, unsigned int divisor)
+{
+    se->divisor = divisor;
+}
+
+// bytes per vertex, the same stride VertexArrayPointers uses
+size_t ShaderElementStride(ShaderElement *se)
+{
+    if (se->size == 0)
+        return 0;
+
+    return se->totalElements * GetElementSize(se->kinds[0]);
+}
+
 VertexBuffer CreateVertexBuffer(float *vertices, size_t size, DrawKind drawKind)
 {
     VertexBuffer vb;
@@ -79,7 +124,7 @@ VertexBuffer CreateVertexBuffer(float *vertices, size_t size, DrawKind drawKind)
 
     glGenBuffers(1, &vb.ID);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vb.ID);
+    GLStateBindBuffer(GL_ARRAY_BUFFER, vb.ID);
     glBufferData(GL_ARRAY_BUFFER, size, vertices, drawKind == STATIC ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
 
     return vb;
@@ -87,7 +132,7 @@ VertexBuffer CreateVertexBuffer(float *vertices, size_t size, DrawKind drawKind)
 
 void VertexBufferBind(VertexBuffer *vb)
 {
-    glBindBuffer(GL_ARRAY_BUFFER, vb->ID);
+    GLStateBindBuffer(GL_ARRAY_BUFFER, vb->ID);
 }
 
 void VertexBufferSetLayout(VertexBuffer *vb, ShaderElement *elements)
@@ -95,13 +140,168 @@ void VertexBufferSetLayout(VertexBuffer *vb, ShaderElement *elements)
     vb->elements = elements;
 }
 
-ElementBuffer CreateElementBuffer(unsigned int *indices, size_t size, DrawKind drawKind)
+// replace the content with one column-major matrix per instance (an m4
+// attribute). The old storage is orphaned, the GPU may still be reading it.
+void VertexBufferSetMatrices(VertexBuffer *vb, const Mat4x4 *matrices, size_t count)
+{
+    size_t size = count * sizeof(float16);
+
+    GLStateBindBuffer(GL_ARRAY_BUFFER, vb->ID);
+    glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+
+    if (count == 0)
+        return;
+
+    float16 *mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped == NULL)
+    {
+        fprintf(stderr, "[ERROR]: Failed to map instance buffer.\n");
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+        mapped[i] = Mat4x4ToFloat(matrices[i]);
+
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+StreamBuffer CreateStreamBuffer(size_t frameSize)
+{
+    StreamBuffer sb = { 0 };
+    size_t size = frameSize * STREAM_BUFFER_REGIONS;
+
+    sb.regionSize = frameSize;
+
+    glGenBuffers(1, &sb.buffer.ID);
+    GLStateBindBuffer(GL_ARRAY_BUFFER, sb.buffer.ID);
+
+    if (GLEXT_ARB_buffer_storage && GLEXT_ARB_sync)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+        sb.mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+        sb.persistent = sb.mapped != NULL;
+
+        if (!sb.persistent)
+        {
+            fprintf(stderr, "[ERROR]: Failed to map stream buffer persistently, using orphaning.\n");
+
+            // the storage is immutable now, start over with a fresh buffer
+            GLStateForgetBuffer(sb.buffer.ID);
+            glDeleteBuffers(1, &sb.buffer.ID);
+            glGenBuffers(1, &sb.buffer.ID);
+            GLStateBindBuffer(GL_ARRAY_BUFFER, sb.buffer.ID);
+        }
+    }
+
+    if (!sb.persistent)
+        glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+
+    return sb;
+}
+
+// wait until the GPU is done reading the current region
+static void StreamBufferWait(StreamBuffer *sb)
+{
+    GLsync fence = sb->fences[sb->region];
+
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+        ++sb->waits;
+
+        do status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        while (status == GL_TIMEOUT_EXPIRED);
+    }
+
+    glDeleteSync(fence);
+    sb->fences[sb->region] = NULL;
+}
+
+// returns where to write size bytes, offset receives their byte offset in the
+// buffer (a multiple of alignment, so offset / stride is the first vertex)
+void *StreamBufferMap(StreamBuffer *sb, size_t size, size_t alignment, size_t *offset)
+{
+    if (alignment == 0) alignment = 1;
+
+    // aligned within the whole buffer, regions need not be a multiple of it
+    size_t base = sb->region * sb->regionSize;
+    size_t start = (base + sb->head + alignment - 1) / alignment * alignment;
+
+    if (start - base + size > sb->regionSize)
+    {
+        fprintf(stderr, "[ERROR]: Stream buffer region full, %zu of %zu bytes used.\n", sb->head, sb->regionSize);
+        return NULL;
+    }
+
+    *offset = start;
+    sb->head = start - base + size;
+
+    if (sb->persistent)
+    {
+        if (sb->fences[sb->region])
+            StreamBufferWait(sb);
+
+        return sb->mapped + start;
+    }
+
+    GLStateBindBuffer(GL_ARRAY_BUFFER, sb->buffer.ID);
+    return glMapBufferRange(GL_ARRAY_BUFFER, start, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+// done writing, must come before drawing from the data
+void StreamBufferUnmap(StreamBuffer *sb)
+{
+    if (sb->persistent)
+        return;
+
+    GLStateBindBuffer(GL_ARRAY_BUFFER, sb->buffer.ID);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+// call after the draws of the frame were submitted, moves to the next region
+void StreamBufferEndFrame(StreamBuffer *sb)
+{
+    if (sb->persistent)
+        sb->fences[sb->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    sb->region = (sb->region + 1) % STREAM_BUFFER_REGIONS;
+    sb->head = 0;
+
+    // back at the start of the ring: hand the old storage to the driver and
+    // get a fresh one nobody is reading
+    if (!sb->persistent && sb->region == 0)
+    {
+        GLStateBindBuffer(GL_ARRAY_BUFFER, sb->buffer.ID);
+        glBufferData(GL_ARRAY_BUFFER, sb->regionSize * STREAM_BUFFER_REGIONS, NULL, GL_STREAM_DRAW);
+    }
+}
+
+void DeleteStreamBuffer(StreamBuffer *sb)
+{
+    for (int i = 0; i < STREAM_BUFFER_REGIONS; ++i)
+        if (sb->fences[i]) glDeleteSync(sb->fences[i]);
+
+    if (sb->persistent)
+    {
+        GLStateBindBuffer(GL_ARRAY_BUFFER, sb->buffer.ID);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+
+    GLStateForgetBuffer(sb->buffer.ID);
+    glDeleteBuffers(1, &sb->buffer.ID);
+
+    *sb = (StreamBuffer) { 0 };
+}
+
+ElementBuffer CreateElementBuffer(const void *indices, size_t size, DrawKind drawKind)
 {
     ElementBuffer eb;
 
     glGenBuffers(1, &eb.ID);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eb.ID);
+    GLStateBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eb.ID);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, drawKind == STATIC ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
 
     return eb;
@@ -109,7 +309,7 @@ ElementBuffer CreateElementBuffer(unsigned int *indices, size_t size, DrawKind d
 
 void ElementBufferBind(ElementBuffer *eb)
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eb->ID);
+    GLStateBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eb->ID);
 }
 
 VertexArray CreateVertexArray()
@@ -123,12 +323,12 @@ VertexArray CreateVertexArray()
 
 void VertexArrayBind(VertexArray *va)
 {
-    glBindVertexArray(va->ID);
+    GLStateBindVertexArray(va->ID);
 }
 
 void VertexArrayUnbind(VertexArray *va)
 {
-    glBindVertexArray(0);
+    GLStateBindVertexArray(0);
 }
 
 void VertexArrayPointers(VertexArray *va, VertexBuffer *vb)
@@ -138,20 +338,58 @@ void VertexArrayPointers(VertexArray *va, VertexBuffer *vb)
         return;
     }
 
+    if (vb->elements->divisor && !GLEXT_ARB_instanced_arrays) {
+        fprintf(stderr, "[ERROR]: Per instance attributes need ARB_instanced_arrays.\n");
+        return;
+    }
+
+    // the pointers are recorded in the bound vertex array, make sure it is va
+    VertexArrayBind(va);
     VertexBufferBind(vb);
 
+    unsigned int location = vb->elements->location;
     int prevOffset = 0;
     for (size_t i = 0; i < vb->elements->size; ++i)
     {
-        glVertexAttribPointer(
-            i,
-            GetElementCount(vb->elements->kinds[i]),
-            vb->elements->openGLType,
-            vb->elements->normalized,
-            vb->elements->totalElements * GetElementSize(vb->elements->kinds[i]),
-            (void*)(prevOffset * GetElementSize(vb->elements->kinds[i])));
-        glEnableVertexAttribArray(i);
-
-        prevOffset += GetElementCount(vb->elements->kinds[i]);
+        ShaderElementKind kind = vb->elements->kinds[i];
+        int columns = GetElementLocations(kind);
+        int columnSize = GetElementCount(kind) / columns;
+
+        for (int column = 0; column < columns; ++column, ++location)
+        {
+            glVertexAttribPointer(
+                location,
+                columnSize,
+                vb->elements->openGLType,
+                vb->elements->normalized,
+                vb->elements->totalElements * GetElementSize(kind),
+                (void*)((prevOffset + column * columnSize) * GetElementSize(kind)));
+            glEnableVertexAttribArray(location);
+
+            if (GLEXT_ARB_instanced_arrays)
+                glVertexAttribDivisor(location, vb->elements->divisor);
+        }
+
+        prevOffset += GetElementCount(kind);
     }
+}
+
+// draw the first vertexCount vertices of va once per world matrix. instances
+// must be attached to va with a single m4 per instance layout.
+void VertexArrayDrawInstanced(VertexArray *va, VertexBuffer *instances, const Mat4x4 *world, size_t count, unsigned int vertexCount)
+{
+    static bool reported = false;
+
+    if (!GLEXT_ARB_draw_instanced) {
+        if (!reported)
+            fprintf(stderr, "[ERROR]: Instanced draws need ARB_draw_instanced.\n");
+
+        reported = true;
+        return;
+    }
+
+    VertexBufferSetMatrices(instances, world, count);
+
+    VertexArrayBind(va);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, count);
 }
\ No newline at end of file
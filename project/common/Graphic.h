@@ -2,6 +2,7 @@
 #define __GRAPHIC_H__
 
 #include "common.h"
+#include "cmath.h"
 
 typedef enum {
 	// integer
@@ -11,18 +12,32 @@ typedef enum {
 	ui1, ui2, ui3, ui4,
 
 	// float
-	f1, f2, f3, f4
+	f1, f2, f3, f4,
+
+	// float matrix, one attribute location per column
+	m3, m4
 } ShaderElementKind;
 
+// layout of one vertex buffer. Attributes take consecutive locations from
+// location on, a non zero divisor makes them advance once per divisor
+// instances instead of once per vertex. The divisor is per layout, every
+// attribute of the buffer shares it; attributes advancing at another rate
+// go in a buffer of their own. A vertex array can take several buffers,
+// each with its own layout starting past the previous one.
 typedef struct ShaderElement {
 	ShaderElementKind *kinds;
 	size_t size;
 	unsigned int openGLType;
 	bool normalized;
 	size_t totalElements;
+	unsigned int location;
+	unsigned int divisor;
 } ShaderElement;
 
 ShaderElement InitShaderElement(ShaderElementKind *kinds, size_t kind_size, unsigned int openGLType, bool normalized);
+void ShaderElementSetLocation(ShaderElement *se, unsigned int location);
+void ShaderElementSetDivisor(ShaderElement *se, unsigned int divisor);
+size_t ShaderElementStride(ShaderElement *se);
 
 typedef enum {
 	STATIC,
@@ -37,12 +52,49 @@ typedef struct VertexBuffer {
 VertexBuffer CreateVertexBuffer(float *vertices, size_t size, DrawKind drawKind);
 void VertexBufferBind(VertexBuffer *vb);
 void VertexBufferSetLayout(VertexBuffer *vb, ShaderElement *elements);
+void VertexBufferSetMatrices(VertexBuffer *vb, const Mat4x4 *matrices, size_t count);
+
+/*
+	Streaming buffer for data rewritten every frame (sprites, particles,
+	debug geometry). The buffer is split into STREAM_BUFFER_REGIONS regions of
+	frameSize bytes, one per frame in flight, and StreamBufferMap hands out
+	write pointers inside the current region.
+
+	With ARB_buffer_storage the whole buffer stays mapped and a fence guards
+	each region: the CPU only waits when it comes back to a region the GPU is
+	still reading. Without it every map is an unsynchronized glMapBufferRange
+	and the storage is orphaned when the ring wraps. Clearing
+	GLEXT_ARB_buffer_storage before the create forces that path.
+
+	buffer is bound to GL_ARRAY_BUFFER while mapping, its ID can be bound to
+	any target to draw from it.
+*/
+
+#define STREAM_BUFFER_REGIONS 3
+
+typedef struct StreamBuffer {
+	VertexBuffer buffer;
+	size_t regionSize;
+	unsigned int region;
+	size_t head;             // next free byte of the current region
+	unsigned char *mapped;   // persistent mapping of the whole buffer
+	GLsync fences[STREAM_BUFFER_REGIONS];
+	bool persistent;
+	size_t waits;            // maps that had to wait for the GPU
+} StreamBuffer;
+
+StreamBuffer CreateStreamBuffer(size_t frameSize);
+void *StreamBufferMap(StreamBuffer *sb, size_t size, size_t alignment, size_t *offset);
+void StreamBufferUnmap(StreamBuffer *sb);
+void StreamBufferEndFrame(StreamBuffer *sb);
+void DeleteStreamBuffer(StreamBuffer *sb);
 
 typedef struct ElementBuffer {
 	unsigned int ID;
 } ElementBuffer;
 
-ElementBuffer CreateElementBuffer(unsigned int *indices, size_t size, DrawKind drawKind);
+// indices are unsigned short or unsigned int, as the draw call says
+ElementBuffer CreateElementBuffer(const void *indices, size_t size, DrawKind drawKind);
 void ElementBufferBind(ElementBuffer *eb);
 
 typedef struct VertexArray {
@@ -52,6 +104,8 @@ typedef struct VertexArray {
 VertexArray CreateVertexArray();
 void VertexArrayBind(VertexArray *va);
 void VertexArrayUnbind(VertexArray *va);
+// binds va and points it at the attributes of vb, va stays bound
 void VertexArrayPointers(VertexArray *va, VertexBuffer *vb);
+void VertexArrayDrawInstanced(VertexArray *va, VertexBuffer *instances, const Mat4x4 *world, size_t count, unsigned int vertexCount);
 
 #endif // __GRAPHIC_H__
\ No newline at end of file
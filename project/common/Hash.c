@@ -0,0 +1,54 @@
+#include <string.h>
+
+#include "Hash.h"
+
+#define HASH_PRIME1 0x9E3779B185EBCA87ull
+#define HASH_PRIME2 0xC2B2AE3D27D4EB4Full
+#define HASH_PRIME3 0x165667B19E3779F9ull
+
+static uint64_t HashRotate(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+uint64_t HashBytes(const void *data, size_t size, uint64_t seed)
+{
+	const unsigned char *bytes = data;
+	uint64_t lanes[4] = { seed + HASH_PRIME1 + HASH_PRIME2, seed + HASH_PRIME2, seed, seed - HASH_PRIME1 };
+	size_t i = 0;
+
+	// four independent lanes so the multiplies overlap
+	for (; i + 32 <= size; i += 32)
+	{
+		for (int k = 0; k < 4; ++k)
+		{
+			uint64_t word;
+			memcpy(&word, bytes + i + k * 8, sizeof(word));
+			lanes[k] = HashRotate(lanes[k] + word * HASH_PRIME2, 31) * HASH_PRIME1;
+		}
+	}
+
+	uint64_t hash = seed ^ (uint64_t)size * HASH_PRIME3;
+
+	for (int k = 0; k < 4; ++k)
+		hash = HashRotate(hash ^ lanes[k], 27) * HASH_PRIME1 + HASH_PRIME3;
+
+	for (; i < size; ++i)
+		hash = HashRotate(hash ^ bytes[i] * HASH_PRIME3, 11) * HASH_PRIME1;
+
+	hash ^= hash >> 33;
+	hash *= HASH_PRIME2;
+	hash ^= hash >> 29;
+	hash *= HASH_PRIME3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+uint64_t HashString(const char *string, uint64_t seed)
+{
+	if (string == NULL)
+		string = "";
+
+	return HashBytes(string, strlen(string), seed);
+}
@@ -0,0 +1,21 @@
+#ifndef __HASH_H__
+#define __HASH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+	64 bit non cryptographic hash for cache keys and checksums.
+
+	Four lanes of 8 byte words are mixed independently so the multiplies
+	overlap, the tail goes in byte by byte. Files written with these hashes
+	depend on the exact output, changing it means bumping the version of
+	every cache that stores them.
+*/
+
+uint64_t HashBytes(const void *data, size_t size, uint64_t seed);
+
+// NULL hashes like ""
+uint64_t HashString(const char *string, uint64_t seed);
+
+#endif // __HASH_H__
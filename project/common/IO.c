@@ -1,5 +1,16 @@
 #include "IO.h"
 
+#include <string.h>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 char* read_file(const char* pathname)
 {
     FILE* file = fopen(pathname, "rb");
@@ -20,3 +31,139 @@ char* read_file(const char* pathname)
     buffer[len - 1] = '\0';
     return buffer;
 }
+
+MappedFile MapFile(const char *pathname)
+{
+    MappedFile file = { 0 };
+
+#if defined(_WIN32)
+    HANDLE handle = CreateFileA(pathname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "[ERROR]: Failed to open %s.\n", pathname);
+        return file;
+    }
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(handle, &size);
+
+    HANDLE mapping = size.QuadPart ? CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    CloseHandle(handle);
+
+    if (size.QuadPart && mapping == NULL)
+    {
+        fprintf(stderr, "[ERROR]: Failed to map %s.\n", pathname);
+        return file;
+    }
+
+    file.data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    file.size = (size_t)size.QuadPart;
+    file.handle = mapping;
+#else
+    int fd = open(pathname, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "[ERROR]: Failed to open %s.\n", pathname);
+        return file;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        fprintf(stderr, "[ERROR]: Failed to read the size of %s.\n", pathname);
+        close(fd);
+        return file;
+    }
+
+    file.size = (size_t)info.st_size;
+
+    if (file.size)
+    {
+        void *data = mmap(NULL, file.size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED)
+        {
+            fprintf(stderr, "[ERROR]: Failed to map %s.\n", pathname);
+            file.size = 0;
+        }
+        else
+        {
+            // parsers read it in parallel chunks, start reading all of it now
+            madvise(data, file.size, MADV_WILLNEED);
+            file.data = data;
+        }
+    }
+
+    close(fd);
+#endif
+
+    return file;
+}
+
+void UnmapFile(MappedFile *file)
+{
+#if defined(_WIN32)
+    if (file->data) UnmapViewOfFile(file->data);
+    if (file->handle) CloseHandle(file->handle);
+#else
+    if (file->data) munmap((void *)file->data, file->size);
+#endif
+
+    *file = (MappedFile) { 0 };
+}
+
+int MakeDirectory(const char *pathname)
+{
+#if defined(_WIN32)
+    if (CreateDirectoryA(pathname, NULL) || GetLastError() == ERROR_ALREADY_EXISTS)
+        return 1;
+#else
+    struct stat info;
+    if (mkdir(pathname, 0755) == 0 || (stat(pathname, &info) == 0 && S_ISDIR(info.st_mode)))
+        return 1;
+#endif
+
+    fprintf(stderr, "[ERROR]: Failed to create directory %s.\n", pathname);
+    return 0;
+}
+
+int WriteFileAtomic(const char *pathname, const void *data, size_t size)
+{
+    // a name per process, so two writers of the same file keep their own
+#if defined(_WIN32)
+    unsigned long id = GetCurrentProcessId();
+#else
+    unsigned long id = (unsigned long)getpid();
+#endif
+
+    size_t length = strlen(pathname) + 32;
+    char *temporary = malloc(length);
+    if (temporary == NULL)
+    {
+        fprintf(stderr, "[ERROR]: Failed to write %s.\n", pathname);
+        return 0;
+    }
+    snprintf(temporary, length, "%s.%lu.tmp", pathname, id);
+
+    FILE *output = fopen(temporary, "wb");
+    int written = output && fwrite(data, 1, size, output) == size;
+    if (output && fclose(output) != 0) written = 0;
+
+    // rename does not replace an existing file on windows, MoveFileEx does
+    if (written)
+#if defined(_WIN32)
+        written = MoveFileExA(temporary, pathname, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        written = rename(temporary, pathname) == 0;
+#endif
+
+    if (!written)
+    {
+        fprintf(stderr, "[ERROR]: Failed to write %s.\n", pathname);
+        remove(temporary);
+    }
+
+    free(temporary);
+
+    return written;
+}
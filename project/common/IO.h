@@ -1,4 +1,26 @@
+#ifndef __IO_H__
+#define __IO_H__
+
 #include <stdio.h>
 #include <stdlib.h>
 
 char* read_file(const char* pathname);
+
+// a read only view of a whole file, mapped instead of copied
+typedef struct MappedFile {
+    const char *data;
+    size_t size;
+    void *handle;
+} MappedFile;
+
+MappedFile MapFile(const char *pathname);
+void UnmapFile(MappedFile *file);
+
+// creates one directory level, true when it exists afterwards
+int MakeDirectory(const char *pathname);
+
+// writes a temporary file per process and renames it over pathname, so readers never see a
+// half written file. true when the whole file is in place
+int WriteFileAtomic(const char *pathname, const void *data, size_t size);
+
+#endif // __IO_H__
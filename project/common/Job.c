@@ -0,0 +1,198 @@
+#include "Job.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
+
+typedef struct JobBatch {
+	JobRangeFunc func;
+	void *userData;
+	size_t count;
+	size_t chunk;
+	atomic_size_t next;
+	atomic_size_t done;
+} JobBatch;
+
+static struct {
+	pthread_once_t once;
+	pthread_mutex_t lock;
+	pthread_mutex_t submit;
+	pthread_cond_t wake;
+	pthread_cond_t finished;
+
+	pthread_t *threads;
+	int workerCount;
+	int running;
+
+	JobBatch *batch;
+	unsigned long generation;
+	int busy;
+} jobs = {
+	PTHREAD_ONCE_INIT,
+	PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	PTHREAD_COND_INITIALIZER
+};
+
+static int JobCoreCount(void)
+{
+#if defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int)n : 1;
+#endif
+}
+
+// grab chunks until the range is exhausted
+static void JobRunChunks(JobBatch *batch)
+{
+	for (;;)
+	{
+		size_t begin = atomic_fetch_add(&batch->next, batch->chunk);
+		if (begin >= batch->count) break;
+
+		size_t end = begin + batch->chunk;
+		if (end > batch->count) end = batch->count;
+
+		batch->func(batch->userData, begin, end);
+
+		atomic_fetch_add(&batch->done, end - begin);
+	}
+}
+
+static void *JobWorker(void *arg)
+{
+	unsigned long seen = 0;
+
+	pthread_mutex_lock(&jobs.lock);
+	for (;;)
+	{
+		while (jobs.running && (jobs.generation == seen || !jobs.batch))
+			pthread_cond_wait(&jobs.wake, &jobs.lock);
+
+		if (!jobs.running) break;
+
+		seen = jobs.generation;
+		JobBatch *batch = jobs.batch;
+		jobs.busy++;
+		pthread_mutex_unlock(&jobs.lock);
+
+		JobRunChunks(batch);
+
+		pthread_mutex_lock(&jobs.lock);
+		jobs.busy--;
+		pthread_cond_broadcast(&jobs.finished);
+	}
+	pthread_mutex_unlock(&jobs.lock);
+
+	return NULL;
+}
+
+static void JobStart(int workerCount)
+{
+	if (workerCount <= 0) workerCount = JobCoreCount() - 1;
+
+	jobs.threads = workerCount > 0 ? malloc(sizeof(pthread_t) * workerCount) : NULL;
+	jobs.workerCount = 0;
+	jobs.running = 1;
+
+	for (int i = 0; i < workerCount; ++i)
+	{
+		if (pthread_create(&jobs.threads[i], NULL, JobWorker, NULL) != 0)
+		{
+			fprintf(stderr, "[ERROR]: Failed to start job worker %d.\n", i);
+			break;
+		}
+
+		jobs.workerCount++;
+	}
+}
+
+static int requestedWorkerCount = 0;
+
+static void JobStartDefault(void)
+{
+	JobStart(requestedWorkerCount);
+}
+
+void JobSystemInit(int workerCount)
+{
+	requestedWorkerCount = workerCount;
+	pthread_once(&jobs.once, JobStartDefault);
+}
+
+void JobSystemShutdown(void)
+{
+	pthread_mutex_lock(&jobs.lock);
+	jobs.running = 0;
+	pthread_cond_broadcast(&jobs.wake);
+	pthread_mutex_unlock(&jobs.lock);
+
+	for (int i = 0; i < jobs.workerCount; ++i)
+		pthread_join(jobs.threads[i], NULL);
+
+	free(jobs.threads);
+	jobs.threads = NULL;
+	jobs.workerCount = 0;
+}
+
+int JobSystemWorkerCount(void)
+{
+	pthread_once(&jobs.once, JobStartDefault);
+
+	return jobs.workerCount;
+}
+
+void JobParallelFor(size_t count, size_t minChunk, JobRangeFunc func, void *userData)
+{
+	if (count == 0) return;
+	if (minChunk == 0) minChunk = 1;
+
+	int workers = JobSystemWorkerCount();
+
+	if (workers == 0 || count <= minChunk || pthread_mutex_trylock(&jobs.submit) != 0)
+	{
+		func(userData, 0, count);
+		return;
+	}
+
+	// a few chunks per thread so uneven work still balances out
+	size_t chunk = count / ((size_t)(workers + 1) * 4);
+	if (chunk < minChunk) chunk = minChunk;
+
+	JobBatch batch;
+	batch.func = func;
+	batch.userData = userData;
+	batch.count = count;
+	batch.chunk = chunk;
+	atomic_init(&batch.next, 0);
+	atomic_init(&batch.done, 0);
+
+	pthread_mutex_lock(&jobs.lock);
+	jobs.batch = &batch;
+	jobs.generation++;
+	pthread_cond_broadcast(&jobs.wake);
+	pthread_mutex_unlock(&jobs.lock);
+
+	JobRunChunks(&batch);
+
+	// the batch lives on this stack, so wait for stragglers to let go of it
+	pthread_mutex_lock(&jobs.lock);
+	while (jobs.busy > 0 || atomic_load(&batch.done) < count)
+		pthread_cond_wait(&jobs.finished, &jobs.lock);
+	jobs.batch = NULL;
+	pthread_mutex_unlock(&jobs.lock);
+
+	pthread_mutex_unlock(&jobs.submit);
+}
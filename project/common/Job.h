@@ -0,0 +1,24 @@
+#ifndef __JOB_H__
+#define __JOB_H__
+
+#include <stddef.h>
+
+// work on items [begin, end) of a parallel range
+typedef void (*JobRangeFunc)(void *userData, size_t begin, size_t end);
+
+// start the worker threads, 0 picks one per core (minus the caller).
+// JobParallelFor does this on first use, so calling it is optional.
+void JobSystemInit(int workerCount);
+
+// stop and join the worker threads
+void JobSystemShutdown(void);
+
+// number of worker threads, not counting the caller
+int JobSystemWorkerCount(void);
+
+// split [0, count) into chunks of at least minChunk items and run them on the
+// workers and the calling thread, returns once every chunk is done.
+// Nested or concurrent calls run serially on the calling thread.
+void JobParallelFor(size_t count, size_t minChunk, JobRangeFunc func, void *userData);
+
+#endif // __JOB_H__
@@ -0,0 +1,1151 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <float.h>
+
+#include "Mesh.h"
+
+#define MESH_NONE 0xFFFFFFFFu
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Indexing
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// FNV-1a over the vertex bytes
+static uint32_t MeshHashVertex(const unsigned char *vertex, size_t stride)
+{
+	uint32_t hash = 2166136261u;
+
+	for (size_t i = 0; i < stride; ++i)
+		hash = (hash ^ vertex[i]) * 16777619u;
+
+	return hash;
+}
+
+size_t MeshGenerateIndices(unsigned int *indices, void *uniqueVertices, const void *vertices, size_t vertexCount, size_t stride)
+{
+	const unsigned char *source = vertices;
+	unsigned char *unique = uniqueVertices;
+
+	// open addressing, at most half full
+	size_t tableSize = 16;
+	while (tableSize < vertexCount * 2) tableSize *= 2;
+
+	unsigned int *table = malloc(tableSize * sizeof(unsigned int));
+	if (table == NULL)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate vertex hash table for %zu vertices.\n", vertexCount);
+		return 0;
+	}
+	memset(table, 0xFF, tableSize * sizeof(unsigned int));
+
+	size_t uniqueCount = 0;
+
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		const unsigned char *vertex = source + i * stride;
+		size_t slot = MeshHashVertex(vertex, stride) & (tableSize - 1);
+
+		while (table[slot] != MESH_NONE && memcmp(unique + table[slot] * stride, vertex, stride) != 0)
+			slot = (slot + 1) & (tableSize - 1);
+
+		if (table[slot] == MESH_NONE)
+		{
+			memcpy(unique + uniqueCount * stride, vertex, stride);
+			table[slot] = (unsigned int)uniqueCount++;
+		}
+
+		indices[i] = table[slot];
+	}
+
+	free(table);
+
+	return uniqueCount;
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Vertex cache
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// triangles using each vertex, as offsets into one array
+typedef struct MeshAdjacency {
+	unsigned int *offsets;   // vertexCount + 1
+	unsigned int *triangles;
+} MeshAdjacency;
+
+static bool MeshBuildAdjacency(MeshAdjacency *adjacency, const unsigned int *indices, size_t indexCount, size_t vertexCount)
+{
+	adjacency->offsets = calloc(vertexCount + 1, sizeof(unsigned int));
+	adjacency->triangles = malloc((indexCount ? indexCount : 1) * sizeof(unsigned int));
+
+	if (!adjacency->offsets || !adjacency->triangles)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate mesh adjacency for %zu indices.\n", indexCount);
+		return false;
+	}
+
+	for (size_t i = 0; i < indexCount; ++i)
+		++adjacency->offsets[indices[i] + 1];
+
+	for (size_t v = 0; v < vertexCount; ++v)
+		adjacency->offsets[v + 1] += adjacency->offsets[v];
+
+	unsigned int *fill = malloc((vertexCount + 1) * sizeof(unsigned int));
+	if (fill == NULL)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate mesh adjacency for %zu indices.\n", indexCount);
+		return false;
+	}
+	memcpy(fill, adjacency->offsets, vertexCount * sizeof(unsigned int));
+
+	for (size_t i = 0; i < indexCount; ++i)
+		adjacency->triangles[fill[indices[i]]++] = (unsigned int)(i / 3);
+
+	free(fill);
+
+	return true;
+}
+
+static void MeshFreeAdjacency(MeshAdjacency *adjacency)
+{
+	free(adjacency->offsets);
+	free(adjacency->triangles);
+}
+
+void MeshOptimizeVertexCache(unsigned int *indices, size_t indexCount, size_t vertexCount)
+{
+	const unsigned int cacheSize = MESH_CACHE_SIZE;
+	size_t triangleCount = indexCount / 3;
+
+	if (triangleCount == 0) return;
+
+	MeshAdjacency adjacency;
+	unsigned int *live = malloc(vertexCount * sizeof(unsigned int));
+	unsigned int *cacheTime = calloc(vertexCount, sizeof(unsigned int));
+	bool *emitted = calloc(triangleCount, sizeof(bool));
+	unsigned int *deadEnd = malloc(indexCount * sizeof(unsigned int));
+	unsigned int *candidates = malloc(indexCount * sizeof(unsigned int));
+	unsigned int *result = malloc(indexCount * sizeof(unsigned int));
+
+	if (!MeshBuildAdjacency(&adjacency, indices, indexCount, vertexCount)
+		|| !live || !cacheTime || !emitted || !deadEnd || !candidates || !result)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate vertex cache optimization for %zu indices.\n", indexCount);
+		goto done;
+	}
+
+	for (size_t v = 0; v < vertexCount; ++v)
+		live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+	size_t deadEndCount = 0;
+	size_t outputCount = 0;
+	size_t cursor = 0;
+	unsigned int time = cacheSize + 1;
+	unsigned int fan = indices[0];
+
+	while (fan != MESH_NONE)
+	{
+		size_t candidateCount = 0;
+
+		// emit every remaining triangle around the fanning vertex
+		for (unsigned int a = adjacency.offsets[fan]; a < adjacency.offsets[fan + 1]; ++a)
+		{
+			unsigned int triangle = adjacency.triangles[a];
+			if (emitted[triangle]) continue;
+
+			for (int k = 0; k < 3; ++k)
+			{
+				unsigned int v = indices[triangle * 3 + k];
+
+				result[outputCount++] = v;
+				deadEnd[deadEndCount++] = v;
+				candidates[candidateCount++] = v;
+				--live[v];
+
+				if (time - cacheTime[v] > cacheSize)
+					cacheTime[v] = time++;
+			}
+
+			emitted[triangle] = true;
+		}
+
+		// the oldest candidate that stays in the cache while its remaining fan is emitted
+		unsigned int next = MESH_NONE;
+		unsigned int best = 0;
+
+		for (size_t c = 0; c < candidateCount; ++c)
+		{
+			unsigned int v = candidates[c];
+			if (live[v] == 0) continue;
+
+			unsigned int priority = 0;
+			if (time - cacheTime[v] + 2 * live[v] <= cacheSize)
+				priority = time - cacheTime[v];
+
+			if (priority > best)
+			{
+				best = priority;
+				next = v;
+			}
+		}
+
+		// dead end, go back to a recent vertex or take the next one with triangles left
+		while (next == MESH_NONE && deadEndCount > 0)
+		{
+			unsigned int v = deadEnd[--deadEndCount];
+			if (live[v] > 0) next = v;
+		}
+
+		while (next == MESH_NONE && cursor < vertexCount)
+		{
+			if (live[cursor] > 0) next = (unsigned int)cursor;
+			else ++cursor;
+		}
+
+		fan = next;
+	}
+
+	memcpy(indices, result, triangleCount * 3 * sizeof(unsigned int));
+
+done:
+	MeshFreeAdjacency(&adjacency);
+	free(live);
+	free(cacheTime);
+	free(emitted);
+	free(deadEnd);
+	free(candidates);
+	free(result);
+}
+
+MeshCacheStats MeshAnalyzeVertexCache(const unsigned int *indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+	MeshCacheStats stats = { 0 };
+
+	unsigned int *cacheTime = calloc(vertexCount, sizeof(unsigned int));
+	bool *used = calloc(vertexCount, sizeof(bool));
+
+	if (!cacheTime || !used || indexCount < 3)
+	{
+		free(cacheTime);
+		free(used);
+		return stats;
+	}
+
+	unsigned int time = cacheSize + 1;
+	size_t misses = 0;
+	size_t usedCount = 0;
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		unsigned int v = indices[i];
+
+		if (time - cacheTime[v] > cacheSize)
+		{
+			cacheTime[v] = time++;
+			++misses;
+		}
+
+		if (!used[v])
+		{
+			used[v] = true;
+			++usedCount;
+		}
+	}
+
+	stats.acmr = (float)misses / (float)(indexCount / 3);
+	stats.atvr = (float)misses / (float)usedCount;
+
+	free(cacheTime);
+	free(used);
+
+	return stats;
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Overdraw
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+typedef struct MeshCluster {
+	unsigned int first;  // triangle
+	unsigned int count;
+	float center[3];     // area weighted, not yet divided by area
+	float normal[3];
+	float area;
+	float sortKey;
+} MeshCluster;
+
+static int MeshCompareClusters(const void *a, const void *b)
+{
+	const MeshCluster *x = a, *y = b;
+
+	// outward facing first, ties keep the cache order
+	if (x->sortKey != y->sortKey) return x->sortKey > y->sortKey ? -1 : 1;
+	return (x->first > y->first) - (x->first < y->first);
+}
+
+static const float *MeshPosition(const unsigned char *vertices, size_t stride, unsigned int v)
+{
+	return (const float *)(vertices + v * stride);
+}
+
+void MeshOptimizeOverdraw(unsigned int *indices, size_t indexCount, const void *vertices, size_t vertexCount, size_t stride, float threshold)
+{
+	const unsigned int cacheSize = MESH_CACHE_SIZE;
+	size_t triangleCount = indexCount / 3;
+
+	if (triangleCount < 2) return;
+
+	unsigned int *cacheTime = calloc(vertexCount, sizeof(unsigned int));
+	unsigned char *misses = malloc(triangleCount);
+	MeshCluster *clusters = malloc(triangleCount * sizeof(MeshCluster));
+	unsigned int *result = malloc(indexCount * sizeof(unsigned int));
+
+	if (!cacheTime || !misses || !clusters || !result)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate overdraw optimization for %zu indices.\n", indexCount);
+		goto done;
+	}
+
+	// cache misses per triangle in the current order
+	unsigned int time = cacheSize + 1;
+	size_t totalMisses = 0;
+
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		misses[t] = 0;
+
+		for (int k = 0; k < 3; ++k)
+		{
+			unsigned int v = indices[t * 3 + k];
+
+			if (time - cacheTime[v] > cacheSize)
+			{
+				cacheTime[v] = time++;
+				++misses[t];
+			}
+		}
+
+		totalMisses += misses[t];
+	}
+
+	// a triangle missing all three vertices starts over, cut there and also
+	// wherever a long enough cluster is already as cache friendly as allowed
+	float limit = (float)totalMisses / (float)triangleCount * threshold;
+	size_t clusterCount = 0;
+	size_t clusterMisses = 0;
+
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		MeshCluster *current = clusterCount ? &clusters[clusterCount - 1] : NULL;
+		bool cut = current == NULL || misses[t] == 3;
+
+		if (!cut && current->count >= cacheSize * 4)
+			cut = (float)clusterMisses / (float)current->count <= limit && misses[t] > 1;
+
+		if (cut)
+		{
+			clusters[clusterCount++] = (MeshCluster) { .first = (unsigned int)t };
+			clusterMisses = 0;
+		}
+
+		clusters[clusterCount - 1].count++;
+		clusterMisses += misses[t];
+	}
+
+	// the mesh centroid and per cluster centroid and normal, all weighted by area
+	const unsigned char *data = vertices;
+	float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+	float meshArea = 0.0f;
+
+	for (size_t c = 0; c < clusterCount; ++c)
+	{
+		MeshCluster *cluster = &clusters[c];
+
+		for (unsigned int t = cluster->first; t < cluster->first + cluster->count; ++t)
+		{
+			const float *p0 = MeshPosition(data, stride, indices[t * 3 + 0]);
+			const float *p1 = MeshPosition(data, stride, indices[t * 3 + 1]);
+			const float *p2 = MeshPosition(data, stride, indices[t * 3 + 2]);
+
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float n[3] = {
+				e1[1] * e2[2] - e1[2] * e2[1],
+				e1[2] * e2[0] - e1[0] * e2[2],
+				e1[0] * e2[1] - e1[1] * e2[0]
+			};
+			float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			for (int k = 0; k < 3; ++k)
+			{
+				cluster->center[k] += (p0[k] + p1[k] + p2[k]) * (area / 3.0f);
+				cluster->normal[k] += n[k];
+			}
+			cluster->area += area;
+		}
+
+		for (int k = 0; k < 3; ++k)
+			meshCenter[k] += cluster->center[k];
+		meshArea += cluster->area;
+	}
+
+	if (meshArea > 0.0f)
+		for (int k = 0; k < 3; ++k)
+			meshCenter[k] /= meshArea;
+
+	// how far the cluster faces away from the middle of the mesh
+	for (size_t c = 0; c < clusterCount; ++c)
+	{
+		MeshCluster *cluster = &clusters[c];
+		const float *n = cluster->normal;
+		float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+		if (cluster->area > 0.0f && length > 0.0f)
+			for (int k = 0; k < 3; ++k)
+				cluster->sortKey += (cluster->center[k] / cluster->area - meshCenter[k]) * n[k] / length;
+	}
+
+	qsort(clusters, clusterCount, sizeof(MeshCluster), MeshCompareClusters);
+
+	size_t outputCount = 0;
+	for (size_t c = 0; c < clusterCount; ++c)
+	{
+		memcpy(result + outputCount, indices + clusters[c].first * 3, clusters[c].count * 3 * sizeof(unsigned int));
+		outputCount += clusters[c].count * 3;
+	}
+
+	// the cuts cost cache misses, keep the input order if it got too many
+	MeshCacheStats reordered = MeshAnalyzeVertexCache(result, outputCount, vertexCount, cacheSize);
+	if (reordered.acmr * (float)triangleCount <= (float)totalMisses * threshold)
+		memcpy(indices, result, outputCount * sizeof(unsigned int));
+
+done:
+	free(cacheTime);
+	free(misses);
+	free(clusters);
+	free(result);
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Vertex fetch
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+size_t MeshOptimizeVertexFetch(void *vertices, unsigned int *indices, size_t indexCount, size_t vertexCount, size_t stride)
+{
+	unsigned int *remap = malloc(vertexCount * sizeof(unsigned int));
+	unsigned char *copy = malloc(vertexCount * stride);
+
+	if (!remap || !copy)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate vertex fetch optimization for %zu vertices.\n", vertexCount);
+		free(remap);
+		free(copy);
+		return vertexCount;
+	}
+
+	memcpy(copy, vertices, vertexCount * stride);
+	memset(remap, 0xFF, vertexCount * sizeof(unsigned int));
+
+	unsigned char *destination = vertices;
+	size_t usedCount = 0;
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		unsigned int v = indices[i];
+
+		if (remap[v] == MESH_NONE)
+		{
+			memcpy(destination + usedCount * stride, copy + v * stride, stride);
+			remap[v] = (unsigned int)usedCount++;
+		}
+
+		indices[i] = remap[v];
+	}
+
+	free(remap);
+	free(copy);
+
+	return usedCount;
+}
+
+unsigned int MeshIndexType(size_t vertexCount)
+{
+	return vertexCount <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+size_t MeshIndexSize(unsigned int indexType)
+{
+	return indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+}
+
+Mesh CreateMesh(const void *vertices, size_t vertexCount, size_t stride, MeshOptimizeStats *stats)
+{
+	Mesh mesh = { 0 };
+	size_t indexCount = vertexCount / 3 * 3;
+
+	unsigned int *indices = malloc((indexCount ? indexCount : 1) * sizeof(unsigned int));
+	mesh.vertices = malloc((indexCount ? indexCount : 1) * stride);
+
+	if (!indices || !mesh.vertices)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate mesh of %zu vertices.\n", vertexCount);
+		free(indices);
+		free(mesh.vertices);
+		return (Mesh) { 0 };
+	}
+
+	size_t uniqueCount = MeshGenerateIndices(indices, mesh.vertices, vertices, indexCount, stride);
+
+	MeshCacheStats before = MeshAnalyzeVertexCache(indices, indexCount, uniqueCount, MESH_CACHE_SIZE);
+
+	MeshOptimizeVertexCache(indices, indexCount, uniqueCount);
+	MeshOptimizeOverdraw(indices, indexCount, mesh.vertices, uniqueCount, stride, 1.15f);
+	uniqueCount = MeshOptimizeVertexFetch(mesh.vertices, indices, indexCount, uniqueCount, stride);
+
+	if (stats)
+	{
+		stats->soupVertices = vertexCount;
+		stats->uniqueVertices = uniqueCount;
+		stats->before = before;
+		stats->after = MeshAnalyzeVertexCache(indices, indexCount, uniqueCount, MESH_CACHE_SIZE);
+	}
+
+	unsigned char *shrunk = realloc(mesh.vertices, (uniqueCount ? uniqueCount : 1) * stride);
+	if (shrunk) mesh.vertices = shrunk;
+
+	mesh.vertexCount = uniqueCount;
+	mesh.stride = stride;
+	mesh.indexCount = indexCount;
+	mesh.indexType = MeshIndexType(uniqueCount);
+
+	if (mesh.indexType == GL_UNSIGNED_SHORT)
+	{
+		// narrowed in place, each short is written behind the int it came from
+		unsigned short *narrow = (unsigned short *)indices;
+		for (size_t i = 0; i < indexCount; ++i)
+			narrow[i] = (unsigned short)indices[i];
+
+		void *packed = realloc(indices, (indexCount ? indexCount : 1) * sizeof(unsigned short));
+		if (packed) indices = packed;
+	}
+
+	mesh.indices = indices;
+
+	return mesh;
+}
+
+void DeleteMesh(Mesh *mesh)
+{
+	free(mesh->vertices);
+	free(mesh->indices);
+
+	*mesh = (Mesh) { 0 };
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Simplification
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// border edges pull this much harder than faces of the same size
+#define MESH_BORDER_WEIGHT 10.0f
+
+// the cosine a triangle normal may turn to in one collapse
+#define MESH_FLIP_COSINE 0.25f
+
+typedef struct MeshQuadric {
+	float a00, a11, a22;
+	float a10, a20, a21;
+	float b0, b1, b2;
+	float c;
+	float weight;
+} MeshQuadric;
+
+typedef enum {
+	MESH_VERTEX_FREE,
+	MESH_VERTEX_BORDER,
+	MESH_VERTEX_LOCKED
+} MeshVertexKind;
+
+typedef struct MeshSimplifier {
+	const MeshSimplifyDesc *desc;
+	Vec3 *positions;        // moved into the unit cube
+	float scale;            // mesh units per unit cube unit
+	MeshQuadric *quadrics;
+	unsigned char *kinds;
+	unsigned int *indices;  // the current triangles
+	size_t indexCount;
+	float error;            // largest collapse cost so far
+
+	// scratch of a pass
+	MeshAdjacency adjacency;
+	unsigned int *remap;
+	bool *locked;
+	unsigned int *candidates; // removed, kept pairs
+	uint64_t *keys;           // cost bits << 32 | candidate
+	uint64_t *keyScratch;
+} MeshSimplifier;
+
+// the quadric of the squared distance to the plane dot(normal, p) + d = 0
+static void MeshQuadricFromPlane(MeshQuadric *q, Vec3 normal, float d, float weight)
+{
+	q->a00 = weight * normal.x * normal.x;
+	q->a11 = weight * normal.y * normal.y;
+	q->a22 = weight * normal.z * normal.z;
+	q->a10 = weight * normal.y * normal.x;
+	q->a20 = weight * normal.z * normal.x;
+	q->a21 = weight * normal.z * normal.y;
+	q->b0 = weight * d * normal.x;
+	q->b1 = weight * d * normal.y;
+	q->b2 = weight * d * normal.z;
+	q->c = weight * d * d;
+	q->weight = weight;
+}
+
+static void MeshQuadricAdd(MeshQuadric *q, const MeshQuadric *r)
+{
+	q->a00 += r->a00; q->a11 += r->a11; q->a22 += r->a22;
+	q->a10 += r->a10; q->a20 += r->a20; q->a21 += r->a21;
+	q->b0 += r->b0; q->b1 += r->b1; q->b2 += r->b2;
+	q->c += r->c;
+	q->weight += r->weight;
+}
+
+// mean squared distance of p to the planes of q
+static float MeshQuadricError(const MeshQuadric *q, Vec3 p)
+{
+	float rx = q->b0 + q->a00 * p.x + q->a10 * p.y + q->a20 * p.z;
+	float ry = q->b1 + q->a10 * p.x + q->a11 * p.y + q->a21 * p.z;
+	float rz = q->b2 + q->a20 * p.x + q->a21 * p.y + q->a22 * p.z;
+
+	// pAp + 2bp + c
+	float r = rx * p.x + ry * p.y + rz * p.z + q->b0 * p.x + q->b1 * p.y + q->b2 * p.z + q->c;
+
+	return q->weight > 0.0f ? fabsf(r) / q->weight : 0.0f;
+}
+
+// vertices sharing their position with another one
+static bool MeshFindSeams(bool *seams, const unsigned char *vertices, size_t vertexCount, size_t stride)
+{
+	size_t tableSize = 16;
+	while (tableSize < vertexCount * 2) tableSize *= 2;
+
+	unsigned int *table = malloc(tableSize * sizeof(unsigned int));
+	if (table == NULL) return false;
+	memset(table, 0xFF, tableSize * sizeof(unsigned int));
+
+	const size_t positionSize = 3 * sizeof(float);
+
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		const unsigned char *position = vertices + v * stride;
+		size_t slot = MeshHashVertex(position, positionSize) & (tableSize - 1);
+
+		while (table[slot] != MESH_NONE && memcmp(vertices + table[slot] * stride, position, positionSize) != 0)
+			slot = (slot + 1) & (tableSize - 1);
+
+		if (table[slot] == MESH_NONE)
+		{
+			table[slot] = (unsigned int)v;
+			seams[v] = false;
+		}
+		else
+		{
+			seams[v] = true;
+			seams[table[slot]] = true;
+		}
+	}
+
+	free(table);
+
+	return true;
+}
+
+// does a triangle around a run from b to a, the twin of the half edge a to b
+static bool MeshHasTwin(const MeshAdjacency *adjacency, const unsigned int *indices, unsigned int a, unsigned int b)
+{
+	for (unsigned int i = adjacency->offsets[a]; i < adjacency->offsets[a + 1]; ++i)
+	{
+		const unsigned int *triangle = indices + adjacency->triangles[i] * 3;
+
+		for (int k = 0; k < 3; ++k)
+			if (triangle[k] == b && triangle[(k + 1) % 3] == a)
+				return true;
+	}
+
+	return false;
+}
+
+static void MeshFreeSimplifier(MeshSimplifier *s)
+{
+	free(s->positions);
+	free(s->quadrics);
+	free(s->kinds);
+	free(s->indices);
+	MeshFreeAdjacency(&s->adjacency);
+	free(s->remap);
+	free(s->locked);
+	free(s->candidates);
+	free(s->keys);
+	free(s->keyScratch);
+
+	*s = (MeshSimplifier) { 0 };
+}
+
+static bool MeshInitSimplifier(MeshSimplifier *s, const MeshSimplifyDesc *desc)
+{
+	size_t vertexCount = desc->vertexCount;
+	size_t indexCount = desc->indexCount / 3 * 3;
+	const unsigned char *vertices = desc->vertices;
+
+	*s = (MeshSimplifier) { 0 };
+	s->desc = desc;
+	s->positions = malloc((vertexCount + 1) * sizeof(Vec3));
+	s->quadrics = calloc(vertexCount + 1, sizeof(MeshQuadric));
+	s->kinds = calloc(vertexCount + 1, 1);
+	s->indices = malloc((indexCount + 1) * sizeof(unsigned int));
+	s->remap = malloc((vertexCount + 1) * sizeof(unsigned int));
+	s->locked = malloc((vertexCount + 1) * sizeof(bool));
+	s->candidates = malloc((indexCount + 1) * 2 * sizeof(unsigned int));
+	s->keys = malloc((indexCount + 1) * sizeof(uint64_t));
+	s->keyScratch = malloc((indexCount + 1) * sizeof(uint64_t));
+
+	if (!s->positions || !s->quadrics || !s->kinds || !s->indices || !s->remap
+		|| !s->locked || !s->candidates || !s->keys || !s->keyScratch)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate simplification of %zu indices.\n", indexCount);
+		MeshFreeSimplifier(s);
+		return false;
+	}
+
+	memcpy(s->indices, desc->indices, indexCount * sizeof(unsigned int));
+	s->indexCount = indexCount;
+
+	// the unit cube keeps the quadrics well inside float precision
+	Vec3 low = { 0.0f, 0.0f, 0.0f }, high = { 0.0f, 0.0f, 0.0f };
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		const float *p = MeshPosition(vertices, desc->stride, (unsigned int)v);
+
+		if (v == 0 || p[0] < low.x) low.x = p[0];
+		if (v == 0 || p[1] < low.y) low.y = p[1];
+		if (v == 0 || p[2] < low.z) low.z = p[2];
+		if (v == 0 || p[0] > high.x) high.x = p[0];
+		if (v == 0 || p[1] > high.y) high.y = p[1];
+		if (v == 0 || p[2] > high.z) high.z = p[2];
+	}
+
+	Vec3 extent = Vec3Sub(high, low);
+	s->scale = fmaxf(extent.x, fmaxf(extent.y, extent.z));
+	if (s->scale <= 0.0f) s->scale = 1.0f;
+
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		const float *p = MeshPosition(vertices, desc->stride, (unsigned int)v);
+		s->positions[v] = Vec3Scale(Vec3Sub((Vec3) { p[0], p[1], p[2] }, low), 1.0f / s->scale);
+	}
+
+	// seams stay where they are, moving one side would open a crack
+	bool *seams = s->locked;
+	if (!MeshFindSeams(seams, vertices, vertexCount, desc->stride))
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate simplification of %zu indices.\n", indexCount);
+		MeshFreeSimplifier(s);
+		return false;
+	}
+
+	for (size_t v = 0; v < vertexCount; ++v)
+		if (seams[v]) s->kinds[v] = MESH_VERTEX_LOCKED;
+
+	if (!MeshBuildAdjacency(&s->adjacency, s->indices, indexCount, vertexCount))
+	{
+		MeshFreeSimplifier(s);
+		return false;
+	}
+
+	for (size_t t = 0; t < indexCount / 3; ++t)
+	{
+		const unsigned int *triangle = s->indices + t * 3;
+		Vec3 p0 = s->positions[triangle[0]], p1 = s->positions[triangle[1]], p2 = s->positions[triangle[2]];
+
+		Vec3 normal = Vec3CrossProduct(Vec3Sub(p1, p0), Vec3Sub(p2, p0));
+		float length = Vec3Length(normal);
+		if (length <= 0.0f) continue;
+
+		normal = Vec3Scale(normal, 1.0f / length);
+
+		MeshQuadric q;
+		MeshQuadricFromPlane(&q, normal, -Vec3DotProduct(normal, p0), length * 0.5f);
+
+		for (int k = 0; k < 3; ++k)
+			MeshQuadricAdd(&s->quadrics[triangle[k]], &q);
+
+		// an edge without twin is on the border, a plane through it holds it in place
+		for (int k = 0; k < 3; ++k)
+		{
+			unsigned int a = triangle[k], b = triangle[(k + 1) % 3];
+			if (MeshHasTwin(&s->adjacency, s->indices, a, b)) continue;
+
+			Vec3 edge = Vec3Sub(s->positions[b], s->positions[a]);
+			Vec3 across = Vec3CrossProduct(edge, normal);
+			float acrossLength = Vec3Length(across);
+			if (acrossLength <= 0.0f) continue;
+
+			across = Vec3Scale(across, 1.0f / acrossLength);
+
+			MeshQuadric border;
+			MeshQuadricFromPlane(&border, across, -Vec3DotProduct(across, s->positions[a]), Vec3DotProduct(edge, edge) * MESH_BORDER_WEIGHT);
+			MeshQuadricAdd(&s->quadrics[a], &border);
+			MeshQuadricAdd(&s->quadrics[b], &border);
+
+			if (s->kinds[a] == MESH_VERTEX_FREE) s->kinds[a] = MESH_VERTEX_BORDER;
+			if (s->kinds[b] == MESH_VERTEX_FREE) s->kinds[b] = MESH_VERTEX_BORDER;
+		}
+	}
+
+	return true;
+}
+
+static float MeshCollapseCost(const MeshSimplifier *s, unsigned int removed, unsigned int kept)
+{
+	MeshQuadric q = s->quadrics[removed];
+	MeshQuadricAdd(&q, &s->quadrics[kept]);
+
+	float cost = MeshQuadricError(&q, s->positions[kept]);
+
+	const MeshSimplifyDesc *desc = s->desc;
+	size_t attributeCount = desc->stride / sizeof(float) - 3;
+
+	if (desc->attributeWeight > 0.0f && attributeCount > 0)
+	{
+		const float *a = MeshPosition(desc->vertices, desc->stride, removed) + 3;
+		const float *b = MeshPosition(desc->vertices, desc->stride, kept) + 3;
+
+		float distance = 0.0f;
+		for (size_t i = 0; i < attributeCount; ++i)
+			distance += (a[i] - b[i]) * (a[i] - b[i]);
+
+		cost += desc->attributeWeight * distance;
+	}
+
+	return cost;
+}
+
+// would moving removed onto kept turn any remaining triangle over
+static bool MeshCollapseFlips(const MeshSimplifier *s, unsigned int removed, unsigned int kept)
+{
+	const MeshAdjacency *adjacency = &s->adjacency;
+
+	for (unsigned int i = adjacency->offsets[removed]; i < adjacency->offsets[removed + 1]; ++i)
+	{
+		const unsigned int *triangle = s->indices + adjacency->triangles[i] * 3;
+		if (triangle[0] == kept || triangle[1] == kept || triangle[2] == kept) continue;
+
+		Vec3 before[3], after[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			before[k] = s->positions[triangle[k]];
+			after[k] = triangle[k] == removed ? s->positions[kept] : before[k];
+		}
+
+		Vec3 n0 = Vec3CrossProduct(Vec3Sub(before[1], before[0]), Vec3Sub(before[2], before[0]));
+		Vec3 n1 = Vec3CrossProduct(Vec3Sub(after[1], after[0]), Vec3Sub(after[2], after[0]));
+
+		float length0 = Vec3Length(n0);
+		if (length0 <= 0.0f) continue;
+
+		if (Vec3DotProduct(n0, n1) <= MESH_FLIP_COSINE * length0 * Vec3Length(n1))
+			return true;
+	}
+
+	return false;
+}
+
+// LSD radix sort of the keys on their upper 32 bits, returns the sorted array
+static uint64_t *MeshSortKeys(uint64_t *keys, uint64_t *scratch, size_t count)
+{
+	unsigned int histogram[3][2048] = { 0 };
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint32_t cost = (uint32_t)(keys[i] >> 32);
+
+		++histogram[0][cost & 2047];
+		++histogram[1][(cost >> 11) & 2047];
+		++histogram[2][cost >> 22];
+	}
+
+	for (int digit = 0; digit < 3 && count > 1; ++digit)
+	{
+		int shift = 32 + digit * 11;
+		unsigned int *h = histogram[digit];
+
+		if (h[(keys[0] >> shift) & 2047] == count)
+			continue;
+
+		unsigned int sum = 0;
+		for (int bucket = 0; bucket < 2048; ++bucket)
+		{
+			unsigned int n = h[bucket];
+			h[bucket] = sum;
+			sum += n;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+			scratch[h[(keys[i] >> shift) & 2047]++] = keys[i];
+
+		uint64_t *swap = keys; keys = scratch; scratch = swap;
+	}
+
+	return keys;
+}
+
+// one round of independent collapses, returns how many were done
+static size_t MeshSimplifyPass(MeshSimplifier *s, size_t targetIndexCount, float limit)
+{
+	size_t vertexCount = s->desc->vertexCount;
+	size_t triangleCount = s->indexCount / 3;
+
+	MeshFreeAdjacency(&s->adjacency);
+	if (!MeshBuildAdjacency(&s->adjacency, s->indices, s->indexCount, vertexCount))
+		return 0;
+
+	// every half edge offers to move its first vertex onto the second
+	size_t candidateCount = 0;
+
+	for (size_t i = 0; i < s->indexCount; ++i)
+	{
+		unsigned int removed = s->indices[i];
+		unsigned int kept = s->indices[i % 3 == 2 ? i - 2 : i + 1];
+
+		if (s->kinds[removed] == MESH_VERTEX_LOCKED)
+			continue;
+
+		// border vertices only slide along the border
+		if (s->kinds[removed] == MESH_VERTEX_BORDER && MeshHasTwin(&s->adjacency, s->indices, removed, kept))
+			continue;
+
+		float cost = MeshCollapseCost(s, removed, kept);
+		if (cost > limit)
+			continue;
+
+		uint32_t bits;
+		memcpy(&bits, &cost, sizeof(bits));
+
+		s->candidates[candidateCount * 2 + 0] = removed;
+		s->candidates[candidateCount * 2 + 1] = kept;
+		s->keys[candidateCount] = (uint64_t)bits << 32 | candidateCount;
+		++candidateCount;
+	}
+
+	// positive floats sort like their bits
+	uint64_t *sorted = MeshSortKeys(s->keys, s->keyScratch, candidateCount);
+
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		s->remap[v] = (unsigned int)v;
+		s->locked[v] = false;
+	}
+
+	size_t goal = (s->indexCount - targetIndexCount) / 3;
+	size_t removedTriangles = 0;
+	size_t collapses = 0;
+
+	for (size_t c = 0; c < candidateCount && removedTriangles < goal; ++c)
+	{
+		size_t candidate = (size_t)(sorted[c] & 0xFFFFFFFFu);
+		unsigned int removed = s->candidates[candidate * 2 + 0];
+		unsigned int kept = s->candidates[candidate * 2 + 1];
+
+		if (s->locked[removed] || s->locked[kept])
+			continue;
+
+		if (MeshCollapseFlips(s, removed, kept))
+			continue;
+
+		float cost;
+		uint32_t bits = (uint32_t)(sorted[c] >> 32);
+		memcpy(&cost, &bits, sizeof(cost));
+
+		s->remap[removed] = kept;
+		MeshQuadricAdd(&s->quadrics[kept], &s->quadrics[removed]);
+		if (cost > s->error) s->error = cost;
+
+		// the triangles around removed change, none of their vertices moves again this pass
+		for (unsigned int i = s->adjacency.offsets[removed]; i < s->adjacency.offsets[removed + 1]; ++i)
+		{
+			const unsigned int *triangle = s->indices + s->adjacency.triangles[i] * 3;
+
+			for (int k = 0; k < 3; ++k)
+				s->locked[triangle[k]] = true;
+
+			if (triangle[0] == kept || triangle[1] == kept || triangle[2] == kept)
+				++removedTriangles;
+		}
+
+		++collapses;
+	}
+
+	// drop the triangles that lost an edge
+	size_t indexCount = 0;
+
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		unsigned int a = s->remap[s->indices[t * 3 + 0]];
+		unsigned int b = s->remap[s->indices[t * 3 + 1]];
+		unsigned int c = s->remap[s->indices[t * 3 + 2]];
+
+		if (a == b || b == c || c == a)
+			continue;
+
+		s->indices[indexCount++] = a;
+		s->indices[indexCount++] = b;
+		s->indices[indexCount++] = c;
+	}
+
+	s->indexCount = indexCount;
+
+	return collapses;
+}
+
+static void MeshSimplifyTo(MeshSimplifier *s, size_t targetIndexCount, float limit)
+{
+	while (s->indexCount > targetIndexCount && MeshSimplifyPass(s, targetIndexCount, limit) > 0)
+		;
+}
+
+// error limit in mesh units to a squared unit cube cost
+static float MeshErrorLimit(const MeshSimplifier *s, float error)
+{
+	float scaled = error / s->scale;
+	return error >= FLT_MAX / 2.0f ? FLT_MAX : scaled * scaled;
+}
+
+size_t MeshSimplify(unsigned int *destination, const MeshSimplifyDesc *desc, size_t targetIndexCount, float targetError, float *resultError)
+{
+	MeshSimplifier s;
+	if (!MeshInitSimplifier(&s, desc))
+	{
+		if (resultError) *resultError = 0.0f;
+		return 0;
+	}
+
+	MeshSimplifyTo(&s, targetIndexCount, MeshErrorLimit(&s, targetError));
+
+	size_t indexCount = s.indexCount;
+	memcpy(destination, s.indices, indexCount * sizeof(unsigned int));
+
+	if (resultError) *resultError = sqrtf(s.error) * s.scale;
+
+	MeshFreeSimplifier(&s);
+
+	return indexCount;
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Level of detail
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+static bool MeshLodChainAppend(MeshLodChain *chain, const unsigned int *indices, size_t indexCount, float error)
+{
+	unsigned int *grown = realloc(chain->indices, (chain->indexCount + indexCount) * sizeof(unsigned int));
+	if (grown == NULL)
+	{
+		fprintf(stderr, "[ERROR]: Failed to grow LOD chain to %zu indices.\n", chain->indexCount + indexCount);
+		return false;
+	}
+
+	chain->indices = grown;
+	memcpy(chain->indices + chain->indexCount, indices, indexCount * sizeof(unsigned int));
+
+	chain->lods[chain->lodCount++] = (MeshLod) { chain->indexCount, indexCount, error };
+	chain->indexCount += indexCount;
+
+	return true;
+}
+
+MeshLodChain CreateMeshLodChain(const MeshSimplifyDesc *desc, int maxLods, float reduction)
+{
+	MeshLodChain chain = { 0 };
+
+	if (maxLods > MESH_MAX_LODS) maxLods = MESH_MAX_LODS;
+
+	MeshSimplifier s;
+	if (maxLods <= 0 || !MeshInitSimplifier(&s, desc))
+		return chain;
+
+	if (!MeshLodChainAppend(&chain, s.indices, s.indexCount, 0.0f))
+	{
+		MeshFreeSimplifier(&s);
+		return chain;
+	}
+
+	// one simplification all the way down keeps the quadrics, and with them the error, of every step
+	while (chain.lodCount < maxLods)
+	{
+		size_t previous = s.indexCount;
+		size_t target = (size_t)((float)(previous / 3) * reduction) * 3;
+
+		MeshSimplifyTo(&s, target, FLT_MAX);
+
+		// stuck on locked vertices or flips, another level would be the same one
+		if (s.indexCount == 0 || s.indexCount > previous - previous / 10)
+			break;
+
+		if (!MeshLodChainAppend(&chain, s.indices, s.indexCount, sqrtf(s.error) * s.scale))
+			break;
+
+		MeshLod *lod = &chain.lods[chain.lodCount - 1];
+		MeshOptimizeVertexCache(chain.indices + lod->firstIndex, lod->indexCount, desc->vertexCount);
+	}
+
+	MeshFreeSimplifier(&s);
+
+	return chain;
+}
+
+void DeleteMeshLodChain(MeshLodChain *chain)
+{
+	free(chain->indices);
+
+	*chain = (MeshLodChain) { 0 };
+}
+
+int MeshLodSelect(const MeshLodChain *chain, Mat4x4 projection, float screenHeight, float distance, float pixelError)
+{
+	if (chain->lodCount == 0 || distance <= 0.0f)
+		return 0;
+
+	// m5 is cot(fovy / 2), a mesh unit at distance covers this many pixels
+	float pixelsPerUnit = projection.m5 * screenHeight * 0.5f / distance;
+
+	for (int lod = chain->lodCount - 1; lod > 0; --lod)
+		if (chain->lods[lod].error * pixelsPerUnit <= pixelError)
+			return lod;
+
+	return 0;
+}
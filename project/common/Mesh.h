@@ -0,0 +1,132 @@
+#ifndef __MESH_H__
+#define __MESH_H__
+
+#include "common.h"
+#include "cmath.h"
+
+/*
+	Mesh optimization, for offline tools and load time.
+
+	MeshGenerateIndices turns a triangle soup into an indexed mesh by hashing
+	whole vertices (bitwise, so -0.0 and 0.0 stay apart). The index passes
+	then reorder triangles:
+
+		MeshOptimizeVertexCache  Tipsify (Sander et al. 2007), fans around
+		                         recently used vertices so they are still in
+		                         the post-transform cache
+		MeshOptimizeOverdraw     cuts the cache friendly order into clusters
+		                         and draws the outward facing ones first so
+		                         early depth rejects more of the rest
+		MeshOptimizeVertexFetch  renumbers vertices in first use order so the
+		                         vertex fetch walks the buffer forward
+
+	MeshAnalyzeVertexCache simulates a FIFO cache: ACMR is transformed
+	vertices per triangle (0.5 best, 3 worst), ATVR is transformed vertices
+	per vertex (1 best).
+
+	CreateMesh runs all of it on a soup and stores the indices as unsigned
+	short when every vertex can be addressed with 16 bits.
+
+	MeshSimplify removes triangles by collapsing edges onto one of their
+	vertices (Garland and Heckbert quadrics), so a simplified index buffer
+	still uses the original vertex buffer. Positions are the first 3 floats
+	of a vertex and any floats after them are attributes: their squared
+	difference, times attributeWeight, is added to the collapse cost.
+	Vertices on an open border only slide along it; vertices sharing their
+	position with another vertex (uv or normal seams) never move. Collapses
+	run in passes, cheapest first, and every pass leaves the neighbourhood
+	of a collapse alone, which keeps it O(n log n).
+
+	The error is the square root of the area weighted mean squared distance
+	to the original planes around the kept vertex, in mesh units. A LOD
+	chain simplifies once and keeps every level as a range of one index
+	buffer, the error of a level bounds all collapses done to reach it.
+	MeshLodSelect projects that error to pixels with the projection matrix
+	and picks the coarsest level under the allowed pixel error.
+*/
+
+#define MESH_CACHE_SIZE 16
+
+typedef struct MeshCacheStats {
+	float acmr;
+	float atvr;
+} MeshCacheStats;
+
+typedef struct Mesh {
+	unsigned char *vertices;
+	size_t vertexCount;
+	size_t stride;
+	void *indices;          // unsigned short or unsigned int, as indexType
+	size_t indexCount;
+	unsigned int indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+} Mesh;
+
+typedef struct MeshOptimizeStats {
+	size_t soupVertices;
+	size_t uniqueVertices;
+	MeshCacheStats before;  // deduplicated, submission order
+	MeshCacheStats after;
+} MeshOptimizeStats;
+
+// indices gets vertexCount entries, uniqueVertices the distinct vertices, returns their count
+size_t MeshGenerateIndices(unsigned int *indices, void *uniqueVertices, const void *vertices, size_t vertexCount, size_t stride);
+
+void MeshOptimizeVertexCache(unsigned int *indices, size_t indexCount, size_t vertexCount);
+
+// expects a vertex cache optimized order; positions are 3 floats at the start of
+// each vertex. threshold >= 1 is how much ACMR may grow, the order is kept if
+// the reordering would cost more.
+void MeshOptimizeOverdraw(unsigned int *indices, size_t indexCount, const void *vertices, size_t vertexCount, size_t stride, float threshold);
+
+// reorders vertices and rewrites indices in place, returns the count of used vertices
+size_t MeshOptimizeVertexFetch(void *vertices, unsigned int *indices, size_t indexCount, size_t vertexCount, size_t stride);
+
+MeshCacheStats MeshAnalyzeVertexCache(const unsigned int *indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize);
+
+// GL_UNSIGNED_SHORT when 16 bit indices can address vertexCount vertices
+unsigned int MeshIndexType(size_t vertexCount);
+size_t MeshIndexSize(unsigned int indexType);
+
+// the full pipeline on a triangle soup, stats may be NULL
+Mesh CreateMesh(const void *vertices, size_t vertexCount, size_t stride, MeshOptimizeStats *stats);
+void DeleteMesh(Mesh *mesh);
+
+#define MESH_MAX_LODS 8
+
+// vertices are float, the first 3 of each vertex are the position
+typedef struct MeshSimplifyDesc {
+	const unsigned int *indices;
+	size_t indexCount;
+	const void *vertices;
+	size_t vertexCount;
+	size_t stride;
+	float attributeWeight; // 0 looks at the positions only
+} MeshSimplifyDesc;
+
+// writes at most desc->indexCount indices to destination and returns their count,
+// stops at targetIndexCount or before an error above targetError (mesh units)
+size_t MeshSimplify(unsigned int *destination, const MeshSimplifyDesc *desc, size_t targetIndexCount, float targetError, float *resultError);
+
+typedef struct MeshLod {
+	size_t firstIndex;
+	size_t indexCount;
+	float error;           // mesh units
+} MeshLod;
+
+typedef struct MeshLodChain {
+	unsigned int *indices; // every level, finest first
+	size_t indexCount;
+	MeshLod lods[MESH_MAX_LODS];
+	int lodCount;
+} MeshLodChain;
+
+// level 0 is the input, each next level keeps about reduction of the previous
+// triangles. Levels are vertex cache optimized.
+MeshLodChain CreateMeshLodChain(const MeshSimplifyDesc *desc, int maxLods, float reduction);
+void DeleteMeshLodChain(MeshLodChain *chain);
+
+// the coarsest level whose error, at distance from a camera projecting with
+// projection onto screenHeight pixels, stays under pixelError
+int MeshLodSelect(const MeshLodChain *chain, Mat4x4 projection, float screenHeight, float distance, float pixelError);
+
+#endif // __MESH_H__
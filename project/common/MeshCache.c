@@ -0,0 +1,292 @@
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+#include "MeshCache.h"
+#include "MeshImport.h"
+#include "Hash.h"
+
+#define MESH_CACHE_BYTE_ORDER 0x01020304u
+
+uint64_t MeshCacheKey(const void *source, size_t size, int maxLods)
+{
+	// the options that shape the cache are part of the key
+	return HashBytes(source, size, (uint64_t)MESH_CACHE_VERSION << 32 | (uint32_t)maxLods);
+}
+
+static size_t MeshCacheAlign(size_t offset)
+{
+	return (offset + MESH_CACHE_ALIGNMENT - 1) & ~(size_t)(MESH_CACHE_ALIGNMENT - 1);
+}
+
+// header hash with the checksum field zeroed, then the blobs
+static uint64_t MeshCacheChecksum(const MeshCacheHeader *header, const unsigned char *file)
+{
+	MeshCacheHeader copy = *header;
+	copy.checksum = 0;
+
+	uint64_t seed = HashBytes(&copy, sizeof(copy), 0);
+
+	return HashBytes(file + sizeof(copy), (size_t)(header->fileSize - sizeof(copy)), seed);
+}
+
+bool MeshCacheWrite(const char *pathname, const Mesh *mesh, const ShaderElement *layout, const MeshLodChain *lods, uint64_t sourceHash)
+{
+	if (layout->size > MESH_CACHE_MAX_KINDS)
+	{
+		fprintf(stderr, "[ERROR]: Mesh cache layouts take at most %d kinds.\n", MESH_CACHE_MAX_KINDS);
+		return false;
+	}
+
+	size_t indexCount = lods ? lods->indexCount : mesh->indexCount;
+	unsigned int indexType = MeshIndexType(mesh->vertexCount);
+	size_t indexSize = MeshIndexSize(indexType);
+
+	MeshCacheHeader header = { 0 };
+	memcpy(header.magic, "MSHC", 4);
+	header.version = MESH_CACHE_VERSION;
+	header.byteOrder = MESH_CACHE_BYTE_ORDER;
+	header.headerSize = sizeof(MeshCacheHeader);
+	header.sourceHash = sourceHash;
+
+	for (size_t i = 0; i < layout->size; ++i)
+		header.kinds[i] = (uint32_t)layout->kinds[i];
+	header.kindCount = (uint32_t)layout->size;
+	header.openGLType = layout->openGLType;
+	header.normalized = layout->normalized;
+	header.stride = (uint32_t)mesh->stride;
+
+	header.vertexCount = mesh->vertexCount;
+	header.vertexOffset = MeshCacheAlign(sizeof(MeshCacheHeader));
+	header.indexCount = indexCount;
+	header.indexOffset = MeshCacheAlign(header.vertexOffset + mesh->vertexCount * mesh->stride);
+	header.indexType = indexType;
+	header.fileSize = header.indexOffset + indexCount * indexSize;
+
+	if (lods)
+	{
+		header.lodCount = (uint32_t)lods->lodCount;
+		for (int lod = 0; lod < lods->lodCount; ++lod)
+			header.lods[lod] = (MeshCacheLod) { (uint32_t)lods->lods[lod].firstIndex, (uint32_t)lods->lods[lod].indexCount, lods->lods[lod].error };
+	}
+	else
+	{
+		header.lodCount = 1;
+		header.lods[0] = (MeshCacheLod) { 0, (uint32_t)indexCount, 0.0f };
+	}
+
+	// positions are the first 3 floats of a vertex
+	for (int k = 0; k < 3; ++k)
+	{
+		header.boundsMin[k] = mesh->vertexCount ? FLT_MAX : 0.0f;
+		header.boundsMax[k] = mesh->vertexCount ? -FLT_MAX : 0.0f;
+	}
+
+	for (size_t v = 0; v < mesh->vertexCount; ++v)
+	{
+		float position[3];
+		memcpy(position, mesh->vertices + v * mesh->stride, sizeof(position));
+
+		for (int k = 0; k < 3; ++k)
+		{
+			if (position[k] < header.boundsMin[k]) header.boundsMin[k] = position[k];
+			if (position[k] > header.boundsMax[k]) header.boundsMax[k] = position[k];
+		}
+	}
+
+	// the whole file in memory, written once
+	unsigned char *file = calloc(1, (size_t)header.fileSize);
+	if (file == NULL)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate mesh cache of %llu bytes.\n", (unsigned long long)header.fileSize);
+		return false;
+	}
+
+	memcpy(file + header.vertexOffset, mesh->vertices, mesh->vertexCount * mesh->stride);
+
+	const void *indices = lods ? (const void *)lods->indices : mesh->indices;
+	unsigned int sourceType = lods ? GL_UNSIGNED_INT : mesh->indexType;
+	unsigned char *destination = file + header.indexOffset;
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		unsigned int index = sourceType == GL_UNSIGNED_SHORT ? ((const unsigned short *)indices)[i] : ((const unsigned int *)indices)[i];
+
+		if (indexType == GL_UNSIGNED_SHORT)
+		{
+			unsigned short narrow = (unsigned short)index;
+			memcpy(destination + i * indexSize, &narrow, indexSize);
+		}
+		else
+		{
+			memcpy(destination + i * indexSize, &index, indexSize);
+		}
+	}
+
+	memcpy(file, &header, sizeof(header));
+	header.checksum = MeshCacheChecksum(&header, file);
+	memcpy(file, &header, sizeof(header));
+
+	// the cache only appears once it is complete
+	bool written = WriteFileAtomic(pathname, file, (size_t)header.fileSize);
+
+	free(file);
+
+	return written;
+}
+
+static bool MeshCacheValid(const MeshCacheHeader *header, size_t fileSize, uint64_t sourceHash, const char **reason)
+{
+	if (memcmp(header->magic, "MSHC", 4) != 0) { *reason = "is not a mesh cache"; return false; }
+	if (header->version != MESH_CACHE_VERSION) { *reason = "has another version"; return false; }
+	if (header->byteOrder != MESH_CACHE_BYTE_ORDER) { *reason = "has another byte order"; return false; }
+	if (header->headerSize != sizeof(MeshCacheHeader) || header->fileSize != fileSize) { *reason = "is truncated"; return false; }
+	if (header->sourceHash != sourceHash) { *reason = "belongs to another source"; return false; }
+
+	*reason = "is damaged";
+
+	if (header->kindCount == 0 || header->kindCount > MESH_CACHE_MAX_KINDS) return false;
+	if (header->indexType != GL_UNSIGNED_SHORT && header->indexType != GL_UNSIGNED_INT) return false;
+	if (header->lodCount > MESH_MAX_LODS) return false;
+
+	if (header->vertexOffset < sizeof(MeshCacheHeader) || header->vertexOffset > fileSize || header->vertexOffset % MESH_CACHE_ALIGNMENT) return false;
+	if (header->indexOffset % MESH_CACHE_ALIGNMENT) return false;
+	if (header->stride && header->vertexCount > (fileSize - header->vertexOffset) / header->stride) return false;
+	if (header->indexOffset < header->vertexOffset + header->vertexCount * header->stride || header->indexOffset > fileSize) return false;
+	if (header->indexCount > (fileSize - header->indexOffset) / MeshIndexSize(header->indexType)) return false;
+
+	for (uint32_t lod = 0; lod < header->lodCount; ++lod)
+		if (header->lods[lod].firstIndex > header->indexCount || header->lods[lod].indexCount > header->indexCount - header->lods[lod].firstIndex)
+			return false;
+
+	return true;
+}
+
+bool MeshCacheOpen(MeshCache *cache, const char *pathname, uint64_t sourceHash)
+{
+	*cache = (MeshCache) { 0 };
+
+	MappedFile file = MapFile(pathname);
+	if (file.data == NULL)
+		return false;
+
+	if (file.size < sizeof(MeshCacheHeader))
+	{
+		fprintf(stderr, "[ERROR]: Mesh cache %s is truncated.\n", pathname);
+		UnmapFile(&file);
+		return false;
+	}
+
+	// the mapping is page aligned, so is the header
+	const MeshCacheHeader *header = (const MeshCacheHeader *)file.data;
+	const char *reason;
+
+	if (!MeshCacheValid(header, file.size, sourceHash, &reason))
+	{
+		fprintf(stderr, "[ERROR]: Mesh cache %s %s.\n", pathname, reason);
+		UnmapFile(&file);
+		return false;
+	}
+
+	if (MeshCacheChecksum(header, (const unsigned char *)file.data) != header->checksum)
+	{
+		fprintf(stderr, "[ERROR]: Mesh cache %s failed its checksum.\n", pathname);
+		UnmapFile(&file);
+		return false;
+	}
+
+	cache->file = file;
+	cache->header = header;
+
+	for (uint32_t i = 0; i < header->kindCount; ++i)
+		cache->kinds[i] = (ShaderElementKind)header->kinds[i];
+
+	cache->vertices = file.data + header->vertexOffset;
+	cache->vertexCount = (size_t)header->vertexCount;
+	cache->stride = header->stride;
+	cache->indices = file.data + header->indexOffset;
+	cache->indexCount = (size_t)header->indexCount;
+	cache->indexType = header->indexType;
+
+	cache->boundsMin = (Vec3) { header->boundsMin[0], header->boundsMin[1], header->boundsMin[2] };
+	cache->boundsMax = (Vec3) { header->boundsMax[0], header->boundsMax[1], header->boundsMax[2] };
+
+	cache->lods.indexCount = cache->indexCount;
+	cache->lods.lodCount = (int)header->lodCount;
+	for (uint32_t lod = 0; lod < header->lodCount; ++lod)
+		cache->lods.lods[lod] = (MeshLod) { header->lods[lod].firstIndex, header->lods[lod].indexCount, header->lods[lod].error };
+
+	return true;
+}
+
+void MeshCacheClose(MeshCache *cache)
+{
+	UnmapFile(&cache->file);
+
+	*cache = (MeshCache) { 0 };
+}
+
+ShaderElement MeshCacheLayout(MeshCache *cache)
+{
+	return InitShaderElement(cache->kinds, cache->header->kindCount, cache->header->openGLType, cache->header->normalized);
+}
+
+void MeshCacheUpload(const MeshCache *cache, VertexBuffer *vb, ElementBuffer *eb)
+{
+	// the driver reads the mapped pages directly, nothing is staged here
+	*vb = CreateVertexBuffer((float *)cache->vertices, cache->vertexCount * cache->stride, STATIC);
+	*eb = CreateElementBuffer(cache->indices, cache->indexCount * MeshIndexSize(cache->indexType), STATIC);
+}
+
+bool LoadMeshCached(MeshCache *cache, const char *pathname, const char *cacheDirectory, int maxLods)
+{
+	*cache = (MeshCache) { 0 };
+
+	MappedFile source = MapFile(pathname);
+	if (source.data == NULL)
+		return false;
+
+	uint64_t hash = MeshCacheKey(source.data, source.size, maxLods);
+	UnmapFile(&source);
+
+	char cachePath[1024];
+	snprintf(cachePath, sizeof(cachePath), "%s/%016llx.mesh", cacheDirectory, (unsigned long long)hash);
+
+	FILE *probe = fopen(cachePath, "rb");
+	if (probe)
+	{
+		fclose(probe);
+
+		if (MeshCacheOpen(cache, cachePath, hash))
+			return true;
+	}
+
+	MeshImport import = ImportMesh(pathname);
+	Mesh *mesh = &import.mesh;
+
+	if (mesh->indexCount == 0)
+	{
+		DeleteMeshImport(&import);
+		return false;
+	}
+
+	MeshOptimizeVertexCache(mesh->indices, mesh->indexCount, mesh->vertexCount);
+	mesh->vertexCount = MeshOptimizeVertexFetch(mesh->vertices, mesh->indices, mesh->indexCount, mesh->vertexCount, mesh->stride);
+
+	MeshLodChain chain = { 0 };
+
+	if (maxLods > 1)
+	{
+		// uv and normal differences count a little next to the geometric error
+		MeshSimplifyDesc desc = { mesh->indices, mesh->indexCount, mesh->vertices, mesh->vertexCount, mesh->stride, 0.01f };
+		chain = CreateMeshLodChain(&desc, maxLods, 0.5f);
+	}
+
+	ShaderElement layout = MeshImportLayout(&import);
+	bool written = MeshCacheWrite(cachePath, mesh, &layout, chain.lodCount ? &chain : NULL, hash);
+
+	DeleteMeshLodChain(&chain);
+	DeleteMeshImport(&import);
+
+	return written && MeshCacheOpen(cache, cachePath, hash);
+}
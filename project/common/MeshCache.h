@@ -0,0 +1,113 @@
+#ifndef __MESH_CACHE_H__
+#define __MESH_CACHE_H__
+
+#include <stdint.h>
+
+#include "Graphic.h"
+#include "Mesh.h"
+#include "IO.h"
+
+/*
+	Binary mesh cache, so text meshes are parsed and optimized once.
+
+	A cache file is a MeshCacheHeader followed by the vertex and the index
+	blob, each starting on a MESH_CACHE_ALIGNMENT boundary:
+
+		header    magic, version, byte order, source hash, checksum,
+		          vertex layout (ShaderElementKind list and GL type),
+		          counts and offsets, bounds, LOD table
+		vertices  vertexCount * stride bytes
+		indices   indexCount unsigned short or unsigned int, every LOD
+		          level back to back, finest first
+
+	MeshCacheOpen maps the file and checks the header and a 64 bit checksum
+	of header and blobs; anything that does not match (other version, other
+	byte order, truncated or damaged file) is refused rather than trusted.
+	The blobs are used where they are mapped: MeshCacheUpload hands them to
+	glBufferData without a copy in between.
+
+	LoadMeshCached is the asset path. It hashes the source file and looks for
+	<hash>.mesh in the cache directory; on a miss it imports the source,
+	optimizes it for the vertex cache and fetch, builds the LOD levels and
+	writes the cache (to a temporary name first, so a crash never leaves a
+	half written cache behind) before mapping it.
+*/
+
+#define MESH_CACHE_VERSION 1
+#define MESH_CACHE_ALIGNMENT 64
+#define MESH_CACHE_MAX_KINDS 8
+
+typedef struct MeshCacheLod {
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float error;
+} MeshCacheLod;
+
+// no padding anywhere, the checksum covers its bytes as they are
+typedef struct MeshCacheHeader {
+	char magic[4];           // "MSHC"
+	uint32_t version;
+	uint32_t byteOrder;      // 0x01020304 as written by the host
+	uint32_t headerSize;
+	uint64_t sourceHash;
+	uint64_t checksum;       // of the header with this field zeroed, then the blobs
+	uint64_t fileSize;
+
+	uint32_t kinds[MESH_CACHE_MAX_KINDS]; // ShaderElementKind
+	uint32_t kindCount;
+	uint32_t openGLType;
+	uint32_t normalized;
+	uint32_t stride;
+
+	uint64_t vertexCount;
+	uint64_t vertexOffset;
+	uint64_t indexCount;
+	uint64_t indexOffset;
+	uint32_t indexType;      // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+
+	float boundsMin[3];
+	float boundsMax[3];
+
+	uint32_t lodCount;
+	MeshCacheLod lods[MESH_MAX_LODS];
+} MeshCacheHeader;
+
+typedef struct MeshCache {
+	MappedFile file;
+	const MeshCacheHeader *header;
+	ShaderElementKind kinds[MESH_CACHE_MAX_KINDS];
+
+	const void *vertices;    // inside the mapping
+	size_t vertexCount;
+	size_t stride;
+	const void *indices;     // inside the mapping
+	size_t indexCount;
+	unsigned int indexType;
+
+	Vec3 boundsMin;
+	Vec3 boundsMax;
+
+	MeshLodChain lods;       // ranges for MeshLodSelect, indices stay NULL
+} MeshCache;
+
+// the key LoadMeshCached files a source under, <key>.mesh as 16 hex digits
+uint64_t MeshCacheKey(const void *source, size_t size, int maxLods);
+
+// writes mesh with the given layout, lods may be NULL for a single level over all indices
+bool MeshCacheWrite(const char *pathname, const Mesh *mesh, const ShaderElement *layout, const MeshLodChain *lods, uint64_t sourceHash);
+
+// maps and validates a cache written for sourceHash, false leaves cache empty
+bool MeshCacheOpen(MeshCache *cache, const char *pathname, uint64_t sourceHash);
+void MeshCacheClose(MeshCache *cache);
+
+// the vertex layout of the cache, it points into cache
+ShaderElement MeshCacheLayout(MeshCache *cache);
+
+// create the buffers straight from the mapping
+void MeshCacheUpload(const MeshCache *cache, VertexBuffer *vb, ElementBuffer *eb);
+
+// open the cache of an OBJ or PLY file in cacheDirectory, or import it and
+// build the cache there first. maxLods is 1 to skip simplification.
+bool LoadMeshCached(MeshCache *cache, const char *pathname, const char *cacheDirectory, int maxLods);
+
+#endif // __MESH_CACHE_H__
@@ -0,0 +1,1184 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <ctype.h>
+
+#include "MeshImport.h"
+#include "IO.h"
+#include "Job.h"
+
+#define IMPORT_NONE 0xFFFFFFFFu
+
+// chunk local arrays, grown by doubling
+typedef struct ImportBuffer {
+	unsigned char *data;
+	size_t size;
+	size_t capacity;
+	bool failed;
+} ImportBuffer;
+
+static void *ImportReserve(ImportBuffer *buffer, size_t size)
+{
+	if (buffer->size + size > buffer->capacity)
+	{
+		size_t capacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+		while (capacity < buffer->size + size) capacity *= 2;
+
+		unsigned char *data = realloc(buffer->data, capacity);
+		if (data == NULL)
+		{
+			buffer->failed = true;
+			return NULL;
+		}
+
+		buffer->data = data;
+		buffer->capacity = capacity;
+	}
+
+	void *result = buffer->data + buffer->size;
+	buffer->size += size;
+
+	return result;
+}
+
+static void ImportFree(ImportBuffer *buffer)
+{
+	free(buffer->data);
+	*buffer = (ImportBuffer) { 0 };
+}
+
+static MeshImport ImportResult(bool hasNormals, bool hasUVs)
+{
+	MeshImport import = { 0 };
+
+	import.kinds[import.kindCount++] = f3;
+	if (hasNormals) import.kinds[import.kindCount++] = f3;
+	if (hasUVs) import.kinds[import.kindCount++] = f2;
+
+	import.hasNormals = hasNormals;
+	import.hasUVs = hasUVs;
+	import.mesh.stride = (3 + (hasNormals ? 3 : 0) + (hasUVs ? 2 : 0)) * sizeof(float);
+	import.mesh.indexType = GL_UNSIGNED_INT;
+
+	return import;
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Text
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+static const double importPowers[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static bool ImportIsDigit(char c)
+{
+	return (unsigned char)(c - '0') < 10;
+}
+
+static const char *ImportSkipSpace(const char *s, const char *end)
+{
+	while (s < end && (*s == ' ' || *s == '\t' || *s == '\r'))
+		++s;
+
+	return s;
+}
+
+// the start of the next line
+static const char *ImportSkipLine(const char *s, const char *end)
+{
+	const char *newline = memchr(s, '\n', (size_t)(end - s));
+
+	return newline ? newline + 1 : end;
+}
+
+// decimal text to float, s is returned unchanged when there is no number.
+// Up to 19 significant digits are kept, enough for anything a float holds.
+static const char *ImportParseFloat(const char *s, const char *end, float *result)
+{
+	const char *start = s = ImportSkipSpace(s, end);
+
+	bool negative = false;
+	if (s < end && (*s == '-' || *s == '+'))
+		negative = *s++ == '-';
+
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool any = false;
+
+	for (; s < end && ImportIsDigit(*s); ++s, any = true)
+	{
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (uint64_t)(*s - '0');
+			if (mantissa) ++digits;
+		}
+		else
+		{
+			++exponent;
+		}
+	}
+
+	if (s < end && *s == '.')
+	{
+		for (++s; s < end && ImportIsDigit(*s); ++s, any = true)
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (uint64_t)(*s - '0');
+				if (mantissa) ++digits;
+				--exponent;
+			}
+		}
+	}
+
+	if (!any)
+	{
+		*result = 0.0f;
+		return start;
+	}
+
+	if (s < end && (*s == 'e' || *s == 'E'))
+	{
+		const char *e = s + 1;
+		bool negativeExponent = false;
+
+		if (e < end && (*e == '-' || *e == '+'))
+			negativeExponent = *e++ == '-';
+
+		if (e < end && ImportIsDigit(*e))
+		{
+			int value = 0;
+			for (; e < end && ImportIsDigit(*e); ++e)
+				if (value < 10000) value = value * 10 + (*e - '0');
+
+			exponent += negativeExponent ? -value : value;
+			s = e;
+		}
+	}
+
+	double value = (double)mantissa;
+
+	for (; exponent > 22; exponent -= 22) value *= 1e22;
+	for (; exponent < -22; exponent += 22) value /= 1e22;
+	value = exponent >= 0 ? value * importPowers[exponent] : value / importPowers[-exponent];
+
+	*result = (float)(negative ? -value : value);
+
+	return s;
+}
+
+// parsed integers saturate here, past any index or count a file can use
+#define IMPORT_INT_MAX 0x7FFFFFFFl
+
+static const char *ImportParseInt(const char *s, const char *end, long *result)
+{
+	const char *start = s = ImportSkipSpace(s, end);
+
+	bool negative = false;
+	if (s < end && (*s == '-' || *s == '+'))
+		negative = *s++ == '-';
+
+	if (s == end || !ImportIsDigit(*s))
+	{
+		*result = 0;
+		return start;
+	}
+
+	long value = 0;
+	for (; s < end && ImportIsDigit(*s); ++s)
+	{
+		int digit = *s - '0';
+		value = value > (IMPORT_INT_MAX - digit) / 10 ? IMPORT_INT_MAX : value * 10 + digit;
+	}
+
+	*result = negative ? -value : value;
+
+	return s;
+}
+
+// split [data, data + size) into count pieces ending on line ends
+static void ImportSplitLines(const char *data, size_t size, size_t count, const char **begins, const char **ends)
+{
+	const char *end = data + size;
+	const char *previous = data;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const char *split = end;
+
+		if (i + 1 < count)
+		{
+			split = data + size / count * (i + 1);
+			if (split < previous) split = previous;
+			split = ImportSkipLine(split, end);
+		}
+
+		begins[i] = previous;
+		ends[i] = split;
+		previous = split;
+	}
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	OBJ
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// negative indices count back from the vertices before the face; the chunk only
+// knows its own count, so they keep the bias until the chunk bases are known
+#define OBJ_RELATIVE 0x80000000u
+#define OBJ_RELATIVE_BIAS 0x40000000l
+
+// relative 0 lands before every chunk base, so it always decodes out of range
+#define OBJ_OUT_OF_RANGE OBJ_RELATIVE
+
+typedef struct ObjChunk {
+	const char *begin;
+	const char *end;
+	ImportBuffer positions; // float[3]
+	ImportBuffer uvs;       // float[2]
+	ImportBuffer normals;   // float[3]
+	ImportBuffer corners;   // uint32_t[3], position uv normal, three per triangle
+	size_t positionBase;
+	size_t uvBase;
+	size_t normalBase;
+	size_t cornerBase;
+} ObjChunk;
+
+// an index that does not fit beside the OBJ_RELATIVE bit is out of range
+static uint32_t ObjEncodeIndex(long index, size_t localCount)
+{
+	if (index > 0)
+		return (unsigned long)index < OBJ_RELATIVE ? (uint32_t)index : OBJ_OUT_OF_RANGE;
+
+	if (index < 0)
+	{
+		long relative = (long)localCount + index + OBJ_RELATIVE_BIAS;
+		return relative > 0 && (unsigned long)relative < OBJ_RELATIVE ? OBJ_RELATIVE | (uint32_t)relative : OBJ_OUT_OF_RANGE;
+	}
+
+	return 0;
+}
+
+// 0 based global index, IMPORT_NONE when missing or out of range
+static uint32_t ObjDecodeIndex(uint32_t encoded, size_t base, size_t count)
+{
+	long index;
+
+	if (encoded == 0) return IMPORT_NONE;
+
+	if (encoded & OBJ_RELATIVE)
+		index = (long)base + (long)(encoded & ~OBJ_RELATIVE) - OBJ_RELATIVE_BIAS;
+	else
+		index = (long)encoded - 1;
+
+	return index >= 0 && (size_t)index < count ? (uint32_t)index : IMPORT_NONE;
+}
+
+static void ObjPushFloats(ImportBuffer *buffer, const char *s, const char *end, int count)
+{
+	float *values = ImportReserve(buffer, count * sizeof(float));
+	if (values == NULL) return;
+
+	for (int i = 0; i < count; ++i)
+		s = ImportParseFloat(s, end, &values[i]);
+}
+
+static void ObjParseFace(ObjChunk *chunk, const char *s, const char *end)
+{
+	uint32_t first[3], previous[3];
+	int cornerCount = 0;
+
+	size_t positionCount = chunk->positions.size / (3 * sizeof(float));
+	size_t uvCount = chunk->uvs.size / (2 * sizeof(float));
+	size_t normalCount = chunk->normals.size / (3 * sizeof(float));
+
+	for (;;)
+	{
+		s = ImportSkipSpace(s, end);
+		if (s == end || *s == '\n' || *s == '#') break;
+
+		long p = 0, t = 0, n = 0;
+		const char *next = ImportParseInt(s, end, &p);
+
+		if (next < end && *next == '/')
+		{
+			next = ImportParseInt(next + 1, end, &t);
+
+			if (next < end && *next == '/')
+				next = ImportParseInt(next + 1, end, &n);
+		}
+
+		// skip whatever is left of the token
+		while (next < end && *next != ' ' && *next != '\t' && *next != '\r' && *next != '\n')
+			++next;
+		s = next;
+
+		uint32_t corner[3] = {
+			ObjEncodeIndex(p, positionCount),
+			ObjEncodeIndex(t, uvCount),
+			ObjEncodeIndex(n, normalCount)
+		};
+
+		// fan from the first corner
+		if (cornerCount >= 2)
+		{
+			uint32_t *triangle = ImportReserve(&chunk->corners, 9 * sizeof(uint32_t));
+			if (triangle == NULL) return;
+
+			memcpy(triangle + 0, first, sizeof(first));
+			memcpy(triangle + 3, previous, sizeof(previous));
+			memcpy(triangle + 6, corner, sizeof(corner));
+		}
+
+		if (cornerCount == 0) memcpy(first, corner, sizeof(corner));
+		memcpy(previous, corner, sizeof(corner));
+		++cornerCount;
+	}
+}
+
+static void ObjParseChunk(ObjChunk *chunk)
+{
+	const char *s = chunk->begin;
+	const char *end = chunk->end;
+
+	while (s < end)
+	{
+		s = ImportSkipSpace(s, end);
+
+		if (end - s >= 2 && s[0] == 'v')
+		{
+			if (s[1] == ' ' || s[1] == '\t')
+				ObjPushFloats(&chunk->positions, s + 1, end, 3);
+			else if (s[1] == 't' && end - s > 2 && (s[2] == ' ' || s[2] == '\t'))
+				ObjPushFloats(&chunk->uvs, s + 2, end, 2);
+			else if (s[1] == 'n' && end - s > 2 && (s[2] == ' ' || s[2] == '\t'))
+				ObjPushFloats(&chunk->normals, s + 2, end, 3);
+		}
+		else if (end - s >= 2 && s[0] == 'f' && (s[1] == ' ' || s[1] == '\t'))
+		{
+			ObjParseFace(chunk, s + 2, end);
+		}
+
+		s = ImportSkipLine(s, end);
+	}
+}
+
+typedef struct ObjJob {
+	ObjChunk *chunks;
+	float *positions;
+	float *uvs;
+	float *normals;
+	uint32_t *corners;
+	size_t positionCount;
+	size_t uvCount;
+	size_t normalCount;
+} ObjJob;
+
+static void ObjParseChunks(void *userData, size_t begin, size_t end)
+{
+	ObjJob *job = userData;
+
+	for (size_t i = begin; i < end; ++i)
+		ObjParseChunk(&job->chunks[i]);
+}
+
+// chunk arrays into the global ones, corners to 0 based global indices
+static void ObjMergeChunks(void *userData, size_t begin, size_t end)
+{
+	ObjJob *job = userData;
+
+	for (size_t i = begin; i < end; ++i)
+	{
+		ObjChunk *chunk = &job->chunks[i];
+
+		if (chunk->positions.size) memcpy(job->positions + chunk->positionBase * 3, chunk->positions.data, chunk->positions.size);
+		if (chunk->uvs.size) memcpy(job->uvs + chunk->uvBase * 2, chunk->uvs.data, chunk->uvs.size);
+		if (chunk->normals.size) memcpy(job->normals + chunk->normalBase * 3, chunk->normals.data, chunk->normals.size);
+
+		const uint32_t *source = (const uint32_t *)chunk->corners.data;
+		uint32_t *destination = job->corners + chunk->cornerBase * 3;
+		size_t cornerCount = chunk->corners.size / (3 * sizeof(uint32_t));
+
+		for (size_t c = 0; c < cornerCount; ++c)
+		{
+			destination[c * 3 + 0] = ObjDecodeIndex(source[c * 3 + 0], chunk->positionBase, job->positionCount);
+			destination[c * 3 + 1] = ObjDecodeIndex(source[c * 3 + 1], chunk->uvBase, job->uvCount);
+			destination[c * 3 + 2] = ObjDecodeIndex(source[c * 3 + 2], chunk->normalBase, job->normalCount);
+		}
+	}
+}
+
+typedef struct ObjVertexJob {
+	const ObjJob *obj;
+	const uint32_t *keys; // position uv normal of every vertex
+	MeshImport *import;
+} ObjVertexJob;
+
+static void ObjWriteVertices(void *userData, size_t begin, size_t end)
+{
+	ObjVertexJob *job = userData;
+	const ObjJob *obj = job->obj;
+	size_t floats = job->import->mesh.stride / sizeof(float);
+
+	for (size_t v = begin; v < end; ++v)
+	{
+		float *vertex = (float *)job->import->mesh.vertices + v * floats;
+		const uint32_t *key = job->keys + v * 3;
+
+		memcpy(vertex, obj->positions + key[0] * 3, 3 * sizeof(float));
+		vertex += 3;
+
+		if (job->import->hasNormals)
+		{
+			if (key[2] != IMPORT_NONE) memcpy(vertex, obj->normals + key[2] * 3, 3 * sizeof(float));
+			else memset(vertex, 0, 3 * sizeof(float));
+			vertex += 3;
+		}
+
+		if (job->import->hasUVs)
+		{
+			if (key[1] != IMPORT_NONE) memcpy(vertex, obj->uvs + key[1] * 2, 2 * sizeof(float));
+			else memset(vertex, 0, 2 * sizeof(float));
+		}
+	}
+}
+
+MeshImport ImportMeshOBJ(const char *data, size_t size)
+{
+	MeshImport import = { 0 };
+
+	size_t chunkCount = size / MESH_IMPORT_CHUNK + 1;
+	ObjChunk *chunks = calloc(chunkCount, sizeof(ObjChunk));
+	const char **bounds = malloc(chunkCount * 2 * sizeof(const char *));
+
+	ObjJob job = { .chunks = chunks };
+	uint32_t *keys = NULL, *heads = NULL, *next = NULL;
+
+	if (!chunks || !bounds)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate OBJ import of %zu bytes.\n", size);
+		goto done;
+	}
+
+	ImportSplitLines(data, size, chunkCount, bounds, bounds + chunkCount);
+	for (size_t i = 0; i < chunkCount; ++i)
+	{
+		chunks[i].begin = bounds[i];
+		chunks[i].end = bounds[chunkCount + i];
+	}
+
+	JobParallelFor(chunkCount, 1, ObjParseChunks, &job);
+
+	size_t cornerCount = 0;
+	for (size_t i = 0; i < chunkCount; ++i)
+	{
+		ObjChunk *chunk = &chunks[i];
+
+		if (chunk->positions.failed || chunk->uvs.failed || chunk->normals.failed || chunk->corners.failed)
+		{
+			fprintf(stderr, "[ERROR]: Failed to allocate OBJ import of %zu bytes.\n", size);
+			goto done;
+		}
+
+		chunk->positionBase = job.positionCount;
+		chunk->uvBase = job.uvCount;
+		chunk->normalBase = job.normalCount;
+		chunk->cornerBase = cornerCount;
+
+		job.positionCount += chunk->positions.size / (3 * sizeof(float));
+		job.uvCount += chunk->uvs.size / (2 * sizeof(float));
+		job.normalCount += chunk->normals.size / (3 * sizeof(float));
+		cornerCount += chunk->corners.size / (3 * sizeof(uint32_t));
+	}
+
+	job.positions = malloc((job.positionCount * 3 + 1) * sizeof(float));
+	job.uvs = malloc((job.uvCount * 2 + 1) * sizeof(float));
+	job.normals = malloc((job.normalCount * 3 + 1) * sizeof(float));
+	job.corners = malloc((cornerCount * 3 + 1) * sizeof(uint32_t));
+
+	if (!job.positions || !job.uvs || !job.normals || !job.corners)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate OBJ import of %zu bytes.\n", size);
+		goto done;
+	}
+
+	JobParallelFor(chunkCount, 1, ObjMergeChunks, &job);
+
+	import = ImportResult(job.normalCount > 0, job.uvCount > 0);
+
+	// one vertex per distinct position uv normal, found through a list per position
+	keys = malloc((cornerCount * 3 + 1) * sizeof(uint32_t));
+	heads = malloc((job.positionCount + 1) * sizeof(uint32_t));
+	next = malloc((cornerCount + 1) * sizeof(uint32_t));
+	unsigned int *indices = malloc((cornerCount + 1) * sizeof(unsigned int));
+
+	if (!keys || !heads || !next || !indices)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate OBJ import of %zu bytes.\n", size);
+		free(indices);
+		import = (MeshImport) { 0 };
+		goto done;
+	}
+	memset(heads, 0xFF, job.positionCount * sizeof(uint32_t));
+
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+	size_t invalid = 0;
+
+	for (size_t c = 0; c < cornerCount; c += 3)
+	{
+		const uint32_t *triangle = job.corners + c * 3;
+
+		if (triangle[0] == IMPORT_NONE || triangle[3] == IMPORT_NONE || triangle[6] == IMPORT_NONE)
+		{
+			++invalid;
+			continue;
+		}
+
+		for (int k = 0; k < 3; ++k)
+		{
+			const uint32_t *corner = triangle + k * 3;
+			uint32_t v = heads[corner[0]];
+
+			while (v != IMPORT_NONE && (keys[v * 3 + 1] != corner[1] || keys[v * 3 + 2] != corner[2]))
+				v = next[v];
+
+			if (v == IMPORT_NONE)
+			{
+				v = (uint32_t)vertexCount++;
+				memcpy(keys + v * 3, corner, 3 * sizeof(uint32_t));
+				next[v] = heads[corner[0]];
+				heads[corner[0]] = v;
+			}
+
+			indices[indexCount++] = v;
+		}
+	}
+
+	if (invalid)
+		fprintf(stderr, "[ERROR]: Skipped %zu OBJ triangles with missing positions.\n", invalid);
+
+	import.mesh.vertices = malloc(vertexCount * import.mesh.stride + 1);
+	if (import.mesh.vertices == NULL)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate %zu OBJ vertices.\n", vertexCount);
+		free(indices);
+		import = (MeshImport) { 0 };
+		goto done;
+	}
+
+	ObjVertexJob vertexJob = { &job, keys, &import };
+	JobParallelFor(vertexCount, 4096, ObjWriteVertices, &vertexJob);
+
+	import.mesh.vertexCount = vertexCount;
+	import.mesh.indices = indices;
+	import.mesh.indexCount = indexCount;
+
+done:
+	for (size_t i = 0; chunks && i < chunkCount; ++i)
+	{
+		ImportFree(&chunks[i].positions);
+		ImportFree(&chunks[i].uvs);
+		ImportFree(&chunks[i].normals);
+		ImportFree(&chunks[i].corners);
+	}
+
+	free(chunks);
+	free(bounds);
+	free(job.positions);
+	free(job.uvs);
+	free(job.normals);
+	free(job.corners);
+	free(keys);
+	free(heads);
+	free(next);
+
+	return import;
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	PLY
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+#define PLY_MAX_PROPERTIES 32
+#define PLY_MAX_ELEMENTS 16
+
+// lines of an ascii vertex block parsed by one job
+#define PLY_LINES_PER_BLOCK 16384
+
+typedef enum {
+	PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16,
+	PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64,
+	PLY_INVALID
+} PlyType;
+
+typedef enum {
+	PLY_ASCII,
+	PLY_LITTLE_ENDIAN,
+	PLY_BIG_ENDIAN
+} PlyFormat;
+
+typedef struct PlyProperty {
+	char name[32];
+	PlyType type;      // the items of a list
+	PlyType countType; // PLY_INVALID when not a list
+} PlyProperty;
+
+typedef struct PlyElement {
+	char name[32];
+	size_t count;
+	PlyProperty properties[PLY_MAX_PROPERTIES];
+	int propertyCount;
+} PlyElement;
+
+// vertex properties the mesh uses, by property index, -1 when missing
+enum { PLY_X, PLY_Y, PLY_Z, PLY_NX, PLY_NY, PLY_NZ, PLY_U, PLY_V, PLY_FIELDS };
+
+typedef struct PlyVertexJob {
+	PlyFormat format;
+	const PlyElement *element;
+	int fields[PLY_FIELDS];
+	size_t offsets[PLY_MAX_PROPERTIES]; // binary
+	size_t size;                        // binary bytes per vertex
+	const unsigned char *binary;
+	const char **blocks;                // ascii, a line start every PLY_LINES_PER_BLOCK vertices
+	const char *end;
+	MeshImport *import;
+	atomic_bool shortLine;              // ascii, a vertex line with fewer values than properties
+} PlyVertexJob;
+
+static const size_t plyTypeSizes[] = { 1, 1, 2, 2, 4, 4, 4, 8, 0 };
+
+static PlyType PlyParseType(const char *name)
+{
+	static const char *names[][2] = {
+		{ "char", "int8" }, { "uchar", "uint8" }, { "short", "int16" }, { "ushort", "uint16" },
+		{ "int", "int32" }, { "uint", "uint32" }, { "float", "float32" }, { "double", "float64" }
+	};
+
+	for (int i = 0; i < PLY_INVALID; ++i)
+		if (strcmp(name, names[i][0]) == 0 || strcmp(name, names[i][1]) == 0)
+			return (PlyType)i;
+
+	return PLY_INVALID;
+}
+
+static double PlyReadBinary(const unsigned char *p, PlyType type, bool swap)
+{
+	unsigned char bytes[8];
+	size_t size = plyTypeSizes[type];
+
+	for (size_t i = 0; i < size; ++i)
+		bytes[i] = swap ? p[size - 1 - i] : p[i];
+
+	switch (type)
+	{
+		case PLY_INT8:    { int8_t v;   memcpy(&v, bytes, 1); return v; }
+		case PLY_UINT8:   { uint8_t v;  memcpy(&v, bytes, 1); return v; }
+		case PLY_INT16:   { int16_t v;  memcpy(&v, bytes, 2); return v; }
+		case PLY_UINT16:  { uint16_t v; memcpy(&v, bytes, 2); return v; }
+		case PLY_INT32:   { int32_t v;  memcpy(&v, bytes, 4); return v; }
+		case PLY_UINT32:  { uint32_t v; memcpy(&v, bytes, 4); return v; }
+		case PLY_FLOAT32: { float v;    memcpy(&v, bytes, 4); return v; }
+		case PLY_FLOAT64: { double v;   memcpy(&v, bytes, 8); return v; }
+		default: return 0.0;
+	}
+}
+
+static bool PlyHostIsBigEndian(void)
+{
+	const uint16_t probe = 1;
+	unsigned char first;
+	memcpy(&first, &probe, 1);
+
+	return first == 0;
+}
+
+// the header up to end_header, returns where the data starts or NULL
+static const char *PlyParseHeader(const char *data, size_t size, PlyFormat *format, PlyElement *elements, int *elementCount)
+{
+	const char *s = data, *end = data + size;
+	PlyElement *element = NULL;
+
+	*elementCount = 0;
+
+	if (size < 4 || memcmp(data, "ply", 3) != 0)
+		return NULL;
+
+	while (s < end)
+	{
+		const char *lineEnd = memchr(s, '\n', (size_t)(end - s));
+		if (lineEnd == NULL) return NULL;
+
+		char line[256];
+		size_t length = (size_t)(lineEnd - s);
+		if (length >= sizeof(line)) length = sizeof(line) - 1;
+		memcpy(line, s, length);
+		line[length] = '\0';
+		s = lineEnd + 1;
+
+		char word[4][32] = { { 0 } };
+		int words = sscanf(line, "%31s %31s %31s %31s", word[0], word[1], word[2], word[3]);
+
+		if (words <= 0) continue;
+
+		if (strcmp(word[0], "end_header") == 0)
+			return s;
+
+		if (strcmp(word[0], "format") == 0 && words >= 2)
+		{
+			if (strcmp(word[1], "ascii") == 0) *format = PLY_ASCII;
+			else if (strcmp(word[1], "binary_little_endian") == 0) *format = PLY_LITTLE_ENDIAN;
+			else if (strcmp(word[1], "binary_big_endian") == 0) *format = PLY_BIG_ENDIAN;
+			else return NULL;
+		}
+		else if (strcmp(word[0], "element") == 0 && words >= 3)
+		{
+			if (*elementCount == PLY_MAX_ELEMENTS) return NULL;
+
+			element = &elements[(*elementCount)++];
+			*element = (PlyElement) { 0 };
+			strcpy(element->name, word[1]);
+			element->count = strtoull(word[2], NULL, 10);
+		}
+		else if (strcmp(word[0], "property") == 0 && element && words >= 3)
+		{
+			if (element->propertyCount == PLY_MAX_PROPERTIES) return NULL;
+
+			PlyProperty *property = &element->properties[element->propertyCount++];
+
+			if (strcmp(word[1], "list") == 0 && words >= 4)
+			{
+				property->countType = PlyParseType(word[2]);
+				property->type = PlyParseType(word[3]);
+
+				char name[32] = { 0 };
+				sscanf(line, "%*s %*s %*s %*s %31s", name);
+				strcpy(property->name, name);
+
+				if (property->countType == PLY_INVALID || property->type == PLY_INVALID) return NULL;
+			}
+			else
+			{
+				property->countType = PLY_INVALID;
+				property->type = PlyParseType(word[1]);
+				strcpy(property->name, word[2]);
+
+				if (property->type == PLY_INVALID) return NULL;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static int PlyFindProperty(const PlyElement *element, const char *const *names)
+{
+	for (int i = 0; i < element->propertyCount; ++i)
+		for (const char *const *name = names; *name; ++name)
+			if (element->properties[i].countType == PLY_INVALID && strcmp(element->properties[i].name, *name) == 0)
+				return i;
+
+	return -1;
+}
+
+static void PlyStoreVertex(PlyVertexJob *job, size_t v, const double *values)
+{
+	MeshImport *import = job->import;
+	float *vertex = (float *)import->mesh.vertices + v * (import->mesh.stride / sizeof(float));
+	int count = 3 + (import->hasNormals ? 3 : 0);
+
+	for (int i = 0; i < count; ++i)
+		*vertex++ = (float)values[job->fields[i]];
+
+	if (import->hasUVs)
+	{
+		*vertex++ = (float)values[job->fields[PLY_U]];
+		*vertex++ = (float)values[job->fields[PLY_V]];
+	}
+}
+
+// an ascii list or scalar value, NULL past the end of the line
+static const char *PlyParseAscii(const char *s, const char *end, double *value)
+{
+	float f;
+	const char *next = ImportParseFloat(s, end, &f);
+
+	*value = f;
+
+	return next == ImportSkipSpace(s, end) ? NULL : next;
+}
+
+static void PlyDecodeVertices(void *userData, size_t begin, size_t end)
+{
+	PlyVertexJob *job = userData;
+	const PlyElement *element = job->element;
+	double values[PLY_MAX_PROPERTIES] = { 0 };
+
+	if (job->format != PLY_ASCII)
+	{
+		bool swap = (job->format == PLY_BIG_ENDIAN) != PlyHostIsBigEndian();
+
+		for (size_t v = begin; v < end; ++v)
+		{
+			const unsigned char *vertex = job->binary + v * job->size;
+
+			for (int i = 0; i < element->propertyCount; ++i)
+				values[i] = PlyReadBinary(vertex + job->offsets[i], element->properties[i].type, swap);
+
+			PlyStoreVertex(job, v, values);
+		}
+
+		return;
+	}
+
+	// begin and end are blocks of lines here
+	for (size_t block = begin; block < end; ++block)
+	{
+		const char *s = job->blocks[block];
+		size_t first = block * PLY_LINES_PER_BLOCK;
+		size_t last = first + PLY_LINES_PER_BLOCK;
+		if (last > element->count) last = element->count;
+
+		for (size_t v = first; v < last; ++v)
+		{
+			for (int i = 0; i < element->propertyCount; ++i)
+			{
+				s = PlyParseAscii(s, job->end, &values[i]);
+
+				if (s == NULL)
+				{
+					atomic_store(&job->shortLine, true);
+					return;
+				}
+			}
+
+			PlyStoreVertex(job, v, values);
+			s = ImportSkipLine(s, job->end);
+		}
+	}
+}
+
+// fan triangulate a face, indices out of range drop the triangle
+static bool PlyPushFace(ImportBuffer *indices, const uint32_t *corners, size_t count, size_t vertexCount)
+{
+	for (size_t k = 2; k < count; ++k)
+	{
+		uint32_t a = corners[0], b = corners[k - 1], c = corners[k];
+		if (a >= vertexCount || b >= vertexCount || c >= vertexCount) continue;
+
+		uint32_t *triangle = ImportReserve(indices, 3 * sizeof(uint32_t));
+		if (triangle == NULL) return false;
+
+		triangle[0] = a; triangle[1] = b; triangle[2] = c;
+	}
+
+	return true;
+}
+
+// reads one element item from s, face lists named vertex_indices go to indices
+static const char *PlyReadItem(const char *s, const char *end, PlyFormat format, const PlyElement *element, bool face,
+		ImportBuffer *indices, size_t vertexCount)
+{
+	bool swap = (format == PLY_BIG_ENDIAN) != PlyHostIsBigEndian();
+	uint32_t corners[256];
+
+	for (int i = 0; i < element->propertyCount; ++i)
+	{
+		const PlyProperty *property = &element->properties[i];
+		bool faceIndices = face && property->countType != PLY_INVALID
+			&& (strcmp(property->name, "vertex_indices") == 0 || strcmp(property->name, "vertex_index") == 0);
+
+		double count = 1.0;
+
+		if (property->countType != PLY_INVALID)
+		{
+			if (format == PLY_ASCII)
+			{
+				s = PlyParseAscii(s, end, &count);
+				if (s == NULL) return NULL;
+			}
+			else
+			{
+				if ((size_t)(end - s) < plyTypeSizes[property->countType]) return NULL;
+				count = PlyReadBinary((const unsigned char *)s, property->countType, swap);
+				s += plyTypeSizes[property->countType];
+			}
+		}
+
+		size_t items = count > 0.0 ? (size_t)count : 0;
+
+		for (size_t k = 0; k < items; ++k)
+		{
+			double value;
+
+			if (format == PLY_ASCII)
+			{
+				s = PlyParseAscii(s, end, &value);
+				if (s == NULL) return NULL;
+			}
+			else
+			{
+				if ((size_t)(end - s) < plyTypeSizes[property->type]) return NULL;
+				value = PlyReadBinary((const unsigned char *)s, property->type, swap);
+				s += plyTypeSizes[property->type];
+			}
+
+			if (faceIndices && k < sizeof(corners) / sizeof(corners[0]))
+				corners[k] = value >= 0.0 ? (uint32_t)value : IMPORT_NONE;
+		}
+
+		if (faceIndices)
+		{
+			if (items > sizeof(corners) / sizeof(corners[0])) items = sizeof(corners) / sizeof(corners[0]);
+			if (!PlyPushFace(indices, corners, items, vertexCount)) return NULL;
+		}
+	}
+
+	return format == PLY_ASCII ? ImportSkipLine(s, end) : s;
+}
+
+MeshImport ImportMeshPLY(const char *data, size_t size)
+{
+	MeshImport import = { 0 };
+
+	PlyFormat format = PLY_ASCII;
+	PlyElement elements[PLY_MAX_ELEMENTS];
+	int elementCount;
+
+	const char *s = PlyParseHeader(data, size, &format, elements, &elementCount);
+	const char *end = data + size;
+
+	if (s == NULL)
+	{
+		fprintf(stderr, "[ERROR]: Not a PLY file, or a header this importer does not read.\n");
+		return import;
+	}
+
+	ImportBuffer indices = { 0 };
+	const char **blocks = NULL;
+	size_t vertexCount = 0;
+	bool failed = false;
+
+	for (int e = 0; e < elementCount && !failed; ++e)
+	{
+		const PlyElement *element = &elements[e];
+
+		if (strcmp(element->name, "vertex") == 0 && import.mesh.vertices == NULL)
+		{
+			static const char *const x[] = { "x", NULL }, *const y[] = { "y", NULL }, *const z[] = { "z", NULL };
+			static const char *const nx[] = { "nx", NULL }, *const ny[] = { "ny", NULL }, *const nz[] = { "nz", NULL };
+			static const char *const u[] = { "u", "s", "texture_u", "texture_s", NULL };
+			static const char *const v[] = { "v", "t", "texture_v", "texture_t", NULL };
+			const char *const *names[PLY_FIELDS] = { x, y, z, nx, ny, nz, u, v };
+
+			PlyVertexJob job = { .format = format, .element = element };
+			for (int f = 0; f < PLY_FIELDS; ++f)
+				job.fields[f] = PlyFindProperty(element, names[f]);
+
+			if (job.fields[PLY_X] < 0 || job.fields[PLY_Y] < 0 || job.fields[PLY_Z] < 0)
+			{
+				fprintf(stderr, "[ERROR]: PLY vertices without x, y and z.\n");
+				failed = true;
+				break;
+			}
+
+			// vertices are fixed size records, in binary files and for the line scan alike
+			for (int i = 0; i < element->propertyCount && !failed; ++i)
+				failed = element->properties[i].countType != PLY_INVALID;
+
+			if (failed)
+			{
+				fprintf(stderr, "[ERROR]: PLY vertex lists are not supported.\n");
+				break;
+			}
+
+			bool hasNormals = job.fields[PLY_NX] >= 0 && job.fields[PLY_NY] >= 0 && job.fields[PLY_NZ] >= 0;
+			bool hasUVs = job.fields[PLY_U] >= 0 && job.fields[PLY_V] >= 0;
+
+			import = ImportResult(hasNormals, hasUVs);
+			vertexCount = element->count;
+			job.import = &import;
+			job.end = end;
+			atomic_init(&job.shortLine, false);
+
+			// the count comes from the file, a huge one must not wrap the size
+			if (vertexCount > (SIZE_MAX - 1) / import.mesh.stride)
+			{
+				fprintf(stderr, "[ERROR]: PLY file claims %zu vertices.\n", vertexCount);
+				failed = true;
+				break;
+			}
+
+			import.mesh.vertices = malloc(vertexCount * import.mesh.stride + 1);
+
+			if (import.mesh.vertices == NULL)
+			{
+				fprintf(stderr, "[ERROR]: Failed to allocate %zu PLY vertices.\n", vertexCount);
+				failed = true;
+				break;
+			}
+
+			if (format != PLY_ASCII)
+			{
+				for (int i = 0; i < element->propertyCount; ++i)
+				{
+					job.offsets[i] = job.size;
+					job.size += plyTypeSizes[element->properties[i].type];
+				}
+
+				if ((size_t)(end - s) / (job.size ? job.size : 1) < vertexCount)
+				{
+					fprintf(stderr, "[ERROR]: PLY file ends inside the vertices.\n");
+					failed = true;
+					break;
+				}
+
+				job.binary = (const unsigned char *)s;
+				JobParallelFor(vertexCount, 4096, PlyDecodeVertices, &job);
+				s += job.size * vertexCount;
+			}
+			else
+			{
+				// the line starts of every block, then the blocks in parallel
+				size_t blockCount = (vertexCount + PLY_LINES_PER_BLOCK - 1) / PLY_LINES_PER_BLOCK;
+				blocks = malloc((blockCount + 1) * sizeof(const char *));
+
+				if (blocks == NULL)
+				{
+					fprintf(stderr, "[ERROR]: Failed to allocate %zu PLY vertices.\n", vertexCount);
+					failed = true;
+					break;
+				}
+
+				size_t line = 0;
+				for (; line < vertexCount && s < end; ++line)
+				{
+					if (line % PLY_LINES_PER_BLOCK == 0)
+						blocks[line / PLY_LINES_PER_BLOCK] = s;
+
+					s = ImportSkipLine(s, end);
+				}
+
+				if (line < vertexCount)
+				{
+					fprintf(stderr, "[ERROR]: PLY file ends after %zu of %zu vertices.\n", line, vertexCount);
+					failed = true;
+					break;
+				}
+
+				job.blocks = blocks;
+				JobParallelFor(blockCount, 1, PlyDecodeVertices, &job);
+
+				if (atomic_load(&job.shortLine))
+				{
+					fprintf(stderr, "[ERROR]: PLY vertex line with fewer values than properties.\n");
+					failed = true;
+					break;
+				}
+			}
+
+			import.mesh.vertexCount = vertexCount;
+			continue;
+		}
+
+		bool face = strcmp(element->name, "face") == 0;
+
+		for (size_t i = 0; i < element->count; ++i)
+		{
+			s = PlyReadItem(s, end, format, element, face, &indices, vertexCount);
+
+			if (s == NULL || indices.failed)
+			{
+				fprintf(stderr, "[ERROR]: PLY %s %zu is cut off or could not be stored.\n", element->name, i);
+				failed = true;
+				break;
+			}
+		}
+	}
+
+	free(blocks);
+
+	if (failed || import.mesh.vertices == NULL)
+	{
+		if (!failed) fprintf(stderr, "[ERROR]: PLY file without vertices.\n");
+		ImportFree(&indices);
+		DeleteMeshImport(&import);
+		return import;
+	}
+
+	import.mesh.indices = indices.data;
+	import.mesh.indexCount = indices.size / sizeof(uint32_t);
+
+	return import;
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Files
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+static bool ImportHasExtension(const char *pathname, const char *extension)
+{
+	size_t length = strlen(pathname), extensionLength = strlen(extension);
+	if (length < extensionLength) return false;
+
+	for (size_t i = 0; i < extensionLength; ++i)
+		if (tolower((unsigned char)pathname[length - extensionLength + i]) != extension[i])
+			return false;
+
+	return true;
+}
+
+MeshImport ImportMesh(const char *pathname)
+{
+	MeshImport import = { 0 };
+
+	bool obj = ImportHasExtension(pathname, ".obj");
+	if (!obj && !ImportHasExtension(pathname, ".ply"))
+	{
+		fprintf(stderr, "[ERROR]: %s is neither an OBJ nor a PLY file.\n", pathname);
+		return import;
+	}
+
+	MappedFile file = MapFile(pathname);
+	if (file.data == NULL)
+		return import;
+
+	import = obj ? ImportMeshOBJ(file.data, file.size) : ImportMeshPLY(file.data, file.size);
+
+	UnmapFile(&file);
+
+	return import;
+}
+
+ShaderElement MeshImportLayout(MeshImport *import)
+{
+	return InitShaderElement(import->kinds, import->kindCount, GL_FLOAT, GL_FALSE);
+}
+
+void DeleteMeshImport(MeshImport *import)
+{
+	DeleteMesh(&import->mesh);
+
+	*import = (MeshImport) { 0 };
+}
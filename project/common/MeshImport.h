@@ -0,0 +1,45 @@
+#ifndef __MESH_IMPORT_H__
+#define __MESH_IMPORT_H__
+
+#include "Graphic.h"
+#include "Mesh.h"
+
+/*
+	Wavefront OBJ and PLY (ascii, binary little and big endian) import.
+
+	The file is mapped, not read. OBJ text is cut into chunks of about
+	MESH_IMPORT_CHUNK bytes at line ends, chunks are parsed in parallel on
+	the job system and merged in file order, so the result does not depend
+	on the thread count. Faces become triangle fans, negative OBJ indices
+	are resolved, and OBJ corners with the same position, uv and normal
+	become one vertex. PLY vertices are decoded in parallel as they are
+	already indexed.
+
+	The mesh has float vertices laid out as kinds says: position (f3), then
+	normal (f3) and uv (f2) when the file has them, corners without one get
+	zeros. Indices are unsigned int, ready for the Mesh optimizers.
+	Groups, materials and smoothing groups are ignored.
+*/
+
+#define MESH_IMPORT_CHUNK (1 << 20)
+
+typedef struct MeshImport {
+	Mesh mesh;
+	ShaderElementKind kinds[3];
+	size_t kindCount;
+	bool hasNormals;
+	bool hasUVs;
+} MeshImport;
+
+// picks the format from the extension, the mesh is empty on failure
+MeshImport ImportMesh(const char *pathname);
+
+MeshImport ImportMeshOBJ(const char *data, size_t size);
+MeshImport ImportMeshPLY(const char *data, size_t size);
+
+// the vertex layout of the import, it points into import
+ShaderElement MeshImportLayout(MeshImport *import);
+
+void DeleteMeshImport(MeshImport *import);
+
+#endif // __MESH_IMPORT_H__
@@ -0,0 +1,657 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "RenderQueue.h"
+#include "GLExt.h"
+#include "GLState.h"
+#include "Job.h"
+
+// uniform blocks start on 16 bytes, the std140 alignment of a vec4
+#define RENDER_UNIFORM_ALIGNMENT 16
+
+RenderQueue CreateRenderQueue(size_t capacity)
+{
+	RenderQueue queue = { 0 };
+
+	if (capacity == 0) capacity = 1024;
+
+	if (capacity > RENDER_MAX_COMMANDS) capacity = RENDER_MAX_COMMANDS;
+
+	queue.commands = malloc(capacity * sizeof(RenderCommand));
+	queue.items = malloc(capacity * sizeof(uint64_t));
+	queue.itemScratch = malloc(capacity * sizeof(uint64_t));
+	queue.histogram = calloc(RENDER_DIGITS, sizeof(*queue.histogram));
+
+	if (!queue.commands || !queue.items || !queue.itemScratch || !queue.histogram)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate render queue for %zu commands.\n", capacity);
+		DeleteRenderQueue(&queue);
+		return queue;
+	}
+
+	queue.capacity = capacity;
+
+	return queue;
+}
+
+void DeleteRenderQueue(RenderQueue *queue)
+{
+	free(queue->commands);
+	free(queue->items);
+	free(queue->itemScratch);
+	free(queue->histogram);
+	free(queue->uniforms);
+	free(queue->updates);
+
+	*queue = (RenderQueue) { 0 };
+}
+
+void RenderQueueSetUniformFunc(RenderQueue *queue, RenderUniformFunc func, void *userData)
+{
+	queue->applyUniforms = func;
+	queue->userData = userData;
+}
+
+void RenderQueueSetUniformStream(RenderQueue *queue, UniformStream *stream, unsigned int binding)
+{
+	queue->uniformStream = stream;
+	queue->uniformBinding = binding;
+}
+
+// room for size bytes at the next aligned offset of the queue data
+static unsigned char *RenderQueueReserveData(RenderQueue *queue, size_t size, size_t *offset)
+{
+	size_t start = (queue->uniformSize + RENDER_UNIFORM_ALIGNMENT - 1) / RENDER_UNIFORM_ALIGNMENT * RENDER_UNIFORM_ALIGNMENT;
+
+	if (start + size > queue->uniformCapacity)
+	{
+		size_t capacity = queue->uniformCapacity ? queue->uniformCapacity * 2 : 4096;
+		while (capacity < start + size) capacity *= 2;
+
+		unsigned char *uniforms = realloc(queue->uniforms, capacity);
+		if (uniforms == NULL)
+		{
+			fprintf(stderr, "[ERROR]: Failed to grow render queue uniforms to %zu bytes.\n", capacity);
+			return NULL;
+		}
+
+		queue->uniforms = uniforms;
+		queue->uniformCapacity = capacity;
+	}
+
+	queue->uniformSize = start + size;
+	*offset = start;
+
+	return queue->uniforms + start;
+}
+
+unsigned int RenderQueuePushUniforms(RenderQueue *queue, const void *data, size_t size)
+{
+	size_t offset;
+	unsigned char *destination = RenderQueueReserveData(queue, size, &offset);
+	if (destination == NULL) return RENDER_UNIFORMS_FAILED;
+
+	memcpy(destination, data, size);
+
+	return (unsigned int)offset;
+}
+
+static bool RenderQueueAddUpdate(RenderQueue *queue, RenderUpdate update)
+{
+	if (queue->updateCount == queue->updateCapacity)
+	{
+		size_t capacity = queue->updateCapacity ? queue->updateCapacity * 2 : 64;
+
+		RenderUpdate *updates = realloc(queue->updates, capacity * sizeof(RenderUpdate));
+		if (updates == NULL)
+		{
+			fprintf(stderr, "[ERROR]: Failed to grow render queue updates to %zu.\n", capacity);
+			return false;
+		}
+
+		queue->updates = updates;
+		queue->updateCapacity = capacity;
+	}
+
+	queue->updates[queue->updateCount++] = update;
+
+	return true;
+}
+
+void RenderQueueUpdateBuffer(RenderQueue *queue, unsigned int buffer, unsigned int offset, const void *data, size_t size)
+{
+	size_t dataOffset;
+	unsigned char *destination = RenderQueueReserveData(queue, size, &dataOffset);
+	if (destination == NULL) return;
+
+	memcpy(destination, data, size);
+
+	RenderQueueAddUpdate(queue, (RenderUpdate) { buffer, offset, (unsigned int)size, (unsigned int)dataOffset });
+}
+
+// the ranges are read now, the arena must not defragment before execution
+RenderCommand RenderCommandMesh(unsigned int program, BufferArena *arena, int mesh)
+{
+	const ArenaMesh *m = &arena->meshes[mesh];
+	RenderCommand command = { 0 };
+
+	command.program = program;
+	command.vertexArray = arena->vao.ID;
+	command.mode = GL_TRIANGLES;
+	command.indexed = true;
+	command.first = m->firstIndex;
+	command.count = m->indexCount;
+	command.baseVertex = m->baseVertex;
+
+	return command;
+}
+
+RenderCommand RenderCommandArrays(unsigned int program, VertexArray *va, unsigned int first, unsigned int count)
+{
+	RenderCommand command = { 0 };
+
+	command.program = program;
+	command.vertexArray = va->ID;
+	command.mode = GL_TRIANGLES;
+	command.first = first;
+	command.count = count;
+
+	return command;
+}
+
+static uint64_t RenderDepthBits(float depth, int bits)
+{
+	if (!(depth > 0.0f)) depth = 0.0f;
+	if (depth > 1.0f) depth = 1.0f;
+
+	return (uint64_t)(depth * (float)((1u << bits) - 1));
+}
+
+uint64_t RenderCommandKey(const RenderCommand *command)
+{
+	uint64_t key = (uint64_t)(command->layer & 0xF) << 22;
+
+	uint64_t program = command->program;
+	uint64_t vertexArray = command->vertexArray;
+	uint64_t texture = command->textures[0];
+
+	if (!command->transparent)
+		return key
+			| (program & 0x1F) << 16
+			| (vertexArray & 0x3F) << 10
+			| (texture & 0x3F) << 4
+			| RenderDepthBits(command->depth, 4);
+
+	// far to near
+	uint64_t depth = ((1u << 14) - 1) - RenderDepthBits(command->depth, 14);
+
+	return key
+		| 1ull << 21
+		| depth << 7
+		| (program & 0x7) << 4
+		| (vertexArray & 0x3) << 2
+		| (texture & 0x3);
+}
+
+static bool RenderQueueGrow(RenderQueue *queue)
+{
+	if (queue->capacity >= RENDER_MAX_COMMANDS)
+	{
+		fprintf(stderr, "[ERROR]: Render queue is limited to %u commands.\n", RENDER_MAX_COMMANDS);
+		return false;
+	}
+
+	size_t capacity = queue->capacity ? queue->capacity * 2 : 1024;
+	if (capacity > RENDER_MAX_COMMANDS) capacity = RENDER_MAX_COMMANDS;
+
+	// a zeroed queue, from a failed create or a slice nobody created, has none yet
+	if (queue->histogram == NULL)
+		queue->histogram = calloc(RENDER_DIGITS, sizeof(*queue->histogram));
+
+	RenderCommand *commands = realloc(queue->commands, capacity * sizeof(RenderCommand));
+	if (commands) queue->commands = commands;
+
+	uint64_t *items = realloc(queue->items, capacity * sizeof(uint64_t));
+	if (items) queue->items = items;
+
+	uint64_t *itemScratch = realloc(queue->itemScratch, capacity * sizeof(uint64_t));
+	if (itemScratch) queue->itemScratch = itemScratch;
+
+	if (!commands || !items || !itemScratch || !queue->histogram)
+	{
+		fprintf(stderr, "[ERROR]: Failed to grow render queue to %zu commands.\n", capacity);
+		return false;
+	}
+
+	queue->capacity = capacity;
+
+	return true;
+}
+
+static void RenderQueueCountDigits(RenderQueue *queue, uint64_t key)
+{
+	for (int digit = 0; digit < RENDER_DIGITS; ++digit)
+		++queue->histogram[digit][(key >> (digit * RENDER_DIGIT_BITS)) & (RENDER_BUCKETS - 1)];
+}
+
+// a sort turned the counts into offsets, count the sorted items again
+static void RenderQueueRecount(RenderQueue *queue)
+{
+	if (!queue->sorted) return;
+
+	if (queue->histogram)
+		memset(queue->histogram, 0, RENDER_DIGITS * sizeof(*queue->histogram));
+	for (size_t i = 0; i < queue->count; ++i)
+		RenderQueueCountDigits(queue, queue->items[i] >> RENDER_INDEX_BITS);
+
+	queue->sorted = false;
+}
+
+void RenderQueueSubmit(RenderQueue *queue, const RenderCommand *command)
+{
+	if (command->uniformSize && command->uniformOffset == RENDER_UNIFORMS_FAILED)
+	{
+		fprintf(stderr, "[ERROR]: Dropped a draw whose uniforms did not fit in the render queue.\n");
+		return;
+	}
+
+	if (queue->count == queue->capacity && !RenderQueueGrow(queue))
+		return;
+
+	RenderQueueRecount(queue);
+
+	size_t i = queue->count++;
+	uint64_t key = RenderCommandKey(command);
+
+	queue->commands[i] = *command;
+	queue->items[i] = key << RENDER_INDEX_BITS | i;
+	queue->sorted = false;
+
+	// the sort needs one histogram per digit, counting here saves it a read
+	RenderQueueCountDigits(queue, key);
+}
+
+void RenderQueueMerge(RenderQueue *queue, const RenderQueue *sources, int count)
+{
+	RenderQueueRecount(queue);
+
+	for (int s = 0; s < count; ++s)
+	{
+		const RenderQueue *source = &sources[s];
+
+		while (queue->count + source->count > queue->capacity)
+			if (!RenderQueueGrow(queue))
+				return;
+
+		size_t dataBase = 0;
+		if (source->uniformSize)
+		{
+			unsigned char *data = RenderQueueReserveData(queue, source->uniformSize, &dataBase);
+			if (data == NULL) return;
+
+			memcpy(data, source->uniforms, source->uniformSize);
+		}
+
+		size_t base = queue->count;
+
+		for (size_t i = 0; i < source->count; ++i)
+		{
+			RenderCommand *command = &queue->commands[base + i];
+
+			*command = source->commands[i];
+			if (command->uniformSize)
+				command->uniformOffset += (unsigned int)dataBase;
+		}
+
+		// a sorted source has its items in key order, the key and index still pair up
+		for (size_t i = 0; i < source->count; ++i)
+		{
+			uint64_t item = source->items[i];
+			uint64_t key = item >> RENDER_INDEX_BITS;
+
+			queue->items[base + i] = key << RENDER_INDEX_BITS | (base + (item & RENDER_INDEX_MASK));
+
+			if (source->sorted)
+				RenderQueueCountDigits(queue, key);
+		}
+
+		if (!source->sorted && source->count)
+		{
+			for (int digit = 0; digit < RENDER_DIGITS; ++digit)
+				for (int bucket = 0; bucket < RENDER_BUCKETS; ++bucket)
+					queue->histogram[digit][bucket] += source->histogram[digit][bucket];
+		}
+
+		queue->count += source->count;
+
+		for (size_t i = 0; i < source->updateCount; ++i)
+		{
+			RenderUpdate update = source->updates[i];
+			update.dataOffset += (unsigned int)dataBase;
+
+			if (!RenderQueueAddUpdate(queue, update))
+				return;
+		}
+	}
+}
+
+typedef struct RenderRecordJob {
+	RenderQueue *slices;
+	size_t sliceCount;
+	size_t count;
+	RenderRecordFunc func;
+	void *userData;
+} RenderRecordJob;
+
+static void RenderRecordSlices(void *userData, size_t begin, size_t end)
+{
+	RenderRecordJob *job = userData;
+
+	for (size_t slice = begin; slice < end; ++slice)
+	{
+		RenderQueue *queue = &job->slices[slice];
+		RenderQueueClear(queue);
+
+		job->func(job->userData, queue, job->count * slice / job->sliceCount, job->count * (slice + 1) / job->sliceCount);
+	}
+}
+
+void RenderQueueRecord(RenderQueue *queue, RenderQueue *slices, int sliceCount, size_t count, RenderRecordFunc func, void *userData)
+{
+	if (sliceCount <= 0) return;
+
+	RenderRecordJob job = { slices, (size_t)sliceCount, count, func, userData };
+	JobParallelFor((size_t)sliceCount, 1, RenderRecordSlices, &job);
+
+	RenderQueueMerge(queue, slices, sliceCount);
+}
+
+// LSD radix sort of the items on their key bits
+void RenderQueueSort(RenderQueue *queue)
+{
+	size_t count = queue->count;
+	uint64_t *items = queue->items;
+	uint64_t *scratch = queue->itemScratch;
+
+	if (queue->sorted)
+		return;
+
+	for (int digit = 0; digit < RENDER_DIGITS && count > 1; ++digit)
+	{
+		unsigned int *h = queue->histogram[digit];
+		int shift = RENDER_INDEX_BITS + digit * RENDER_DIGIT_BITS;
+
+		// all keys share this digit, the pass would not move anything
+		if (h[(items[0] >> shift) & (RENDER_BUCKETS - 1)] == count)
+			continue;
+
+		unsigned int sum = 0;
+		for (int bucket = 0; bucket < RENDER_BUCKETS; ++bucket)
+		{
+			unsigned int n = h[bucket];
+			h[bucket] = sum;
+			sum += n;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint64_t item = items[i];
+			scratch[h[(item >> shift) & (RENDER_BUCKETS - 1)]++] = item;
+		}
+
+		uint64_t *swap = items; items = scratch; scratch = swap;
+	}
+
+	queue->items = items;
+	queue->itemScratch = scratch;
+	queue->sorted = true;
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Execution
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+typedef struct RenderState {
+	bool valid;
+	unsigned int program;
+	unsigned int vertexArray;
+	unsigned int textures[RENDER_TEXTURES];
+} RenderState;
+
+enum {
+	RENDER_CHANGE_PROGRAM = 1 << 0,
+	RENDER_CHANGE_VERTEX_ARRAY = 1 << 1,
+	RENDER_CHANGE_TEXTURE = 1 << 2 // shifted by the unit
+};
+
+// what has to change to draw command after state, state is updated
+static unsigned int RenderStateStep(RenderState *state, const RenderCommand *command)
+{
+	unsigned int changes = 0;
+
+	if (!state->valid || state->program != command->program)
+		changes |= RENDER_CHANGE_PROGRAM;
+
+	if (!state->valid || state->vertexArray != command->vertexArray)
+		changes |= RENDER_CHANGE_VERTEX_ARRAY;
+
+	for (int unit = 0; unit < RENDER_TEXTURES; ++unit)
+	{
+		unsigned int texture = command->textures[unit];
+
+		if (texture && (!state->valid || state->textures[unit] != texture))
+		{
+			changes |= RENDER_CHANGE_TEXTURE << unit;
+			state->textures[unit] = texture;
+		}
+	}
+
+	state->valid = true;
+	state->program = command->program;
+	state->vertexArray = command->vertexArray;
+
+	return changes;
+}
+
+static unsigned int RenderChangeCount(unsigned int changes)
+{
+	return (unsigned int)__builtin_popcount(changes);
+}
+
+// false when the draw needs instancing the context does not have
+static bool RenderQueueDraw(const RenderCommand *command)
+{
+	if (command->instanceCount > 1 && !GLEXT_ARB_draw_instanced)
+		return false;
+
+	if (command->indexed)
+	{
+		const void *indices = (void*)((size_t)command->first * sizeof(unsigned int));
+
+		if (command->instanceCount > 1)
+			glDrawElementsInstancedBaseVertex(command->mode, command->count, GL_UNSIGNED_INT, indices, command->instanceCount, command->baseVertex);
+		else
+			glDrawElementsBaseVertex(command->mode, command->count, GL_UNSIGNED_INT, indices, command->baseVertex);
+	}
+	else if (command->instanceCount > 1)
+	{
+		glDrawArraysInstanced(command->mode, command->first, command->count, command->instanceCount);
+	}
+	else
+	{
+		glDrawArrays(command->mode, command->first, command->count);
+	}
+
+	return true;
+}
+
+// walks the uniform blocks of the sorted draws, the same way when sizing and when drawing
+typedef struct RenderUniformCursor {
+	bool valid;
+	unsigned int offset;
+	unsigned int size;
+	size_t slot;
+	size_t next;
+} RenderUniformCursor;
+
+// the block of command in the stream, fresh is set when it starts a new one
+static size_t RenderUniformStep(RenderUniformCursor *cursor, const RenderCommand *command, size_t alignment, bool *fresh)
+{
+	*fresh = !cursor->valid || cursor->offset != command->uniformOffset || cursor->size != command->uniformSize;
+
+	if (*fresh)
+	{
+		cursor->valid = true;
+		cursor->offset = command->uniformOffset;
+		cursor->size = command->uniformSize;
+		cursor->slot = cursor->next;
+		cursor->next = (cursor->slot + command->uniformSize + alignment - 1) / alignment * alignment;
+	}
+
+	return cursor->slot;
+}
+
+// copies every per draw block into the stream with one map, returns the mapped base
+static bool RenderQueueStreamUniforms(RenderQueue *queue, size_t *base, unsigned int *blockCount)
+{
+	UniformStream *stream = queue->uniformStream;
+	RenderUniformCursor cursor = { 0 };
+	bool fresh;
+
+	for (size_t i = 0; i < queue->count; ++i)
+	{
+		const RenderCommand *command = &queue->commands[queue->items[i] & RENDER_INDEX_MASK];
+		if (command->uniformSize) RenderUniformStep(&cursor, command, stream->alignment, &fresh);
+	}
+
+	// nothing to stream is not a failure
+	if (cursor.next == 0)
+		return true;
+
+	unsigned char *blocks = UniformStreamMap(stream, cursor.next, base);
+	if (blocks == NULL)
+		return false;
+
+	cursor = (RenderUniformCursor) { 0 };
+
+	for (size_t i = 0; i < queue->count; ++i)
+	{
+		const RenderCommand *command = &queue->commands[queue->items[i] & RENDER_INDEX_MASK];
+		if (command->uniformSize == 0) continue;
+
+		size_t slot = RenderUniformStep(&cursor, command, stream->alignment, &fresh);
+
+		if (fresh)
+		{
+			memcpy(blocks + slot, queue->uniforms + command->uniformOffset, command->uniformSize);
+			++*blockCount;
+		}
+	}
+
+	UniformStreamUnmap(stream);
+
+	return true;
+}
+
+void RenderQueueExecute(RenderQueue *queue)
+{
+	RenderQueueStats stats = { 0 };
+
+	for (size_t i = 0; i < queue->updateCount; ++i)
+	{
+		const RenderUpdate *update = &queue->updates[i];
+
+		GLStateBindBuffer(GL_COPY_WRITE_BUFFER, update->buffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, update->offset, update->size, queue->uniforms + update->dataOffset);
+	}
+	stats.updates = (unsigned int)queue->updateCount;
+
+	// what issuing in submission order would have cost
+	RenderState unsorted = { 0 };
+	for (size_t i = 0; i < queue->count; ++i)
+		stats.unsortedSwitches += RenderChangeCount(RenderStateStep(&unsorted, &queue->commands[i]));
+
+	if (!queue->sorted)
+		RenderQueueSort(queue);
+
+	size_t uniformBase = 0;
+	bool streamed = queue->uniformStream && RenderQueueStreamUniforms(queue, &uniformBase, &stats.uniformBlocks);
+
+	// the frame's blocks do not fit the stream region, the uniform func takes over if there is one
+	stats.uniformOverflow = queue->uniformStream && !streamed;
+
+	if (stats.uniformOverflow && !queue->stats.uniformOverflow)
+		fprintf(stderr, "[ERROR]: Per draw uniforms overflow the uniform stream, %s.\n",
+			queue->applyUniforms ? "falling back to the uniform func" : "drawing without them");
+
+	RenderUniformCursor cursor = { 0 };
+	RenderState state = { 0 };
+
+	for (size_t i = 0; i < queue->count; ++i)
+	{
+		const RenderCommand *command = &queue->commands[queue->items[i] & RENDER_INDEX_MASK];
+		unsigned int changes = RenderStateStep(&state, command);
+
+		if (changes & RENDER_CHANGE_PROGRAM)
+		{
+			GLStateUseProgram(command->program);
+			++stats.programSwitches;
+		}
+
+		if (changes & RENDER_CHANGE_VERTEX_ARRAY)
+		{
+			GLStateBindVertexArray(command->vertexArray);
+			++stats.vertexArraySwitches;
+		}
+
+		for (int unit = 0; unit < RENDER_TEXTURES; ++unit)
+		{
+			if (changes & (RENDER_CHANGE_TEXTURE << unit))
+			{
+				GLStateBindTexture(unit, GL_TEXTURE_2D, command->textures[unit]);
+				++stats.textureSwitches;
+			}
+		}
+
+		if (command->uniformSize && streamed)
+		{
+			bool fresh;
+			size_t slot = RenderUniformStep(&cursor, command, queue->uniformStream->alignment, &fresh);
+
+			UniformStreamBind(queue->uniformStream, queue->uniformBinding, uniformBase + slot, command->uniformSize);
+		}
+		else if (command->uniformSize && queue->applyUniforms)
+		{
+			queue->applyUniforms(queue->userData, command->program, queue->uniforms + command->uniformOffset, command->uniformSize);
+		}
+
+		if (RenderQueueDraw(command))
+			++stats.draws;
+		else
+			++stats.skippedDraws;
+	}
+
+	// once when it starts, not every frame
+	if (stats.skippedDraws && !queue->stats.skippedDraws)
+		fprintf(stderr, "[ERROR]: Skipped %u instanced draws, they need ARB_draw_instanced.\n", stats.skippedDraws);
+
+	unsigned int switches = stats.programSwitches + stats.vertexArraySwitches + stats.textureSwitches;
+	stats.savedSwitches = stats.unsortedSwitches > switches ? stats.unsortedSwitches - switches : 0;
+
+	queue->stats = stats;
+}
+
+void RenderQueueClear(RenderQueue *queue)
+{
+	if (queue->histogram)
+		memset(queue->histogram, 0, RENDER_DIGITS * sizeof(*queue->histogram));
+
+	queue->count = 0;
+	queue->uniformSize = 0;
+	queue->updateCount = 0;
+	queue->sorted = false;
+}
@@ -0,0 +1,164 @@
+#ifndef __RENDER_QUEUE_H__
+#define __RENDER_QUEUE_H__
+
+#include <stdint.h>
+
+#include "common.h"
+#include "BufferArena.h"
+#include "UniformBuffer.h"
+
+/*
+	Deferred draw submission.
+
+	Draws are recorded as RenderCommand packets during the frame, sorted by
+	a 26 bit key and executed together, changing state only where
+	consecutive commands differ. The key, most significant field first:
+
+		opaque       layer:4 0:1 program:5 vertexArray:6 texture:6 depth:4
+		transparent  layer:4 1:1 depth:14 program:3 vertexArray:2 texture:2
+
+	Opaque draws are grouped by state and go front to back inside a group,
+	transparent draws go back to front. Depth is expected in [0, 1]. Only
+	the low bits of each GL name enter the key, names sharing them only
+	cost a switch. Equal keys keep submission order.
+
+	Recording touches no GL, so it can run on worker threads, each into its
+	own queue, merged in array order by RenderQueueMerge or RenderQueueRecord.
+	Buffer updates are applied at the start of the execution, before any
+	draw. Only the merged queue is executed, on the thread owning the GL
+	context.
+
+	Per draw uniforms reach the program through the uniform func, or with a
+	uniform stream set, as uniform blocks copied into the stream with one map
+	and bound per draw. Consecutive draws pushing the same data share a block.
+*/
+
+#define RENDER_TEXTURES 4
+
+#define RENDER_KEY_BITS 26
+#define RENDER_INDEX_BITS 24
+#define RENDER_INDEX_MASK ((1u << RENDER_INDEX_BITS) - 1)
+#define RENDER_MAX_COMMANDS (1u << RENDER_INDEX_BITS)
+
+#define RENDER_DIGIT_BITS 13
+#define RENDER_DIGITS ((RENDER_KEY_BITS + RENDER_DIGIT_BITS - 1) / RENDER_DIGIT_BITS)
+#define RENDER_BUCKETS (1 << RENDER_DIGIT_BITS)
+
+typedef struct RenderCommand {
+	unsigned int program;
+	unsigned int vertexArray;
+	unsigned int textures[RENDER_TEXTURES]; // GL_TEXTURE_2D per unit, 0 leaves the unit alone
+
+	unsigned int mode;          // GL_TRIANGLES, ...
+	bool indexed;               // unsigned int indices from the element buffer of vertexArray
+	unsigned int first;         // first index or first vertex
+	unsigned int count;         // index or vertex count
+	int baseVertex;             // indexed draws only
+	unsigned int instanceCount; // 0 or 1 for a plain draw
+
+	unsigned int uniformOffset; // RenderQueuePushUniforms result
+	unsigned int uniformSize;   // 0 for no per draw uniforms
+
+	unsigned char layer;        // 0 to 15, lower layers draw first
+	bool transparent;
+	float depth;
+} RenderCommand;
+
+// glBufferSubData of recorded bytes, applied before the draws
+typedef struct RenderUpdate {
+	unsigned int buffer;
+	unsigned int offset;     // in the destination buffer
+	unsigned int size;
+	unsigned int dataOffset; // in the queue data
+} RenderUpdate;
+
+// called before a draw with its uniform data, the program is already bound
+typedef void (*RenderUniformFunc)(void *userData, unsigned int program, const void *uniforms, size_t size);
+
+typedef struct RenderQueueStats {
+	unsigned int draws;
+	unsigned int skippedDraws;   // instanced draws without ARB_draw_instanced
+	unsigned int programSwitches;
+	unsigned int vertexArraySwitches;
+	unsigned int textureSwitches;
+	unsigned int unsortedSwitches; // program + vertex array + texture switches in submission order
+	unsigned int savedSwitches;
+	unsigned int updates;
+	unsigned int uniformBlocks;  // blocks written to the uniform stream
+	bool uniformOverflow;        // the blocks did not fit the stream, drawn through the uniform func or without
+} RenderQueueStats;
+
+typedef struct RenderQueue {
+	RenderCommand *commands;
+	uint64_t *items;        // key << RENDER_INDEX_BITS | command index
+	uint64_t *itemScratch;
+	unsigned int (*histogram)[RENDER_BUCKETS]; // RENDER_DIGITS rows
+	size_t count;
+	size_t capacity;
+	bool sorted;
+
+	unsigned char *uniforms; // per draw uniforms and buffer update bytes
+	size_t uniformSize;
+	size_t uniformCapacity;
+
+	RenderUpdate *updates;
+	size_t updateCount;
+	size_t updateCapacity;
+
+	RenderUniformFunc applyUniforms;
+	void *userData;
+
+	UniformStream *uniformStream;
+	unsigned int uniformBinding;
+
+	RenderQueueStats stats;
+} RenderQueue;
+
+RenderQueue CreateRenderQueue(size_t capacity);
+void DeleteRenderQueue(RenderQueue *queue);
+void RenderQueueSetUniformFunc(RenderQueue *queue, RenderUniformFunc func, void *userData);
+
+// per draw uniforms as std140 blocks bound to binding, NULL goes back to the uniform func.
+// a frame whose blocks overflow the stream sets stats.uniformOverflow and uses the uniform func
+void RenderQueueSetUniformStream(RenderQueue *queue, UniformStream *stream, unsigned int binding);
+
+#define RENDER_UNIFORMS_FAILED ((unsigned int)-1)
+
+// copy per draw uniform data into the queue, returns its offset for the command,
+// RENDER_UNIFORMS_FAILED when the data cannot grow. such commands are not submitted
+unsigned int RenderQueuePushUniforms(RenderQueue *queue, const void *data, size_t size);
+
+// indexed draw of an arena mesh
+RenderCommand RenderCommandMesh(unsigned int program, BufferArena *arena, int mesh);
+
+// glDrawArrays style draw of count vertices from first
+RenderCommand RenderCommandArrays(unsigned int program, VertexArray *va, unsigned int first, unsigned int count);
+
+// the RENDER_KEY_BITS sort key of a command
+uint64_t RenderCommandKey(const RenderCommand *command);
+
+void RenderQueueSubmit(RenderQueue *queue, const RenderCommand *command);
+
+// record size bytes to be written to buffer at offset before the draws
+void RenderQueueUpdateBuffer(RenderQueue *queue, unsigned int buffer, unsigned int offset, const void *data, size_t size);
+
+// append the commands, uniforms and updates of count queues, in order
+void RenderQueueMerge(RenderQueue *queue, const RenderQueue *sources, int count);
+
+// record items [begin, end) of a range into queue, called on any thread
+typedef void (*RenderRecordFunc)(void *userData, RenderQueue *queue, size_t begin, size_t end);
+
+// record [0, count) as sliceCount slices in parallel, one queue each, then
+// merge them into queue. The slices are cleared first and keep their memory.
+void RenderQueueRecord(RenderQueue *queue, RenderQueue *slices, int sliceCount, size_t count, RenderRecordFunc func, void *userData);
+
+// stable radix sort, one pass per RENDER_DIGIT_BITS digit the keys differ in
+void RenderQueueSort(RenderQueue *queue);
+
+// sort if needed and issue every command, then fill queue->stats
+void RenderQueueExecute(RenderQueue *queue);
+
+// drop the commands, uniform data and updates for the next frame
+void RenderQueueClear(RenderQueue *queue);
+
+#endif // __RENDER_QUEUE_H__
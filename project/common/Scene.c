@@ -0,0 +1,198 @@
+#include <string.h>
+#include <stdio.h>
+
+#include "Scene.h"
+
+Transform TransformIdentity(void)
+{
+	Transform result = {
+		QuaternionIdentity(),
+		{ 0.0f, 0.0f, 0.0f },
+		{ 1.0f, 1.0f, 1.0f }
+	};
+
+	return result;
+}
+
+// rotation columns of QuaternionToMatrixScalar, each scaled by its axis
+Mat3x4 TransformToMat3x4(const Transform t)
+{
+	Mat3x4 result = { 0 };
+
+	const Quaternion q = t.rotation;
+
+	float a2 = q.x*q.x;
+	float b2 = q.y*q.y;
+	float c2 = q.z*q.z;
+	float ac = q.x*q.z;
+	float ab = q.x*q.y;
+	float bc = q.y*q.z;
+	float ad = q.w*q.x;
+	float bd = q.w*q.y;
+	float cd = q.w*q.z;
+
+	result.m0 = (1 - 2*(b2 + c2))*t.scale.x;
+	result.m1 = 2*(ab + cd)*t.scale.x;
+	result.m2 = 2*(ac - bd)*t.scale.x;
+
+	result.m4 = 2*(ab - cd)*t.scale.y;
+	result.m5 = (1 - 2*(a2 + c2))*t.scale.y;
+	result.m6 = 2*(bc + ad)*t.scale.y;
+
+	result.m8 = 2*(ac + bd)*t.scale.z;
+	result.m9 = 2*(bc - ad)*t.scale.z;
+	result.m10 = (1 - 2*(a2 + b2))*t.scale.z;
+
+	result.m12 = t.translation.x;
+	result.m13 = t.translation.y;
+	result.m14 = t.translation.z;
+
+	return result;
+}
+
+SceneGraph SceneGraphCreate(size_t capacity)
+{
+	SceneGraph scene = { 0 };
+
+	if (capacity == 0) capacity = 64;
+
+	scene.parent = malloc(capacity*sizeof(int));
+	scene.local = malloc(capacity*sizeof(Transform));
+	scene.world = malloc(capacity*sizeof(Mat3x4));
+	scene.dirty = malloc(capacity);
+
+	if (!scene.parent || !scene.local || !scene.world || !scene.dirty)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate scene graph for %zu nodes.\n", capacity);
+		SceneGraphFree(&scene);
+		return scene;
+	}
+
+	scene.capacity = capacity;
+
+	return scene;
+}
+
+void SceneGraphFree(SceneGraph *scene)
+{
+	free(scene->parent);
+	free(scene->local);
+	free(scene->world);
+	free(scene->dirty);
+
+	*scene = (SceneGraph) { 0 };
+}
+
+static int SceneGraphGrow(SceneGraph *scene)
+{
+	size_t capacity = scene->capacity ? scene->capacity*2 : 64;
+
+	int *parent = realloc(scene->parent, capacity*sizeof(int));
+	if (parent) scene->parent = parent;
+
+	Transform *local = realloc(scene->local, capacity*sizeof(Transform));
+	if (local) scene->local = local;
+
+	Mat3x4 *world = realloc(scene->world, capacity*sizeof(Mat3x4));
+	if (world) scene->world = world;
+
+	unsigned char *dirty = realloc(scene->dirty, capacity);
+	if (dirty) scene->dirty = dirty;
+
+	if (!parent || !local || !world || !dirty)
+	{
+		fprintf(stderr, "[ERROR]: Failed to grow scene graph to %zu nodes.\n", capacity);
+		return 0;
+	}
+
+	scene->capacity = capacity;
+
+	return 1;
+}
+
+int SceneGraphAddNode(SceneGraph *scene, int parent, const Transform local)
+{
+	if (parent != SCENE_NO_PARENT && (parent < 0 || (size_t)parent >= scene->count))
+	{
+		fprintf(stderr, "[ERROR]: Scene node parent %d does not exist.\n", parent);
+		return -1;
+	}
+
+	if (scene->count == scene->capacity && !SceneGraphGrow(scene))
+		return -1;
+
+	size_t node = scene->count++;
+
+	scene->parent[node] = parent;
+	scene->local[node] = local;
+	scene->dirty[node] = 1;
+
+	if (node < scene->firstDirty) scene->firstDirty = node;
+
+	return (int)node;
+}
+
+void SceneGraphSetLocal(SceneGraph *scene, int node, const Transform local)
+{
+	scene->local[node] = local;
+	scene->dirty[node] = 1;
+
+	if ((size_t)node < scene->firstDirty) scene->firstDirty = node;
+}
+
+Transform SceneGraphGetLocal(const SceneGraph *scene, int node)
+{
+	return scene->local[node];
+}
+
+size_t SceneGraphUpdate(SceneGraph *scene)
+{
+	size_t first = scene->firstDirty;
+	size_t count = scene->count;
+
+	scene->changedBegin = 0;
+	scene->changedEnd = 0;
+
+	if (first >= count)
+		return 0;
+
+	int *parent = scene->parent;
+	unsigned char *dirty = scene->dirty;
+	size_t updated = 0;
+	size_t last = first;
+
+	// parents come first, so by the time a node is reached its parent's flag
+	// says whether its world matrix was rewritten in this pass
+	for (size_t node = first; node < count; ++node)
+	{
+		int p = parent[node];
+
+		if (!dirty[node] && (p == SCENE_NO_PARENT || !dirty[p]))
+			continue;
+
+		dirty[node] = 1;
+
+		Mat3x4 local = TransformToMat3x4(scene->local[node]);
+
+		if (p == SCENE_NO_PARENT)
+			scene->world[node] = local;
+		else
+			Mat3x4MultiplyTo(&scene->world[node], &local, &scene->world[p]);
+
+		last = node;
+		++updated;
+	}
+
+	memset(dirty + first, 0, last + 1 - first);
+
+	scene->changedBegin = first;
+	scene->changedEnd = last + 1;
+	scene->firstDirty = count;
+
+	return updated;
+}
+
+Mat3x4 SceneGraphGetWorld(const SceneGraph *scene, int node)
+{
+	return scene->world[node];
+}
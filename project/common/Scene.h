@@ -0,0 +1,74 @@
+#ifndef __SCENE_H__
+#define __SCENE_H__
+
+#include "cmath.h"
+
+/*
+	Transform hierarchy.
+
+	Nodes live in flat arrays and a parent always comes before its children
+	(nodes are only ever appended under an existing parent), so one forward
+	pass updates the whole tree. Changing a local transform marks the node
+	dirty; SceneGraphUpdate starts at the first dirty node and only
+	recomputes nodes that are dirty or whose parent was recomputed. A scene
+	where nothing moved costs nothing.
+
+	World matrices are affine (Mat3x4, 48 bytes) and contiguous, ready to be
+	uploaded as 3 vec4 rows per node or expanded with Mat3x4ToMat4x4Array.
+*/
+
+#define SCENE_NO_PARENT -1
+
+typedef struct Transform {
+	Quaternion rotation;
+	Vec3 translation;
+	Vec3 scale;
+} Transform;
+
+typedef struct SceneGraph {
+	int *parent;
+	Transform *local;
+	Mat3x4 *world;
+	unsigned char *dirty;
+
+	size_t count;
+	size_t capacity;
+
+	// nodes before this one are all clean
+	size_t firstDirty;
+
+	// world[changedBegin, changedEnd) was rewritten by the last update
+	size_t changedBegin;
+	size_t changedEnd;
+} SceneGraph;
+
+// no rotation, no translation, unit scale
+Transform TransformIdentity(void);
+
+// scale, then rotate, then translate
+Mat3x4 TransformToMat3x4(const Transform t);
+
+// create an empty scene with room for capacity nodes
+SceneGraph SceneGraphCreate(size_t capacity);
+
+// release the scene memory
+void SceneGraphFree(SceneGraph *scene);
+
+// append a node under parent (SCENE_NO_PARENT for a root), returns its index
+// or -1 if the storage could not grow
+int SceneGraphAddNode(SceneGraph *scene, int parent, const Transform local);
+
+// replace the local transform of a node and mark it dirty
+void SceneGraphSetLocal(SceneGraph *scene, int node, const Transform local);
+
+// local transform of a node
+Transform SceneGraphGetLocal(const SceneGraph *scene, int node);
+
+// recompute the world matrices of dirty nodes and everything below them,
+// returns how many were recomputed
+size_t SceneGraphUpdate(SceneGraph *scene);
+
+// world matrix of a node as of the last update
+Mat3x4 SceneGraphGetWorld(const SceneGraph *scene, int node);
+
+#endif // __SCENE_H__
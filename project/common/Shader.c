@@ -1,6 +1,11 @@
+#include <string.h>
+
 #include "Shader.h"
 #include "common.h"
 #include "IO.h"
+#include "GLState.h"
+#include "GLExt.h"
+#include "ShaderCache.h"
 
 /*
  * float 	-> 4
@@ -8,39 +13,223 @@
  * unsigned int 	-> 4
 */
 
-int ShaderGetUniformLocation(unsigned int program, const char *name)
+// length without a trailing [0], GL lists arrays as name[0]
+static size_t ShaderNameLength(const char *name)
+{
+	size_t length = strlen(name);
+
+	if (length > 3 && strcmp(name + length - 3, "[0]") == 0)
+		length -= 3;
+
+	return length;
+}
+
+static uint32_t ShaderHashName(const char *name, size_t length)
+{
+	uint32_t hash = 2166136261u;
+
+	for (size_t i = 0; i < length; ++i)
+		hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+
+	return hash;
+}
+
+// active uniforms outside blocks into the table, once after linking
+static void ShaderReflect(Shader *shader)
+{
+	GLint count = 0;
+	glGetProgramiv(shader->shaderID, GL_ACTIVE_UNIFORMS, &count);
+
+	if (count <= 0)
+		return;
+
+	unsigned int slots = 1;
+	while (slots < (unsigned int)count * 2) slots <<= 1;
+
+	shader->uniforms = calloc(count, sizeof(ShaderUniform));
+	shader->table = malloc(slots * sizeof(int));
+
+	if (!shader->uniforms || !shader->table)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate the uniform table of %d uniforms.\n", count);
+		free(shader->uniforms);
+		free(shader->table);
+		shader->uniforms = NULL;
+		shader->table = NULL;
+		return;
+	}
+
+	memset(shader->table, 0xFF, slots * sizeof(int));
+	shader->tableMask = slots - 1;
+
+	for (GLint i = 0; i < count; ++i)
+	{
+		char name[SHADER_UNIFORM_NAME];
+		GLint size;
+		GLenum type;
+
+		glGetActiveUniform(shader->shaderID, (GLuint)i, sizeof(name), NULL, &size, &type, name);
+
+		// block members have no location, they are set through the buffer
+		int location = glGetUniformLocation(shader->shaderID, name);
+		if (location < 0)
+			continue;
+
+		int index = shader->uniformCount++;
+		ShaderUniform *uniform = &shader->uniforms[index];
+		size_t length = ShaderNameLength(name);
+
+		memcpy(uniform->name, name, length);
+		uniform->name[length] = '\0';
+		uniform->hash = ShaderHashName(name, length);
+		uniform->location = location;
+		uniform->type = type;
+		uniform->size = size;
+
+		unsigned int slot = uniform->hash & shader->tableMask;
+		while (shader->table[slot] >= 0)
+			slot = (slot + 1) & shader->tableMask;
+
+		shader->table[slot] = index;
+	}
+}
+
+Shader ShaderFromProgram(unsigned int program)
+{
+	Shader shader = { program };
+	ShaderReflect(&shader);
+
+	return shader;
+}
+
+int ShaderFindUniform(Shader *shader, const char *name)
+{
+	size_t length = ShaderNameLength(name);
+	uint32_t hash = ShaderHashName(name, length);
+
+	if (shader->table)
+	{
+		for (unsigned int slot = hash & shader->tableMask; shader->table[slot] >= 0; slot = (slot + 1) & shader->tableMask)
+		{
+			const ShaderUniform *uniform = &shader->uniforms[shader->table[slot]];
+
+			if (uniform->hash == hash && strncmp(uniform->name, name, length) == 0 && uniform->name[length] == '\0')
+				return shader->table[slot];
+		}
+	}
+
+	// report a missing name once, not every frame
+	for (int i = 0; i < shader->missingCount; ++i)
+		if (shader->missing[i] == hash)
+			return -1;
+
+	// a name that cannot be remembered would be reported every frame
+	if (shader->missingCount == SHADER_MISSING_REPORTS)
+	{
+		if (!shader->missingSuppressed)
+			fprintf(stderr, "[ERROR]: More than %d uniforms missing from shader, further missing uniforms suppressed.\n", SHADER_MISSING_REPORTS);
+
+		shader->missingSuppressed = true;
+		return -1;
+	}
+
+	shader->missing[shader->missingCount++] = hash;
+
+	fprintf(stderr, "[ERROR]: Failed to retrive `%s` uniform from shader.\n", name);
+
+	return -1;
+}
+
+// false when the uniform already holds value, the shadow copy is updated
+static bool ShaderUniformChanged(Shader *shader, int uniform, const void *value, size_t size)
 {
-	int result = glGetUniformLocation(program, name);
+	ShaderUniform *u = &shader->uniforms[uniform];
+
+	if (u->known && memcmp(u->value, value, size) == 0)
+	{
+		++shader->stats.hits;
+		return false;
+	}
 
-	if (result < 0)
-		fprintf(stderr, "[ERROR]: Failed to retrive `%s` uniform from shader.\n", name);
+	memcpy(u->value, value, size);
+	u->known = true;
+	++shader->stats.misses;
 
-	return result;
+	return true;
 }
 
 void ShaderBind(Shader *shader)
 {
-	glUseProgram(shader->shaderID);
+	GLStateUseProgram(shader->shaderID);
+}
+
+void ShaderSetIntAt(Shader *shader, int uniform, int value)
+{
+	if (uniform >= 0 && ShaderUniformChanged(shader, uniform, &value, sizeof(value)))
+		glUniform1i(shader->uniforms[uniform].location, value);
+}
+
+void ShaderSetFloatAt(Shader *shader, int uniform, float value)
+{
+	if (uniform >= 0 && ShaderUniformChanged(shader, uniform, &value, sizeof(value)))
+		glUniform1f(shader->uniforms[uniform].location, value);
+}
+
+void ShaderSetFloat3At(Shader *shader, int uniform, const Vec3 value)
+{
+	float v[3] = { value.x, value.y, value.z };
+
+	if (uniform >= 0 && ShaderUniformChanged(shader, uniform, v, sizeof(v)))
+		glUniform3f(shader->uniforms[uniform].location, value.x, value.y, value.z);
+}
+
+void ShaderSetMat4At(Shader *shader, int uniform, const Mat4x4 value)
+{
+	if (uniform < 0)
+		return;
+
+	float16 m = Mat4x4ToFloat(value);
+
+	if (ShaderUniformChanged(shader, uniform, m.v, sizeof(m.v)))
+		glUniformMatrix4fv(shader->uniforms[uniform].location, 1, GL_FALSE, m.v);
 }
 
 void ShaderSetInt(Shader *shader, const char *name, int value)
 {
-	glUniform1i(ShaderGetUniformLocation(shader->shaderID, name), value);
+	ShaderSetIntAt(shader, ShaderFindUniform(shader, name), value);
 }
 
 void ShaderSetFloat(Shader *shader, const char *name, float value)
 {
-	glUniform1f(ShaderGetUniformLocation(shader->shaderID, name), value);
+	ShaderSetFloatAt(shader, ShaderFindUniform(shader, name), value);
 }
 
 void ShaderSetFloat3(Shader *shader, const char *name, const Vec3 value)
 {
-	glUniform3f(ShaderGetUniformLocation(shader->shaderID, name), value.x, value.y, value.z);
+	ShaderSetFloat3At(shader, ShaderFindUniform(shader, name), value);
 }
 
 void ShaderSetMat4(Shader *shader, const char *name, const Mat4x4 value)
 {
-	glUniformMatrix4fv(ShaderGetUniformLocation(shader->shaderID, name), 1, GL_FALSE, Mat4x4ToFloat(value).v);
+	ShaderSetMat4At(shader, ShaderFindUniform(shader, name), value);
+}
+
+void ShaderResetUniformStats(Shader *shader)
+{
+	shader->stats = (ShaderUniformStats) { 0 };
+}
+
+void ShaderBindUniformBlock(Shader *shader, const char *blockName, unsigned int binding)
+{
+	unsigned int index = glGetUniformBlockIndex(shader->shaderID, blockName);
+
+	if (index == GL_INVALID_INDEX)
+	{
+		fprintf(stderr, "[ERROR]: Failed to retrive `%s` uniform block from shader.\n", blockName);
+		return;
+	}
+
+	glUniformBlockBinding(shader->shaderID, index, binding);
 }
 
 void CheckShader(unsigned int shader, const char *message)
@@ -82,47 +271,104 @@ unsigned int CreateFragmentShader(const char *fragmentShaderSource)
 	return shader;
 }
 
+Shader CreateShaderFromSource(const char *vertexShaderSource, const char *fragmentShaderSource)
+{
+	uint64_t key = 0;
+	unsigned int program = 0;
+
+	if (ShaderCacheEnabled())
+	{
+		key = ShaderCacheKey(vertexShaderSource, fragmentShaderSource);
+		program = ShaderCacheLoad(key);
+	}
+
+	if (program == 0)
+	{
+		// compile vertex and fragment shader 
+		unsigned int vertexShaderStatus = CreateVetexShader(vertexShaderSource);
+		unsigned int fragmentShaderStatus = CreateFragmentShader(fragmentShaderSource);
+
+		// both were reported already, callers take shaderID 0 for a shader that cannot be used
+		int vertexCompiled, fragmentCompiled;
+		glGetShaderiv(vertexShaderStatus, GL_COMPILE_STATUS, &vertexCompiled);
+		glGetShaderiv(fragmentShaderStatus, GL_COMPILE_STATUS, &fragmentCompiled);
+
+		if (!vertexCompiled || !fragmentCompiled)
+		{
+			glDeleteShader(vertexShaderStatus);
+			glDeleteShader(fragmentShaderStatus);
+
+			return (Shader) { 0 };
+		}
+
+		program = glCreateProgram();
+
+		glAttachShader(program, vertexShaderStatus);
+		glAttachShader(program, fragmentShaderStatus);
+
+		if (ShaderCacheEnabled())
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+		glLinkProgram(program);
+
+		glDeleteShader(vertexShaderStatus);
+		glDeleteShader(fragmentShaderStatus);
+
+		int status;
+		char info[512];
+
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		if ( !status )
+		{
+			glGetProgramInfoLog(program, 512, NULL, info);
+			fprintf(stderr, "Failed to linke shader program :: %s\n", info);
+
+			glDeleteProgram(program);
+
+			return (Shader) { 0 };
+		}
+
+		ShaderCacheStore(key, program);
+	}
+
+	GLStateUseProgram(program);
+
+	return ShaderFromProgram(program);
+}
+
 Shader CreateShader(const char *vertexShaderPath, const char *fragmentShaderPath)
 {
-	const char *vertexShaderSource = read_file(vertexShaderPath);
-	const char *fragmentShaderSource = read_file(fragmentShaderPath);
+	char *vertexShaderSource = read_file(vertexShaderPath);
+	char *fragmentShaderSource = read_file(fragmentShaderPath);
 
 	// check if files exist.
 	if (!vertexShaderSource || !fragmentShaderSource)
 	{
 		printf("shader_err: I think, you passed NULL in file parameters.\n");
 
+		free(vertexShaderSource);
+		free(fragmentShaderSource);
+
 		return (Shader) { 
 			-1
 		};
 	}
 
-	// compile vertex and fragment shader 
-	unsigned int vertexShaderStatus = CreateVetexShader(vertexShaderSource);
-	unsigned int fragmentShaderStatus = CreateFragmentShader(fragmentShaderSource);
-
-	unsigned int program = glCreateProgram();
-
-	glAttachShader(program, vertexShaderStatus);
-	glAttachShader(program, fragmentShaderStatus);
-	glLinkProgram(program);
+	Shader shader = CreateShaderFromSource(vertexShaderSource, fragmentShaderSource);
 
-	int status;
-	char info[512];
+	free(vertexShaderSource);
+	free(fragmentShaderSource);
 
-	glGetProgramiv(program, GL_LINK_STATUS, &status);
-	if ( !status )
-	{
-		glGetShaderInfoLog(program, 512, NULL, info);
-		fprintf(stderr, "Failed to linke shader program :: %s\n", info);
-	}
+	return shader;
+}
 
-	glUseProgram(program);
+void DeleteShader(Shader *shader)
+{
+	GLStateForgetProgram(shader->shaderID);
+	glDeleteProgram(shader->shaderID);
 
-	glDeleteShader(vertexShaderStatus);
-	glDeleteShader(fragmentShaderStatus);
+	free(shader->uniforms);
+	free(shader->table);
 
-	return (Shader) { 
-		program
-	};
+	*shader = (Shader) { 0 };
 }
\ No newline at end of file
@@ -1,10 +1,62 @@
 #ifndef __SHADER_H__
 #define __SHADER_H__
 
+#include <stdint.h>
+#include <stdbool.h>
+
 #include "cmath.h"
 
+/*
+	CreateShader lists the active uniforms of the program once after linking
+	(glGetActiveUniform) into a table hashed by name, so setting a uniform
+	never asks the driver for a location. Uniforms inside uniform blocks
+	have no location and are left out. Arrays are found by their plain name
+	or name[0].
+
+	ShaderFindUniform resolves a name to a handle up front; the *At setters
+	take handles, the name setters look the handle up in the table first.
+	A name that is not an active uniform is reported once, then ignored.
+
+	Every uniform keeps a copy of the value last set through these setters
+	(the first element for arrays), and a set with the same value skips the
+	glUniform call. Setters expect the shader to be bound and must be the
+	only way its uniforms change.
+
+	After ShaderCacheInit, programs are loaded from the program binary cache
+	when it has them and compiled and stored there when it does not.
+*/
+
+#define SHADER_UNIFORM_NAME 64
+#define SHADER_MISSING_REPORTS 16
+
+typedef struct ShaderUniform {
+	char name[SHADER_UNIFORM_NAME];
+	uint32_t hash;
+	int location;
+	unsigned int type;       // GL_FLOAT_VEC3, GL_FLOAT_MAT4, ...
+	int size;                // array length, 1 otherwise
+	bool known;              // value holds what GL has
+	unsigned char value[64]; // enough for a mat4
+} ShaderUniform;
+
+typedef struct ShaderUniformStats {
+	unsigned int hits;       // sets skipped, the value was already there
+	unsigned int misses;     // sets that reached GL
+} ShaderUniformStats;
+
 typedef struct Shader {
 	unsigned int shaderID;
+
+	ShaderUniform *uniforms;
+	int uniformCount;
+	int *table;              // uniform index per slot, -1 when empty
+	unsigned int tableMask;  // slot count - 1
+
+	uint32_t missing[SHADER_MISSING_REPORTS]; // names already reported
+	int missingCount;
+	bool missingSuppressed;  // past SHADER_MISSING_REPORTS names nothing more is reported
+
+	ShaderUniformStats stats;
 } Shader;
 
 void ShaderBind(Shader *shader);
@@ -13,6 +65,28 @@ void ShaderSetFloat(Shader *shader, const char *name, float value);
 void ShaderSetFloat3(Shader *shader, const char *name, const Vec3 value);
 void ShaderSetMat4(Shader *shader, const char *name, const Mat4x4 value);
 
+// handle of an active uniform, -1 when the program has none of that name
+int ShaderFindUniform(Shader *shader, const char *name);
+
+// set by handle, -1 is ignored
+void ShaderSetIntAt(Shader *shader, int uniform, int value);
+void ShaderSetFloatAt(Shader *shader, int uniform, float value);
+void ShaderSetFloat3At(Shader *shader, int uniform, const Vec3 value);
+void ShaderSetMat4At(Shader *shader, int uniform, const Mat4x4 value);
+
+// point the uniform block blockName at a binding point, once after linking
+void ShaderBindUniformBlock(Shader *shader, const char *blockName, unsigned int binding);
+
+void ShaderResetUniformStats(Shader *shader);
+
 Shader CreateShader(const char *vertexShaderPath, const char *fragmentShaderPath);
 
+// same from sources in memory, through the program binary cache when it is on.
+// shaderID 0 when a stage does not compile or the program does not link
+Shader CreateShaderFromSource(const char *vertexShaderSource, const char *fragmentShaderSource);
+// wrap a linked program, listing its uniforms
+Shader ShaderFromProgram(unsigned int program);
+
+void DeleteShader(Shader *shader);
+
 #endif // __SHADER_H__
@@ -0,0 +1,207 @@
+#include <string.h>
+
+#include "ShaderCache.h"
+#include "common.h"
+#include "Hash.h"
+#include "IO.h"
+#include "GLExt.h"
+
+static struct {
+	bool enabled;
+	char directory[1024];    // with the version subdirectory
+	uint64_t driver;         // hash of the driver strings
+	ShaderCacheStats stats;
+} shaderCache;
+
+bool ShaderCacheInit(const char *directory)
+{
+	shaderCache.enabled = false;
+
+	if (directory == NULL)
+		return false;
+
+	if (!GLEXT_ARB_get_program_binary)
+	{
+		fprintf(stderr, "[ERROR]: No program binary support, shaders compile from source.\n");
+		return false;
+	}
+
+	int written = snprintf(shaderCache.directory, sizeof(shaderCache.directory), "%s/v%d", directory, SHADER_CACHE_VERSION);
+	if (written < 0 || (size_t)written >= sizeof(shaderCache.directory) - 32)
+	{
+		fprintf(stderr, "[ERROR]: Shader cache directory %s is too long.\n", directory);
+		return false;
+	}
+
+	if (!MakeDirectory(directory) || !MakeDirectory(shaderCache.directory))
+		return false;
+
+	// a binary only fits the driver that wrote it
+	uint64_t driver = SHADER_CACHE_VERSION;
+	driver = HashString((const char *)glGetString(GL_VENDOR), driver);
+	driver = HashString((const char *)glGetString(GL_RENDERER), driver);
+	driver = HashString((const char *)glGetString(GL_VERSION), driver);
+	driver = HashString((const char *)glGetString(GL_SHADING_LANGUAGE_VERSION), driver);
+
+	shaderCache.driver = driver;
+	shaderCache.enabled = true;
+
+	return true;
+}
+
+bool ShaderCacheEnabled(void)
+{
+	return shaderCache.enabled;
+}
+
+uint64_t ShaderCacheKey(const char *vertexSource, const char *fragmentSource)
+{
+	uint64_t key = HashString(vertexSource, shaderCache.driver);
+
+	// the hash mixes in the length, "ab" + "c" and "a" + "bc" differ
+	return HashString(fragmentSource, key);
+}
+
+static void ShaderCachePath(char *path, size_t size, uint64_t key)
+{
+	snprintf(path, size, "%s/%016llx.bin", shaderCache.directory, (unsigned long long)key);
+}
+
+static bool ShaderCacheValid(const ShaderCacheHeader *header, uint64_t key, long fileSize, const char **reason)
+{
+	if (memcmp(header->magic, "GLPB", 4) != 0)
+		*reason = "not a program binary";
+	else if (header->version != SHADER_CACHE_VERSION)
+		*reason = "other version";
+	else if (header->key != key)
+		*reason = "other program";
+	else if (header->length == 0 || (long)header->length != fileSize - (long)sizeof(*header))
+		*reason = "truncated";
+	else
+		return true;
+
+	return false;
+}
+
+unsigned int ShaderCacheLoad(uint64_t key)
+{
+	if (!shaderCache.enabled)
+		return 0;
+
+	char path[1100];
+	ShaderCachePath(path, sizeof(path), key);
+
+	FILE *input = fopen(path, "rb");
+	if (input == NULL)
+	{
+		shaderCache.stats.misses++;
+		return 0;
+	}
+
+	fseek(input, 0L, SEEK_END);
+	long fileSize = ftell(input);
+	fseek(input, 0L, SEEK_SET);
+
+	ShaderCacheHeader header = { 0 };
+	const char *reason = "truncated";
+	void *binary = NULL;
+	unsigned int program = 0;
+
+	if (fread(&header, sizeof(header), 1, input) == 1 && ShaderCacheValid(&header, key, fileSize, &reason))
+	{
+		binary = malloc(header.length);
+
+		if (binary == NULL || fread(binary, 1, header.length, input) != header.length)
+			reason = "truncated";
+		else if (HashBytes(binary, header.length, key) != header.checksum)
+			reason = "checksum mismatch";
+		else
+		{
+			program = glCreateProgram();
+			glProgramBinary(program, header.binaryFormat, binary, (GLsizei)header.length);
+
+			// the driver may still refuse it, after an update under the same strings
+			int status = 0;
+			glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+			if (!status)
+			{
+				glDeleteProgram(program);
+				program = 0;
+				reason = "refused by the driver";
+			}
+		}
+	}
+
+	fclose(input);
+	free(binary);
+
+	if (program == 0)
+	{
+		fprintf(stderr, "[ERROR]: Refused program binary %s (%s), compiling from source.\n", path, reason);
+		remove(path);
+		shaderCache.stats.rejected++;
+		return 0;
+	}
+
+	shaderCache.stats.hits++;
+
+	return program;
+}
+
+void ShaderCacheStore(uint64_t key, unsigned int program)
+{
+	if (!shaderCache.enabled)
+		return;
+
+	int length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	if (length <= 0)
+		return;
+
+	unsigned char *file = malloc(sizeof(ShaderCacheHeader) + (size_t)length);
+	if (file == NULL)
+		return;
+
+	ShaderCacheHeader header = { 0 };
+	memcpy(header.magic, "GLPB", 4);
+	header.version = SHADER_CACHE_VERSION;
+	header.key = key;
+
+	GLsizei returned = 0;
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &returned, &format, file + sizeof(header));
+
+	if (returned <= 0)
+	{
+		free(file);
+		return;
+	}
+
+	header.binaryFormat = format;
+	header.length = (uint32_t)returned;
+	header.checksum = HashBytes(file + sizeof(header), header.length, key);
+	memcpy(file, &header, sizeof(header));
+
+	char path[1100];
+	ShaderCachePath(path, sizeof(path), key);
+
+	// a crash never leaves half a binary behind
+	bool written = WriteFileAtomic(path, file, sizeof(header) + header.length);
+
+	free(file);
+
+	if (written)
+		shaderCache.stats.stored++;
+}
+
+ShaderCacheStats ShaderCacheGetStats(void)
+{
+	return shaderCache.stats;
+}
+
+void ShaderCacheResetStats(void)
+{
+	shaderCache.stats = (ShaderCacheStats) { 0 };
+}
@@ -0,0 +1,63 @@
+#ifndef __SHADER_CACHE_H__
+#define __SHADER_CACHE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+	Program binary cache, so GLSL is compiled and linked by the driver once
+	rather than on every launch.
+
+	ShaderCacheInit points the cache at a directory; binaries live in its
+	v<SHADER_CACHE_VERSION> subdirectory, one <key>.bin per program:
+
+		header    magic, version, key, checksum, binary format, length
+		binary    what glGetProgramBinary returned
+
+	The key hashes both sources as they are compiled (defines included) and
+	the GL_VENDOR, GL_RENDERER, GL_VERSION and GLSL version strings, so a
+	driver update or another GPU looks for other files instead of feeding a
+	binary to a driver that cannot take it.
+
+	ShaderCacheLoad checks the header and the checksum before glProgramBinary
+	and the link status after it. A missing, damaged or refused binary only
+	costs a source compile: CreateShader falls back on its own and stores a
+	fresh binary over the bad one. Without ARB_get_program_binary, or with no
+	binary format offered, the cache stays off and every program compiles.
+*/
+
+#define SHADER_CACHE_VERSION 1
+
+typedef struct ShaderCacheHeader {
+	char magic[4];           // "GLPB"
+	uint32_t version;
+	uint64_t key;
+	uint64_t checksum;       // of the binary
+	uint32_t binaryFormat;
+	uint32_t length;         // binary bytes after the header
+} ShaderCacheHeader;
+
+typedef struct ShaderCacheStats {
+	unsigned int hits;       // programs loaded from a binary
+	unsigned int misses;     // no binary yet, compiled from source
+	unsigned int rejected;   // binary damaged or refused by the driver, compiled from source
+	unsigned int stored;     // binaries written
+} ShaderCacheStats;
+
+// turn the cache on in directory, NULL turns it off. needs the context.
+bool ShaderCacheInit(const char *directory);
+bool ShaderCacheEnabled(void);
+
+// key of a program from the sources handed to the compiler
+uint64_t ShaderCacheKey(const char *vertexSource, const char *fragmentSource);
+
+// a linked program from the binary of key, 0 when it has to be compiled
+unsigned int ShaderCacheLoad(uint64_t key);
+
+// save the binary of a program linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+void ShaderCacheStore(uint64_t key, unsigned int program);
+
+ShaderCacheStats ShaderCacheGetStats(void);
+void ShaderCacheResetStats(void);
+
+#endif // __SHADER_CACHE_H__
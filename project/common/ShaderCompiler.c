@@ -0,0 +1,244 @@
+#include <string.h>
+
+#include "ShaderCompiler.h"
+#include "ShaderCache.h"
+#include "common.h"
+#include "IO.h"
+#include "GLExt.h"
+
+ShaderCompiler CreateShaderCompiler(void)
+{
+	ShaderCompiler compiler = { 0 };
+
+	compiler.parallel = GLEXT_KHR_parallel_shader_compile;
+	compiler.blockingPoll = SHADER_COMPILER_BLOCKING_POLL;
+
+	// 0xFFFFFFFF leaves the thread count to the driver, 0 would turn it off
+	if (compiler.parallel)
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+
+	return compiler;
+}
+
+static unsigned int ShaderCompilerStart(GLenum type, const char *source)
+{
+	unsigned int shader = glCreateShader(type);
+
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+
+	return shader;
+}
+
+int ShaderCompilerSubmit(ShaderCompiler *compiler, const char *vertexShaderSource, const char *fragmentShaderSource, ShaderReadyFunc callback, void *userData)
+{
+	if (compiler->jobCount == compiler->jobCapacity)
+	{
+		int capacity = compiler->jobCapacity ? compiler->jobCapacity * 2 : 64;
+
+		ShaderCompileJob *jobs = realloc(compiler->jobs, capacity * sizeof(ShaderCompileJob));
+		if (jobs == NULL)
+		{
+			fprintf(stderr, "[ERROR]: Failed to grow shader compiler jobs to %d.\n", capacity);
+			return -1;
+		}
+
+		compiler->jobs = jobs;
+		compiler->jobCapacity = capacity;
+	}
+
+	int handle = compiler->jobCount++;
+	ShaderCompileJob *job = &compiler->jobs[handle];
+
+	*job = (ShaderCompileJob) {
+		.status = SHADER_PENDING,
+		.callback = callback,
+		.userData = userData
+	};
+
+	compiler->pending++;
+
+	if (ShaderCacheEnabled())
+	{
+		job->key = ShaderCacheKey(vertexShaderSource, fragmentShaderSource);
+		job->program = ShaderCacheLoad(job->key);
+
+		if (job->program)
+			return handle;
+	}
+
+	// no status query anywhere, the driver works while the caller goes on
+	job->vertex = ShaderCompilerStart(GL_VERTEX_SHADER, vertexShaderSource);
+	job->fragment = ShaderCompilerStart(GL_FRAGMENT_SHADER, fragmentShaderSource);
+	job->program = glCreateProgram();
+
+	glAttachShader(job->program, job->vertex);
+	glAttachShader(job->program, job->fragment);
+
+	if (ShaderCacheEnabled())
+		glProgramParameteri(job->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	glLinkProgram(job->program);
+
+	return handle;
+}
+
+int ShaderCompilerSubmitFiles(ShaderCompiler *compiler, const char *vertexShaderPath, const char *fragmentShaderPath, ShaderReadyFunc callback, void *userData)
+{
+	char *vertexShaderSource = read_file(vertexShaderPath);
+	char *fragmentShaderSource = read_file(fragmentShaderPath);
+	int handle = -1;
+
+	if (vertexShaderSource && fragmentShaderSource)
+		handle = ShaderCompilerSubmit(compiler, vertexShaderSource, fragmentShaderSource, callback, userData);
+	else
+		fprintf(stderr, "[ERROR]: Failed to read shader %s or %s.\n", vertexShaderPath, fragmentShaderPath);
+
+	// glShaderSource keeps its own copy
+	free(vertexShaderSource);
+	free(fragmentShaderSource);
+
+	return handle;
+}
+
+static void ShaderCompilerLog(unsigned int shader, const char *message)
+{
+	int status = 0;
+	char info[512];
+
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (!status)
+	{
+		glGetShaderInfoLog(shader, sizeof(info), NULL, info);
+		fprintf(stderr, "%s :: %s\n", message, info);
+	}
+}
+
+// reads the link status, waits for the driver unless the job is complete
+static void ShaderCompilerResolve(ShaderCompiler *compiler, int handle)
+{
+	ShaderCompileJob *job = &compiler->jobs[handle];
+
+	int status = 0;
+	glGetProgramiv(job->program, GL_LINK_STATUS, &status);
+
+	if (status)
+	{
+		if (job->vertex)
+			ShaderCacheStore(job->key, job->program);
+
+		job->shader = ShaderFromProgram(job->program);
+		job->status = SHADER_READY;
+	}
+	else
+	{
+		char info[512];
+
+		ShaderCompilerLog(job->vertex, "Failed to compile vertex shader");
+		ShaderCompilerLog(job->fragment, "Failed to compile fragment shader");
+
+		glGetProgramInfoLog(job->program, sizeof(info), NULL, info);
+		fprintf(stderr, "Failed to linke shader program :: %s\n", info);
+
+		glDeleteProgram(job->program);
+		job->program = 0;
+		job->status = SHADER_FAILED;
+	}
+
+	if (job->vertex)
+	{
+		glDeleteShader(job->vertex);
+		glDeleteShader(job->fragment);
+		job->vertex = job->fragment = 0;
+	}
+
+	compiler->pending--;
+
+	if (job->callback)
+		job->callback(job->userData, handle, job->status == SHADER_READY ? &job->shader : NULL);
+}
+
+static int ShaderCompilerPollBlocking(ShaderCompiler *compiler, int budget)
+{
+	for (int i = compiler->firstPending; i < compiler->jobCount; ++i)
+	{
+		ShaderCompileJob *job = &compiler->jobs[i];
+
+		if (job->status != SHADER_PENDING)
+			continue;
+
+		// binaries are linked already, only compiles count against the budget
+		if (job->vertex && !compiler->parallel)
+		{
+			if (budget == 0)
+				continue;
+			budget--;
+		}
+		else if (job->vertex)
+		{
+			int complete = 0;
+			glGetProgramiv(job->program, GL_COMPLETION_STATUS_KHR, &complete);
+
+			if (!complete && budget == 0)
+				continue;
+		}
+
+		ShaderCompilerResolve(compiler, i);
+	}
+
+	while (compiler->firstPending < compiler->jobCount && compiler->jobs[compiler->firstPending].status != SHADER_PENDING)
+		compiler->firstPending++;
+
+	return compiler->pending;
+}
+
+int ShaderCompilerPoll(ShaderCompiler *compiler)
+{
+	return ShaderCompilerPollBlocking(compiler, compiler->parallel ? 0 : compiler->blockingPoll);
+}
+
+void ShaderCompilerFinish(ShaderCompiler *compiler)
+{
+	ShaderCompilerPollBlocking(compiler, compiler->pending);
+}
+
+ShaderStatus ShaderCompilerStatus(const ShaderCompiler *compiler, int handle)
+{
+	if (handle < 0 || handle >= compiler->jobCount)
+		return SHADER_FAILED;
+
+	return compiler->jobs[handle].status;
+}
+
+Shader *ShaderCompilerGet(ShaderCompiler *compiler, int handle, Shader *placeholder)
+{
+	if (ShaderCompilerStatus(compiler, handle) != SHADER_READY)
+		return placeholder;
+
+	return &compiler->jobs[handle].shader;
+}
+
+void DeleteShaderCompiler(ShaderCompiler *compiler)
+{
+	for (int i = 0; i < compiler->jobCount; ++i)
+	{
+		ShaderCompileJob *job = &compiler->jobs[i];
+
+		if (job->status == SHADER_READY)
+			DeleteShader(&job->shader);
+		else if (job->status == SHADER_PENDING)
+		{
+			glDeleteProgram(job->program);
+
+			if (job->vertex)
+			{
+				glDeleteShader(job->vertex);
+				glDeleteShader(job->fragment);
+			}
+		}
+	}
+
+	free(compiler->jobs);
+
+	*compiler = (ShaderCompiler) { 0 };
+}
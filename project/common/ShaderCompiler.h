@@ -0,0 +1,86 @@
+#ifndef __SHADER_COMPILER_H__
+#define __SHADER_COMPILER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Shader.h"
+
+/*
+	Non blocking program creation, for loads that build many programs.
+
+	ShaderCompilerSubmit issues the compile and link calls of a program and
+	returns at once; no status is asked for, so the driver keeps compiling
+	while the next programs are submitted. With KHR_parallel_shader_compile
+	the driver compiles on its own threads and ShaderCompilerPoll asks
+	GL_COMPLETION_STATUS_KHR, which never waits, before reading the link
+	status of a program. Without it a status query waits for the compile,
+	so a poll finishes at most blockingPoll programs, oldest first, to keep
+	frames short while a level loads.
+
+	A finished program is reflected like CreateShader does, stored in the
+	program binary cache when that is on, and handed to its callback in the
+	poll that saw it finish. Until then ShaderCompilerGet returns the
+	placeholder given to it, a flat shaded program for instance, so the
+	renderer draws something for every material from the first frame.
+
+	Programs the binary cache has are linked at submit and come out of the
+	next poll. The compiler owns its programs, DeleteShaderCompiler
+	deletes them.
+*/
+
+#define SHADER_COMPILER_BLOCKING_POLL 4
+
+typedef enum {
+	SHADER_PENDING, SHADER_READY, SHADER_FAILED
+} ShaderStatus;
+
+// called once per program from the poll that finished it, shader is NULL when it failed
+typedef void (*ShaderReadyFunc)(void *userData, int handle, Shader *shader);
+
+typedef struct ShaderCompileJob {
+	Shader shader;           // once SHADER_READY
+	ShaderStatus status;
+	unsigned int program;
+	unsigned int vertex;     // 0 for a program from the binary cache
+	unsigned int fragment;
+	uint64_t key;            // program binary cache key
+	ShaderReadyFunc callback;
+	void *userData;
+} ShaderCompileJob;
+
+typedef struct ShaderCompiler {
+	ShaderCompileJob *jobs;
+	int jobCount;
+	int jobCapacity;
+	int firstPending;        // no pending job before it
+	int pending;
+
+	bool parallel;           // completion is known without waiting
+	int blockingPoll;        // programs a poll finishes without the extension
+} ShaderCompiler;
+
+// lets the driver use as many compiler threads as it likes
+ShaderCompiler CreateShaderCompiler(void);
+
+// start compiling a program, returns its handle. callback may be NULL.
+int ShaderCompilerSubmit(ShaderCompiler *compiler, const char *vertexShaderSource, const char *fragmentShaderSource, ShaderReadyFunc callback, void *userData);
+
+// same from files, -1 when one cannot be read
+int ShaderCompilerSubmitFiles(ShaderCompiler *compiler, const char *vertexShaderPath, const char *fragmentShaderPath, ShaderReadyFunc callback, void *userData);
+
+// finish what is done, returns how many programs are still pending
+int ShaderCompilerPoll(ShaderCompiler *compiler);
+
+// wait for every pending program
+void ShaderCompilerFinish(ShaderCompiler *compiler);
+
+ShaderStatus ShaderCompilerStatus(const ShaderCompiler *compiler, int handle);
+
+// the program of handle once it is ready, placeholder until then and when it failed.
+// valid until the next submit.
+Shader *ShaderCompilerGet(ShaderCompiler *compiler, int handle, Shader *placeholder);
+
+void DeleteShaderCompiler(ShaderCompiler *compiler);
+
+#endif // __SHADER_COMPILER_H__
@@ -0,0 +1,152 @@
+#include <string.h>
+
+#include "ShaderPermutation.h"
+#include "common.h"
+#include "GLExt.h"
+
+ShaderPermutations CreateShaderPermutations(ShaderSources *sources, const char *vertexShaderPath, const char *fragmentShaderPath, const char *const *features, int featureCount)
+{
+	ShaderPermutations permutations = { 0 };
+
+	if (strlen(vertexShaderPath) >= SHADER_SOURCE_PATH || strlen(fragmentShaderPath) >= SHADER_SOURCE_PATH)
+	{
+		fprintf(stderr, "[ERROR]: Shader path %s or %s is too long.\n", vertexShaderPath, fragmentShaderPath);
+		return permutations;
+	}
+
+	if (featureCount > SHADER_MAX_FEATURES)
+	{
+		fprintf(stderr, "[ERROR]: Shaders take at most %d features, %d given.\n", SHADER_MAX_FEATURES, featureCount);
+		featureCount = SHADER_MAX_FEATURES;
+	}
+
+	permutations.sources = sources;
+	strcpy(permutations.vertexShaderPath, vertexShaderPath);
+	strcpy(permutations.fragmentShaderPath, fragmentShaderPath);
+	permutations.features = features;
+	permutations.featureCount = featureCount;
+	permutations.last = -1;
+
+	return permutations;
+}
+
+// variants leave out what their features do not use, a missing block is fine
+static void ShaderPermutationBindBlock(Shader *shader, const ShaderPermutationBlock *block)
+{
+	if (shader->shaderID == 0)
+		return;
+
+	unsigned int index = glGetUniformBlockIndex(shader->shaderID, block->name);
+
+	if (index != GL_INVALID_INDEX)
+		glUniformBlockBinding(shader->shaderID, index, block->binding);
+}
+
+void ShaderPermutationsBindUniformBlock(ShaderPermutations *permutations, const char *blockName, unsigned int binding)
+{
+	if (permutations->blockCount == SHADER_PERMUTATION_BLOCKS || strlen(blockName) >= SHADER_UNIFORM_NAME)
+	{
+		fprintf(stderr, "[ERROR]: Failed to add uniform block `%s` to the shader permutations.\n", blockName);
+		return;
+	}
+
+	ShaderPermutationBlock *block = &permutations->blocks[permutations->blockCount++];
+	strcpy(block->name, blockName);
+	block->binding = binding;
+
+	for (int i = 0; i < permutations->permutationCount; ++i)
+		ShaderPermutationBindBlock(&permutations->permutations[i].shader, block);
+}
+
+static Shader ShaderPermutationBuild(ShaderPermutations *permutations, uint32_t features)
+{
+	// "#define NAME 1\n" per feature
+	char defines[SHADER_MAX_FEATURES * (SHADER_UNIFORM_NAME + 12)];
+	size_t length = 0;
+	defines[0] = '\0';
+
+	for (int i = 0; i < permutations->featureCount; ++i)
+	{
+		if (features & (1u << i))
+		{
+			int written = snprintf(defines + length, sizeof(defines) - length, "#define %.*s 1\n", SHADER_UNIFORM_NAME - 1, permutations->features[i]);
+			if (written > 0) length += (size_t)written;
+		}
+	}
+
+	char *vertexShaderSource = ShaderSourceExpand(permutations->sources, permutations->vertexShaderPath, defines);
+	char *fragmentShaderSource = ShaderSourceExpand(permutations->sources, permutations->fragmentShaderPath, defines);
+
+	Shader shader = { 0 };
+
+	if (vertexShaderSource && fragmentShaderSource)
+	{
+		shader = CreateShaderFromSource(vertexShaderSource, fragmentShaderSource);
+
+		for (int i = 0; i < permutations->blockCount; ++i)
+			ShaderPermutationBindBlock(&shader, &permutations->blocks[i]);
+	}
+
+	free(vertexShaderSource);
+	free(fragmentShaderSource);
+
+	return shader;
+}
+
+Shader *ShaderPermutationGet(ShaderPermutations *permutations, uint32_t features)
+{
+	if (permutations->featureCount < SHADER_MAX_FEATURES)
+		features &= (1u << permutations->featureCount) - 1;
+
+	// the same variant is usually asked for many times in a row
+	int found = -1;
+
+	if (permutations->last >= 0 && permutations->permutations[permutations->last].features == features)
+		found = permutations->last;
+
+	for (int i = 0; found < 0 && i < permutations->permutationCount; ++i)
+		if (permutations->permutations[i].features == features)
+			found = i;
+
+	if (found >= 0)
+		permutations->hits++;
+	else
+	{
+		if (permutations->permutationCount == permutations->permutationCapacity)
+		{
+			int capacity = permutations->permutationCapacity ? permutations->permutationCapacity * 2 : 8;
+
+			ShaderPermutation *grown = realloc(permutations->permutations, capacity * sizeof(ShaderPermutation));
+			if (grown == NULL)
+			{
+				fprintf(stderr, "[ERROR]: Failed to grow shader permutations to %d.\n", capacity);
+				return NULL;
+			}
+
+			permutations->permutations = grown;
+			permutations->permutationCapacity = capacity;
+		}
+
+		found = permutations->permutationCount++;
+		permutations->permutations[found].features = features;
+		permutations->permutations[found].shader = ShaderPermutationBuild(permutations, features);
+		permutations->compiles++;
+	}
+
+	permutations->last = found;
+
+	Shader *shader = &permutations->permutations[found].shader;
+
+	return shader->shaderID ? shader : NULL;
+}
+
+void DeleteShaderPermutations(ShaderPermutations *permutations)
+{
+	for (int i = 0; i < permutations->permutationCount; ++i)
+		if (permutations->permutations[i].shader.shaderID)
+			DeleteShader(&permutations->permutations[i].shader);
+
+	free(permutations->permutations);
+
+	*permutations = (ShaderPermutations) { 0 };
+}
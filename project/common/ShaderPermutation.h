@@ -0,0 +1,74 @@
+#ifndef __SHADER_PERMUTATION_H__
+#define __SHADER_PERMUTATION_H__
+
+#include <stdint.h>
+
+#include "Shader.h"
+#include "ShaderSource.h"
+
+/*
+	Variants of one vertex and fragment shader pair, selected by features.
+
+	Every feature is a define name, feature i is bit i of the mask. The mask
+	picks which defines ShaderSourceExpand puts after #version, so one file
+	pair with #ifdef blocks replaces a copy of the files per variant:
+
+		static const char *meshFeatures[] = { "TEXTURED", "INSTANCED" };
+
+		ShaderPermutations mesh = CreateShaderPermutations(&sources,
+			"assets/shader/mesh.vs", "assets/shader/mesh.fs", meshFeatures, 2);
+
+		Shader *shader = ShaderPermutationGet(&mesh, TEXTURED | INSTANCED);
+
+	A variant is compiled the first time it is asked for, through the
+	program binary cache when that is on, so only variants a scene draws
+	cost anything. Uniform blocks given to ShaderPermutationsBindUniformBlock
+	are bound in every variant that has them, built or still to come.
+*/
+
+#define SHADER_MAX_FEATURES 32
+#define SHADER_PERMUTATION_BLOCKS 8
+
+typedef struct ShaderPermutation {
+	uint32_t features;
+	Shader shader;           // shaderID 0 when the sources could not be read
+} ShaderPermutation;
+
+typedef struct ShaderPermutationBlock {
+	char name[SHADER_UNIFORM_NAME];
+	unsigned int binding;
+} ShaderPermutationBlock;
+
+typedef struct ShaderPermutations {
+	ShaderSources *sources;  // shared, so include files are read once for all sets
+	char vertexShaderPath[SHADER_SOURCE_PATH];
+	char fragmentShaderPath[SHADER_SOURCE_PATH];
+
+	const char *const *features; // kept, not copied
+	int featureCount;
+
+	ShaderPermutationBlock blocks[SHADER_PERMUTATION_BLOCKS];
+	int blockCount;
+
+	ShaderPermutation *permutations;
+	int permutationCount;
+	int permutationCapacity;
+	int last;                // the permutation asked for last
+
+	unsigned int compiles;   // variants built
+	unsigned int hits;       // asks served by a built variant
+} ShaderPermutations;
+
+ShaderPermutations CreateShaderPermutations(ShaderSources *sources, const char *vertexShaderPath, const char *fragmentShaderPath, const char *const *features, int featureCount);
+
+// bind blockName to binding in every variant declaring it
+void ShaderPermutationsBindUniformBlock(ShaderPermutations *permutations, const char *blockName, unsigned int binding);
+
+// the variant with the features of the mask, built on first use. bits past
+// featureCount are ignored. NULL when its sources cannot be read, the
+// pointer is valid until a variant is built.
+Shader *ShaderPermutationGet(ShaderPermutations *permutations, uint32_t features);
+
+void DeleteShaderPermutations(ShaderPermutations *permutations);
+
+#endif // __SHADER_PERMUTATION_H__
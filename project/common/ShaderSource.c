@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "ShaderSource.h"
+
+typedef struct ShaderText {
+	char *data;
+	size_t length;
+	size_t capacity;
+	bool failed;
+} ShaderText;
+
+static void ShaderTextAppend(ShaderText *text, const char *data, size_t length)
+{
+	if (text->failed)
+		return;
+
+	if (text->length + length + 1 > text->capacity)
+	{
+		size_t capacity = text->capacity ? text->capacity * 2 : 4096;
+		while (capacity < text->length + length + 1) capacity *= 2;
+
+		char *grown = realloc(text->data, capacity);
+		if (grown == NULL)
+		{
+			fprintf(stderr, "[ERROR]: Failed to grow shader source to %zu bytes.\n", capacity);
+			text->failed = true;
+			return;
+		}
+
+		text->data = grown;
+		text->capacity = capacity;
+	}
+
+	memcpy(text->data + text->length, data, length);
+	text->length += length;
+	text->data[text->length] = '\0';
+}
+
+static void ShaderTextLine(ShaderText *text, int line, int file)
+{
+	char directive[64];
+	int length = snprintf(directive, sizeof(directive), "#line %d %d\n", line, file);
+
+	ShaderTextAppend(text, directive, (size_t)length);
+}
+
+static const char *ShaderSkipBlank(const char *c, const char *end)
+{
+	while (c < end && (*c == ' ' || *c == '\t'))
+		++c;
+
+	return c;
+}
+
+// include paths are relative to the file that names them
+static bool ShaderResolvePath(char *path, const char *from, const char *name, size_t nameLength)
+{
+	size_t directory = 0;
+
+	if (name[0] != '/')
+		for (size_t i = 0; from[i]; ++i)
+			if (from[i] == '/' || from[i] == '\\')
+				directory = i + 1;
+
+	if (directory + nameLength >= SHADER_SOURCE_PATH)
+		return false;
+
+	memcpy(path, from, directory);
+	memcpy(path + directory, name, nameLength);
+	path[directory + nameLength] = '\0';
+
+	return true;
+}
+
+// finds the #version and #include lines, once per file
+static bool ShaderSourceParse(ShaderSourceFile *file)
+{
+	const char *text = file->text;
+	const char *end = text + file->length;
+	int capacity = 0;
+	int line = 1;
+
+	for (const char *start = text; start < end; ++line)
+	{
+		const char *lineEnd = memchr(start, '\n', (size_t)(end - start));
+		lineEnd = lineEnd ? lineEnd + 1 : end;
+
+		const char *c = ShaderSkipBlank(start, lineEnd);
+
+		if (c < lineEnd && *c == '#')
+		{
+			c = ShaderSkipBlank(c + 1, lineEnd);
+
+			if (file->versionEnd == 0 && lineEnd - c >= 7 && strncmp(c, "version", 7) == 0)
+			{
+				file->versionEnd = (size_t)(lineEnd - text);
+				file->versionLine = line;
+			}
+			else if (lineEnd - c >= 7 && strncmp(c, "include", 7) == 0)
+			{
+				c = ShaderSkipBlank(c + 7, lineEnd);
+
+				char close = *c == '<' ? '>' : '"';
+				const char *name = c + 1;
+				const char *nameEnd = c < lineEnd && (*c == '"' || *c == '<') ? memchr(name, close, (size_t)(lineEnd - name)) : NULL;
+
+				if (nameEnd == NULL || nameEnd == name)
+				{
+					fprintf(stderr, "[ERROR]: %s:%d: expected #include \"file\".\n", file->path, line);
+					return false;
+				}
+
+				if (file->includeCount == capacity)
+				{
+					capacity = capacity ? capacity * 2 : 4;
+
+					ShaderInclude *includes = realloc(file->includes, capacity * sizeof(ShaderInclude));
+					if (includes == NULL)
+						return false;
+
+					file->includes = includes;
+				}
+
+				ShaderInclude *include = &file->includes[file->includeCount++];
+				include->start = (size_t)(start - text);
+				include->end = (size_t)(lineEnd - text);
+				include->line = line;
+
+				if (!ShaderResolvePath(include->path, file->path, name, (size_t)(nameEnd - name)))
+				{
+					fprintf(stderr, "[ERROR]: %s:%d: include path is too long.\n", file->path, line);
+					return false;
+				}
+			}
+		}
+
+		start = lineEnd;
+	}
+
+	return true;
+}
+
+static void ShaderSourceFree(ShaderSourceFile *file)
+{
+	free(file->text);
+	free(file->includes);
+}
+
+// index of the file at path, read and parsed on first use, -1 when it cannot be
+static int ShaderSourceLoad(ShaderSources *sources, const char *path)
+{
+	for (int i = 0; i < sources->fileCount; ++i)
+	{
+		if (strcmp(sources->files[i].path, path) == 0)
+		{
+			sources->reuses++;
+			return i;
+		}
+	}
+
+	if (strlen(path) >= SHADER_SOURCE_PATH)
+	{
+		fprintf(stderr, "[ERROR]: Shader path %s is too long.\n", path);
+		return -1;
+	}
+
+	if (sources->fileCount == sources->fileCapacity)
+	{
+		int capacity = sources->fileCapacity ? sources->fileCapacity * 2 : 16;
+
+		ShaderSourceFile *files = realloc(sources->files, capacity * sizeof(ShaderSourceFile));
+		if (files == NULL)
+		{
+			fprintf(stderr, "[ERROR]: Failed to grow shader sources to %d.\n", capacity);
+			return -1;
+		}
+
+		sources->files = files;
+		sources->fileCapacity = capacity;
+	}
+
+	FILE *input = fopen(path, "rb");
+	if (input == NULL)
+		return -1;
+
+	fseek(input, 0L, SEEK_END);
+	long length = ftell(input);
+	fseek(input, 0L, SEEK_SET);
+
+	ShaderSourceFile file = { 0 };
+	strcpy(file.path, path);
+	file.text = length >= 0 ? malloc((size_t)length + 1) : NULL;
+
+	if (file.text)
+	{
+		file.length = fread(file.text, 1, (size_t)length, input);
+		file.text[file.length] = '\0';
+	}
+
+	fclose(input);
+
+	if (file.text == NULL || !ShaderSourceParse(&file))
+	{
+		ShaderSourceFree(&file);
+		return -1;
+	}
+
+	sources->reads++;
+	sources->files[sources->fileCount] = file;
+
+	return sources->fileCount++;
+}
+
+typedef struct ShaderExpansion {
+	ShaderText text;
+	int included[SHADER_INCLUDES_PER_SHADER];
+	int includedCount;
+} ShaderExpansion;
+
+static bool ShaderSourceIncluded(ShaderExpansion *expansion, int index)
+{
+	for (int i = 0; i < expansion->includedCount; ++i)
+		if (expansion->included[i] == index)
+			return true;
+
+	return false;
+}
+
+static bool ShaderSourceEmit(ShaderSources *sources, ShaderExpansion *expansion, int index, const char *defines, int depth)
+{
+	if (depth > SHADER_INCLUDE_DEPTH)
+	{
+		fprintf(stderr, "[ERROR]: %s: includes nest deeper than %d.\n", sources->files[index].path, SHADER_INCLUDE_DEPTH);
+		return false;
+	}
+
+	// loading an include may move the files, so no pointer into them is kept
+	size_t position = 0;
+
+	if (defines)
+	{
+		const ShaderSourceFile *file = &sources->files[index];
+
+		ShaderTextAppend(&expansion->text, file->text, file->versionEnd);
+		if (file->versionEnd && file->text[file->versionEnd - 1] != '\n')
+			ShaderTextAppend(&expansion->text, "\n", 1);
+
+		ShaderTextAppend(&expansion->text, defines, strlen(defines));
+		ShaderTextLine(&expansion->text, file->versionLine + 1, index);
+
+		position = file->versionEnd;
+	}
+
+	for (int i = 0; i < sources->files[index].includeCount; ++i)
+	{
+		ShaderInclude include = sources->files[index].includes[i];
+
+		// nothing may come before #version, an include up there is dropped
+		if (include.start < position)
+			continue;
+
+		ShaderTextAppend(&expansion->text, sources->files[index].text + position, include.start - position);
+		position = include.end;
+
+		int child = ShaderSourceLoad(sources, include.path);
+		if (child < 0)
+		{
+			fprintf(stderr, "[ERROR]: %s:%d: cannot include %s.\n", sources->files[index].path, include.line, include.path);
+			return false;
+		}
+
+		if (!ShaderSourceIncluded(expansion, child))
+		{
+			if (expansion->includedCount == SHADER_INCLUDES_PER_SHADER)
+			{
+				fprintf(stderr, "[ERROR]: %s: more than %d includes.\n", sources->files[index].path, SHADER_INCLUDES_PER_SHADER);
+				return false;
+			}
+
+			expansion->included[expansion->includedCount++] = child;
+
+			ShaderTextLine(&expansion->text, 1, child);
+			if (!ShaderSourceEmit(sources, expansion, child, NULL, depth + 1))
+				return false;
+			ShaderTextAppend(&expansion->text, "\n", 1);
+		}
+
+		ShaderTextLine(&expansion->text, include.line + 1, index);
+	}
+
+	const ShaderSourceFile *file = &sources->files[index];
+	ShaderTextAppend(&expansion->text, file->text + position, file->length - position);
+
+	return !expansion->text.failed;
+}
+
+char *ShaderSourceExpand(ShaderSources *sources, const char *path, const char *defines)
+{
+	int root = ShaderSourceLoad(sources, path);
+	if (root < 0)
+	{
+		fprintf(stderr, "[ERROR]: Failed to read shader %s.\n", path);
+		return NULL;
+	}
+
+	ShaderExpansion expansion = { 0 };
+	expansion.included[expansion.includedCount++] = root;
+
+	if (!ShaderSourceEmit(sources, &expansion, root, defines ? defines : "", 0))
+	{
+		free(expansion.text.data);
+		return NULL;
+	}
+
+	return expansion.text.data;
+}
+
+const char *ShaderSourcePath(const ShaderSources *sources, int index)
+{
+	if (index < 0 || index >= sources->fileCount)
+		return NULL;
+
+	return sources->files[index].path;
+}
+
+void DeleteShaderSources(ShaderSources *sources)
+{
+	for (int i = 0; i < sources->fileCount; ++i)
+		ShaderSourceFree(&sources->files[i]);
+
+	free(sources->files);
+
+	*sources = (ShaderSources) { 0 };
+}
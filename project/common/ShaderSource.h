@@ -0,0 +1,64 @@
+#ifndef __SHADER_SOURCE_H__
+#define __SHADER_SOURCE_H__
+
+#include <stddef.h>
+
+/*
+	GLSL preprocessing in front of the compiler, which has no #include.
+
+	ShaderSources keeps every file it has read, parsed once: the text, the
+	#version line and the #include "path" lines, with paths relative to the
+	including file. Expanding a shader copies text spans around those lines,
+	so building many variants of a shader reads and scans each file once.
+
+	ShaderSourceExpand writes the top file with its includes in place and
+	the given defines right after #version, where GLSL wants them. A file is
+	included once per shader, later includes of it are dropped, so include
+	files need no guards and cycles end by themselves. #line directives keep
+	compiler errors pointing at the right line; drivers that print the
+	source string number print the index of the file in ShaderSources,
+	ShaderSourcePath turns it back into a path.
+*/
+
+#define SHADER_SOURCE_PATH 256
+#define SHADER_INCLUDE_DEPTH 16
+#define SHADER_INCLUDES_PER_SHADER 64
+
+typedef struct ShaderInclude {
+	size_t start;            // the #include line in text, newline included
+	size_t end;
+	int line;                // 1 based
+	char path[SHADER_SOURCE_PATH]; // resolved against the including file
+} ShaderInclude;
+
+typedef struct ShaderSourceFile {
+	char path[SHADER_SOURCE_PATH];
+	char *text;
+	size_t length;
+
+	size_t versionEnd;       // past the #version line, 0 without one
+	int versionLine;
+
+	ShaderInclude *includes;
+	int includeCount;
+} ShaderSourceFile;
+
+typedef struct ShaderSources {
+	ShaderSourceFile *files;
+	int fileCount;
+	int fileCapacity;
+
+	unsigned int reads;      // files read from disk
+	unsigned int reuses;     // files served from the cache
+} ShaderSources;
+
+// the shader at path with its includes and defines, NULL when a file is missing. free it.
+char *ShaderSourceExpand(ShaderSources *sources, const char *path, const char *defines);
+
+// path of the file a compiler error names by its source string number
+const char *ShaderSourcePath(const ShaderSources *sources, int index);
+
+// drop every file, the next expand reads them again
+void DeleteShaderSources(ShaderSources *sources);
+
+#endif // __SHADER_SOURCE_H__
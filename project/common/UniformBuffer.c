@@ -0,0 +1,214 @@
+#include <string.h>
+
+#include "UniformBuffer.h"
+#include "GLState.h"
+#include "GLExt.h"
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	std140
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+static const struct {
+	size_t alignment;
+	size_t size;
+	unsigned int columns; // matrices only
+} std140Types[] = {
+	[STD140_FLOAT] = { 4, 4, 0 },
+	[STD140_INT]   = { 4, 4, 0 },
+	[STD140_UINT]  = { 4, 4, 0 },
+	[STD140_VEC2]  = { 8, 8, 0 },
+	[STD140_VEC3]  = { 16, 12, 0 },
+	[STD140_VEC4]  = { 16, 16, 0 },
+	[STD140_IVEC2] = { 8, 8, 0 },
+	[STD140_IVEC3] = { 16, 12, 0 },
+	[STD140_IVEC4] = { 16, 16, 0 },
+	[STD140_MAT3]  = { 16, 48, 3 },
+	[STD140_MAT4]  = { 16, 64, 4 }
+};
+
+static size_t Std140Align(size_t offset, size_t alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+size_t Std140Add(Std140Layout *layout, const char *name, Std140Type type, unsigned int arrayCount)
+{
+	if (layout->memberCount == STD140_MAX_MEMBERS)
+	{
+		fprintf(stderr, "[ERROR]: std140 layouts take at most %d members, `%s` is dropped.\n", STD140_MAX_MEMBERS, name);
+		return layout->end;
+	}
+
+	size_t alignment = std140Types[type].alignment;
+	size_t size = std140Types[type].size;
+	size_t stride = 0;
+
+	// array elements and matrix columns are vec4 aligned
+	if (arrayCount > 0)
+	{
+		alignment = 16;
+		stride = Std140Align(size, 16);
+		size = stride * arrayCount;
+	}
+
+	Std140Member *member = &layout->members[layout->memberCount++];
+	member->name = name;
+	member->type = type;
+	member->arrayCount = arrayCount;
+	member->offset = Std140Align(layout->end, alignment);
+	member->arrayStride = stride;
+
+	layout->end = member->offset + size;
+
+	// whatever follows an array or a matrix starts on a vec4
+	if (arrayCount > 0 || std140Types[type].columns)
+		layout->end = Std140Align(layout->end, 16);
+
+	return member->offset;
+}
+
+size_t Std140Size(const Std140Layout *layout)
+{
+	return Std140Align(layout->end, 16);
+}
+
+int Std140Find(const Std140Layout *layout, const char *name)
+{
+	for (size_t i = 0; i < layout->memberCount; ++i)
+		if (strcmp(layout->members[i].name, name) == 0)
+			return (int)i;
+
+	return -1;
+}
+
+void Std140SetFloat(void *block, size_t offset, float value)
+{
+	memcpy((unsigned char *)block + offset, &value, sizeof(value));
+}
+
+void Std140SetInt(void *block, size_t offset, int value)
+{
+	memcpy((unsigned char *)block + offset, &value, sizeof(value));
+}
+
+void Std140SetVec3(void *block, size_t offset, Vec3 value)
+{
+	float v[3] = { value.x, value.y, value.z };
+	memcpy((unsigned char *)block + offset, v, sizeof(v));
+}
+
+void Std140SetVec4(void *block, size_t offset, Vec4 value)
+{
+	float v[4] = { value.x, value.y, value.z, value.w };
+	memcpy((unsigned char *)block + offset, v, sizeof(v));
+}
+
+void Std140SetMat3(void *block, size_t offset, Mat4x4 value)
+{
+	float16 m = Mat4x4ToFloat(value);
+
+	// column major, each column padded to a vec4
+	for (int column = 0; column < 3; ++column)
+		memcpy((unsigned char *)block + offset + column * 16, &m.v[column * 4], 3 * sizeof(float));
+}
+
+void Std140SetMat4(void *block, size_t offset, Mat4x4 value)
+{
+	float16 m = Mat4x4ToFloat(value);
+	memcpy((unsigned char *)block + offset, m.v, sizeof(m.v));
+}
+
+FrameUniforms CreateFrameUniforms(Mat4x4 view, Mat4x4 proj, Vec3 cameraPosition, float time)
+{
+	FrameUniforms frame = { 0 };
+
+	frame.view = Mat4x4ToFloat(view);
+	frame.proj = Mat4x4ToFloat(proj);
+	frame.viewProj = Mat4x4ToFloat(Mat4x4Multiply(view, proj));
+	frame.cameraPosition[0] = cameraPosition.x;
+	frame.cameraPosition[1] = cameraPosition.y;
+	frame.cameraPosition[2] = cameraPosition.z;
+	frame.cameraPosition[3] = 1.0f;
+	frame.time = time;
+
+	return frame;
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Uniform stream
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+UniformStream CreateUniformStream(size_t frameSize)
+{
+	UniformStream us = { 0 };
+
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+	// the spec caps it at 256, which is also a safe guess without an answer
+	us.alignment = alignment > 0 ? (size_t)alignment : 256;
+	us.stream = CreateStreamBuffer(frameSize);
+
+	return us;
+}
+
+void *UniformStreamMap(UniformStream *us, size_t size, size_t *offset)
+{
+	return StreamBufferMap(&us->stream, size, us->alignment, offset);
+}
+
+void UniformStreamUnmap(UniformStream *us)
+{
+	StreamBufferUnmap(&us->stream);
+}
+
+size_t UniformStreamPush(UniformStream *us, const void *data, size_t size)
+{
+	size_t offset;
+	void *destination = UniformStreamMap(us, size, &offset);
+
+	if (destination == NULL)
+		return (size_t)-1;
+
+	memcpy(destination, data, size);
+	UniformStreamUnmap(us);
+
+	return offset;
+}
+
+void UniformStreamBind(UniformStream *us, unsigned int binding, size_t offset, size_t size)
+{
+	GLStateBindBufferRange(GL_UNIFORM_BUFFER, binding, us->stream.buffer.ID, offset, size);
+}
+
+bool UniformStreamPushBind(UniformStream *us, unsigned int binding, const void *data, size_t size)
+{
+	size_t offset = UniformStreamPush(us, data, size);
+
+	if (offset == (size_t)-1)
+		return false;
+
+	UniformStreamBind(us, binding, offset, size);
+
+	return true;
+}
+
+void UniformStreamEndFrame(UniformStream *us)
+{
+	StreamBufferEndFrame(&us->stream);
+}
+
+void DeleteUniformStream(UniformStream *us)
+{
+	DeleteStreamBuffer(&us->stream);
+
+	*us = (UniformStream) { 0 };
+}
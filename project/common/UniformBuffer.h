@@ -0,0 +1,119 @@
+#ifndef __UNIFORM_BUFFER_H__
+#define __UNIFORM_BUFFER_H__
+
+#include "common.h"
+#include "cmath.h"
+#include "Graphic.h"
+
+/*
+	Uniform buffer objects.
+
+	Std140Layout gives the std140 offset of every member of a uniform block,
+	so C code fills blocks without repeating the packing rules by hand:
+
+		scalars align to 4, vec2 to 8, vec3 and vec4 to 16 (a vec3 is 12
+		bytes, a scalar may follow in its last 4)
+		array elements and matrix columns take 16 bytes each
+		a member after an array or a matrix starts on 16
+		the block size rounds up to 16
+
+	Blocks are shared through fixed binding points. ShaderBindUniformBlock
+	points a block of a program at one after linking, so every program
+	declaring Frame reads the one range bound to UNIFORM_BINDING_FRAME,
+	written once per frame:
+
+		layout (std140) uniform Frame {
+			mat4 view;
+			mat4 proj;
+			mat4 viewProj;
+			vec4 cameraPosition;
+			float time;
+		};
+
+	UniformStream sub-allocates blocks from one large buffer, a StreamBuffer,
+	so it is persistently mapped where ARB_buffer_storage exists and the CPU
+	never writes a range the GPU may still read. Offsets follow
+	GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT and a draw selects its block with a
+	glBindBufferRange instead of one glUniform call per value.
+*/
+
+#define UNIFORM_BINDING_FRAME 0
+#define UNIFORM_BINDING_DRAW 1
+
+#define STD140_MAX_MEMBERS 32
+
+typedef enum {
+	STD140_FLOAT, STD140_INT, STD140_UINT,
+	STD140_VEC2, STD140_VEC3, STD140_VEC4,
+	STD140_IVEC2, STD140_IVEC3, STD140_IVEC4,
+	STD140_MAT3, STD140_MAT4
+} Std140Type;
+
+typedef struct Std140Member {
+	const char *name;
+	Std140Type type;
+	unsigned int arrayCount; // 0 for a single value
+	size_t offset;
+	size_t arrayStride;      // 0 for a single value
+} Std140Member;
+
+typedef struct Std140Layout {
+	Std140Member members[STD140_MAX_MEMBERS];
+	size_t memberCount;
+	size_t end;              // past the last member
+} Std140Layout;
+
+// appends a member, returns its offset. name is kept, not copied.
+size_t Std140Add(Std140Layout *layout, const char *name, Std140Type type, unsigned int arrayCount);
+
+// block size, what GL_UNIFORM_BLOCK_DATA_SIZE reports for the same block
+size_t Std140Size(const Std140Layout *layout);
+
+// member index or -1
+int Std140Find(const Std140Layout *layout, const char *name);
+
+// write one value into a block at a member offset
+void Std140SetFloat(void *block, size_t offset, float value);
+void Std140SetInt(void *block, size_t offset, int value);
+void Std140SetVec3(void *block, size_t offset, Vec3 value);
+void Std140SetVec4(void *block, size_t offset, Vec4 value);
+void Std140SetMat3(void *block, size_t offset, Mat4x4 value); // upper left 3x3
+void Std140SetMat4(void *block, size_t offset, Mat4x4 value);
+
+// the Frame block above, laid out for std140
+typedef struct FrameUniforms {
+	float16 view;
+	float16 proj;
+	float16 viewProj;
+	float cameraPosition[4];
+	float time;
+	float padding[3];
+} FrameUniforms;
+
+FrameUniforms CreateFrameUniforms(Mat4x4 view, Mat4x4 proj, Vec3 cameraPosition, float time);
+
+typedef struct UniformStream {
+	StreamBuffer stream;
+	size_t alignment;        // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+} UniformStream;
+
+// frameSize bytes of blocks per frame, alignment padding included
+UniformStream CreateUniformStream(size_t frameSize);
+
+// write pointer for a block of size bytes, NULL when the frame is full
+void *UniformStreamMap(UniformStream *us, size_t size, size_t *offset);
+void UniformStreamUnmap(UniformStream *us);
+
+// map, copy and unmap, returns the offset or (size_t)-1 when the frame is full
+size_t UniformStreamPush(UniformStream *us, const void *data, size_t size);
+
+// glBindBufferRange of a block, through the state cache
+void UniformStreamBind(UniformStream *us, unsigned int binding, size_t offset, size_t size);
+
+// copy and bind in one go, for blocks bound once like the Frame block
+bool UniformStreamPushBind(UniformStream *us, unsigned int binding, const void *data, size_t size);
+
+void UniformStreamEndFrame(UniformStream *us);
+void DeleteUniformStream(UniformStream *us);
+
+#endif // __UNIFORM_BUFFER_H__
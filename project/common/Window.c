@@ -1,4 +1,6 @@
 #include "Window.h"
+#include "GLExt.h"
+#include "GLState.h"
 
 GLFWwindow *InitWindow(int width, int height, const char *title)
 {
@@ -24,7 +26,10 @@ GLFWwindow *InitWindow(int width, int height, const char *title)
 		return NULL;
 	}
 
-	glViewport(0, 0, 800, 600);
+	GLExtLoad((GLADloadproc)glfwGetProcAddress);
+	GLStateInvalidate();
+
+	GLStateViewport(0, 0, 800, 600);
 
 	return window;
 }
@@ -1,5 +1,10 @@
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "cmath.h"
+#include "cmath_simd.h"
+#include "Job.h"
 
 // Clamp float value
 float Clamp(float value, float min, float max)
@@ -415,6 +420,22 @@ Vec3 Vec3Normalize(const Vec3 v)
 
 // transform a vector by given matrix
 Vec3 Vec3Transform(Vec3 v, Mat4x4 m)
+{
+	Vec3 result;
+
+	cmathKernels.Vec3Transform(&result, &v, &m);
+
+	return result;
+}
+
+// transform a vector by given matrix, result may alias v
+void Vec3TransformTo(Vec3 *result, const Vec3 *v, const Mat4x4 *m)
+{
+	cmathKernels.Vec3Transform(result, v, m);
+}
+
+// transform a vector by given matrix, scalar reference
+Vec3 Vec3TransformScalar(Vec3 v, Mat4x4 m)
 {
 	Vec3 result = Vec3Zero();
 
@@ -635,10 +656,220 @@ Vec4 Vec4Lerp(const Vec4 v1, const Vec4 v2, float amount)
 	/////////////////////////////////////////////////////////
 */
 
+/*
+	GEMM: C = A*B, all row-major.
+
+	B is packed into GEMM_KC x GEMM_NC panels and A into GEMM_MC x GEMM_KC
+	blocks so the micro-kernel streams through L1/L2 resident data, the
+	micro-kernel itself keeps a gemmRows x gemmCols tile of C in registers.
+	Large products are split into row ranges over the job system. The pack
+	buffers (about 350 KB per range) are too big for the stack of a worker
+	thread, they come from a workspace the caller keeps, so repeated
+	products allocate nothing.
+*/
+
+#define GEMM_MC 96 // multiple of every backend's gemmRows
+#define GEMM_KC 256
+#define GEMM_NC 256 // multiple of every backend's gemmCols
+
+// below this many multiply-adds packing costs more than it saves
+#define GEMM_SMALL_WORK (32*32*32)
+
+// above this many multiply-adds the row blocks go to the job system
+#define GEMM_PARALLEL_WORK (128*128*128)
+
+// GEMM_MC*GEMM_KC floats for A then GEMM_KC*GEMM_NC for B, per row range
+#define GEMM_PACK_FLOATS (GEMM_MC*GEMM_KC + GEMM_KC*GEMM_NC)
+#define GEMM_PACK_SIZE (GEMM_PACK_FLOATS*sizeof(float))
+
+typedef struct MatrixGemm {
+	float *C;
+	const float *A;
+	const float *B;
+	size_t M, N, K;
+	float *pack;   // one GEMM_PACK_FLOATS slot per range
+	size_t ranges;
+} MatrixGemm;
+
+static void MatrixPackA(float *ap, const float *A, size_t lda, size_t mc, size_t kc, int mr)
+{
+	for (size_t ir = 0; ir < mc; ir += mr, ap += mr*kc)
+	{
+		for (int i = 0; i < mr; ++i)
+		{
+			if (ir + i < mc)
+				for (size_t p = 0; p < kc; ++p) ap[p*mr + i] = A[(ir + i)*lda + p];
+			else
+				for (size_t p = 0; p < kc; ++p) ap[p*mr + i] = 0.0f;
+		}
+	}
+}
+
+static void MatrixPackB(float *bp, const float *B, size_t ldb, size_t kc, size_t nc, int nr)
+{
+	for (size_t jr = 0; jr < nc; jr += nr, bp += nr*kc)
+	{
+		size_t cols = nc - jr < (size_t)nr ? nc - jr : (size_t)nr;
+
+		for (size_t p = 0; p < kc; ++p)
+		{
+			size_t j = 0;
+			for (; j < cols; ++j) bp[p*nr + j] = B[p*ldb + jr + j];
+			for (; j < (size_t)nr; ++j) bp[p*nr + j] = 0.0f;
+		}
+	}
+}
+
+// rows [rowBegin, rowEnd) of C without packing, for small products
+static void MatrixMultiplyRows(MatrixGemm *g, size_t rowBegin, size_t rowEnd)
+{
+	memset(g->C + rowBegin*g->N, 0, (rowEnd - rowBegin)*g->N*sizeof(float));
+
+	for (size_t i = rowBegin; i < rowEnd; ++i)
+		for (size_t k = 0; k < g->K; ++k)
+		{
+			float a = g->A[i*g->K + k];
+			for (size_t j = 0; j < g->N; ++j) g->C[i*g->N + j] += a*g->B[k*g->N + j];
+		}
+}
+
+// rows [rowBegin, rowEnd) of C, packing into ap
+static void MatrixMultiplyBlocks(MatrixGemm *g, float *ap, size_t rowBegin, size_t rowEnd)
+{
+	float *bp = ap + GEMM_MC*GEMM_KC;
+
+	void (*kernel)(size_t, const float *, const float *, float *, size_t) = cmathKernels.GemmKernel;
+	int mr = cmathKernels.gemmRows;
+	int nr = cmathKernels.gemmCols;
+
+	memset(g->C + rowBegin*g->N, 0, (rowEnd - rowBegin)*g->N*sizeof(float));
+
+	for (size_t jc = 0; jc < g->N; jc += GEMM_NC)
+	{
+		size_t nc = g->N - jc < GEMM_NC ? g->N - jc : GEMM_NC;
+
+		for (size_t pc = 0; pc < g->K; pc += GEMM_KC)
+		{
+			size_t kc = g->K - pc < GEMM_KC ? g->K - pc : GEMM_KC;
+
+			MatrixPackB(bp, g->B + pc*g->N + jc, g->N, kc, nc, nr);
+
+			for (size_t ic = rowBegin; ic < rowEnd; ic += GEMM_MC)
+			{
+				size_t mc = rowEnd - ic < GEMM_MC ? rowEnd - ic : GEMM_MC;
+
+				MatrixPackA(ap, g->A + ic*g->K + pc, g->K, mc, kc, mr);
+
+				for (size_t jr = 0; jr < nc; jr += nr)
+				{
+					for (size_t ir = 0; ir < mc; ir += mr)
+					{
+						float *c = g->C + (ic + ir)*g->N + jc + jr;
+
+						if (ir + mr <= mc && jr + nr <= nc)
+						{
+							kernel(kc, ap + ir*kc, bp + jr*kc, c, g->N);
+							continue;
+						}
+
+						// edge tile, let the kernel write a full tile and copy out the valid part
+						float tile[CMATH_GEMM_MAX_ROWS*CMATH_GEMM_MAX_COLS] = { 0 };
+						kernel(kc, ap + ir*kc, bp + jr*kc, tile, nr);
+
+						size_t rows = mc - ir < (size_t)mr ? mc - ir : (size_t)mr;
+						size_t cols = nc - jr < (size_t)nr ? nc - jr : (size_t)nr;
+
+						for (size_t i = 0; i < rows; ++i)
+							for (size_t j = 0; j < cols; ++j) c[i*g->N + j] += tile[i*nr + j];
+					}
+				}
+			}
+		}
+	}
+}
+
+// ranges [begin, end), each over an even share of the GEMM_MC row blocks with its own pack slot
+static void MatrixMultiplyRanges(void *userData, size_t begin, size_t end)
+{
+	MatrixGemm *g = userData;
+	size_t blocks = (g->M + GEMM_MC - 1)/GEMM_MC;
+
+	for (size_t range = begin; range < end; ++range)
+	{
+		size_t rowBegin = blocks*range/g->ranges*GEMM_MC;
+		size_t rowEnd = blocks*(range + 1)/g->ranges*GEMM_MC;
+		if (rowEnd > g->M) rowEnd = g->M;
+
+		MatrixMultiplyBlocks(g, g->pack + range*GEMM_PACK_FLOATS, rowBegin, rowEnd);
+	}
+}
+
+// row ranges a product is split into, 0 for small products that need no packing
+static size_t MatrixGemmRanges(size_t Ar, size_t Ac, size_t Bc)
+{
+	size_t work = Ar*Ac*Bc;
+	if (work <= GEMM_SMALL_WORK) return 0;
+
+	size_t blocks = (Ar + GEMM_MC - 1)/GEMM_MC;
+	if (work < GEMM_PARALLEL_WORK || blocks == 1) return 1;
+
+	size_t threads = (size_t)JobSystemWorkerCount() + 1;
+	return blocks < threads ? blocks : threads;
+}
+
+size_t MatrixMultiplyWorkspaceSize(size_t Ar, size_t Ac, size_t Bc)
+{
+	return MatrixGemmRanges(Ar, Ac, Bc)*GEMM_PACK_SIZE;
+}
+
+// multiply A (Ar x Ac) by B (Br x Bc) into result (Ar x Bc), row-major, packing into workspace
+int MatrixMultiplyTo(float *result, void *workspace, size_t workspaceSize, const float *A, const float *B, size_t Ar, size_t Ac, size_t Br, size_t Bc)
+{
+	if (Ac != Br) return 0;
+
+	MatrixGemm gemm = { result, A, B, Ar, Bc, Ac, workspace, MatrixGemmRanges(Ar, Ac, Bc) };
+
+	if (gemm.ranges == 0)
+	{
+		MatrixMultiplyRows(&gemm, 0, Ar);
+		return 1;
+	}
+
+	// a smaller workspace runs fewer ranges, none at all borrows one for the call
+	void *owned = NULL;
+
+	if (workspaceSize < GEMM_PACK_SIZE)
+	{
+		owned = CMathAlignedAlloc(gemm.ranges*GEMM_PACK_SIZE, 64);
+		if (owned == NULL)
+		{
+			fprintf(stderr, "[ERROR]: Failed to allocate %zu bytes of GEMM pack buffers.\n", gemm.ranges*GEMM_PACK_SIZE);
+			MatrixMultiplyRows(&gemm, 0, Ar);
+			return 1;
+		}
+
+		gemm.pack = owned;
+	}
+	else if (workspaceSize/GEMM_PACK_SIZE < gemm.ranges)
+		gemm.ranges = workspaceSize/GEMM_PACK_SIZE;
+
+	if (gemm.ranges > 1)
+		JobParallelFor(gemm.ranges, 1, MatrixMultiplyRanges, &gemm);
+	else
+		MatrixMultiplyRanges(&gemm, 0, 1);
+
+	CMathAlignedFree(owned);
+
+	return 1;
+}
+
+// multiply A*B into a newly allocated Ar x Bc matrix, free() it when done
 float *MatrixMultiply(float *A, float *B, size_t Ar, size_t Ac, size_t Br, size_t Bc)
 {
-	float *result = malloc((Ar * Br) * sizeof(float));
-	for (int i = 0; i < Bc; ++i) for (int j = 0; j < Ac; ++j) for (int k = 0; k < Ar; ++k) result[j] += A[k + j * Ac] * B[k + i * Br];
+	if (Ac != Br) return NULL;
+
+	float *result = malloc(Ar*Bc*sizeof(float));
+	if (result) MatrixMultiplyTo(result, NULL, 0, A, B, Ar, Ac, Br, Bc);
 
 	return result;
 }
@@ -699,6 +930,22 @@ Mat4x4 Mat4x4Transpose(Mat4x4 m)
 
 // invert of a matrix
 Mat4x4 Mat4x4Invert(Mat4x4 m)
+{
+	Mat4x4 result;
+
+	cmathKernels.Mat4x4Invert(&result, &m);
+
+	return result;
+}
+
+// invert of a matrix, result may alias m
+void Mat4x4InvertTo(Mat4x4 *result, const Mat4x4 *m)
+{
+	cmathKernels.Mat4x4Invert(result, m);
+}
+
+// invert of a matrix, scalar reference
+Mat4x4 Mat4x4InvertScalar(Mat4x4 m)
 {
 	Mat4x4 result = { 0 };
 
@@ -807,6 +1054,22 @@ Mat4x4 Mat4x4Subtract(Mat4x4 m1, Mat4x4 m2)
 
 // multiplication of two matrix 
 Mat4x4 Mat4x4Multiply(Mat4x4 m1, Mat4x4 m2)
+{
+	Mat4x4 result;
+
+	cmathKernels.Mat4x4Multiply(&result, &m1, &m2);
+
+	return result;
+}
+
+// multiplication of two matrix, result may alias m1 or m2
+void Mat4x4MultiplyTo(Mat4x4 *result, const Mat4x4 *m1, const Mat4x4 *m2)
+{
+	cmathKernels.Mat4x4Multiply(result, m1, m2);
+}
+
+// multiplication of two matrix, scalar reference
+Mat4x4 Mat4x4MultiplyScalar(Mat4x4 m1, Mat4x4 m2)
 {
 	Mat4x4 result = { 0 };
 
@@ -1052,6 +1315,192 @@ float16 Mat4x4ToFloat(const Mat4x4 m)
 	return result;
 }
 
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Affine Matrix Related functions
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// identity affine matrix
+Mat3x4 Mat3x4Identity(void)
+{
+	Mat3x4 result = { 1.0f, 0.0f, 0.0f, 0.0f,
+										0.0f, 1.0f, 0.0f, 0.0f,
+										0.0f, 0.0f, 1.0f, 0.0f };
+
+	return result;
+}
+
+// drop the bottom row of a Mat4x4
+Mat3x4 Mat3x4FromMat4x4(const Mat4x4 m)
+{
+	Mat3x4 result = { m.m0, m.m4, m.m8, m.m12,
+										m.m1, m.m5, m.m9, m.m13,
+										m.m2, m.m6, m.m10, m.m14 };
+
+	return result;
+}
+
+// expand to a Mat4x4
+Mat4x4 Mat3x4ToMat4x4(const Mat3x4 m)
+{
+	Mat4x4 result = { m.m0, m.m4, m.m8, m.m12,
+										m.m1, m.m5, m.m9, m.m13,
+										m.m2, m.m6, m.m10, m.m14,
+										0.0f, 0.0f, 0.0f, 1.0f };
+
+	return result;
+}
+
+// expand count affine matrices to Mat4x4
+void Mat3x4ToMat4x4Array(Mat4x4 *result, const Mat3x4 *m, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) result[i] = Mat3x4ToMat4x4(m[i]);
+}
+
+// matrix to float array
+float16 Mat3x4ToFloat(const Mat3x4 m)
+{
+	return Mat4x4ToFloat(Mat3x4ToMat4x4(m));
+}
+
+// multiplication of two affine matrix
+Mat3x4 Mat3x4Multiply(Mat3x4 m1, Mat3x4 m2)
+{
+	Mat3x4 result;
+
+	cmathKernels.Mat3x4Multiply(&result, &m1, &m2);
+
+	return result;
+}
+
+// multiplication of two affine matrix, result may alias m1 or m2
+void Mat3x4MultiplyTo(Mat3x4 *result, const Mat3x4 *m1, const Mat3x4 *m2)
+{
+	cmathKernels.Mat3x4Multiply(result, m1, m2);
+}
+
+// multiplication of two affine matrix, scalar reference. Mat4x4MultiplyScalar
+// with the zero products of the implied bottom row left out.
+Mat3x4 Mat3x4MultiplyScalar(Mat3x4 m1, Mat3x4 m2)
+{
+	Mat3x4 result = { 0 };
+
+	result.m0 = m1.m0*m2.m0 + m1.m1*m2.m4 + m1.m2*m2.m8;
+	result.m1 = m1.m0*m2.m1 + m1.m1*m2.m5 + m1.m2*m2.m9;
+	result.m2 = m1.m0*m2.m2 + m1.m1*m2.m6 + m1.m2*m2.m10;
+	result.m4 = m1.m4*m2.m0 + m1.m5*m2.m4 + m1.m6*m2.m8;
+	result.m5 = m1.m4*m2.m1 + m1.m5*m2.m5 + m1.m6*m2.m9;
+	result.m6 = m1.m4*m2.m2 + m1.m5*m2.m6 + m1.m6*m2.m10;
+	result.m8 = m1.m8*m2.m0 + m1.m9*m2.m4 + m1.m10*m2.m8;
+	result.m9 = m1.m8*m2.m1 + m1.m9*m2.m5 + m1.m10*m2.m9;
+	result.m10 = m1.m8*m2.m2 + m1.m9*m2.m6 + m1.m10*m2.m10;
+	result.m12 = m1.m12*m2.m0 + m1.m13*m2.m4 + m1.m14*m2.m8 + m2.m12;
+	result.m13 = m1.m12*m2.m1 + m1.m13*m2.m5 + m1.m14*m2.m9 + m2.m13;
+	result.m14 = m1.m12*m2.m2 + m1.m13*m2.m6 + m1.m14*m2.m10 + m2.m14;
+
+	return result;
+}
+
+// invert of an affine matrix
+Mat3x4 Mat3x4Invert(Mat3x4 m)
+{
+	Mat3x4 result = { 0 };
+
+	// first column of the adjugate, reused for the determinant
+	float c0 = m.m5*m.m10 - m.m9*m.m6;
+	float c1 = m.m9*m.m2 - m.m1*m.m10;
+	float c2 = m.m1*m.m6 - m.m5*m.m2;
+
+	float invDet = 1.0f/(m.m0*c0 + m.m4*c1 + m.m8*c2);
+
+	result.m0 = c0*invDet;
+	result.m4 = (m.m8*m.m6 - m.m4*m.m10)*invDet;
+	result.m8 = (m.m4*m.m9 - m.m8*m.m5)*invDet;
+	result.m1 = c1*invDet;
+	result.m5 = (m.m0*m.m10 - m.m8*m.m2)*invDet;
+	result.m9 = (m.m8*m.m1 - m.m0*m.m9)*invDet;
+	result.m2 = c2*invDet;
+	result.m6 = (m.m4*m.m2 - m.m0*m.m6)*invDet;
+	result.m10 = (m.m0*m.m5 - m.m4*m.m1)*invDet;
+
+	result.m12 = -(result.m0*m.m12 + result.m4*m.m13 + result.m8*m.m14);
+	result.m13 = -(result.m1*m.m12 + result.m5*m.m13 + result.m9*m.m14);
+	result.m14 = -(result.m2*m.m12 + result.m6*m.m13 + result.m10*m.m14);
+
+	return result;
+}
+
+// invert of a rotation + translation matrix
+Mat3x4 Mat3x4InvertRigid(Mat3x4 m)
+{
+	Mat3x4 result = { 0 };
+
+	result.m0 = m.m0;
+	result.m1 = m.m4;
+	result.m2 = m.m8;
+	result.m4 = m.m1;
+	result.m5 = m.m5;
+	result.m6 = m.m9;
+	result.m8 = m.m2;
+	result.m9 = m.m6;
+	result.m10 = m.m10;
+
+	result.m12 = -(m.m0*m.m12 + m.m1*m.m13 + m.m2*m.m14);
+	result.m13 = -(m.m4*m.m12 + m.m5*m.m13 + m.m6*m.m14);
+	result.m14 = -(m.m8*m.m12 + m.m9*m.m13 + m.m10*m.m14);
+
+	return result;
+}
+
+// get translation matrix
+Mat3x4 Mat3x4Translation(const Vec3 v)
+{
+	Mat3x4 result = { 1.0f, 0.0f, 0.0f, v.x,
+										0.0f, 1.0f, 0.0f, v.y,
+										0.0f, 0.0f, 1.0f, v.z };
+
+	return result;
+}
+
+// rotation matrix from axis and angle
+Mat3x4 Mat3x4Rotate(const Vec3 axis, float angle)
+{
+	return Mat3x4FromMat4x4(Mat4x4Rotate(axis, angle));
+}
+
+// view matrix
+Mat3x4 Mat3x4LookAt(const Vec3 from, const Vec3 to, const Vec3 up)
+{
+	return Mat3x4FromMat4x4(Mat4x4LookAt(from, to, up));
+}
+
+// transform a point (w = 1)
+Vec3 Mat3x4TransformPoint(const Mat3x4 m, const Vec3 v)
+{
+	Vec3 result = Vec3Zero();
+
+	result.x = m.m0 * v.x + m.m4 * v.y + m.m8 * v.z + m.m12;
+	result.y = m.m1 * v.x + m.m5 * v.y + m.m9 * v.z + m.m13;
+	result.z = m.m2 * v.x + m.m6 * v.y + m.m10 * v.z + m.m14;
+
+	return result;
+}
+
+// transform a direction (w = 0)
+Vec3 Mat3x4TransformDirection(const Mat3x4 m, const Vec3 v)
+{
+	Vec3 result = Vec3Zero();
+
+	result.x = m.m0 * v.x + m.m4 * v.y + m.m8 * v.z;
+	result.y = m.m1 * v.x + m.m5 * v.y + m.m9 * v.z;
+	result.z = m.m2 * v.x + m.m6 * v.y + m.m10 * v.z;
+
+	return result;
+}
+
 /*
 	/////////////////////////////////////////////////////////
 	///
@@ -1328,6 +1777,22 @@ Quaternion QuaternionFromMatrix(const Mat4x4 m)
 
 // get a matrix for a given quaternion
 Mat4x4 QuaternionToMatrix(const Quaternion q)
+{
+	Mat4x4 result;
+
+	cmathKernels.QuaternionToMatrix(&result, &q);
+
+	return result;
+}
+
+// get a matrix for a given quaternion
+void QuaternionToMatrixTo(Mat4x4 *result, const Quaternion *q)
+{
+	cmathKernels.QuaternionToMatrix(result, q);
+}
+
+// get a matrix for a given quaternion, scalar reference
+Mat4x4 QuaternionToMatrixScalar(const Quaternion q)
 {
 	Mat4x4 result = { 1.0f, 0.0f, 0.0f, 0.0f,
 										0.0f, 1.0f, 0.0f, 0.0f,
@@ -1499,3 +1964,216 @@ Quaternion QuaternionTransform(Quaternion q, Mat4x4 mat)
 
     return result;
 }
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Batch transform
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// smallest slice handed to a worker thread
+#define CMATH_BATCH_MIN_CHUNK 4096
+
+typedef enum {
+	BATCH_POINTS,
+	BATCH_DIRECTIONS,
+	BATCH_VEC4,
+	BATCH_POINTS_EACH,
+	BATCH_VEC4_EACH
+} CMathBatchKind;
+
+typedef struct CMathBatch {
+	CMathBatchKind kind;
+	void *result;
+	const void *v;
+	const Mat4x4 *m;
+} CMathBatch;
+
+size_t cmathParallelThreshold = 0;
+
+void CMathSetParallelThreshold(size_t count)
+{
+	cmathParallelThreshold = count;
+}
+
+static void CMathBatchRange(void *userData, size_t begin, size_t end)
+{
+	CMathBatch *batch = userData;
+	size_t count = end - begin;
+
+	switch (batch->kind)
+	{
+		case BATCH_POINTS:
+			cmathKernels.Vec3TransformPoints((Vec3 *)batch->result + begin, (const Vec3 *)batch->v + begin, batch->m, count);
+			break;
+
+		case BATCH_DIRECTIONS:
+			cmathKernels.Vec3TransformDirections((Vec3 *)batch->result + begin, (const Vec3 *)batch->v + begin, batch->m, count);
+			break;
+
+		case BATCH_VEC4:
+			cmathKernels.Vec4TransformArray((Vec4 *)batch->result + begin, (const Vec4 *)batch->v + begin, batch->m, count);
+			break;
+
+		case BATCH_POINTS_EACH:
+			cmathKernels.Vec3TransformPointsEach((Vec3 *)batch->result + begin, (const Vec3 *)batch->v + begin, batch->m + begin, count);
+			break;
+
+		case BATCH_VEC4_EACH:
+			cmathKernels.Vec4TransformEach((Vec4 *)batch->result + begin, (const Vec4 *)batch->v + begin, batch->m + begin, count);
+			break;
+	}
+}
+
+static void CMathBatchRun(CMathBatch batch, size_t count)
+{
+	if (cmathParallelThreshold && count >= cmathParallelThreshold)
+		JobParallelFor(count, CMATH_BATCH_MIN_CHUNK, CMathBatchRange, &batch);
+	else
+		CMathBatchRange(&batch, 0, count);
+}
+
+// transform count points (w = 1) by the same matrix
+void Vec3TransformPoints(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	CMathBatchRun((CMathBatch) { BATCH_POINTS, result, v, m }, count);
+}
+
+// transform count directions (w = 0) by the same matrix
+void Vec3TransformDirections(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	CMathBatchRun((CMathBatch) { BATCH_DIRECTIONS, result, v, m }, count);
+}
+
+// transform count vectors by the same matrix
+void Vec4TransformArray(Vec4 *result, const Vec4 *v, const Mat4x4 *m, size_t count)
+{
+	CMathBatchRun((CMathBatch) { BATCH_VEC4, result, v, m }, count);
+}
+
+// transform point v[i] (w = 1) by matrix m[i]
+void Vec3TransformPointsEach(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	CMathBatchRun((CMathBatch) { BATCH_POINTS_EACH, result, v, m }, count);
+}
+
+// transform vector v[i] by matrix m[i]
+void Vec4TransformEach(Vec4 *result, const Vec4 *v, const Mat4x4 *m, size_t count)
+{
+	CMathBatchRun((CMathBatch) { BATCH_VEC4_EACH, result, v, m }, count);
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Fast approximate math
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// sin/cos of r in [-pi/4, pi/4] picked by quadrant, cephes sinf/cosf
+// polynomials. Both are evaluated and selected without branches, the
+// quadrant of random angles mispredicts badly otherwise.
+static float FastSinCosQuadrant(float r, int quadrant)
+{
+	float r2 = r*r;
+
+	float s = r + r*r2*(-1.6666654611e-1f + r2*(8.3321608736e-3f + r2*-1.9515295891e-4f));
+	float c = 1.0f - 0.5f*r2 + r2*r2*(4.166664568298827e-2f + r2*(-1.388731625493765e-3f + r2*2.443315711809948e-5f));
+
+	union { float f; unsigned int i; } us = { s }, uc = { c };
+	unsigned int odd = 0u - (unsigned int)(quadrant & 1);
+
+	us.i = ((us.i & ~odd) | (uc.i & odd)) ^ ((unsigned int)(quadrant & 2) << 30);
+
+	return us.f;
+}
+
+// |x| below which FastReduce is exact, 2^13 quadrants of pi/2
+#define FAST_REDUCE_LIMIT 12867.96f
+
+// x = quadrant*pi/2 + r, pi/2 split in three parts (Cody-Waite, the first two
+// have 8 and 11 bit mantissas) so the products stay exact for |quadrant| < 2^13.
+// Callers keep |x| below FAST_REDUCE_LIMIT, the conversion to int is undefined far above it
+static float FastReduce(float x, int *quadrant)
+{
+	// round to nearest by pushing the fraction out of the mantissa
+	float fq = (x*0.636619772f + 12582912.0f) - 12582912.0f;
+
+	*quadrant = (int)fq;
+
+	return ((x - fq*1.5703125f) - fq*4.837512969970703125e-4f) - fq*7.54978995489188216e-8f;
+}
+
+// sine of x in radians
+float FastSin(float x)
+{
+	// also takes inf and nan
+	if (!(fabsf(x) < FAST_REDUCE_LIMIT))
+		return sinf(x);
+
+	int quadrant;
+	float r = FastReduce(x, &quadrant);
+
+	return FastSinCosQuadrant(r, quadrant);
+}
+
+// cosine of x in radians
+float FastCos(float x)
+{
+	if (!(fabsf(x) < FAST_REDUCE_LIMIT))
+		return cosf(x);
+
+	int quadrant;
+	float r = FastReduce(x, &quadrant);
+
+	return FastSinCosQuadrant(r, quadrant + 1);
+}
+
+// arc cosine of x in [-1, 1], Abramowitz & Stegun 4.4.46
+float FastAcos(float x)
+{
+	float a = fabsf(x);
+
+	float p = 1.5707963050f + a*(-0.2145988016f + a*(0.0889789874f + a*(-0.0501743046f +
+		a*(0.0308918810f + a*(-0.0170881256f + a*(0.0066700901f + a*-0.0012624911f))))));
+
+	float result = sqrtf(1.0f - a)*p;
+
+	// PI - result for negative x, without a branch
+	return 0.5f*PI - copysignf(0.5f*PI - result, x);
+}
+
+// spherical linear interpolation with FastAcos/FastSin, 1/sin(theta) comes
+// from FastRsqrt(1 - cos^2) so there is no division
+Quaternion QuaternionSlerpFast(Quaternion q1, Quaternion q2, float amount)
+{
+	Quaternion result = { 0 };
+
+	float cosHalfTheta = q1.x*q2.x + q1.y*q2.y + q1.z*q2.z + q1.w*q2.w;
+
+	// take the short way round, the sign of the dot product is random for
+	// unrelated rotations so flip without a branch
+	float flip = copysignf(1.0f, cosHalfTheta);
+	q2.x *= flip; q2.y *= flip; q2.z *= flip; q2.w *= flip;
+	cosHalfTheta = fabsf(cosHalfTheta);
+
+	if (cosHalfTheta >= 1.0f) return q1;
+	if (cosHalfTheta > 0.95f) return QuaternionNlerpFast(q1, q2, amount);
+
+	// cosHalfTheta <= 0.95 here, so sin(halfTheta) is well away from 0
+	float halfTheta = FastAcos(cosHalfTheta);
+	float invSinHalfTheta = FastRsqrt(1.0f - cosHalfTheta*cosHalfTheta);
+
+	float ratioA = FastSin((1 - amount)*halfTheta)*invSinHalfTheta;
+	float ratioB = FastSin(amount*halfTheta)*invSinHalfTheta;
+
+	result.x = (q1.x*ratioA + q2.x*ratioB);
+	result.y = (q1.y*ratioA + q2.y*ratioB);
+	result.z = (q1.z*ratioA + q2.z*ratioB);
+	result.w = (q1.w*ratioA + q2.w*ratioB);
+
+	return result;
+}
@@ -4,6 +4,22 @@
 #include <stdlib.h>
 #include <math.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+	#define CMATH_HAS_SSE2 1
+	#include <xmmintrin.h>
+#endif
+
+#if defined(CMATH_HAS_SSE2) && (defined(__GNUC__) || defined(__clang__))
+	// AVX/FMA kernels are built with per-function target attributes, so the
+	// library itself still only requires SSE2.
+	#define CMATH_HAS_AVX 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define CMATH_HAS_NEON 1
+	#include <arm_neon.h>
+#endif
+
 //----------------------------------------------------------------------------------
 // Defines and Macros
 //----------------------------------------------------------------------------------
@@ -51,6 +67,14 @@ typedef struct Mat4x4 {
 	float m3, m7, m11, m15;
 } Mat4x4;
 
+// affine transform: a Mat4x4 whose bottom row is always 0 0 0 1, which is
+// left out (48 bytes). Same element names as Mat4x4.
+typedef struct Mat3x4 {
+	float m0, m4, m8,  m12;
+	float m1, m5, m9,  m13;
+	float m2, m6, m10, m14;
+} Mat3x4;
+
 typedef struct float3 {
 	float v[3];
 } float3;
@@ -59,6 +83,59 @@ typedef struct float16 {
 	float v[16];
 } float16;
 
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	SIMD backend
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// Kernel set used by the Mat4x4 family (multiply, invert, transform,
+// quaternion to matrix) and Mat3x4 multiply. The best one the running CPU
+// supports is picked at startup; the scalar path stays available as the
+// reference.
+//
+// Accuracy against the scalar reference:
+//   SSE2, AVX, NEON   multiply, transform and quaternion are bit-identical
+//                     (same products, same summation order).
+//   FMA               multiply and transform fuse each multiply-add, every
+//                     element stays within 8 ulp of the scalar result,
+//                     measured against the sum of the absolute terms (both
+//                     round up to four times, 3 ulp is the most seen on
+//                     random input).
+//   invert            scalar and NEON expand the 2x2 minors into the
+//                     cofactors (Mat4x4InvertScalar). SSE2, AVX and FMA use
+//                     a 2x2 block adjugate instead, every element stays
+//                     within 8 ulp of the largest element of the result
+//                     times the condition number of the input.
+typedef enum {
+	CMATH_BACKEND_SCALAR,
+	CMATH_BACKEND_SSE2,
+	CMATH_BACKEND_AVX,
+	CMATH_BACKEND_FMA,
+	CMATH_BACKEND_NEON
+} CMathBackend;
+
+// returns the backend currently used by the Mat4x4 family
+CMathBackend CMathGetBackend(void);
+
+// force a backend, returns 0 if the CPU (or the build) does not support it
+int CMathSetBackend(CMathBackend backend);
+
+// human readable backend name
+const char *CMathBackendName(CMathBackend backend);
+
+// batch functions with at least this many elements are split across the job
+// system (see Job.h), 0 keeps everything on the calling thread (default)
+void CMathSetParallelThreshold(size_t count);
+
+// allocate memory aligned to alignment (a power of two)
+void *CMathAlignedAlloc(size_t size, size_t alignment);
+
+// release memory from CMathAlignedAlloc
+void CMathAlignedFree(void *ptr);
+
 // Clamp float value
 float Clamp(float value, float min, float max);
 
@@ -212,6 +289,12 @@ Vec3 Vec3Normalize(const Vec3 v);
 // transform a vector by given matrix
 Vec3 Vec3Transform(Vec3 v, Mat4x4 m);
 
+// transform a vector by given matrix, result may alias v
+void Vec3TransformTo(Vec3 *result, const Vec3 *v, const Mat4x4 *m);
+
+// transform a vector by given matrix, scalar reference
+Vec3 Vec3TransformScalar(Vec3 v, Mat4x4 m);
+
 // linear interpolation between two vectors by amount
 Vec3 Vec3Lerp(const Vec3 v1, const Vec3 v2, float amount);
 
@@ -288,9 +371,23 @@ Vec4 Vec4Lerp(const Vec4 v1, const Vec4 v2, float amount);
 	/////////////////////////////////////////////////////////
 */
 
-// multiply A*B matrix
+// multiply A*B matrix into a newly allocated Ar x Bc result (row-major),
+// returns NULL if Ac != Br. Free the result with free().
 float *MatrixMultiply(float *A, float *B, size_t Ar, size_t Ac, size_t Br, size_t Bc);
 
+// multiply A*B matrix into result (Ar x Bc, row-major), returns 0 if Ac != Br.
+// Blocked and register tiled, large products run on the job system. The pack
+// buffers live in workspace, MatrixMultiplyWorkspaceSize bytes the caller keeps
+// across products (CMathAlignedAlloc with 64 keeps them on cache lines). A
+// NULL workspace allocates one for the call. result must not overlap A or B.
+// Summation order differs from a naive loop, and the FMA backend fuses, so
+// results can differ in the last bits.
+int MatrixMultiplyTo(float *result, void *workspace, size_t workspaceSize, const float *A, const float *B, size_t Ar, size_t Ac, size_t Br, size_t Bc);
+
+// workspace bytes MatrixMultiplyTo needs for the product with the current
+// job system, 0 for products small enough to skip packing
+size_t MatrixMultiplyWorkspaceSize(size_t Ar, size_t Ac, size_t Bc);
+
 // compute matrix determinant
 float Mat4x4Determinant(Mat4x4 m);
 
@@ -303,6 +400,12 @@ Mat4x4 Mat4x4Transpose(Mat4x4 m);
 // invert of a matrix
 Mat4x4 Mat4x4Invert(Mat4x4 m);
 
+// invert of a matrix, result may alias m
+void Mat4x4InvertTo(Mat4x4 *result, const Mat4x4 *m);
+
+// invert of a matrix, scalar reference
+Mat4x4 Mat4x4InvertScalar(Mat4x4 m);
+
 // identity matrix 
 Mat4x4 Mat4x4Identity(void);
 
@@ -315,6 +418,12 @@ Mat4x4 Mat4x4Subtract(Mat4x4 m1, Mat4x4 m2);
 // multiplication of two matrix 
 Mat4x4 Mat4x4Multiply(Mat4x4 m1, Mat4x4 m2);
 
+// multiplication of two matrix, result may alias m1 or m2
+void Mat4x4MultiplyTo(Mat4x4 *result, const Mat4x4 *m1, const Mat4x4 *m2);
+
+// multiplication of two matrix, scalar reference
+Mat4x4 Mat4x4MultiplyScalar(Mat4x4 m1, Mat4x4 m2);
+
 // get translation matrix
 Mat4x4 Mat4x4Translation(const Vec3 v);
 
@@ -336,6 +445,61 @@ Mat4x4 Mat4x4LookAt(const Vec3 from, const Vec3 to, const Vec3 up);
 // matrix to float array
 float16 Mat4x4ToFloat(const Mat4x4 m);
 
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Affine Matrix Related functions
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// identity affine matrix
+Mat3x4 Mat3x4Identity(void);
+
+// drop the bottom row of a Mat4x4, only meaningful if it is 0 0 0 1
+Mat3x4 Mat3x4FromMat4x4(const Mat4x4 m);
+
+// expand to a Mat4x4 (bottom row 0 0 0 1)
+Mat4x4 Mat3x4ToMat4x4(const Mat3x4 m);
+
+// expand count affine matrices to Mat4x4, e.g. right before an upload
+void Mat3x4ToMat4x4Array(Mat4x4 *result, const Mat3x4 *m, size_t count);
+
+// matrix to float array, same layout as Mat4x4ToFloat
+float16 Mat3x4ToFloat(const Mat3x4 m);
+
+// multiplication of two affine matrix, same order as Mat4x4Multiply (m1 is
+// applied first). 36 multiply-adds instead of 64.
+Mat3x4 Mat3x4Multiply(Mat3x4 m1, Mat3x4 m2);
+
+// multiplication of two affine matrix, result may alias m1 or m2
+void Mat3x4MultiplyTo(Mat3x4 *result, const Mat3x4 *m1, const Mat3x4 *m2);
+
+// multiplication of two affine matrix, scalar reference
+Mat3x4 Mat3x4MultiplyScalar(Mat3x4 m1, Mat3x4 m2);
+
+// invert of an affine matrix (3x3 inverse plus translation)
+Mat3x4 Mat3x4Invert(Mat3x4 m);
+
+// invert of a rotation + translation matrix, transposes the rotation.
+// Only valid when the 3x3 part is orthonormal (no scale or shear).
+Mat3x4 Mat3x4InvertRigid(Mat3x4 m);
+
+// get translation matrix
+Mat3x4 Mat3x4Translation(const Vec3 v);
+
+// rotation matrix from axis and angle
+Mat3x4 Mat3x4Rotate(const Vec3 axis, float angle);
+
+// view matrix, rigid so Mat3x4InvertRigid gives the camera transform back
+Mat3x4 Mat3x4LookAt(const Vec3 from, const Vec3 to, const Vec3 up);
+
+// transform a point (w = 1)
+Vec3 Mat3x4TransformPoint(const Mat3x4 m, const Vec3 v);
+
+// transform a direction (w = 0), translation is ignored
+Vec3 Mat3x4TransformDirection(const Mat3x4 m, const Vec3 v);
+
 /*
 	/////////////////////////////////////////////////////////
 	///
@@ -392,6 +556,12 @@ Quaternion QuaternionFromMatrix(const Mat4x4 m);
 // get a matrix for a given quaternion
 Mat4x4 QuaternionToMatrix(const Quaternion q);
 
+// get a matrix for a given quaternion
+void QuaternionToMatrixTo(Mat4x4 *result, const Quaternion *q);
+
+// get a matrix for a given quaternion, scalar reference
+Mat4x4 QuaternionToMatrixScalar(const Quaternion q);
+
 // get rotation for an angle and axis
 Quaternion QuaternionFromAxisAngle(Vec3 axis, float angle);
 
@@ -409,4 +579,157 @@ Vec3 QuaternionToEuler(Quaternion q);
 // Transform a quaternion given a transformation matrix
 Quaternion QuaternionTransform(Quaternion q, Mat4x4 mat);
 
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Batch transform
+	///
+	///	result may alias the input vectors in all of these,
+	///	but must not partially overlap them.
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// transform count points (w = 1) by the same matrix
+void Vec3TransformPoints(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count);
+
+// transform count directions (w = 0) by the same matrix
+void Vec3TransformDirections(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count);
+
+// transform count vectors by the same matrix
+void Vec4TransformArray(Vec4 *result, const Vec4 *v, const Mat4x4 *m, size_t count);
+
+// transform point v[i] (w = 1) by matrix m[i]
+void Vec3TransformPointsEach(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count);
+
+// transform vector v[i] by matrix m[i]
+void Vec4TransformEach(Vec4 *result, const Vec4 *v, const Mat4x4 *m, size_t count);
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Fast approximate math
+	///
+	///	Opt-in replacements for the libm based functions above,
+	///	for hot loops (animation, lighting prep) that can live
+	///	with a few ulp of error. Measured maximum errors:
+	///
+	///	FastRsqrt                relative 3.0e-7 (SSE),
+	///	                         1.5e-7 (portable fallback)
+	///	FastSin, FastCos         absolute 9.3e-8, the range
+	///	                         reduction is exact for |x| < 1.2e4,
+	///	                         larger x goes to sinf/cosf
+	///	FastAcos                 absolute 4.4e-7 on [-1, 1]
+	///	*NormalizeFast           relative 3.3e-7 per component
+	///	QuaternionSlerpFast      absolute 6.0e-7 per component
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// 1/sqrt(x) for x > 0, hardware estimate plus Newton steps. Inline, a call
+// costs about as much as the estimate saves over sqrtf and a division.
+static inline float FastRsqrt(float x)
+{
+#if defined(CMATH_HAS_SSE2)
+	// 12 bit estimate, one Newton step
+	float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+
+	return y*(1.5f - 0.5f*x*y*y);
+#elif defined(CMATH_HAS_NEON)
+	// 8 bit estimate, two Newton steps
+	float32x2_t v = vdup_n_f32(x);
+	float32x2_t y = vrsqrte_f32(v);
+	y = vmul_f32(y, vrsqrts_f32(vmul_f32(v, y), y));
+	y = vmul_f32(y, vrsqrts_f32(vmul_f32(v, y), y));
+
+	return vget_lane_f32(y, 0);
+#else
+	// bit trick estimate, three Newton steps
+	union { float f; unsigned int i; } u = { x };
+	u.i = 0x5f375a86 - (u.i >> 1);
+
+	float y = u.f;
+	y = y*(1.5f - 0.5f*x*y*y);
+	y = y*(1.5f - 0.5f*x*y*y);
+	y = y*(1.5f - 0.5f*x*y*y);
+
+	return y;
+#endif
+}
+
+// sine of x in radians
+float FastSin(float x);
+
+// cosine of x in radians
+float FastCos(float x);
+
+// arc cosine of x in [-1, 1]
+float FastAcos(float x);
+
+// Vec3Normalize using FastRsqrt, zero length vectors are left as they are
+static inline Vec3 Vec3NormalizeFast(const Vec3 v)
+{
+	Vec3 result = v;
+
+	float lengthSquared = v.x*v.x + v.y*v.y + v.z*v.z;
+	if (lengthSquared != 0.0f)
+	{
+		float ilength = FastRsqrt(lengthSquared);
+
+		result.x *= ilength;
+		result.y *= ilength;
+		result.z *= ilength;
+	}
+
+	return result;
+}
+
+// Vec4Normalize using FastRsqrt, zero length vectors become zero
+static inline Vec4 Vec4NormalizeFast(const Vec4 v)
+{
+	Vec4 result = { 0 };
+
+	float lengthSquared = v.x*v.x + v.y*v.y + v.z*v.z + v.w*v.w;
+	if (lengthSquared > 0)
+	{
+		float ilength = FastRsqrt(lengthSquared);
+
+		result.x = v.x*ilength;
+		result.y = v.y*ilength;
+		result.z = v.z*ilength;
+		result.w = v.w*ilength;
+	}
+
+	return result;
+}
+
+// QuaternionNormalize using FastRsqrt
+static inline Quaternion QuaternionNormalizeFast(const Quaternion q)
+{
+	float lengthSquared = q.x*q.x + q.y*q.y + q.z*q.z + q.w*q.w;
+	if (lengthSquared == 0.0f) return q;
+
+	float ilength = FastRsqrt(lengthSquared);
+
+	Quaternion result = { q.x*ilength, q.y*ilength, q.z*ilength, q.w*ilength };
+
+	return result;
+}
+
+// QuaternionNlerp using FastRsqrt
+static inline Quaternion QuaternionNlerpFast(const Quaternion q1, const Quaternion q2, float amount)
+{
+	Quaternion result = { 0 };
+
+	result.x = q1.x + amount*(q2.x - q1.x);
+	result.y = q1.y + amount*(q2.y - q1.y);
+	result.z = q1.z + amount*(q2.z - q1.z);
+	result.w = q1.w + amount*(q2.w - q1.w);
+
+	return QuaternionNormalizeFast(result);
+}
+
+// QuaternionSlerp with FastAcos/FastSin and no division
+Quaternion QuaternionSlerpFast(Quaternion q1, Quaternion q2, float amount);
+
 #endif // __MATH_H__
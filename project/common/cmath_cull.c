@@ -0,0 +1,186 @@
+#include <string.h>
+#include <stdio.h>
+
+#include "cmath_cull.h"
+#include "cmath_simd.h"
+#include "Job.h"
+
+// objects per parallel block, each block compacts into its own slice
+#define CULL_BLOCK 16384
+
+static Vec4 FrustumNormalizePlane(Vec4 plane)
+{
+	float length = sqrtf(plane.x*plane.x + plane.y*plane.y + plane.z*plane.z);
+	if (length == 0.0f) length = 1.0f;
+	float ilength = 1.0f/length;
+
+	return (Vec4) { plane.x*ilength, plane.y*ilength, plane.z*ilength, plane.w*ilength };
+}
+
+// Gribb / Hartmann: clip space is -w <= x, y, z <= w, so every plane is the
+// last row of the matrix plus or minus one of the others
+Frustum FrustumFromMatrix(const Mat4x4 viewProjection)
+{
+	const Mat4x4 m = viewProjection;
+
+	Vec4 row0 = { m.m0, m.m4, m.m8, m.m12 };
+	Vec4 row1 = { m.m1, m.m5, m.m9, m.m13 };
+	Vec4 row2 = { m.m2, m.m6, m.m10, m.m14 };
+	Vec4 row3 = { m.m3, m.m7, m.m11, m.m15 };
+
+	Frustum result = { 0 };
+
+	result.planes[FRUSTUM_LEFT] = FrustumNormalizePlane(Vec4Add(row3, row0));
+	result.planes[FRUSTUM_RIGHT] = FrustumNormalizePlane(Vec4Sub(row3, row0));
+	result.planes[FRUSTUM_BOTTOM] = FrustumNormalizePlane(Vec4Add(row3, row1));
+	result.planes[FRUSTUM_TOP] = FrustumNormalizePlane(Vec4Sub(row3, row1));
+	result.planes[FRUSTUM_NEAR] = FrustumNormalizePlane(Vec4Add(row3, row2));
+	result.planes[FRUSTUM_FAR] = FrustumNormalizePlane(Vec4Sub(row3, row2));
+
+	return result;
+}
+
+float FrustumPlaneDistance(const Vec4 plane, const Vec3 p)
+{
+	return plane.x*p.x + plane.y*p.y + plane.z*p.z + plane.w;
+}
+
+int FrustumSphereVisible(const Frustum *frustum, const Vec3 center, float radius)
+{
+	int inside = 1;
+
+	for (int p = 0; p < FRUSTUM_PLANE_COUNT; ++p)
+		inside &= FrustumPlaneDistance(frustum->planes[p], center) >= -radius;
+
+	return inside;
+}
+
+int FrustumBoxVisible(const Frustum *frustum, const Vec3 center, const Vec3 extent)
+{
+	int inside = 1;
+
+	for (int p = 0; p < FRUSTUM_PLANE_COUNT; ++p)
+	{
+		const Vec4 plane = frustum->planes[p];
+		float radius = fabsf(plane.x)*extent.x + fabsf(plane.y)*extent.y + fabsf(plane.z)*extent.z;
+
+		inside &= FrustumPlaneDistance(plane, center) >= -radius;
+	}
+
+	return inside;
+}
+
+int FrustumAABBVisible(const Frustum *frustum, const Vec3 min, const Vec3 max)
+{
+	Vec3 center = Vec3Scale(Vec3Add(min, max), 0.5f);
+	Vec3 extent = Vec3Scale(Vec3Sub(max, min), 0.5f);
+
+	return FrustumBoxVisible(frustum, center, extent);
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Batch culling
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+typedef struct CullJob {
+	int boxes;
+	const float *a[4];
+	const float *b[3];
+	const Vec4 *planes;
+	unsigned int *visible;
+	size_t count;
+	size_t *blockVisible;
+} CullJob;
+
+static size_t CullSlice(const CullJob *job, size_t first, size_t count)
+{
+	const float *a[4] = { 0 };
+	const float *b[3] = { 0 };
+
+	for (int c = 0; c < 4; ++c) if (job->a[c]) a[c] = job->a[c] + first;
+	for (int c = 0; c < 3; ++c) if (job->b[c]) b[c] = job->b[c] + first;
+
+	if (job->boxes)
+		return cmathKernels.CullBoxes(job->visible + first, a, b, job->planes, first, count);
+
+	return cmathKernels.CullSpheres(job->visible + first, a, job->planes, first, count);
+}
+
+static void CullRange(void *userData, size_t begin, size_t end)
+{
+	CullJob *job = userData;
+
+	for (size_t block = begin; block < end; ++block)
+	{
+		size_t first = block*CULL_BLOCK;
+		size_t count = job->count - first < CULL_BLOCK ? job->count - first : CULL_BLOCK;
+
+		job->blockVisible[block] = CullSlice(job, first, count);
+	}
+}
+
+static size_t CullRun(CullJob *job)
+{
+	size_t count = job->count;
+
+	if (!cmathParallelThreshold || count < cmathParallelThreshold || count <= CULL_BLOCK)
+		return CullSlice(job, 0, count);
+
+	size_t blocks = (count + CULL_BLOCK - 1)/CULL_BLOCK;
+
+	job->blockVisible = malloc(blocks*sizeof(size_t));
+	if (job->blockVisible == NULL)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate cull blocks, culling on one thread.\n");
+		return CullSlice(job, 0, count);
+	}
+
+	JobParallelFor(blocks, 1, CullRange, job);
+
+	// every block compacted into its own slice, close the gaps between them
+	size_t visible = job->blockVisible[0];
+	for (size_t block = 1; block < blocks; ++block)
+	{
+		memmove(job->visible + visible, job->visible + block*CULL_BLOCK, job->blockVisible[block]*sizeof(unsigned int));
+		visible += job->blockVisible[block];
+	}
+
+	free(job->blockVisible);
+	job->blockVisible = NULL;
+
+	return visible;
+}
+
+size_t FrustumCullSpheres(unsigned int *visible, const Frustum *frustum, const Vec4SoA *spheres)
+{
+	CullJob job = {
+		0,
+		{ spheres->x, spheres->y, spheres->z, spheres->w },
+		{ 0 },
+		frustum->planes,
+		visible,
+		spheres->count,
+		NULL
+	};
+
+	return CullRun(&job);
+}
+
+size_t FrustumCullBoxes(unsigned int *visible, const Frustum *frustum, const Vec3SoA *center, const Vec3SoA *extent)
+{
+	CullJob job = {
+		1,
+		{ center->x, center->y, center->z },
+		{ extent->x, extent->y, extent->z },
+		frustum->planes,
+		visible,
+		center->count,
+		NULL
+	};
+
+	return CullRun(&job);
+}
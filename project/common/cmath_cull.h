@@ -0,0 +1,61 @@
+#ifndef __CMATH_CULL_H__
+#define __CMATH_CULL_H__
+
+#include "cmath.h"
+#include "cmath_soa.h"
+
+/*
+	View frustum culling.
+
+	A plane is stored as a Vec4: xyz is the unit normal pointing into the
+	frustum, w the distance term, so a point p is inside when
+	dot(xyz, p) + w >= 0.
+
+	The batch functions take bounds as SoA streams and write the indices of
+	the visible elements, in ascending order, to an array that must have room
+	for every element. They go through the SIMD kernel table (4 or 8 objects
+	per instruction) and are bit-identical to the single object tests on every
+	backend. Past CMathSetParallelThreshold elements the work is split across
+	the job system.
+*/
+
+typedef enum {
+	FRUSTUM_LEFT,
+	FRUSTUM_RIGHT,
+	FRUSTUM_BOTTOM,
+	FRUSTUM_TOP,
+	FRUSTUM_NEAR,
+	FRUSTUM_FAR,
+	FRUSTUM_PLANE_COUNT
+} FrustumPlane;
+
+typedef struct Frustum {
+	Vec4 planes[FRUSTUM_PLANE_COUNT];
+} Frustum;
+
+// extract the normalized planes of viewProjection, which is proj * view as in
+// the shader: Mat4x4Multiply(view, proj)
+Frustum FrustumFromMatrix(const Mat4x4 viewProjection);
+
+// signed distance from a point to a plane, positive inside
+float FrustumPlaneDistance(const Vec4 plane, const Vec3 p);
+
+// 1 if the sphere is at least partly inside the frustum
+int FrustumSphereVisible(const Frustum *frustum, const Vec3 center, float radius);
+
+// 1 if the box (center and half extents) is at least partly inside the
+// frustum. Boxes that straddle two planes just outside a corner are kept.
+int FrustumBoxVisible(const Frustum *frustum, const Vec3 center, const Vec3 extent);
+
+// same test as FrustumBoxVisible for a min / max box
+int FrustumAABBVisible(const Frustum *frustum, const Vec3 min, const Vec3 max);
+
+// test spheres->count spheres (xyz center, w radius), returns the number of
+// visible ones, their indices are written to visible
+size_t FrustumCullSpheres(unsigned int *visible, const Frustum *frustum, const Vec4SoA *spheres);
+
+// test center->count boxes given as center and half extents, returns the
+// number of visible ones, their indices are written to visible
+size_t FrustumCullBoxes(unsigned int *visible, const Frustum *frustum, const Vec3SoA *center, const Vec3SoA *extent);
+
+#endif // __CMATH_CULL_H__
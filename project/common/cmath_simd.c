@@ -0,0 +1,2220 @@
+#include <string.h>
+#include <stdint.h>
+
+#include "cmath.h"
+#include "cmath_simd.h"
+
+#if defined(CMATH_HAS_SSE2)
+	#include <immintrin.h>
+#endif
+
+#if defined(CMATH_HAS_NEON)
+	#include <arm_neon.h>
+#endif
+
+/*
+	NOTE: Mat4x4 stores m0, m4, m8, m12 first, so every group of four floats in
+	memory is one row of the matrix (m12, m13, m14 being the translation).
+	All kernels below work on those memory rows.
+
+	Mat4x4Multiply(m1, m2) computes m2 * m1, so row r of the result is
+	m2[r][0] * row0(m1) + m2[r][1] * row1(m1) + m2[r][2] * row2(m1) + m2[r][3] * row3(m1)
+	summed in that order, which is the order the scalar code uses.
+*/
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Scalar reference
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+static void Mat4x4MultiplyScalarKernel(Mat4x4 *result, const Mat4x4 *m1, const Mat4x4 *m2)
+{
+	*result = Mat4x4MultiplyScalar(*m1, *m2);
+}
+
+static void Mat3x4MultiplyScalarKernel(Mat3x4 *result, const Mat3x4 *m1, const Mat3x4 *m2)
+{
+	*result = Mat3x4MultiplyScalar(*m1, *m2);
+}
+
+static void Mat4x4InvertScalarKernel(Mat4x4 *result, const Mat4x4 *m)
+{
+	*result = Mat4x4InvertScalar(*m);
+}
+
+static void Vec3TransformScalarKernel(Vec3 *result, const Vec3 *v, const Mat4x4 *m)
+{
+	*result = Vec3TransformScalar(*v, *m);
+}
+
+static void QuaternionToMatrixScalarKernel(Mat4x4 *result, const Quaternion *q)
+{
+	*result = QuaternionToMatrixScalar(*q);
+}
+
+static void Vec3TransformPointsScalar(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		float x = v[i].x, y = v[i].y, z = v[i].z;
+
+		result[i].x = m->m0*x + m->m4*y + m->m8*z + m->m12;
+		result[i].y = m->m1*x + m->m5*y + m->m9*z + m->m13;
+		result[i].z = m->m2*x + m->m6*y + m->m10*z + m->m14;
+	}
+}
+
+static void Vec3TransformDirectionsScalar(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		float x = v[i].x, y = v[i].y, z = v[i].z;
+
+		result[i].x = m->m0*x + m->m4*y + m->m8*z;
+		result[i].y = m->m1*x + m->m5*y + m->m9*z;
+		result[i].z = m->m2*x + m->m6*y + m->m10*z;
+	}
+}
+
+static void Vec4TransformArrayScalar(Vec4 *result, const Vec4 *v, const Mat4x4 *m, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		float x = v[i].x, y = v[i].y, z = v[i].z, w = v[i].w;
+
+		result[i].x = m->m0*x + m->m4*y + m->m8*z + m->m12*w;
+		result[i].y = m->m1*x + m->m5*y + m->m9*z + m->m13*w;
+		result[i].z = m->m2*x + m->m6*y + m->m10*z + m->m14*w;
+		result[i].w = m->m3*x + m->m7*y + m->m11*z + m->m15*w;
+	}
+}
+
+static void Vec3TransformPointsEachScalar(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		Vec3TransformPointsScalar(result + i, v + i, m + i, 1);
+}
+
+static void Vec4TransformEachScalar(Vec4 *result, const Vec4 *v, const Mat4x4 *m, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		Vec4TransformArrayScalar(result + i, v + i, m + i, 1);
+}
+
+/*
+	NOTE: stream kernels follow the scalar cmath functions exactly: Vec3 (3
+	components) normalize leaves zero length vectors alone like Vec3Normalize,
+	Vec4 (4 components) zeroes them like Vec4Normalize.
+*/
+
+static void StreamAddScalar(float *result, const float *a, const float *b, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) result[i] = a[i] + b[i];
+}
+
+static void StreamScaleScalar(float *result, const float *a, float f, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) result[i] = a[i]*f;
+}
+
+static void StreamLerpScalar(float *result, const float *a, const float *b, float amount, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) result[i] = a[i] + amount*(b[i] - a[i]);
+}
+
+static void StreamDotScalar(float *result, const float *const *a, const float *const *b, int components, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		float dot = a[0][i]*b[0][i] + a[1][i]*b[1][i] + a[2][i]*b[2][i];
+		if (components == 4) dot += a[3][i]*b[3][i];
+
+		result[i] = dot;
+	}
+}
+
+static void StreamLengthScalar(float *result, const float *const *v, int components, size_t count)
+{
+	StreamDotScalar(result, v, v, components, count);
+
+	for (size_t i = 0; i < count; ++i) result[i] = sqrtf(result[i]);
+}
+
+static void StreamNormalizeScalar(float *const *result, const float *const *v, int components, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		float length = v[0][i]*v[0][i] + v[1][i]*v[1][i] + v[2][i]*v[2][i];
+		if (components == 4) length += v[3][i]*v[3][i];
+		length = sqrtf(length);
+
+		int keep = components == 4 ? !(length > 0.0f) : !(length != 0.0f);
+		float ilength = 1.0f/length;
+
+		for (int c = 0; c < components; ++c)
+			result[c][i] = keep ? (components == 4 ? 0.0f : v[c][i]) : v[c][i]*ilength;
+	}
+}
+
+static void StreamCrossScalar(float *const *result, const float *const *a, const float *const *b, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		float ax = a[0][i], ay = a[1][i], az = a[2][i];
+		float bx = b[0][i], by = b[1][i], bz = b[2][i];
+
+		result[0][i] = ay*bz - az*by;
+		result[1][i] = az*bx - ax*bz;
+		result[2][i] = ax*by - ay*bx;
+	}
+}
+
+/*
+	NOTE: quaternion stream kernels take the short way round, b is negated
+	where the dot product is negative. Nlerp is then QuaternionNlerp exactly.
+	Slerp follows QuaternionSlerp but swaps acosf/sinf for the polynomials
+	below, so the SIMD kernels can compute every path and select per lane
+	and still match the scalar kernel bit for bit.
+*/
+
+// acos on [0, 1], Abramowitz & Stegun 4.4.46 (see FastAcos)
+static inline float SlerpAcos(float x)
+{
+	float p = 1.5707963050f + x*(-0.2145988016f + x*(0.0889789874f + x*(-0.0501743046f +
+		x*(0.0308918810f + x*(-0.0170881256f + x*(0.0066700901f + x*-0.0012624911f))))));
+
+	return sqrtf(1.0f - x)*p;
+}
+
+// sin on [0, PI/2], Taylor series up to x^11 (error below 6e-8)
+static inline float SlerpSin(float x)
+{
+	float x2 = x*x;
+
+	return x + x*x2*(-1.6666667e-1f + x2*(8.3333333e-3f + x2*(-1.9841270e-4f +
+		x2*(2.7557319e-6f + x2*-2.5052108e-8f))));
+}
+
+// b flipped onto the hemisphere of a, returns the dot product after the flip
+static inline float QuaternionStreamFlip(float *b, const float *a)
+{
+	float dot = a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3];
+
+	if (dot < 0.0f)
+	{
+		for (int c = 0; c < 4; ++c) b[c] = -b[c];
+		dot = -dot;
+	}
+
+	return dot;
+}
+
+static inline void QuaternionStreamNlerp(float *result, const float *a, const float *b, float amount)
+{
+	for (int c = 0; c < 4; ++c) result[c] = a[c] + amount*(b[c] - a[c]);
+
+	float length = sqrtf(result[0]*result[0] + result[1]*result[1] + result[2]*result[2] + result[3]*result[3]);
+	if (length == 0.0f) length = 1.0f;
+	float ilength = 1.0f/length;
+
+	for (int c = 0; c < 4; ++c) result[c] *= ilength;
+}
+
+static void StreamNlerpScalar(float *const *result, const float *const *a, const float *const *b, const float *amount, size_t amountStride, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		float qa[4] = { a[0][i], a[1][i], a[2][i], a[3][i] };
+		float qb[4] = { b[0][i], b[1][i], b[2][i], b[3][i] };
+		float q[4];
+
+		QuaternionStreamFlip(qb, qa);
+		QuaternionStreamNlerp(q, qa, qb, amount[i*amountStride]);
+
+		for (int c = 0; c < 4; ++c) result[c][i] = q[c];
+	}
+}
+
+static void StreamSlerpScalar(float *const *result, const float *const *a, const float *const *b, const float *amount, size_t amountStride, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		float qa[4] = { a[0][i], a[1][i], a[2][i], a[3][i] };
+		float qb[4] = { b[0][i], b[1][i], b[2][i], b[3][i] };
+		float q[4];
+
+		float t = amount[i*amountStride];
+		float cosHalfTheta = QuaternionStreamFlip(qb, qa);
+
+		if (cosHalfTheta >= 1.0f)
+		{
+			for (int c = 0; c < 4; ++c) q[c] = qa[c];
+		}
+		else if (cosHalfTheta > 0.95f) QuaternionStreamNlerp(q, qa, qb, t);
+		else
+		{
+			float halfTheta = SlerpAcos(cosHalfTheta);
+			float invSinHalfTheta = 1.0f/sqrtf(1.0f - cosHalfTheta*cosHalfTheta);
+
+			float ratioA = SlerpSin((1 - t)*halfTheta)*invSinHalfTheta;
+			float ratioB = SlerpSin(t*halfTheta)*invSinHalfTheta;
+
+			for (int c = 0; c < 4; ++c) q[c] = qa[c]*ratioA + qb[c]*ratioB;
+		}
+
+		for (int c = 0; c < 4; ++c) result[c][i] = q[c];
+	}
+}
+
+static void StreamQuaternionToMatrixScalar(Mat4x4 *result, const float *const *q, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		result[i] = QuaternionToMatrixScalar((Quaternion) { q[0][i], q[1][i], q[2][i], q[3][i] });
+}
+
+/*
+	NOTE: cull kernels store an index for every element and only advance past
+	the visible ones, so the output needs room for count indices. The plane
+	distance is summed in the same order everywhere, which keeps all
+	backends in agreement with FrustumSphereVisible / FrustumBoxVisible.
+*/
+
+static inline size_t CullAppend(unsigned int *visible, size_t n, size_t index, int mask, int lanes)
+{
+	for (int k = 0; k < lanes; ++k)
+	{
+		visible[n] = (unsigned int)(index + k);
+		n += (mask >> k) & 1;
+	}
+
+	return n;
+}
+
+static size_t CullSpheresScalar(unsigned int *visible, const float *const *sphere, const Vec4 *planes, size_t base, size_t count)
+{
+	size_t n = 0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		float x = sphere[0][i], y = sphere[1][i], z = sphere[2][i], r = sphere[3][i];
+		int inside = 1;
+
+		for (int p = 0; p < 6; ++p)
+			inside &= planes[p].x*x + planes[p].y*y + planes[p].z*z + planes[p].w >= -r;
+
+		n = CullAppend(visible, n, base + i, inside, 1);
+	}
+
+	return n;
+}
+
+static size_t CullBoxesScalar(unsigned int *visible, const float *const *center, const float *const *extent, const Vec4 *planes, size_t base, size_t count)
+{
+	size_t n = 0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		float x = center[0][i], y = center[1][i], z = center[2][i];
+		float ex = extent[0][i], ey = extent[1][i], ez = extent[2][i];
+		int inside = 1;
+
+		for (int p = 0; p < 6; ++p)
+		{
+			float distance = planes[p].x*x + planes[p].y*y + planes[p].z*z + planes[p].w;
+			float radius = fabsf(planes[p].x)*ex + fabsf(planes[p].y)*ey + fabsf(planes[p].z)*ez;
+
+			inside &= distance >= -radius;
+		}
+
+		n = CullAppend(visible, n, base + i, inside, 1);
+	}
+
+	return n;
+}
+
+/*
+	NOTE: GEMM micro-kernels add the product of a packed rows x k sliver of A
+	(rows consecutive floats per k) and a packed k x cols sliver of B (cols
+	consecutive floats per k) to a rows x cols tile of C with row stride ldc.
+*/
+
+static void GemmKernelScalar(size_t k, const float *a, const float *b, float *c, size_t ldc)
+{
+	float acc[4][4] = { 0 };
+
+	for (size_t p = 0; p < k; ++p, a += 4, b += 4)
+		for (int i = 0; i < 4; ++i)
+			for (int j = 0; j < 4; ++j) acc[i][j] += a[i]*b[j];
+
+	for (int i = 0; i < 4; ++i)
+		for (int j = 0; j < 4; ++j) c[i*ldc + j] += acc[i][j];
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	SSE2
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+#if defined(CMATH_HAS_SSE2)
+
+#define CMATH_SHUFFLE(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+#define CMATH_SWIZZLE(v, x, y, z, w) _mm_shuffle_ps((v), (v), CMATH_SHUFFLE(x, y, z, w))
+
+static void Mat4x4MultiplySSE2(Mat4x4 *result, const Mat4x4 *m1, const Mat4x4 *m2)
+{
+	const float *a = (const float *)m1;
+	const float *b = (const float *)m2;
+	float *r = (float *)result;
+
+	__m128 a0 = _mm_loadu_ps(a + 0);
+	__m128 a1 = _mm_loadu_ps(a + 4);
+	__m128 a2 = _mm_loadu_ps(a + 8);
+	__m128 a3 = _mm_loadu_ps(a + 12);
+
+	__m128 b0 = _mm_loadu_ps(b + 0);
+	__m128 b1 = _mm_loadu_ps(b + 4);
+	__m128 b2 = _mm_loadu_ps(b + 8);
+	__m128 b3 = _mm_loadu_ps(b + 12);
+
+	__m128 row[4] = { b0, b1, b2, b3 };
+
+	for (int i = 0; i < 4; ++i)
+	{
+		__m128 acc = _mm_mul_ps(a0, CMATH_SWIZZLE(row[i], 0, 0, 0, 0));
+		acc = _mm_add_ps(acc, _mm_mul_ps(a1, CMATH_SWIZZLE(row[i], 1, 1, 1, 1)));
+		acc = _mm_add_ps(acc, _mm_mul_ps(a2, CMATH_SWIZZLE(row[i], 2, 2, 2, 2)));
+		acc = _mm_add_ps(acc, _mm_mul_ps(a3, CMATH_SWIZZLE(row[i], 3, 3, 3, 3)));
+
+		_mm_storeu_ps(r + i*4, acc);
+	}
+}
+
+// 2x2 row major matrices packed as { m00, m01, m10, m11 }
+// A*B
+static inline __m128 Mat2MulSSE2(__m128 a, __m128 b)
+{
+	return _mm_add_ps(_mm_mul_ps(a, CMATH_SWIZZLE(b, 0, 3, 0, 3)),
+	                  _mm_mul_ps(CMATH_SWIZZLE(a, 1, 0, 3, 2), CMATH_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// adj(A)*B
+static inline __m128 Mat2AdjMulSSE2(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(CMATH_SWIZZLE(a, 3, 3, 0, 0), b),
+	                  _mm_mul_ps(CMATH_SWIZZLE(a, 1, 1, 2, 2), CMATH_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+// A*adj(B)
+static inline __m128 Mat2MulAdjSSE2(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(a, CMATH_SWIZZLE(b, 3, 0, 3, 0)),
+	                  _mm_mul_ps(CMATH_SWIZZLE(a, 1, 0, 3, 2), CMATH_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// Block inverse: split m into 2x2 blocks | A B |, invert through their
+//                                        | C D |
+// adjugates so the whole thing is 4-wide and needs a single division.
+static void Mat4x4InvertSSE2(Mat4x4 *result, const Mat4x4 *m)
+{
+	const float *p = (const float *)m;
+	float *r = (float *)result;
+
+	__m128 r0 = _mm_loadu_ps(p + 0);
+	__m128 r1 = _mm_loadu_ps(p + 4);
+	__m128 r2 = _mm_loadu_ps(p + 8);
+	__m128 r3 = _mm_loadu_ps(p + 12);
+
+	__m128 A = _mm_movelh_ps(r0, r1);
+	__m128 B = _mm_movehl_ps(r1, r0);
+	__m128 C = _mm_movelh_ps(r2, r3);
+	__m128 D = _mm_movehl_ps(r3, r2);
+
+	// { |A|, |B|, |C|, |D| }
+	__m128 detSub = _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(r0, r2, CMATH_SHUFFLE(0, 2, 0, 2)), _mm_shuffle_ps(r1, r3, CMATH_SHUFFLE(1, 3, 1, 3))),
+		_mm_mul_ps(_mm_shuffle_ps(r0, r2, CMATH_SHUFFLE(1, 3, 1, 3)), _mm_shuffle_ps(r1, r3, CMATH_SHUFFLE(0, 2, 0, 2))));
+
+	__m128 detA = CMATH_SWIZZLE(detSub, 0, 0, 0, 0);
+	__m128 detB = CMATH_SWIZZLE(detSub, 1, 1, 1, 1);
+	__m128 detC = CMATH_SWIZZLE(detSub, 2, 2, 2, 2);
+	__m128 detD = CMATH_SWIZZLE(detSub, 3, 3, 3, 3);
+
+	__m128 D_C = Mat2AdjMulSSE2(D, C);
+	__m128 A_B = Mat2AdjMulSSE2(A, B);
+
+	// inverse is 1/|M| * | X Y |, computed here as adjugates of X, Y, Z, W
+	//                    | Z W |
+	__m128 X_ = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2MulSSE2(B, D_C));
+	__m128 W_ = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2MulSSE2(C, A_B));
+	__m128 Y_ = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdjSSE2(D, A_B));
+	__m128 Z_ = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdjSSE2(A, D_C));
+
+	// |M| = |A|*|D| + |B|*|C| - tr(adj(A)B * adj(D)C)
+	__m128 tr = _mm_mul_ps(A_B, CMATH_SWIZZLE(D_C, 0, 2, 1, 3));
+	tr = _mm_add_ps(tr, CMATH_SWIZZLE(tr, 2, 3, 0, 1));
+	tr = _mm_add_ps(tr, CMATH_SWIZZLE(tr, 1, 0, 3, 2));
+
+	__m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+	detM = _mm_sub_ps(detM, tr);
+
+	__m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+
+	X_ = _mm_mul_ps(X_, rDetM);
+	Y_ = _mm_mul_ps(Y_, rDetM);
+	Z_ = _mm_mul_ps(Z_, rDetM);
+	W_ = _mm_mul_ps(W_, rDetM);
+
+	// undo the adjugate while storing
+	_mm_storeu_ps(r + 0, _mm_shuffle_ps(X_, Y_, CMATH_SHUFFLE(3, 1, 3, 1)));
+	_mm_storeu_ps(r + 4, _mm_shuffle_ps(X_, Y_, CMATH_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(r + 8, _mm_shuffle_ps(Z_, W_, CMATH_SHUFFLE(3, 1, 3, 1)));
+	_mm_storeu_ps(r + 12, _mm_shuffle_ps(Z_, W_, CMATH_SHUFFLE(2, 0, 2, 0)));
+}
+
+static void Vec3TransformSSE2(Vec3 *result, const Vec3 *v, const Mat4x4 *m)
+{
+	const float *p = (const float *)m;
+
+	// transpose the memory rows into columns { m0, m1, m2, m3 }, ...
+	__m128 c0 = _mm_loadu_ps(p + 0);
+	__m128 c1 = _mm_loadu_ps(p + 4);
+	__m128 c2 = _mm_loadu_ps(p + 8);
+	__m128 c3 = _mm_loadu_ps(p + 12);
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+	__m128 acc = _mm_mul_ps(c0, _mm_set1_ps(v->x));
+	acc = _mm_add_ps(acc, _mm_mul_ps(c1, _mm_set1_ps(v->y)));
+	acc = _mm_add_ps(acc, _mm_mul_ps(c2, _mm_set1_ps(v->z)));
+	acc = _mm_add_ps(acc, c3);
+
+	_mm_storel_pi((__m64 *)result, acc);
+	_mm_store_ss(&result->z, _mm_movehl_ps(acc, acc));
+}
+
+// result row i = m2[i][0]*m1 row 0 + m2[i][1]*m1 row 1 + m2[i][2]*m1 row 2
+// + (-0, -0, -0, m2[i][3]), adding -0 keeps every lane bit-identical to the
+// scalar path which has no term there
+static void Mat3x4MultiplySSE2(Mat3x4 *result, const Mat3x4 *m1, const Mat3x4 *m2)
+{
+	const float *a = (const float *)m1;
+	const float *b = (const float *)m2;
+	float *r = (float *)result;
+
+	const __m128 translation = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+	const __m128 negZero = _mm_setr_ps(-0.0f, -0.0f, -0.0f, 0.0f);
+
+	__m128 a0 = _mm_loadu_ps(a + 0);
+	__m128 a1 = _mm_loadu_ps(a + 4);
+	__m128 a2 = _mm_loadu_ps(a + 8);
+
+	__m128 rows[3] = { _mm_loadu_ps(b + 0), _mm_loadu_ps(b + 4), _mm_loadu_ps(b + 8) };
+
+	for (int i = 0; i < 3; ++i)
+	{
+		__m128 bi = rows[i];
+		__m128 t = _mm_or_ps(_mm_and_ps(bi, translation), negZero);
+
+		__m128 row = _mm_mul_ps(CMATH_SWIZZLE(bi, 0, 0, 0, 0), a0);
+		row = _mm_add_ps(row, _mm_mul_ps(CMATH_SWIZZLE(bi, 1, 1, 1, 1), a1));
+		row = _mm_add_ps(row, _mm_mul_ps(CMATH_SWIZZLE(bi, 2, 2, 2, 2), a2));
+		row = _mm_add_ps(row, t);
+
+		_mm_storeu_ps(r + 4*i, row);
+	}
+}
+
+static void QuaternionToMatrixSSE2(Mat4x4 *result, const Quaternion *q)
+{
+	float *r = (float *)result;
+
+	const __m128 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+
+	__m128 v = _mm_loadu_ps(&q->x);
+	__m128 sq = _mm_mul_ps(v, v);
+
+	// { ab, bc, ac } and { cd, ad, bd }
+	__m128 p1 = _mm_mul_ps(CMATH_SWIZZLE(v, 0, 1, 0, 3), CMATH_SWIZZLE(v, 1, 2, 2, 3));
+	__m128 p2 = _mm_mul_ps(CMATH_SWIZZLE(v, 3, 3, 3, 3), CMATH_SWIZZLE(v, 2, 0, 1, 3));
+
+	// { b2 + c2, a2 + c2, a2 + b2 }
+	__m128 diag = _mm_add_ps(CMATH_SWIZZLE(sq, 1, 0, 0, 3), CMATH_SWIZZLE(sq, 2, 2, 1, 3));
+
+	// d = { m0, m5, m10 }, s = { m1, m6, m8 }, f = { m4, m9, m2 }, lane 3 cleared
+	__m128 d = _mm_and_ps(_mm_sub_ps(one, _mm_mul_ps(two, diag)), mask);
+	__m128 s = _mm_and_ps(_mm_mul_ps(two, _mm_add_ps(p1, p2)), mask);
+	__m128 f = _mm_and_ps(_mm_mul_ps(two, _mm_sub_ps(p1, p2)), mask);
+
+	__m128 row0 = _mm_shuffle_ps(_mm_unpacklo_ps(d, f), s, CMATH_SHUFFLE(0, 1, 2, 3));
+	__m128 row1 = _mm_shuffle_ps(_mm_shuffle_ps(s, d, CMATH_SHUFFLE(0, 0, 1, 1)), f, CMATH_SHUFFLE(0, 2, 1, 3));
+	__m128 row2 = _mm_shuffle_ps(_mm_shuffle_ps(f, s, CMATH_SHUFFLE(2, 2, 1, 1)), d, CMATH_SHUFFLE(0, 2, 2, 3));
+
+	_mm_storeu_ps(r + 0, row0);
+	_mm_storeu_ps(r + 4, row1);
+	_mm_storeu_ps(r + 8, row2);
+	_mm_storeu_ps(r + 12, _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+// { x0 y0 z0 x1 } { y1 z1 x2 y2 } { z2 x3 y3 z3 } -> { x0..x3 } { y0..y3 } { z0..z3 }
+static inline void Vec3LoadSoA4(const float *p, __m128 *x, __m128 *y, __m128 *z)
+{
+	__m128 a = _mm_loadu_ps(p + 0);
+	__m128 b = _mm_loadu_ps(p + 4);
+	__m128 c = _mm_loadu_ps(p + 8);
+
+	*x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, CMATH_SHUFFLE(2, 2, 1, 1)), CMATH_SHUFFLE(0, 3, 0, 2));
+	*y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, CMATH_SHUFFLE(1, 1, 0, 0)), _mm_shuffle_ps(b, c, CMATH_SHUFFLE(3, 3, 2, 2)), CMATH_SHUFFLE(0, 2, 0, 2));
+	*z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, CMATH_SHUFFLE(2, 2, 1, 1)), CMATH_SWIZZLE(c, 0, 0, 3, 3), CMATH_SHUFFLE(0, 2, 0, 2));
+}
+
+static inline void Vec3StoreSoA4(float *p, __m128 x, __m128 y, __m128 z)
+{
+	__m128 a = _mm_shuffle_ps(_mm_unpacklo_ps(x, y), _mm_shuffle_ps(z, x, CMATH_SHUFFLE(0, 0, 1, 1)), CMATH_SHUFFLE(0, 1, 0, 2));
+	__m128 b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, CMATH_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x, y, CMATH_SHUFFLE(2, 2, 2, 2)), CMATH_SHUFFLE(0, 2, 0, 2));
+	__m128 c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, CMATH_SHUFFLE(2, 2, 3, 3)), _mm_shuffle_ps(y, z, CMATH_SHUFFLE(3, 3, 3, 3)), CMATH_SHUFFLE(0, 2, 0, 2));
+
+	_mm_storeu_ps(p + 0, a);
+	_mm_storeu_ps(p + 4, b);
+	_mm_storeu_ps(p + 8, c);
+}
+
+static inline void Vec3TransformSoA4(float *dst, const float *src, const __m128 *c)
+{
+	__m128 x, y, z;
+	Vec3LoadSoA4(src, &x, &y, &z);
+
+	__m128 rx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0], x), _mm_mul_ps(c[4], y)), _mm_mul_ps(c[8], z)), c[12]);
+	__m128 ry = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(c[1], x), _mm_mul_ps(c[5], y)), _mm_mul_ps(c[9], z)), c[13]);
+	__m128 rz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(c[2], x), _mm_mul_ps(c[6], y)), _mm_mul_ps(c[10], z)), c[14]);
+
+	Vec3StoreSoA4(dst, rx, ry, rz);
+}
+
+// w is 1 for points and 0 for directions
+static void Vec3TransformSSE2Batch(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count, float w)
+{
+	__m128 c[15];
+	c[0] = _mm_set1_ps(m->m0); c[4] = _mm_set1_ps(m->m4); c[8] = _mm_set1_ps(m->m8); c[12] = _mm_set1_ps(m->m12*w);
+	c[1] = _mm_set1_ps(m->m1); c[5] = _mm_set1_ps(m->m5); c[9] = _mm_set1_ps(m->m9); c[13] = _mm_set1_ps(m->m13*w);
+	c[2] = _mm_set1_ps(m->m2); c[6] = _mm_set1_ps(m->m6); c[10] = _mm_set1_ps(m->m10); c[14] = _mm_set1_ps(m->m14*w);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		Vec3TransformSoA4((float *)(result + i), (const float *)(v + i), c);
+
+	// run the last partial group through a padded copy
+	if (i < count)
+	{
+		Vec3 tail[4] = { 0 };
+
+		memcpy(tail, v + i, (count - i)*sizeof(Vec3));
+		Vec3TransformSoA4((float *)tail, (const float *)tail, c);
+		memcpy(result + i, tail, (count - i)*sizeof(Vec3));
+	}
+}
+
+static void Vec3TransformPointsSSE2(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	Vec3TransformSSE2Batch(result, v, m, count, 1.0f);
+}
+
+static void Vec3TransformDirectionsSSE2(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	Vec3TransformSSE2Batch(result, v, m, count, 0.0f);
+}
+
+static void Vec4TransformArraySSE2(Vec4 *result, const Vec4 *v, const Mat4x4 *m, size_t count)
+{
+	const float *p = (const float *)m;
+
+	__m128 c0 = _mm_loadu_ps(p + 0);
+	__m128 c1 = _mm_loadu_ps(p + 4);
+	__m128 c2 = _mm_loadu_ps(p + 8);
+	__m128 c3 = _mm_loadu_ps(p + 12);
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		__m128 in = _mm_loadu_ps(&v[i].x);
+
+		__m128 acc = _mm_mul_ps(c0, CMATH_SWIZZLE(in, 0, 0, 0, 0));
+		acc = _mm_add_ps(acc, _mm_mul_ps(c1, CMATH_SWIZZLE(in, 1, 1, 1, 1)));
+		acc = _mm_add_ps(acc, _mm_mul_ps(c2, CMATH_SWIZZLE(in, 2, 2, 2, 2)));
+		acc = _mm_add_ps(acc, _mm_mul_ps(c3, CMATH_SWIZZLE(in, 3, 3, 3, 3)));
+
+		_mm_storeu_ps(&result[i].x, acc);
+	}
+}
+
+static void Vec3TransformPointsEachSSE2(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		Vec3TransformSSE2(result + i, v + i, m + i);
+}
+
+static void Vec4TransformEachSSE2(Vec4 *result, const Vec4 *v, const Mat4x4 *m, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		Vec4TransformArraySSE2(result + i, v + i, m + i, 1);
+}
+
+static void StreamAddSSE2(float *result, const float *a, const float *b, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(result + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+
+	StreamAddScalar(result + i, a + i, b + i, count - i);
+}
+
+static void StreamScaleSSE2(float *result, const float *a, float f, size_t count)
+{
+	const __m128 s = _mm_set1_ps(f);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(result + i, _mm_mul_ps(_mm_loadu_ps(a + i), s));
+
+	StreamScaleScalar(result + i, a + i, f, count - i);
+}
+
+static void StreamLerpSSE2(float *result, const float *a, const float *b, float amount, size_t count)
+{
+	const __m128 t = _mm_set1_ps(amount);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 va = _mm_loadu_ps(a + i);
+		_mm_storeu_ps(result + i, _mm_add_ps(va, _mm_mul_ps(t, _mm_sub_ps(_mm_loadu_ps(b + i), va))));
+	}
+
+	StreamLerpScalar(result + i, a + i, b + i, amount, count - i);
+}
+
+static inline __m128 StreamDot4SSE2(const float *const *a, const float *const *b, int components, size_t i)
+{
+	__m128 dot = _mm_mul_ps(_mm_loadu_ps(a[0] + i), _mm_loadu_ps(b[0] + i));
+	dot = _mm_add_ps(dot, _mm_mul_ps(_mm_loadu_ps(a[1] + i), _mm_loadu_ps(b[1] + i)));
+	dot = _mm_add_ps(dot, _mm_mul_ps(_mm_loadu_ps(a[2] + i), _mm_loadu_ps(b[2] + i)));
+	if (components == 4) dot = _mm_add_ps(dot, _mm_mul_ps(_mm_loadu_ps(a[3] + i), _mm_loadu_ps(b[3] + i)));
+
+	return dot;
+}
+
+static void StreamDotSSE2(float *result, const float *const *a, const float *const *b, int components, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(result + i, StreamDot4SSE2(a, b, components, i));
+
+	const float *ta[4] = { 0 }, *tb[4] = { 0 };
+	for (int c = 0; c < components; ++c) { ta[c] = a[c] + i; tb[c] = b[c] + i; }
+	StreamDotScalar(result + i, ta, tb, components, count - i);
+}
+
+static void StreamLengthSSE2(float *result, const float *const *v, int components, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(result + i, _mm_sqrt_ps(StreamDot4SSE2(v, v, components, i)));
+
+	const float *tv[4] = { 0 };
+	for (int c = 0; c < components; ++c) tv[c] = v[c] + i;
+	StreamLengthScalar(result + i, tv, components, count - i);
+}
+
+static void StreamNormalizeSSE2(float *const *result, const float *const *v, int components, size_t count)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 zero = _mm_setzero_ps();
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 length = _mm_sqrt_ps(StreamDot4SSE2(v, v, components, i));
+		__m128 ilength = _mm_div_ps(one, length);
+		__m128 scale = components == 4 ? _mm_cmpgt_ps(length, zero) : _mm_cmpneq_ps(length, zero);
+
+		for (int c = 0; c < components; ++c)
+		{
+			__m128 in = _mm_loadu_ps(v[c] + i);
+			__m128 keep = components == 4 ? zero : _mm_andnot_ps(scale, in);
+
+			_mm_storeu_ps(result[c] + i, _mm_or_ps(_mm_and_ps(scale, _mm_mul_ps(in, ilength)), keep));
+		}
+	}
+
+	float *tr[4] = { 0 };
+	const float *tv[4] = { 0 };
+	for (int c = 0; c < components; ++c) { tr[c] = result[c] + i; tv[c] = v[c] + i; }
+	StreamNormalizeScalar(tr, tv, components, count - i);
+}
+
+static void StreamCrossSSE2(float *const *result, const float *const *a, const float *const *b, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 ax = _mm_loadu_ps(a[0] + i), ay = _mm_loadu_ps(a[1] + i), az = _mm_loadu_ps(a[2] + i);
+		__m128 bx = _mm_loadu_ps(b[0] + i), by = _mm_loadu_ps(b[1] + i), bz = _mm_loadu_ps(b[2] + i);
+
+		_mm_storeu_ps(result[0] + i, _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by)));
+		_mm_storeu_ps(result[1] + i, _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz)));
+		_mm_storeu_ps(result[2] + i, _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx)));
+	}
+
+	float *tr[3] = { result[0] + i, result[1] + i, result[2] + i };
+	const float *ta[3] = { a[0] + i, a[1] + i, a[2] + i };
+	const float *tb[3] = { b[0] + i, b[1] + i, b[2] + i };
+	StreamCrossScalar(tr, ta, tb, count - i);
+}
+
+static inline __m128 SlerpAcosSSE2(__m128 x)
+{
+	__m128 p = _mm_set1_ps(-0.0012624911f);
+	p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(0.0066700901f));
+	p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(-0.0170881256f));
+	p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(0.0308918810f));
+	p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(-0.0501743046f));
+	p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(0.0889789874f));
+	p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(-0.2145988016f));
+	p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(1.5707963050f));
+
+	return _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), x)), p);
+}
+
+static inline __m128 SlerpSinSSE2(__m128 x)
+{
+	__m128 x2 = _mm_mul_ps(x, x);
+
+	__m128 p = _mm_set1_ps(-2.5052108e-8f);
+	p = _mm_add_ps(_mm_mul_ps(x2, p), _mm_set1_ps(2.7557319e-6f));
+	p = _mm_add_ps(_mm_mul_ps(x2, p), _mm_set1_ps(-1.9841270e-4f));
+	p = _mm_add_ps(_mm_mul_ps(x2, p), _mm_set1_ps(8.3333333e-3f));
+	p = _mm_add_ps(_mm_mul_ps(x2, p), _mm_set1_ps(-1.6666667e-1f));
+
+	return _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(x, x2), p));
+}
+
+// loads 4 quaternions, b flipped onto the hemisphere of a, returns the dot
+// product after the flip
+static inline __m128 QuaternionStreamLoad4SSE2(__m128 *qa, __m128 *qb, const float *const *a, const float *const *b, size_t i)
+{
+	for (int c = 0; c < 4; ++c)
+	{
+		qa[c] = _mm_loadu_ps(a[c] + i);
+		qb[c] = _mm_loadu_ps(b[c] + i);
+	}
+
+	__m128 dot = _mm_mul_ps(qa[0], qb[0]);
+	dot = _mm_add_ps(dot, _mm_mul_ps(qa[1], qb[1]));
+	dot = _mm_add_ps(dot, _mm_mul_ps(qa[2], qb[2]));
+	dot = _mm_add_ps(dot, _mm_mul_ps(qa[3], qb[3]));
+
+	// sign bit where dot < 0, flipping it negates exactly like the scalar path
+	__m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+	for (int c = 0; c < 4; ++c) qb[c] = _mm_xor_ps(qb[c], flip);
+
+	return _mm_xor_ps(dot, flip);
+}
+
+static inline void QuaternionStreamNlerp4SSE2(__m128 *q, const __m128 *qa, const __m128 *qb, __m128 t)
+{
+	for (int c = 0; c < 4; ++c) q[c] = _mm_add_ps(qa[c], _mm_mul_ps(t, _mm_sub_ps(qb[c], qa[c])));
+
+	__m128 length = _mm_mul_ps(q[0], q[0]);
+	length = _mm_add_ps(length, _mm_mul_ps(q[1], q[1]));
+	length = _mm_add_ps(length, _mm_mul_ps(q[2], q[2]));
+	length = _mm_add_ps(length, _mm_mul_ps(q[3], q[3]));
+	length = _mm_sqrt_ps(length);
+
+	// zero length becomes 1 (the bits of 0.0f are all clear)
+	const __m128 one = _mm_set1_ps(1.0f);
+	length = _mm_or_ps(length, _mm_and_ps(_mm_cmpeq_ps(length, _mm_setzero_ps()), one));
+	__m128 ilength = _mm_div_ps(one, length);
+
+	for (int c = 0; c < 4; ++c) q[c] = _mm_mul_ps(q[c], ilength);
+}
+
+static inline __m128 StreamAmount4SSE2(const float *amount, size_t amountStride, size_t i)
+{
+	return amountStride ? _mm_loadu_ps(amount + i) : _mm_set1_ps(*amount);
+}
+
+static void StreamNlerpSSE2(float *const *result, const float *const *a, const float *const *b, const float *amount, size_t amountStride, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 qa[4], qb[4], q[4];
+
+		QuaternionStreamLoad4SSE2(qa, qb, a, b, i);
+		QuaternionStreamNlerp4SSE2(q, qa, qb, StreamAmount4SSE2(amount, amountStride, i));
+
+		for (int c = 0; c < 4; ++c) _mm_storeu_ps(result[c] + i, q[c]);
+	}
+
+	float *tr[4] = { result[0] + i, result[1] + i, result[2] + i, result[3] + i };
+	const float *ta[4] = { a[0] + i, a[1] + i, a[2] + i, a[3] + i };
+	const float *tb[4] = { b[0] + i, b[1] + i, b[2] + i, b[3] + i };
+	StreamNlerpScalar(tr, ta, tb, amount + i*amountStride, amountStride, count - i);
+}
+
+static void StreamSlerpSSE2(float *const *result, const float *const *a, const float *const *b, const float *amount, size_t amountStride, size_t count)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 nlerpLimit = _mm_set1_ps(0.95f);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 qa[4], qb[4], qn[4];
+
+		__m128 t = StreamAmount4SSE2(amount, amountStride, i);
+		__m128 cosHalfTheta = QuaternionStreamLoad4SSE2(qa, qb, a, b, i);
+
+		// every lane takes all three paths, the masks pick one
+		QuaternionStreamNlerp4SSE2(qn, qa, qb, t);
+
+		__m128 halfTheta = SlerpAcosSSE2(cosHalfTheta);
+		__m128 invSinHalfTheta = _mm_div_ps(one, _mm_sqrt_ps(_mm_sub_ps(one, _mm_mul_ps(cosHalfTheta, cosHalfTheta))));
+
+		__m128 ratioA = _mm_mul_ps(SlerpSinSSE2(_mm_mul_ps(_mm_sub_ps(one, t), halfTheta)), invSinHalfTheta);
+		__m128 ratioB = _mm_mul_ps(SlerpSinSSE2(_mm_mul_ps(t, halfTheta)), invSinHalfTheta);
+
+		__m128 useA = _mm_cmpge_ps(cosHalfTheta, one);
+		__m128 useNlerp = _mm_cmpgt_ps(cosHalfTheta, nlerpLimit);
+
+		for (int c = 0; c < 4; ++c)
+		{
+			__m128 q = _mm_add_ps(_mm_mul_ps(qa[c], ratioA), _mm_mul_ps(qb[c], ratioB));
+			q = _mm_or_ps(_mm_and_ps(useNlerp, qn[c]), _mm_andnot_ps(useNlerp, q));
+			q = _mm_or_ps(_mm_and_ps(useA, qa[c]), _mm_andnot_ps(useA, q));
+
+			_mm_storeu_ps(result[c] + i, q);
+		}
+	}
+
+	float *tr[4] = { result[0] + i, result[1] + i, result[2] + i, result[3] + i };
+	const float *ta[4] = { a[0] + i, a[1] + i, a[2] + i, a[3] + i };
+	const float *tb[4] = { b[0] + i, b[1] + i, b[2] + i, b[3] + i };
+	StreamSlerpScalar(tr, ta, tb, amount + i*amountStride, amountStride, count - i);
+}
+
+// same arithmetic as QuaternionToMatrixScalar on 4 quaternions, then
+// transposed into 4 matrices
+static void StreamQuaternionToMatrixSSE2(Mat4x4 *result, const float *const *q, size_t count)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 row3 = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(q[0] + i);
+		__m128 y = _mm_loadu_ps(q[1] + i);
+		__m128 z = _mm_loadu_ps(q[2] + i);
+		__m128 w = _mm_loadu_ps(q[3] + i);
+
+		__m128 a2 = _mm_mul_ps(x, x);
+		__m128 b2 = _mm_mul_ps(y, y);
+		__m128 c2 = _mm_mul_ps(z, z);
+		__m128 ac = _mm_mul_ps(x, z);
+		__m128 ab = _mm_mul_ps(x, y);
+		__m128 bc = _mm_mul_ps(y, z);
+		__m128 ad = _mm_mul_ps(w, x);
+		__m128 bd = _mm_mul_ps(w, y);
+		__m128 cd = _mm_mul_ps(w, z);
+
+		// row 0 { m0 m4 m8 0 }, row 1 { m1 m5 m9 0 }, row 2 { m2 m6 m10 0 }
+		__m128 r00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(b2, c2)));
+		__m128 r01 = _mm_mul_ps(two, _mm_sub_ps(ab, cd));
+		__m128 r02 = _mm_mul_ps(two, _mm_add_ps(ac, bd));
+		__m128 r03 = _mm_setzero_ps();
+
+		__m128 r10 = _mm_mul_ps(two, _mm_add_ps(ab, cd));
+		__m128 r11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(a2, c2)));
+		__m128 r12 = _mm_mul_ps(two, _mm_sub_ps(bc, ad));
+		__m128 r13 = _mm_setzero_ps();
+
+		__m128 r20 = _mm_mul_ps(two, _mm_sub_ps(ac, bd));
+		__m128 r21 = _mm_mul_ps(two, _mm_add_ps(bc, ad));
+		__m128 r22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(a2, b2)));
+		__m128 r23 = _mm_setzero_ps();
+
+		_MM_TRANSPOSE4_PS(r00, r01, r02, r03);
+		_MM_TRANSPOSE4_PS(r10, r11, r12, r13);
+		_MM_TRANSPOSE4_PS(r20, r21, r22, r23);
+
+		float *r = (float *)(result + i);
+
+		_mm_storeu_ps(r + 0, r00);  _mm_storeu_ps(r + 4, r10);  _mm_storeu_ps(r + 8, r20);  _mm_storeu_ps(r + 12, row3);
+		_mm_storeu_ps(r + 16, r01); _mm_storeu_ps(r + 20, r11); _mm_storeu_ps(r + 24, r21); _mm_storeu_ps(r + 28, row3);
+		_mm_storeu_ps(r + 32, r02); _mm_storeu_ps(r + 36, r12); _mm_storeu_ps(r + 40, r22); _mm_storeu_ps(r + 44, row3);
+		_mm_storeu_ps(r + 48, r03); _mm_storeu_ps(r + 52, r13); _mm_storeu_ps(r + 56, r23); _mm_storeu_ps(r + 60, row3);
+	}
+
+	const float *tq[4] = { q[0] + i, q[1] + i, q[2] + i, q[3] + i };
+	StreamQuaternionToMatrixScalar(result + i, tq, count - i);
+}
+
+static size_t CullSpheresSSE2(unsigned int *visible, const float *const *sphere, const Vec4 *planes, size_t base, size_t count)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+
+	size_t n = 0, i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(sphere[0] + i);
+		__m128 y = _mm_loadu_ps(sphere[1] + i);
+		__m128 z = _mm_loadu_ps(sphere[2] + i);
+		__m128 r = _mm_xor_ps(_mm_loadu_ps(sphere[3] + i), sign);
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		for (int p = 0; p < 6; ++p)
+		{
+			__m128 distance = _mm_mul_ps(_mm_set1_ps(planes[p].x), x);
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].y), y));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].z), z));
+			distance = _mm_add_ps(distance, _mm_set1_ps(planes[p].w));
+
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, r));
+		}
+
+		n = CullAppend(visible, n, base + i, _mm_movemask_ps(inside), 4);
+	}
+
+	const float *ts[4] = { sphere[0] + i, sphere[1] + i, sphere[2] + i, sphere[3] + i };
+	return n + CullSpheresScalar(visible + n, ts, planes, base + i, count - i);
+}
+
+static size_t CullBoxesSSE2(unsigned int *visible, const float *const *center, const float *const *extent, const Vec4 *planes, size_t base, size_t count)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+
+	size_t n = 0, i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(center[0] + i);
+		__m128 y = _mm_loadu_ps(center[1] + i);
+		__m128 z = _mm_loadu_ps(center[2] + i);
+		__m128 ex = _mm_loadu_ps(extent[0] + i);
+		__m128 ey = _mm_loadu_ps(extent[1] + i);
+		__m128 ez = _mm_loadu_ps(extent[2] + i);
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		for (int p = 0; p < 6; ++p)
+		{
+			__m128 distance = _mm_mul_ps(_mm_set1_ps(planes[p].x), x);
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].y), y));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].z), z));
+			distance = _mm_add_ps(distance, _mm_set1_ps(planes[p].w));
+
+			__m128 radius = _mm_mul_ps(_mm_set1_ps(fabsf(planes[p].x)), ex);
+			radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(fabsf(planes[p].y)), ey));
+			radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(fabsf(planes[p].z)), ez));
+
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_xor_ps(radius, sign)));
+		}
+
+		n = CullAppend(visible, n, base + i, _mm_movemask_ps(inside), 4);
+	}
+
+	const float *tc[3] = { center[0] + i, center[1] + i, center[2] + i };
+	const float *te[3] = { extent[0] + i, extent[1] + i, extent[2] + i };
+	return n + CullBoxesScalar(visible + n, tc, te, planes, base + i, count - i);
+}
+
+// 4 x 8 tile, 8 accumulators
+static void GemmKernelSSE2(size_t k, const float *a, const float *b, float *c, size_t ldc)
+{
+	__m128 c00 = _mm_setzero_ps(), c01 = _mm_setzero_ps();
+	__m128 c10 = _mm_setzero_ps(), c11 = _mm_setzero_ps();
+	__m128 c20 = _mm_setzero_ps(), c21 = _mm_setzero_ps();
+	__m128 c30 = _mm_setzero_ps(), c31 = _mm_setzero_ps();
+
+	for (size_t p = 0; p < k; ++p, a += 4, b += 8)
+	{
+		__m128 b0 = _mm_loadu_ps(b);
+		__m128 b1 = _mm_loadu_ps(b + 4);
+		__m128 ai;
+
+		ai = _mm_set1_ps(a[0]);
+		c00 = _mm_add_ps(c00, _mm_mul_ps(ai, b0));
+		c01 = _mm_add_ps(c01, _mm_mul_ps(ai, b1));
+
+		ai = _mm_set1_ps(a[1]);
+		c10 = _mm_add_ps(c10, _mm_mul_ps(ai, b0));
+		c11 = _mm_add_ps(c11, _mm_mul_ps(ai, b1));
+
+		ai = _mm_set1_ps(a[2]);
+		c20 = _mm_add_ps(c20, _mm_mul_ps(ai, b0));
+		c21 = _mm_add_ps(c21, _mm_mul_ps(ai, b1));
+
+		ai = _mm_set1_ps(a[3]);
+		c30 = _mm_add_ps(c30, _mm_mul_ps(ai, b0));
+		c31 = _mm_add_ps(c31, _mm_mul_ps(ai, b1));
+	}
+
+	_mm_storeu_ps(c, _mm_add_ps(_mm_loadu_ps(c), c00));
+	_mm_storeu_ps(c + 4, _mm_add_ps(_mm_loadu_ps(c + 4), c01));
+	_mm_storeu_ps(c + ldc, _mm_add_ps(_mm_loadu_ps(c + ldc), c10));
+	_mm_storeu_ps(c + ldc + 4, _mm_add_ps(_mm_loadu_ps(c + ldc + 4), c11));
+	_mm_storeu_ps(c + 2*ldc, _mm_add_ps(_mm_loadu_ps(c + 2*ldc), c20));
+	_mm_storeu_ps(c + 2*ldc + 4, _mm_add_ps(_mm_loadu_ps(c + 2*ldc + 4), c21));
+	_mm_storeu_ps(c + 3*ldc, _mm_add_ps(_mm_loadu_ps(c + 3*ldc), c30));
+	_mm_storeu_ps(c + 3*ldc + 4, _mm_add_ps(_mm_loadu_ps(c + 3*ldc + 4), c31));
+}
+
+#endif // CMATH_HAS_SSE2
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	AVX / FMA
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+#if defined(CMATH_HAS_AVX)
+
+// two result rows per 256-bit register
+__attribute__((target("avx")))
+static void Mat4x4MultiplyAVX(Mat4x4 *result, const Mat4x4 *m1, const Mat4x4 *m2)
+{
+	const float *a = (const float *)m1;
+	const float *b = (const float *)m2;
+	float *r = (float *)result;
+
+	__m256 a0 = _mm256_broadcast_ps((const __m128 *)(a + 0));
+	__m256 a1 = _mm256_broadcast_ps((const __m128 *)(a + 4));
+	__m256 a2 = _mm256_broadcast_ps((const __m128 *)(a + 8));
+	__m256 a3 = _mm256_broadcast_ps((const __m128 *)(a + 12));
+
+	__m256 b01 = _mm256_loadu_ps(b + 0);
+	__m256 b23 = _mm256_loadu_ps(b + 8);
+
+	__m256 r01 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, 0x00));
+	r01 = _mm256_add_ps(r01, _mm256_mul_ps(a1, _mm256_shuffle_ps(b01, b01, 0x55)));
+	r01 = _mm256_add_ps(r01, _mm256_mul_ps(a2, _mm256_shuffle_ps(b01, b01, 0xAA)));
+	r01 = _mm256_add_ps(r01, _mm256_mul_ps(a3, _mm256_shuffle_ps(b01, b01, 0xFF)));
+
+	__m256 r23 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b23, b23, 0x00));
+	r23 = _mm256_add_ps(r23, _mm256_mul_ps(a1, _mm256_shuffle_ps(b23, b23, 0x55)));
+	r23 = _mm256_add_ps(r23, _mm256_mul_ps(a2, _mm256_shuffle_ps(b23, b23, 0xAA)));
+	r23 = _mm256_add_ps(r23, _mm256_mul_ps(a3, _mm256_shuffle_ps(b23, b23, 0xFF)));
+
+	_mm256_storeu_ps(r + 0, r01);
+	_mm256_storeu_ps(r + 8, r23);
+}
+
+__attribute__((target("avx,fma")))
+static void Mat3x4MultiplyFMA(Mat3x4 *result, const Mat3x4 *m1, const Mat3x4 *m2)
+{
+	const float *a = (const float *)m1;
+	const float *b = (const float *)m2;
+	float *r = (float *)result;
+
+	const __m128 translation = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+
+	__m128 a0 = _mm_loadu_ps(a + 0);
+	__m128 a1 = _mm_loadu_ps(a + 4);
+	__m128 a2 = _mm_loadu_ps(a + 8);
+
+	__m128 rows[3] = { _mm_loadu_ps(b + 0), _mm_loadu_ps(b + 4), _mm_loadu_ps(b + 8) };
+
+	for (int i = 0; i < 3; ++i)
+	{
+		__m128 bi = rows[i];
+
+		__m128 row = _mm_fmadd_ps(CMATH_SWIZZLE(bi, 0, 0, 0, 0), a0, _mm_and_ps(bi, translation));
+		row = _mm_fmadd_ps(CMATH_SWIZZLE(bi, 1, 1, 1, 1), a1, row);
+		row = _mm_fmadd_ps(CMATH_SWIZZLE(bi, 2, 2, 2, 2), a2, row);
+
+		_mm_storeu_ps(r + 4*i, row);
+	}
+}
+
+__attribute__((target("avx,fma")))
+static void Mat4x4MultiplyFMA(Mat4x4 *result, const Mat4x4 *m1, const Mat4x4 *m2)
+{
+	const float *a = (const float *)m1;
+	const float *b = (const float *)m2;
+	float *r = (float *)result;
+
+	__m256 a0 = _mm256_broadcast_ps((const __m128 *)(a + 0));
+	__m256 a1 = _mm256_broadcast_ps((const __m128 *)(a + 4));
+	__m256 a2 = _mm256_broadcast_ps((const __m128 *)(a + 8));
+	__m256 a3 = _mm256_broadcast_ps((const __m128 *)(a + 12));
+
+	__m256 b01 = _mm256_loadu_ps(b + 0);
+	__m256 b23 = _mm256_loadu_ps(b + 8);
+
+	__m256 r01 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, 0x00));
+	r01 = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(b01, b01, 0x55), r01);
+	r01 = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(b01, b01, 0xAA), r01);
+	r01 = _mm256_fmadd_ps(a3, _mm256_shuffle_ps(b01, b01, 0xFF), r01);
+
+	__m256 r23 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b23, b23, 0x00));
+	r23 = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(b23, b23, 0x55), r23);
+	r23 = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(b23, b23, 0xAA), r23);
+	r23 = _mm256_fmadd_ps(a3, _mm256_shuffle_ps(b23, b23, 0xFF), r23);
+
+	_mm256_storeu_ps(r + 0, r01);
+	_mm256_storeu_ps(r + 8, r23);
+}
+
+__attribute__((target("avx,fma")))
+static void Vec3TransformFMA(Vec3 *result, const Vec3 *v, const Mat4x4 *m)
+{
+	const float *p = (const float *)m;
+
+	__m128 c0 = _mm_loadu_ps(p + 0);
+	__m128 c1 = _mm_loadu_ps(p + 4);
+	__m128 c2 = _mm_loadu_ps(p + 8);
+	__m128 c3 = _mm_loadu_ps(p + 12);
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+	__m128 acc = _mm_mul_ps(c0, _mm_set1_ps(v->x));
+	acc = _mm_fmadd_ps(c1, _mm_set1_ps(v->y), acc);
+	acc = _mm_fmadd_ps(c2, _mm_set1_ps(v->z), acc);
+	acc = _mm_add_ps(acc, c3);
+
+	_mm_storel_pi((__m64 *)result, acc);
+	_mm_store_ss(&result->z, _mm_movehl_ps(acc, acc));
+}
+
+// 8 x { x y z } -> { x0..x7 } { y0..y7 } { z0..z7 }
+__attribute__((target("avx")))
+static inline void Vec3LoadSoA8(const float *p, __m256 *x, __m256 *y, __m256 *z)
+{
+	__m256 m03 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 0)), _mm_loadu_ps(p + 12), 1);
+	__m256 m14 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 4)), _mm_loadu_ps(p + 16), 1);
+	__m256 m25 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 8)), _mm_loadu_ps(p + 20), 1);
+
+	__m256 xy = _mm256_shuffle_ps(m14, m25, CMATH_SHUFFLE(2, 3, 1, 2));
+	__m256 yz = _mm256_shuffle_ps(m03, m14, CMATH_SHUFFLE(1, 2, 0, 1));
+
+	*x = _mm256_shuffle_ps(m03, xy, CMATH_SHUFFLE(0, 3, 0, 2));
+	*y = _mm256_shuffle_ps(yz, xy, CMATH_SHUFFLE(0, 2, 1, 3));
+	*z = _mm256_shuffle_ps(yz, m25, CMATH_SHUFFLE(1, 3, 0, 3));
+}
+
+__attribute__((target("avx")))
+static inline void Vec3StoreSoA8(float *p, __m256 x, __m256 y, __m256 z)
+{
+	__m256 rxy = _mm256_shuffle_ps(x, y, CMATH_SHUFFLE(0, 2, 0, 2));
+	__m256 ryz = _mm256_shuffle_ps(y, z, CMATH_SHUFFLE(1, 3, 1, 3));
+	__m256 rzx = _mm256_shuffle_ps(z, x, CMATH_SHUFFLE(0, 2, 1, 3));
+
+	__m256 r03 = _mm256_shuffle_ps(rxy, rzx, CMATH_SHUFFLE(0, 2, 0, 2));
+	__m256 r14 = _mm256_shuffle_ps(ryz, rxy, CMATH_SHUFFLE(0, 2, 1, 3));
+	__m256 r25 = _mm256_shuffle_ps(rzx, ryz, CMATH_SHUFFLE(1, 3, 1, 3));
+
+	_mm_storeu_ps(p + 0, _mm256_castps256_ps128(r03));
+	_mm_storeu_ps(p + 4, _mm256_castps256_ps128(r14));
+	_mm_storeu_ps(p + 8, _mm256_castps256_ps128(r25));
+	_mm_storeu_ps(p + 12, _mm256_extractf128_ps(r03, 1));
+	_mm_storeu_ps(p + 16, _mm256_extractf128_ps(r14, 1));
+	_mm_storeu_ps(p + 20, _mm256_extractf128_ps(r25, 1));
+}
+
+__attribute__((target("avx")))
+static inline void Vec3TransformSoA8AVX(float *dst, const float *src, const __m256 *c)
+{
+	__m256 x, y, z;
+	Vec3LoadSoA8(src, &x, &y, &z);
+
+	__m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[0], x), _mm256_mul_ps(c[4], y)), _mm256_mul_ps(c[8], z)), c[12]);
+	__m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[1], x), _mm256_mul_ps(c[5], y)), _mm256_mul_ps(c[9], z)), c[13]);
+	__m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[2], x), _mm256_mul_ps(c[6], y)), _mm256_mul_ps(c[10], z)), c[14]);
+
+	Vec3StoreSoA8(dst, rx, ry, rz);
+}
+
+__attribute__((target("avx,fma")))
+static inline void Vec3TransformSoA8FMA(float *dst, const float *src, const __m256 *c)
+{
+	__m256 x, y, z;
+	Vec3LoadSoA8(src, &x, &y, &z);
+
+	__m256 rx = _mm256_fmadd_ps(c[8], z, _mm256_fmadd_ps(c[4], y, _mm256_fmadd_ps(c[0], x, c[12])));
+	__m256 ry = _mm256_fmadd_ps(c[9], z, _mm256_fmadd_ps(c[5], y, _mm256_fmadd_ps(c[1], x, c[13])));
+	__m256 rz = _mm256_fmadd_ps(c[10], z, _mm256_fmadd_ps(c[6], y, _mm256_fmadd_ps(c[2], x, c[14])));
+
+	Vec3StoreSoA8(dst, rx, ry, rz);
+}
+
+__attribute__((target("avx")))
+static inline void Vec3SplatAVX(__m256 *c, const Mat4x4 *m, float w)
+{
+	c[0] = _mm256_set1_ps(m->m0); c[4] = _mm256_set1_ps(m->m4); c[8] = _mm256_set1_ps(m->m8); c[12] = _mm256_set1_ps(m->m12*w);
+	c[1] = _mm256_set1_ps(m->m1); c[5] = _mm256_set1_ps(m->m5); c[9] = _mm256_set1_ps(m->m9); c[13] = _mm256_set1_ps(m->m13*w);
+	c[2] = _mm256_set1_ps(m->m2); c[6] = _mm256_set1_ps(m->m6); c[10] = _mm256_set1_ps(m->m10); c[14] = _mm256_set1_ps(m->m14*w);
+}
+
+__attribute__((target("avx")))
+static void Vec3TransformAVXBatch(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count, float w)
+{
+	__m256 c[15];
+	Vec3SplatAVX(c, m, w);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		Vec3TransformSoA8AVX((float *)(result + i), (const float *)(v + i), c);
+
+	if (i < count)
+	{
+		Vec3 tail[8] = { 0 };
+
+		memcpy(tail, v + i, (count - i)*sizeof(Vec3));
+		Vec3TransformSoA8AVX((float *)tail, (const float *)tail, c);
+		memcpy(result + i, tail, (count - i)*sizeof(Vec3));
+	}
+}
+
+__attribute__((target("avx,fma")))
+static void Vec3TransformFMABatch(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count, float w)
+{
+	__m256 c[15];
+	Vec3SplatAVX(c, m, w);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		Vec3TransformSoA8FMA((float *)(result + i), (const float *)(v + i), c);
+
+	if (i < count)
+	{
+		Vec3 tail[8] = { 0 };
+
+		memcpy(tail, v + i, (count - i)*sizeof(Vec3));
+		Vec3TransformSoA8FMA((float *)tail, (const float *)tail, c);
+		memcpy(result + i, tail, (count - i)*sizeof(Vec3));
+	}
+}
+
+static void Vec3TransformPointsAVX(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	Vec3TransformAVXBatch(result, v, m, count, 1.0f);
+}
+
+static void Vec3TransformDirectionsAVX(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	Vec3TransformAVXBatch(result, v, m, count, 0.0f);
+}
+
+static void Vec3TransformPointsFMA(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	Vec3TransformFMABatch(result, v, m, count, 1.0f);
+}
+
+static void Vec3TransformDirectionsFMA(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	Vec3TransformFMABatch(result, v, m, count, 0.0f);
+}
+
+// two vectors per 256-bit register, columns broadcast to both halves
+__attribute__((target("avx,fma")))
+static void Vec4TransformArrayFMA(Vec4 *result, const Vec4 *v, const Mat4x4 *m, size_t count)
+{
+	const float *p = (const float *)m;
+
+	__m128 c0 = _mm_loadu_ps(p + 0);
+	__m128 c1 = _mm_loadu_ps(p + 4);
+	__m128 c2 = _mm_loadu_ps(p + 8);
+	__m128 c3 = _mm_loadu_ps(p + 12);
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+	__m256 col0 = _mm256_insertf128_ps(_mm256_castps128_ps256(c0), c0, 1);
+	__m256 col1 = _mm256_insertf128_ps(_mm256_castps128_ps256(c1), c1, 1);
+	__m256 col2 = _mm256_insertf128_ps(_mm256_castps128_ps256(c2), c2, 1);
+	__m256 col3 = _mm256_insertf128_ps(_mm256_castps128_ps256(c3), c3, 1);
+
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		__m256 in = _mm256_loadu_ps(&v[i].x);
+
+		__m256 acc = _mm256_mul_ps(col0, _mm256_shuffle_ps(in, in, 0x00));
+		acc = _mm256_fmadd_ps(col1, _mm256_shuffle_ps(in, in, 0x55), acc);
+		acc = _mm256_fmadd_ps(col2, _mm256_shuffle_ps(in, in, 0xAA), acc);
+		acc = _mm256_fmadd_ps(col3, _mm256_shuffle_ps(in, in, 0xFF), acc);
+
+		_mm256_storeu_ps(&result[i].x, acc);
+	}
+
+	if (i < count)
+	{
+		__m128 in = _mm_loadu_ps(&v[i].x);
+
+		__m128 acc = _mm_mul_ps(c0, CMATH_SWIZZLE(in, 0, 0, 0, 0));
+		acc = _mm_fmadd_ps(c1, CMATH_SWIZZLE(in, 1, 1, 1, 1), acc);
+		acc = _mm_fmadd_ps(c2, CMATH_SWIZZLE(in, 2, 2, 2, 2), acc);
+		acc = _mm_fmadd_ps(c3, CMATH_SWIZZLE(in, 3, 3, 3, 3), acc);
+
+		_mm_storeu_ps(&result[i].x, acc);
+	}
+}
+
+__attribute__((target("avx")))
+static void StreamAddAVX(float *result, const float *a, const float *b, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(result + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+
+	StreamAddScalar(result + i, a + i, b + i, count - i);
+}
+
+__attribute__((target("avx")))
+static void StreamScaleAVX(float *result, const float *a, float f, size_t count)
+{
+	const __m256 s = _mm256_set1_ps(f);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(result + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), s));
+
+	StreamScaleScalar(result + i, a + i, f, count - i);
+}
+
+__attribute__((target("avx")))
+static void StreamLerpAVX(float *result, const float *a, const float *b, float amount, size_t count)
+{
+	const __m256 t = _mm256_set1_ps(amount);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 va = _mm256_loadu_ps(a + i);
+		_mm256_storeu_ps(result + i, _mm256_add_ps(va, _mm256_mul_ps(t, _mm256_sub_ps(_mm256_loadu_ps(b + i), va))));
+	}
+
+	StreamLerpScalar(result + i, a + i, b + i, amount, count - i);
+}
+
+__attribute__((target("avx")))
+static inline __m256 StreamDot8AVX(const float *const *a, const float *const *b, int components, size_t i)
+{
+	__m256 dot = _mm256_mul_ps(_mm256_loadu_ps(a[0] + i), _mm256_loadu_ps(b[0] + i));
+	dot = _mm256_add_ps(dot, _mm256_mul_ps(_mm256_loadu_ps(a[1] + i), _mm256_loadu_ps(b[1] + i)));
+	dot = _mm256_add_ps(dot, _mm256_mul_ps(_mm256_loadu_ps(a[2] + i), _mm256_loadu_ps(b[2] + i)));
+	if (components == 4) dot = _mm256_add_ps(dot, _mm256_mul_ps(_mm256_loadu_ps(a[3] + i), _mm256_loadu_ps(b[3] + i)));
+
+	return dot;
+}
+
+__attribute__((target("avx")))
+static void StreamDotAVX(float *result, const float *const *a, const float *const *b, int components, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(result + i, StreamDot8AVX(a, b, components, i));
+
+	const float *ta[4] = { 0 }, *tb[4] = { 0 };
+	for (int c = 0; c < components; ++c) { ta[c] = a[c] + i; tb[c] = b[c] + i; }
+	StreamDotScalar(result + i, ta, tb, components, count - i);
+}
+
+__attribute__((target("avx")))
+static void StreamLengthAVX(float *result, const float *const *v, int components, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(result + i, _mm256_sqrt_ps(StreamDot8AVX(v, v, components, i)));
+
+	const float *tv[4] = { 0 };
+	for (int c = 0; c < components; ++c) tv[c] = v[c] + i;
+	StreamLengthScalar(result + i, tv, components, count - i);
+}
+
+__attribute__((target("avx")))
+static void StreamNormalizeAVX(float *const *result, const float *const *v, int components, size_t count)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 zero = _mm256_setzero_ps();
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 length = _mm256_sqrt_ps(StreamDot8AVX(v, v, components, i));
+		__m256 ilength = _mm256_div_ps(one, length);
+		__m256 scale = _mm256_cmp_ps(length, zero, components == 4 ? _CMP_GT_OQ : _CMP_NEQ_UQ);
+
+		for (int c = 0; c < components; ++c)
+		{
+			__m256 in = _mm256_loadu_ps(v[c] + i);
+			__m256 keep = components == 4 ? zero : _mm256_andnot_ps(scale, in);
+
+			_mm256_storeu_ps(result[c] + i, _mm256_or_ps(_mm256_and_ps(scale, _mm256_mul_ps(in, ilength)), keep));
+		}
+	}
+
+	float *tr[4] = { 0 };
+	const float *tv[4] = { 0 };
+	for (int c = 0; c < components; ++c) { tr[c] = result[c] + i; tv[c] = v[c] + i; }
+	StreamNormalizeScalar(tr, tv, components, count - i);
+}
+
+__attribute__((target("avx")))
+static void StreamCrossAVX(float *const *result, const float *const *a, const float *const *b, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 ax = _mm256_loadu_ps(a[0] + i), ay = _mm256_loadu_ps(a[1] + i), az = _mm256_loadu_ps(a[2] + i);
+		__m256 bx = _mm256_loadu_ps(b[0] + i), by = _mm256_loadu_ps(b[1] + i), bz = _mm256_loadu_ps(b[2] + i);
+
+		_mm256_storeu_ps(result[0] + i, _mm256_sub_ps(_mm256_mul_ps(ay, bz), _mm256_mul_ps(az, by)));
+		_mm256_storeu_ps(result[1] + i, _mm256_sub_ps(_mm256_mul_ps(az, bx), _mm256_mul_ps(ax, bz)));
+		_mm256_storeu_ps(result[2] + i, _mm256_sub_ps(_mm256_mul_ps(ax, by), _mm256_mul_ps(ay, bx)));
+	}
+
+	float *tr[3] = { result[0] + i, result[1] + i, result[2] + i };
+	const float *ta[3] = { a[0] + i, a[1] + i, a[2] + i };
+	const float *tb[3] = { b[0] + i, b[1] + i, b[2] + i };
+	StreamCrossScalar(tr, ta, tb, count - i);
+}
+
+__attribute__((target("avx")))
+static inline __m256 SlerpAcosAVX(__m256 x)
+{
+	__m256 p = _mm256_set1_ps(-0.0012624911f);
+	p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(0.0066700901f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(-0.0170881256f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(0.0308918810f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(-0.0501743046f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(0.0889789874f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(-0.2145988016f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(1.5707963050f));
+
+	return _mm256_mul_ps(_mm256_sqrt_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), x)), p);
+}
+
+__attribute__((target("avx")))
+static inline __m256 SlerpSinAVX(__m256 x)
+{
+	__m256 x2 = _mm256_mul_ps(x, x);
+
+	__m256 p = _mm256_set1_ps(-2.5052108e-8f);
+	p = _mm256_add_ps(_mm256_mul_ps(x2, p), _mm256_set1_ps(2.7557319e-6f));
+	p = _mm256_add_ps(_mm256_mul_ps(x2, p), _mm256_set1_ps(-1.9841270e-4f));
+	p = _mm256_add_ps(_mm256_mul_ps(x2, p), _mm256_set1_ps(8.3333333e-3f));
+	p = _mm256_add_ps(_mm256_mul_ps(x2, p), _mm256_set1_ps(-1.6666667e-1f));
+
+	return _mm256_add_ps(x, _mm256_mul_ps(_mm256_mul_ps(x, x2), p));
+}
+
+__attribute__((target("avx")))
+static inline __m256 QuaternionStreamLoad8AVX(__m256 *qa, __m256 *qb, const float *const *a, const float *const *b, size_t i)
+{
+	for (int c = 0; c < 4; ++c)
+	{
+		qa[c] = _mm256_loadu_ps(a[c] + i);
+		qb[c] = _mm256_loadu_ps(b[c] + i);
+	}
+
+	__m256 dot = _mm256_mul_ps(qa[0], qb[0]);
+	dot = _mm256_add_ps(dot, _mm256_mul_ps(qa[1], qb[1]));
+	dot = _mm256_add_ps(dot, _mm256_mul_ps(qa[2], qb[2]));
+	dot = _mm256_add_ps(dot, _mm256_mul_ps(qa[3], qb[3]));
+
+	__m256 flip = _mm256_and_ps(_mm256_cmp_ps(dot, _mm256_setzero_ps(), _CMP_LT_OQ), _mm256_set1_ps(-0.0f));
+	for (int c = 0; c < 4; ++c) qb[c] = _mm256_xor_ps(qb[c], flip);
+
+	return _mm256_xor_ps(dot, flip);
+}
+
+__attribute__((target("avx")))
+static inline void QuaternionStreamNlerp8AVX(__m256 *q, const __m256 *qa, const __m256 *qb, __m256 t)
+{
+	for (int c = 0; c < 4; ++c) q[c] = _mm256_add_ps(qa[c], _mm256_mul_ps(t, _mm256_sub_ps(qb[c], qa[c])));
+
+	__m256 length = _mm256_mul_ps(q[0], q[0]);
+	length = _mm256_add_ps(length, _mm256_mul_ps(q[1], q[1]));
+	length = _mm256_add_ps(length, _mm256_mul_ps(q[2], q[2]));
+	length = _mm256_add_ps(length, _mm256_mul_ps(q[3], q[3]));
+	length = _mm256_sqrt_ps(length);
+
+	const __m256 one = _mm256_set1_ps(1.0f);
+	length = _mm256_blendv_ps(length, one, _mm256_cmp_ps(length, _mm256_setzero_ps(), _CMP_EQ_OQ));
+	__m256 ilength = _mm256_div_ps(one, length);
+
+	for (int c = 0; c < 4; ++c) q[c] = _mm256_mul_ps(q[c], ilength);
+}
+
+__attribute__((target("avx")))
+static inline __m256 StreamAmount8AVX(const float *amount, size_t amountStride, size_t i)
+{
+	return amountStride ? _mm256_loadu_ps(amount + i) : _mm256_set1_ps(*amount);
+}
+
+__attribute__((target("avx")))
+static void StreamNlerpAVX(float *const *result, const float *const *a, const float *const *b, const float *amount, size_t amountStride, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 qa[4], qb[4], q[4];
+
+		QuaternionStreamLoad8AVX(qa, qb, a, b, i);
+		QuaternionStreamNlerp8AVX(q, qa, qb, StreamAmount8AVX(amount, amountStride, i));
+
+		for (int c = 0; c < 4; ++c) _mm256_storeu_ps(result[c] + i, q[c]);
+	}
+
+	float *tr[4] = { result[0] + i, result[1] + i, result[2] + i, result[3] + i };
+	const float *ta[4] = { a[0] + i, a[1] + i, a[2] + i, a[3] + i };
+	const float *tb[4] = { b[0] + i, b[1] + i, b[2] + i, b[3] + i };
+	StreamNlerpScalar(tr, ta, tb, amount + i*amountStride, amountStride, count - i);
+}
+
+__attribute__((target("avx")))
+static void StreamSlerpAVX(float *const *result, const float *const *a, const float *const *b, const float *amount, size_t amountStride, size_t count)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 nlerpLimit = _mm256_set1_ps(0.95f);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 qa[4], qb[4], qn[4];
+
+		__m256 t = StreamAmount8AVX(amount, amountStride, i);
+		__m256 cosHalfTheta = QuaternionStreamLoad8AVX(qa, qb, a, b, i);
+
+		QuaternionStreamNlerp8AVX(qn, qa, qb, t);
+
+		__m256 halfTheta = SlerpAcosAVX(cosHalfTheta);
+		__m256 invSinHalfTheta = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_sub_ps(one, _mm256_mul_ps(cosHalfTheta, cosHalfTheta))));
+
+		__m256 ratioA = _mm256_mul_ps(SlerpSinAVX(_mm256_mul_ps(_mm256_sub_ps(one, t), halfTheta)), invSinHalfTheta);
+		__m256 ratioB = _mm256_mul_ps(SlerpSinAVX(_mm256_mul_ps(t, halfTheta)), invSinHalfTheta);
+
+		__m256 useA = _mm256_cmp_ps(cosHalfTheta, one, _CMP_GE_OQ);
+		__m256 useNlerp = _mm256_cmp_ps(cosHalfTheta, nlerpLimit, _CMP_GT_OQ);
+
+		for (int c = 0; c < 4; ++c)
+		{
+			__m256 q = _mm256_add_ps(_mm256_mul_ps(qa[c], ratioA), _mm256_mul_ps(qb[c], ratioB));
+			q = _mm256_blendv_ps(q, qn[c], useNlerp);
+			q = _mm256_blendv_ps(q, qa[c], useA);
+
+			_mm256_storeu_ps(result[c] + i, q);
+		}
+	}
+
+	float *tr[4] = { result[0] + i, result[1] + i, result[2] + i, result[3] + i };
+	const float *ta[4] = { a[0] + i, a[1] + i, a[2] + i, a[3] + i };
+	const float *tb[4] = { b[0] + i, b[1] + i, b[2] + i, b[3] + i };
+	StreamSlerpScalar(tr, ta, tb, amount + i*amountStride, amountStride, count - i);
+}
+
+__attribute__((target("avx")))
+static size_t CullSpheresAVX(unsigned int *visible, const float *const *sphere, const Vec4 *planes, size_t base, size_t count)
+{
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+
+	size_t n = 0, i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(sphere[0] + i);
+		__m256 y = _mm256_loadu_ps(sphere[1] + i);
+		__m256 z = _mm256_loadu_ps(sphere[2] + i);
+		__m256 r = _mm256_xor_ps(_mm256_loadu_ps(sphere[3] + i), sign);
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		for (int p = 0; p < 6; ++p)
+		{
+			__m256 distance = _mm256_mul_ps(_mm256_broadcast_ss(&planes[p].x), x);
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_broadcast_ss(&planes[p].y), y));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_broadcast_ss(&planes[p].z), z));
+			distance = _mm256_add_ps(distance, _mm256_broadcast_ss(&planes[p].w));
+
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, r, _CMP_GE_OQ));
+		}
+
+		n = CullAppend(visible, n, base + i, _mm256_movemask_ps(inside), 8);
+	}
+
+	const float *ts[4] = { sphere[0] + i, sphere[1] + i, sphere[2] + i, sphere[3] + i };
+	return n + CullSpheresScalar(visible + n, ts, planes, base + i, count - i);
+}
+
+__attribute__((target("avx")))
+static size_t CullBoxesAVX(unsigned int *visible, const float *const *center, const float *const *extent, const Vec4 *planes, size_t base, size_t count)
+{
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+
+	// |normal| per plane, the radius of a box along the plane normal
+	Vec4 absPlanes[6];
+	for (int p = 0; p < 6; ++p)
+		absPlanes[p] = (Vec4) { fabsf(planes[p].x), fabsf(planes[p].y), fabsf(planes[p].z), 0.0f };
+
+	size_t n = 0, i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(center[0] + i);
+		__m256 y = _mm256_loadu_ps(center[1] + i);
+		__m256 z = _mm256_loadu_ps(center[2] + i);
+		__m256 ex = _mm256_loadu_ps(extent[0] + i);
+		__m256 ey = _mm256_loadu_ps(extent[1] + i);
+		__m256 ez = _mm256_loadu_ps(extent[2] + i);
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		for (int p = 0; p < 6; ++p)
+		{
+			__m256 distance = _mm256_mul_ps(_mm256_broadcast_ss(&planes[p].x), x);
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_broadcast_ss(&planes[p].y), y));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_broadcast_ss(&planes[p].z), z));
+			distance = _mm256_add_ps(distance, _mm256_broadcast_ss(&planes[p].w));
+
+			__m256 radius = _mm256_mul_ps(_mm256_broadcast_ss(&absPlanes[p].x), ex);
+			radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_broadcast_ss(&absPlanes[p].y), ey));
+			radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_broadcast_ss(&absPlanes[p].z), ez));
+
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_xor_ps(radius, sign), _CMP_GE_OQ));
+		}
+
+		n = CullAppend(visible, n, base + i, _mm256_movemask_ps(inside), 8);
+	}
+
+	const float *tc[3] = { center[0] + i, center[1] + i, center[2] + i };
+	const float *te[3] = { extent[0] + i, extent[1] + i, extent[2] + i };
+	return n + CullBoxesScalar(visible + n, tc, te, planes, base + i, count - i);
+}
+
+// 6 x 16 tile, 12 accumulators + 2 B registers + 1 broadcast fill the 16 ymm
+__attribute__((target("avx")))
+static void GemmKernelAVX(size_t k, const float *a, const float *b, float *c, size_t ldc)
+{
+	__m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+	__m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+	__m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+	__m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+	__m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+	__m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+	for (size_t p = 0; p < k; ++p, a += 6, b += 16)
+	{
+		__m256 b0 = _mm256_loadu_ps(b);
+		__m256 b1 = _mm256_loadu_ps(b + 8);
+		__m256 ai;
+
+		ai = _mm256_broadcast_ss(a);
+		c00 = _mm256_add_ps(c00, _mm256_mul_ps(ai, b0));
+		c01 = _mm256_add_ps(c01, _mm256_mul_ps(ai, b1));
+
+		ai = _mm256_broadcast_ss(a + 1);
+		c10 = _mm256_add_ps(c10, _mm256_mul_ps(ai, b0));
+		c11 = _mm256_add_ps(c11, _mm256_mul_ps(ai, b1));
+
+		ai = _mm256_broadcast_ss(a + 2);
+		c20 = _mm256_add_ps(c20, _mm256_mul_ps(ai, b0));
+		c21 = _mm256_add_ps(c21, _mm256_mul_ps(ai, b1));
+
+		ai = _mm256_broadcast_ss(a + 3);
+		c30 = _mm256_add_ps(c30, _mm256_mul_ps(ai, b0));
+		c31 = _mm256_add_ps(c31, _mm256_mul_ps(ai, b1));
+
+		ai = _mm256_broadcast_ss(a + 4);
+		c40 = _mm256_add_ps(c40, _mm256_mul_ps(ai, b0));
+		c41 = _mm256_add_ps(c41, _mm256_mul_ps(ai, b1));
+
+		ai = _mm256_broadcast_ss(a + 5);
+		c50 = _mm256_add_ps(c50, _mm256_mul_ps(ai, b0));
+		c51 = _mm256_add_ps(c51, _mm256_mul_ps(ai, b1));
+	}
+
+	_mm256_storeu_ps(c, _mm256_add_ps(_mm256_loadu_ps(c), c00));
+	_mm256_storeu_ps(c + 8, _mm256_add_ps(_mm256_loadu_ps(c + 8), c01));
+	_mm256_storeu_ps(c + ldc, _mm256_add_ps(_mm256_loadu_ps(c + ldc), c10));
+	_mm256_storeu_ps(c + ldc + 8, _mm256_add_ps(_mm256_loadu_ps(c + ldc + 8), c11));
+	_mm256_storeu_ps(c + 2*ldc, _mm256_add_ps(_mm256_loadu_ps(c + 2*ldc), c20));
+	_mm256_storeu_ps(c + 2*ldc + 8, _mm256_add_ps(_mm256_loadu_ps(c + 2*ldc + 8), c21));
+	_mm256_storeu_ps(c + 3*ldc, _mm256_add_ps(_mm256_loadu_ps(c + 3*ldc), c30));
+	_mm256_storeu_ps(c + 3*ldc + 8, _mm256_add_ps(_mm256_loadu_ps(c + 3*ldc + 8), c31));
+	_mm256_storeu_ps(c + 4*ldc, _mm256_add_ps(_mm256_loadu_ps(c + 4*ldc), c40));
+	_mm256_storeu_ps(c + 4*ldc + 8, _mm256_add_ps(_mm256_loadu_ps(c + 4*ldc + 8), c41));
+	_mm256_storeu_ps(c + 5*ldc, _mm256_add_ps(_mm256_loadu_ps(c + 5*ldc), c50));
+	_mm256_storeu_ps(c + 5*ldc + 8, _mm256_add_ps(_mm256_loadu_ps(c + 5*ldc + 8), c51));
+}
+
+__attribute__((target("avx,fma")))
+static void GemmKernelFMA(size_t k, const float *a, const float *b, float *c, size_t ldc)
+{
+	__m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+	__m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+	__m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+	__m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+	__m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+	__m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+	for (size_t p = 0; p < k; ++p, a += 6, b += 16)
+	{
+		__m256 b0 = _mm256_loadu_ps(b);
+		__m256 b1 = _mm256_loadu_ps(b + 8);
+		__m256 ai;
+
+		ai = _mm256_broadcast_ss(a);
+		c00 = _mm256_fmadd_ps(ai, b0, c00);
+		c01 = _mm256_fmadd_ps(ai, b1, c01);
+
+		ai = _mm256_broadcast_ss(a + 1);
+		c10 = _mm256_fmadd_ps(ai, b0, c10);
+		c11 = _mm256_fmadd_ps(ai, b1, c11);
+
+		ai = _mm256_broadcast_ss(a + 2);
+		c20 = _mm256_fmadd_ps(ai, b0, c20);
+		c21 = _mm256_fmadd_ps(ai, b1, c21);
+
+		ai = _mm256_broadcast_ss(a + 3);
+		c30 = _mm256_fmadd_ps(ai, b0, c30);
+		c31 = _mm256_fmadd_ps(ai, b1, c31);
+
+		ai = _mm256_broadcast_ss(a + 4);
+		c40 = _mm256_fmadd_ps(ai, b0, c40);
+		c41 = _mm256_fmadd_ps(ai, b1, c41);
+
+		ai = _mm256_broadcast_ss(a + 5);
+		c50 = _mm256_fmadd_ps(ai, b0, c50);
+		c51 = _mm256_fmadd_ps(ai, b1, c51);
+	}
+
+	_mm256_storeu_ps(c, _mm256_add_ps(_mm256_loadu_ps(c), c00));
+	_mm256_storeu_ps(c + 8, _mm256_add_ps(_mm256_loadu_ps(c + 8), c01));
+	_mm256_storeu_ps(c + ldc, _mm256_add_ps(_mm256_loadu_ps(c + ldc), c10));
+	_mm256_storeu_ps(c + ldc + 8, _mm256_add_ps(_mm256_loadu_ps(c + ldc + 8), c11));
+	_mm256_storeu_ps(c + 2*ldc, _mm256_add_ps(_mm256_loadu_ps(c + 2*ldc), c20));
+	_mm256_storeu_ps(c + 2*ldc + 8, _mm256_add_ps(_mm256_loadu_ps(c + 2*ldc + 8), c21));
+	_mm256_storeu_ps(c + 3*ldc, _mm256_add_ps(_mm256_loadu_ps(c + 3*ldc), c30));
+	_mm256_storeu_ps(c + 3*ldc + 8, _mm256_add_ps(_mm256_loadu_ps(c + 3*ldc + 8), c31));
+	_mm256_storeu_ps(c + 4*ldc, _mm256_add_ps(_mm256_loadu_ps(c + 4*ldc), c40));
+	_mm256_storeu_ps(c + 4*ldc + 8, _mm256_add_ps(_mm256_loadu_ps(c + 4*ldc + 8), c41));
+	_mm256_storeu_ps(c + 5*ldc, _mm256_add_ps(_mm256_loadu_ps(c + 5*ldc), c50));
+	_mm256_storeu_ps(c + 5*ldc + 8, _mm256_add_ps(_mm256_loadu_ps(c + 5*ldc + 8), c51));
+}
+
+#endif // CMATH_HAS_AVX
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	NEON
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+#if defined(CMATH_HAS_NEON)
+
+// vmulq + vaddq (not vfmaq) so results stay identical to the scalar path
+static void Mat4x4MultiplyNEON(Mat4x4 *result, const Mat4x4 *m1, const Mat4x4 *m2)
+{
+	const float *a = (const float *)m1;
+	const float *b = (const float *)m2;
+	float *r = (float *)result;
+
+	float32x4_t a0 = vld1q_f32(a + 0);
+	float32x4_t a1 = vld1q_f32(a + 4);
+	float32x4_t a2 = vld1q_f32(a + 8);
+	float32x4_t a3 = vld1q_f32(a + 12);
+
+	float32x4_t row[4] = { vld1q_f32(b + 0), vld1q_f32(b + 4), vld1q_f32(b + 8), vld1q_f32(b + 12) };
+
+	for (int i = 0; i < 4; ++i)
+	{
+		float32x2_t lo = vget_low_f32(row[i]);
+		float32x2_t hi = vget_high_f32(row[i]);
+
+		float32x4_t acc = vmulq_lane_f32(a0, lo, 0);
+		acc = vaddq_f32(acc, vmulq_lane_f32(a1, lo, 1));
+		acc = vaddq_f32(acc, vmulq_lane_f32(a2, hi, 0));
+		acc = vaddq_f32(acc, vmulq_lane_f32(a3, hi, 1));
+
+		vst1q_f32(r + i*4, acc);
+	}
+}
+
+// same order as the scalar path, see Mat3x4MultiplySSE2
+static void Mat3x4MultiplyNEON(Mat3x4 *result, const Mat3x4 *m1, const Mat3x4 *m2)
+{
+	const float *a = (const float *)m1;
+	const float *b = (const float *)m2;
+	float *r = (float *)result;
+
+	float32x4_t a0 = vld1q_f32(a + 0);
+	float32x4_t a1 = vld1q_f32(a + 4);
+	float32x4_t a2 = vld1q_f32(a + 8);
+
+	float32x4_t rows[3] = { vld1q_f32(b + 0), vld1q_f32(b + 4), vld1q_f32(b + 8) };
+
+	for (int i = 0; i < 3; ++i)
+	{
+		float32x4_t bi = rows[i];
+		float32x4_t t = vsetq_lane_f32(vgetq_lane_f32(bi, 3), vdupq_n_f32(-0.0f), 3);
+
+		float32x4_t row = vmulq_n_f32(a0, vgetq_lane_f32(bi, 0));
+		row = vaddq_f32(row, vmulq_n_f32(a1, vgetq_lane_f32(bi, 1)));
+		row = vaddq_f32(row, vmulq_n_f32(a2, vgetq_lane_f32(bi, 2)));
+		row = vaddq_f32(row, t);
+
+		vst1q_f32(r + 4*i, row);
+	}
+}
+
+static void Vec3TransformNEON(Vec3 *result, const Vec3 *v, const Mat4x4 *m)
+{
+	// de-interleaving load hands back the columns { m0, m1, m2, m3 }, ...
+	float32x4x4_t c = vld4q_f32((const float *)m);
+
+	float32x4_t acc = vmulq_n_f32(c.val[0], v->x);
+	acc = vaddq_f32(acc, vmulq_n_f32(c.val[1], v->y));
+	acc = vaddq_f32(acc, vmulq_n_f32(c.val[2], v->z));
+	acc = vaddq_f32(acc, c.val[3]);
+
+	vst1_f32(&result->x, vget_low_f32(acc));
+	result->z = vgetq_lane_f32(acc, 2);
+}
+
+// vld3q splits x, y and z for us, no shuffling needed
+static void Vec3TransformNEONBatch(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count, float w)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		float32x4x3_t in = vld3q_f32(&v[i].x);
+		float32x4x3_t out;
+
+		out.val[0] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(in.val[0], m->m0), vmulq_n_f32(in.val[1], m->m4)), vmulq_n_f32(in.val[2], m->m8)), vdupq_n_f32(m->m12*w));
+		out.val[1] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(in.val[0], m->m1), vmulq_n_f32(in.val[1], m->m5)), vmulq_n_f32(in.val[2], m->m9)), vdupq_n_f32(m->m13*w));
+		out.val[2] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(in.val[0], m->m2), vmulq_n_f32(in.val[1], m->m6)), vmulq_n_f32(in.val[2], m->m10)), vdupq_n_f32(m->m14*w));
+
+		vst3q_f32(&result[i].x, out);
+	}
+
+	if (w != 0.0f) Vec3TransformPointsScalar(result + i, v + i, m, count - i);
+	else Vec3TransformDirectionsScalar(result + i, v + i, m, count - i);
+}
+
+static void Vec3TransformPointsNEON(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	Vec3TransformNEONBatch(result, v, m, count, 1.0f);
+}
+
+static void Vec3TransformDirectionsNEON(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count)
+{
+	Vec3TransformNEONBatch(result, v, m, count, 0.0f);
+}
+
+// 4 x 8 tile
+static void GemmKernelNEON(size_t k, const float *a, const float *b, float *c, size_t ldc)
+{
+	float32x4_t c00 = vdupq_n_f32(0.0f), c01 = vdupq_n_f32(0.0f);
+	float32x4_t c10 = vdupq_n_f32(0.0f), c11 = vdupq_n_f32(0.0f);
+	float32x4_t c20 = vdupq_n_f32(0.0f), c21 = vdupq_n_f32(0.0f);
+	float32x4_t c30 = vdupq_n_f32(0.0f), c31 = vdupq_n_f32(0.0f);
+
+	for (size_t p = 0; p < k; ++p, a += 4, b += 8)
+	{
+		float32x4_t b0 = vld1q_f32(b);
+		float32x4_t b1 = vld1q_f32(b + 4);
+		float32x4_t ai;
+
+		ai = vdupq_n_f32(a[0]);
+		c00 = vaddq_f32(c00, vmulq_f32(ai, b0));
+		c01 = vaddq_f32(c01, vmulq_f32(ai, b1));
+
+		ai = vdupq_n_f32(a[1]);
+		c10 = vaddq_f32(c10, vmulq_f32(ai, b0));
+		c11 = vaddq_f32(c11, vmulq_f32(ai, b1));
+
+		ai = vdupq_n_f32(a[2]);
+		c20 = vaddq_f32(c20, vmulq_f32(ai, b0));
+		c21 = vaddq_f32(c21, vmulq_f32(ai, b1));
+
+		ai = vdupq_n_f32(a[3]);
+		c30 = vaddq_f32(c30, vmulq_f32(ai, b0));
+		c31 = vaddq_f32(c31, vmulq_f32(ai, b1));
+	}
+
+	vst1q_f32(c, vaddq_f32(vld1q_f32(c), c00));
+	vst1q_f32(c + 4, vaddq_f32(vld1q_f32(c + 4), c01));
+	vst1q_f32(c + ldc, vaddq_f32(vld1q_f32(c + ldc), c10));
+	vst1q_f32(c + ldc + 4, vaddq_f32(vld1q_f32(c + ldc + 4), c11));
+	vst1q_f32(c + 2*ldc, vaddq_f32(vld1q_f32(c + 2*ldc), c20));
+	vst1q_f32(c + 2*ldc + 4, vaddq_f32(vld1q_f32(c + 2*ldc + 4), c21));
+	vst1q_f32(c + 3*ldc, vaddq_f32(vld1q_f32(c + 3*ldc), c30));
+	vst1q_f32(c + 3*ldc + 4, vaddq_f32(vld1q_f32(c + 3*ldc + 4), c31));
+}
+
+#endif // CMATH_HAS_NEON
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Aligned memory
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// over-allocate and keep the malloc pointer right in front of the block,
+// works the same on every platform (no posix_memalign on mingw)
+void *CMathAlignedAlloc(size_t size, size_t alignment)
+{
+	if (alignment < sizeof(void *)) alignment = sizeof(void *);
+
+	unsigned char *raw = malloc(size + alignment + sizeof(void *));
+	if (raw == NULL) return NULL;
+
+	uintptr_t aligned = ((uintptr_t)(raw + sizeof(void *)) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	((void **)aligned)[-1] = raw;
+
+	return (void *)aligned;
+}
+
+void CMathAlignedFree(void *ptr)
+{
+	if (ptr) free(((void **)ptr)[-1]);
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Dispatch
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+#define CMATH_SCALAR_KERNELS { \
+	.backend = CMATH_BACKEND_SCALAR, \
+	.Mat4x4Multiply = Mat4x4MultiplyScalarKernel, \
+	.Mat3x4Multiply = Mat3x4MultiplyScalarKernel, \
+	.Mat4x4Invert = Mat4x4InvertScalarKernel, \
+	.Vec3Transform = Vec3TransformScalarKernel, \
+	.QuaternionToMatrix = QuaternionToMatrixScalarKernel, \
+	.Vec3TransformPoints = Vec3TransformPointsScalar, \
+	.Vec3TransformDirections = Vec3TransformDirectionsScalar, \
+	.Vec4TransformArray = Vec4TransformArrayScalar, \
+	.Vec3TransformPointsEach = Vec3TransformPointsEachScalar, \
+	.Vec4TransformEach = Vec4TransformEachScalar, \
+	.StreamAdd = StreamAddScalar, \
+	.StreamScale = StreamScaleScalar, \
+	.StreamLerp = StreamLerpScalar, \
+	.StreamDot = StreamDotScalar, \
+	.StreamLength = StreamLengthScalar, \
+	.StreamNormalize = StreamNormalizeScalar, \
+	.StreamCross = StreamCrossScalar, \
+	.StreamNlerp = StreamNlerpScalar, \
+	.StreamSlerp = StreamSlerpScalar, \
+	.StreamQuaternionToMatrix = StreamQuaternionToMatrixScalar, \
+	.CullSpheres = CullSpheresScalar, \
+	.CullBoxes = CullBoxesScalar, \
+	.GemmKernel = GemmKernelScalar, \
+	.gemmRows = 4, \
+	.gemmCols = 4 \
+}
+
+CMathKernels cmathKernels = CMATH_SCALAR_KERNELS;
+
+static int CMathBackendSupported(CMathBackend backend)
+{
+	switch (backend)
+	{
+		case CMATH_BACKEND_SCALAR:
+			return 1;
+
+#if defined(CMATH_HAS_SSE2)
+		case CMATH_BACKEND_SSE2:
+			return 1;
+#endif
+
+#if defined(CMATH_HAS_AVX)
+		case CMATH_BACKEND_AVX:
+			return __builtin_cpu_supports("avx");
+
+		case CMATH_BACKEND_FMA:
+			return __builtin_cpu_supports("avx") && __builtin_cpu_supports("fma");
+#endif
+
+#if defined(CMATH_HAS_NEON)
+		case CMATH_BACKEND_NEON:
+			return 1;
+#endif
+
+		default:
+			return 0;
+	}
+}
+
+CMathBackend CMathGetBackend(void)
+{
+	return cmathKernels.backend;
+}
+
+int CMathSetBackend(CMathBackend backend)
+{
+	if (!CMathBackendSupported(backend)) return 0;
+
+	CMathKernels kernels = CMATH_SCALAR_KERNELS;
+
+	kernels.backend = backend;
+
+	switch (backend)
+	{
+#if defined(CMATH_HAS_SSE2)
+		case CMATH_BACKEND_SSE2:
+			kernels.Mat4x4Multiply = Mat4x4MultiplySSE2;
+			kernels.Mat3x4Multiply = Mat3x4MultiplySSE2;
+			kernels.Mat4x4Invert = Mat4x4InvertSSE2;
+			kernels.Vec3Transform = Vec3TransformSSE2;
+			kernels.QuaternionToMatrix = QuaternionToMatrixSSE2;
+			kernels.Vec3TransformPoints = Vec3TransformPointsSSE2;
+			kernels.Vec3TransformDirections = Vec3TransformDirectionsSSE2;
+			kernels.Vec4TransformArray = Vec4TransformArraySSE2;
+			kernels.Vec3TransformPointsEach = Vec3TransformPointsEachSSE2;
+			kernels.Vec4TransformEach = Vec4TransformEachSSE2;
+			kernels.StreamAdd = StreamAddSSE2;
+			kernels.StreamScale = StreamScaleSSE2;
+			kernels.StreamLerp = StreamLerpSSE2;
+			kernels.StreamDot = StreamDotSSE2;
+			kernels.StreamLength = StreamLengthSSE2;
+			kernels.StreamNormalize = StreamNormalizeSSE2;
+			kernels.StreamCross = StreamCrossSSE2;
+			kernels.StreamNlerp = StreamNlerpSSE2;
+			kernels.StreamSlerp = StreamSlerpSSE2;
+			kernels.StreamQuaternionToMatrix = StreamQuaternionToMatrixSSE2;
+			kernels.CullSpheres = CullSpheresSSE2;
+			kernels.CullBoxes = CullBoxesSSE2;
+			kernels.GemmKernel = GemmKernelSSE2;
+			kernels.gemmRows = 4;
+			kernels.gemmCols = 8;
+			break;
+#endif
+
+#if defined(CMATH_HAS_AVX)
+		case CMATH_BACKEND_AVX:
+			kernels.Mat4x4Multiply = Mat4x4MultiplyAVX;
+			kernels.Mat3x4Multiply = Mat3x4MultiplySSE2;
+			kernels.Mat4x4Invert = Mat4x4InvertSSE2;
+			kernels.Vec3Transform = Vec3TransformSSE2;
+			kernels.QuaternionToMatrix = QuaternionToMatrixSSE2;
+			kernels.Vec3TransformPoints = Vec3TransformPointsAVX;
+			kernels.Vec3TransformDirections = Vec3TransformDirectionsAVX;
+			kernels.Vec4TransformArray = Vec4TransformArraySSE2;
+			kernels.Vec3TransformPointsEach = Vec3TransformPointsEachSSE2;
+			kernels.Vec4TransformEach = Vec4TransformEachSSE2;
+			kernels.StreamAdd = StreamAddAVX;
+			kernels.StreamScale = StreamScaleAVX;
+			kernels.StreamLerp = StreamLerpAVX;
+			kernels.StreamDot = StreamDotAVX;
+			kernels.StreamLength = StreamLengthAVX;
+			kernels.StreamNormalize = StreamNormalizeAVX;
+			kernels.StreamCross = StreamCrossAVX;
+			kernels.StreamNlerp = StreamNlerpAVX;
+			kernels.StreamSlerp = StreamSlerpAVX;
+			kernels.StreamQuaternionToMatrix = StreamQuaternionToMatrixSSE2;
+			kernels.CullSpheres = CullSpheresAVX;
+			kernels.CullBoxes = CullBoxesAVX;
+			kernels.GemmKernel = GemmKernelAVX;
+			kernels.gemmRows = 6;
+			kernels.gemmCols = 16;
+			break;
+
+		case CMATH_BACKEND_FMA:
+			kernels.Mat4x4Multiply = Mat4x4MultiplyFMA;
+			kernels.Mat3x4Multiply = Mat3x4MultiplyFMA;
+			kernels.Mat4x4Invert = Mat4x4InvertSSE2;
+			kernels.Vec3Transform = Vec3TransformFMA;
+			kernels.QuaternionToMatrix = QuaternionToMatrixSSE2;
+			kernels.Vec3TransformPoints = Vec3TransformPointsFMA;
+			kernels.Vec3TransformDirections = Vec3TransformDirectionsFMA;
+			kernels.Vec4TransformArray = Vec4TransformArrayFMA;
+			kernels.Vec3TransformPointsEach = Vec3TransformPointsEachSSE2;
+			kernels.Vec4TransformEach = Vec4TransformEachSSE2;
+			kernels.StreamAdd = StreamAddAVX;
+			kernels.StreamScale = StreamScaleAVX;
+			kernels.StreamLerp = StreamLerpAVX;
+			kernels.StreamDot = StreamDotAVX;
+			kernels.StreamLength = StreamLengthAVX;
+			kernels.StreamNormalize = StreamNormalizeAVX;
+			kernels.StreamCross = StreamCrossAVX;
+			kernels.StreamNlerp = StreamNlerpAVX;
+			kernels.StreamSlerp = StreamSlerpAVX;
+			kernels.StreamQuaternionToMatrix = StreamQuaternionToMatrixSSE2;
+			kernels.CullSpheres = CullSpheresAVX;
+			kernels.CullBoxes = CullBoxesAVX;
+			kernels.GemmKernel = GemmKernelFMA;
+			kernels.gemmRows = 6;
+			kernels.gemmCols = 16;
+			break;
+#endif
+
+#if defined(CMATH_HAS_NEON)
+		// NOTE: invert and quaternion stay scalar on NEON, the scalar code
+		// already compiles to straight-line vector-friendly arithmetic there.
+		case CMATH_BACKEND_NEON:
+			kernels.Mat4x4Multiply = Mat4x4MultiplyNEON;
+			kernels.Mat3x4Multiply = Mat3x4MultiplyNEON;
+			kernels.Vec3Transform = Vec3TransformNEON;
+			kernels.Vec3TransformPoints = Vec3TransformPointsNEON;
+			kernels.Vec3TransformDirections = Vec3TransformDirectionsNEON;
+			kernels.GemmKernel = GemmKernelNEON;
+			kernels.gemmRows = 4;
+			kernels.gemmCols = 8;
+			break;
+#endif
+
+		default:
+			break;
+	}
+
+	cmathKernels = kernels;
+
+	return 1;
+}
+
+const char *CMathBackendName(CMathBackend backend)
+{
+	switch (backend)
+	{
+		case CMATH_BACKEND_SCALAR: return "scalar";
+		case CMATH_BACKEND_SSE2: return "sse2";
+		case CMATH_BACKEND_AVX: return "avx";
+		case CMATH_BACKEND_FMA: return "avx+fma";
+		case CMATH_BACKEND_NEON: return "neon";
+		default: return "unknown";
+	}
+}
+
+// pick the best backend once, before main() runs
+__attribute__((constructor))
+static void CMathInitBackend(void)
+{
+#if defined(CMATH_HAS_AVX)
+	// constructors may run before libgcc has probed the cpu
+	__builtin_cpu_init();
+#endif
+
+	const CMathBackend preferred[] = {
+		CMATH_BACKEND_FMA,
+		CMATH_BACKEND_AVX,
+		CMATH_BACKEND_NEON,
+		CMATH_BACKEND_SSE2
+	};
+
+	for (size_t i = 0; i < sizeof(preferred) / sizeof(preferred[0]); ++i)
+		if (CMathSetBackend(preferred[i])) return;
+}
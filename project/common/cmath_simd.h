@@ -0,0 +1,61 @@
+#ifndef __CMATH_SIMD_H__
+#define __CMATH_SIMD_H__
+
+#include "cmath.h"
+
+// largest GEMM tile of any backend, the driver sizes its buffers with these
+#define CMATH_GEMM_MAX_ROWS 6
+#define CMATH_GEMM_MAX_COLS 16
+
+// CMATH_HAS_SSE2, CMATH_HAS_AVX and CMATH_HAS_NEON come from cmath.h
+
+// Table of kernels behind the cmath entry points. It starts out scalar and is
+// upgraded once at startup to the best backend the running CPU supports.
+typedef struct CMathKernels {
+	CMathBackend backend;
+
+	void (*Mat4x4Multiply)(Mat4x4 *result, const Mat4x4 *m1, const Mat4x4 *m2);
+	void (*Mat3x4Multiply)(Mat3x4 *result, const Mat3x4 *m1, const Mat3x4 *m2);
+	void (*Mat4x4Invert)(Mat4x4 *result, const Mat4x4 *m);
+	void (*Vec3Transform)(Vec3 *result, const Vec3 *v, const Mat4x4 *m);
+	void (*QuaternionToMatrix)(Mat4x4 *result, const Quaternion *q);
+
+	// batch transform
+	void (*Vec3TransformPoints)(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count);
+	void (*Vec3TransformDirections)(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count);
+	void (*Vec4TransformArray)(Vec4 *result, const Vec4 *v, const Mat4x4 *m, size_t count);
+	void (*Vec3TransformPointsEach)(Vec3 *result, const Vec3 *v, const Mat4x4 *m, size_t count);
+	void (*Vec4TransformEach)(Vec4 *result, const Vec4 *v, const Mat4x4 *m, size_t count);
+
+	// float streams for the SoA containers, components is 3 or 4
+	void (*StreamAdd)(float *result, const float *a, const float *b, size_t count);
+	void (*StreamScale)(float *result, const float *a, float f, size_t count);
+	void (*StreamLerp)(float *result, const float *a, const float *b, float amount, size_t count);
+	void (*StreamDot)(float *result, const float *const *a, const float *const *b, int components, size_t count);
+	void (*StreamLength)(float *result, const float *const *v, int components, size_t count);
+	void (*StreamNormalize)(float *const *result, const float *const *v, int components, size_t count);
+	void (*StreamCross)(float *const *result, const float *const *a, const float *const *b, size_t count);
+
+	// quaternion streams (4 components), amountStride is 0 for one shared
+	// amount or 1 for one amount per element
+	void (*StreamNlerp)(float *const *result, const float *const *a, const float *const *b, const float *amount, size_t amountStride, size_t count);
+	void (*StreamSlerp)(float *const *result, const float *const *a, const float *const *b, const float *amount, size_t amountStride, size_t count);
+	void (*StreamQuaternionToMatrix)(Mat4x4 *result, const float *const *q, size_t count);
+
+	// frustum culling against 6 planes, writes base + i for every visible
+	// element i and returns how many there were
+	size_t (*CullSpheres)(unsigned int *visible, const float *const *sphere, const Vec4 *planes, size_t base, size_t count);
+	size_t (*CullBoxes)(unsigned int *visible, const float *const *center, const float *const *extent, const Vec4 *planes, size_t base, size_t count);
+
+	// GEMM micro-kernel, adds a packed gemmRows x gemmCols tile into c
+	void (*GemmKernel)(size_t k, const float *a, const float *b, float *c, size_t ldc);
+	int gemmRows;
+	int gemmCols;
+} CMathKernels;
+
+extern CMathKernels cmathKernels;
+
+// see CMathSetParallelThreshold
+extern size_t cmathParallelThreshold;
+
+#endif // __CMATH_SIMD_H__
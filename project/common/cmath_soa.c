@@ -0,0 +1,476 @@
+#include <string.h>
+#include <stdio.h>
+
+#include "cmath_soa.h"
+#include "cmath_simd.h"
+#include "Job.h"
+
+// streams start on a cache line and are padded to a whole number of lines
+#define SOA_ALIGNMENT 64
+#define SOA_PAD (SOA_ALIGNMENT / sizeof(float))
+
+// smallest slice handed to a worker thread
+#define SOA_MIN_CHUNK 8192
+
+static size_t SoAStride(size_t capacity)
+{
+	return (capacity + SOA_PAD - 1) & ~(size_t)(SOA_PAD - 1);
+}
+
+// move the streams into one block big enough for count elements, the first
+// stream owns the block. The old block is left for the caller to free.
+static int SoAGrow(float **streams, int components, size_t keep, size_t *capacity, size_t count)
+{
+	size_t newCapacity = *capacity*2 > count ? *capacity*2 : count;
+	size_t stride = SoAStride(newCapacity);
+
+	float *block = CMathAlignedAlloc(stride*components*sizeof(float), SOA_ALIGNMENT);
+	if (block == NULL)
+	{
+		fprintf(stderr, "[ERROR]: Failed to allocate SoA stream of %zu elements.\n", newCapacity);
+		return 0;
+	}
+
+	for (int c = 0; c < components; ++c)
+	{
+		if (keep) memcpy(block + stride*c, streams[c], keep*sizeof(float));
+		streams[c] = block + stride*c;
+	}
+
+	*capacity = newCapacity;
+	return 1;
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Parallel dispatch
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+typedef enum {
+	SOA_ADD,
+	SOA_SCALE,
+	SOA_LERP,
+	SOA_DOT,
+	SOA_LENGTH,
+	SOA_NORMALIZE,
+	SOA_CROSS,
+	SOA_NLERP,
+	SOA_SLERP,
+	SOA_TO_MATRIX
+} SoAOp;
+
+typedef struct SoAJob {
+	SoAOp op;
+	int components;
+	float *result[4];
+	const float *a[4];
+	const float *b[4];
+	float *out;
+	float f;
+
+	// quaternion ops: amount has amountStride 0 (shared) or 1 (per element)
+	const float *amount;
+	size_t amountStride;
+	Mat4x4 *matrices;
+} SoAJob;
+
+static void SoARange(void *userData, size_t begin, size_t end)
+{
+	SoAJob *job = userData;
+	size_t count = end - begin;
+
+	float *r[4] = { 0 };
+	const float *a[4] = { 0 };
+	const float *b[4] = { 0 };
+
+	for (int c = 0; c < job->components; ++c)
+	{
+		if (job->result[c]) r[c] = job->result[c] + begin;
+		if (job->a[c]) a[c] = job->a[c] + begin;
+		if (job->b[c]) b[c] = job->b[c] + begin;
+	}
+
+	switch (job->op)
+	{
+		case SOA_ADD:
+			for (int c = 0; c < job->components; ++c) cmathKernels.StreamAdd(r[c], a[c], b[c], count);
+			break;
+
+		case SOA_SCALE:
+			for (int c = 0; c < job->components; ++c) cmathKernels.StreamScale(r[c], a[c], job->f, count);
+			break;
+
+		case SOA_LERP:
+			for (int c = 0; c < job->components; ++c) cmathKernels.StreamLerp(r[c], a[c], b[c], job->f, count);
+			break;
+
+		case SOA_DOT:
+			cmathKernels.StreamDot(job->out + begin, a, b, job->components, count);
+			break;
+
+		case SOA_LENGTH:
+			cmathKernels.StreamLength(job->out + begin, a, job->components, count);
+			break;
+
+		case SOA_NORMALIZE:
+			cmathKernels.StreamNormalize(r, a, job->components, count);
+			break;
+
+		case SOA_CROSS:
+			cmathKernels.StreamCross(r, a, b, count);
+			break;
+
+		case SOA_NLERP:
+			cmathKernels.StreamNlerp(r, a, b, job->amount + begin*job->amountStride, job->amountStride, count);
+			break;
+
+		case SOA_SLERP:
+			cmathKernels.StreamSlerp(r, a, b, job->amount + begin*job->amountStride, job->amountStride, count);
+			break;
+
+		case SOA_TO_MATRIX:
+			cmathKernels.StreamQuaternionToMatrix(job->matrices + begin, a, count);
+			break;
+	}
+}
+
+static void SoARun(SoAJob *job, size_t count)
+{
+	if (cmathParallelThreshold && count >= cmathParallelThreshold)
+		JobParallelFor(count, SOA_MIN_CHUNK, SoARange, job);
+	else
+		SoARange(job, 0, count);
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Vec3SoA
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+Vec3SoA Vec3SoAAlloc(size_t capacity)
+{
+	Vec3SoA soa = { 0 };
+
+	if (capacity) Vec3SoAResize(&soa, capacity);
+	soa.count = 0;
+
+	return soa;
+}
+
+void Vec3SoAFree(Vec3SoA *soa)
+{
+	CMathAlignedFree(soa->x);
+	*soa = (Vec3SoA) { 0 };
+}
+
+bool Vec3SoAResize(Vec3SoA *soa, size_t count)
+{
+	if (count > soa->capacity)
+	{
+		float *old = soa->x;
+		float *streams[3] = { soa->x, soa->y, soa->z };
+
+		if (!SoAGrow(streams, 3, soa->count, &soa->capacity, count)) return false;
+
+		CMathAlignedFree(old);
+		soa->x = streams[0];
+		soa->y = streams[1];
+		soa->z = streams[2];
+	}
+
+	soa->count = count;
+	return true;
+}
+
+bool Vec3SoAFromArray(Vec3SoA *soa, const Vec3 *v, size_t count)
+{
+	// a failed grow keeps the old, smaller storage
+	if (!Vec3SoAResize(soa, count))
+		return false;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		soa->x[i] = v[i].x;
+		soa->y[i] = v[i].y;
+		soa->z[i] = v[i].z;
+	}
+
+	return true;
+}
+
+void Vec3SoAToArray(const Vec3SoA *soa, Vec3 *v)
+{
+	for (size_t i = 0; i < soa->count; ++i)
+		v[i] = (Vec3) { soa->x[i], soa->y[i], soa->z[i] };
+}
+
+Vec3 Vec3SoAGet(const Vec3SoA *soa, size_t i)
+{
+	return (Vec3) { soa->x[i], soa->y[i], soa->z[i] };
+}
+
+void Vec3SoASet(Vec3SoA *soa, size_t i, Vec3 v)
+{
+	soa->x[i] = v.x;
+	soa->y[i] = v.y;
+	soa->z[i] = v.z;
+}
+
+static void Vec3SoARun(SoAOp op, Vec3SoA *result, float *out, const Vec3SoA *v1, const Vec3SoA *v2, float f)
+{
+	size_t count = v1->count;
+
+	if (result && !Vec3SoAResize(result, count))
+		return;
+
+	SoAJob job = { op, 3, { 0 }, { v1->x, v1->y, v1->z }, { 0 }, out, f };
+
+	if (result)
+	{
+		job.result[0] = result->x;
+		job.result[1] = result->y;
+		job.result[2] = result->z;
+	}
+
+	if (v2)
+	{
+		job.b[0] = v2->x;
+		job.b[1] = v2->y;
+		job.b[2] = v2->z;
+	}
+
+	SoARun(&job, count);
+}
+
+void Vec3SoAAdd(Vec3SoA *result, const Vec3SoA *v1, const Vec3SoA *v2)
+{
+	Vec3SoARun(SOA_ADD, result, NULL, v1, v2, 0.0f);
+}
+
+void Vec3SoAScale(Vec3SoA *result, const Vec3SoA *v, float f)
+{
+	Vec3SoARun(SOA_SCALE, result, NULL, v, NULL, f);
+}
+
+void Vec3SoADotProduct(float *result, const Vec3SoA *v1, const Vec3SoA *v2)
+{
+	Vec3SoARun(SOA_DOT, NULL, result, v1, v2, 0.0f);
+}
+
+void Vec3SoACrossProduct(Vec3SoA *result, const Vec3SoA *v1, const Vec3SoA *v2)
+{
+	Vec3SoARun(SOA_CROSS, result, NULL, v1, v2, 0.0f);
+}
+
+void Vec3SoANormalize(Vec3SoA *result, const Vec3SoA *v)
+{
+	Vec3SoARun(SOA_NORMALIZE, result, NULL, v, NULL, 0.0f);
+}
+
+void Vec3SoALerp(Vec3SoA *result, const Vec3SoA *v1, const Vec3SoA *v2, float amount)
+{
+	Vec3SoARun(SOA_LERP, result, NULL, v1, v2, amount);
+}
+
+void Vec3SoALength(float *result, const Vec3SoA *v)
+{
+	Vec3SoARun(SOA_LENGTH, NULL, result, v, NULL, 0.0f);
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Vec4SoA
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+Vec4SoA Vec4SoAAlloc(size_t capacity)
+{
+	Vec4SoA soa = { 0 };
+
+	if (capacity) Vec4SoAResize(&soa, capacity);
+	soa.count = 0;
+
+	return soa;
+}
+
+void Vec4SoAFree(Vec4SoA *soa)
+{
+	CMathAlignedFree(soa->x);
+	*soa = (Vec4SoA) { 0 };
+}
+
+bool Vec4SoAResize(Vec4SoA *soa, size_t count)
+{
+	if (count > soa->capacity)
+	{
+		float *old = soa->x;
+		float *streams[4] = { soa->x, soa->y, soa->z, soa->w };
+
+		if (!SoAGrow(streams, 4, soa->count, &soa->capacity, count)) return false;
+
+		CMathAlignedFree(old);
+		soa->x = streams[0];
+		soa->y = streams[1];
+		soa->z = streams[2];
+		soa->w = streams[3];
+	}
+
+	soa->count = count;
+	return true;
+}
+
+bool Vec4SoAFromArray(Vec4SoA *soa, const Vec4 *v, size_t count)
+{
+	// a failed grow keeps the old, smaller storage
+	if (!Vec4SoAResize(soa, count))
+		return false;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		soa->x[i] = v[i].x;
+		soa->y[i] = v[i].y;
+		soa->z[i] = v[i].z;
+		soa->w[i] = v[i].w;
+	}
+
+	return true;
+}
+
+void Vec4SoAToArray(const Vec4SoA *soa, Vec4 *v)
+{
+	for (size_t i = 0; i < soa->count; ++i)
+		v[i] = (Vec4) { soa->x[i], soa->y[i], soa->z[i], soa->w[i] };
+}
+
+Vec4 Vec4SoAGet(const Vec4SoA *soa, size_t i)
+{
+	return (Vec4) { soa->x[i], soa->y[i], soa->z[i], soa->w[i] };
+}
+
+void Vec4SoASet(Vec4SoA *soa, size_t i, Vec4 v)
+{
+	soa->x[i] = v.x;
+	soa->y[i] = v.y;
+	soa->z[i] = v.z;
+	soa->w[i] = v.w;
+}
+
+static void Vec4SoARun(SoAOp op, Vec4SoA *result, float *out, const Vec4SoA *v1, const Vec4SoA *v2, float f)
+{
+	size_t count = v1->count;
+
+	if (result && !Vec4SoAResize(result, count))
+		return;
+
+	SoAJob job = { op, 4, { 0 }, { v1->x, v1->y, v1->z, v1->w }, { 0 }, out, f };
+
+	if (result)
+	{
+		job.result[0] = result->x;
+		job.result[1] = result->y;
+		job.result[2] = result->z;
+		job.result[3] = result->w;
+	}
+
+	if (v2)
+	{
+		job.b[0] = v2->x;
+		job.b[1] = v2->y;
+		job.b[2] = v2->z;
+		job.b[3] = v2->w;
+	}
+
+	SoARun(&job, count);
+}
+
+void Vec4SoAAdd(Vec4SoA *result, const Vec4SoA *v1, const Vec4SoA *v2)
+{
+	Vec4SoARun(SOA_ADD, result, NULL, v1, v2, 0.0f);
+}
+
+void Vec4SoAScale(Vec4SoA *result, const Vec4SoA *v, float f)
+{
+	Vec4SoARun(SOA_SCALE, result, NULL, v, NULL, f);
+}
+
+void Vec4SoADotProduct(float *result, const Vec4SoA *v1, const Vec4SoA *v2)
+{
+	Vec4SoARun(SOA_DOT, NULL, result, v1, v2, 0.0f);
+}
+
+void Vec4SoANormalize(Vec4SoA *result, const Vec4SoA *v)
+{
+	Vec4SoARun(SOA_NORMALIZE, result, NULL, v, NULL, 0.0f);
+}
+
+void Vec4SoALerp(Vec4SoA *result, const Vec4SoA *v1, const Vec4SoA *v2, float amount)
+{
+	Vec4SoARun(SOA_LERP, result, NULL, v1, v2, amount);
+}
+
+void Vec4SoALength(float *result, const Vec4SoA *v)
+{
+	Vec4SoARun(SOA_LENGTH, NULL, result, v, NULL, 0.0f);
+}
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	QuaternionSoA
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+static void QuaternionSoARun(SoAOp op, QuaternionSoA *result, const QuaternionSoA *q1, const QuaternionSoA *q2, const float *amount, size_t amountStride)
+{
+	size_t count = q1->count;
+
+	if (!Vec4SoAResize(result, count))
+		return;
+
+	SoAJob job = {
+		op, 4,
+		{ result->x, result->y, result->z, result->w },
+		{ q1->x, q1->y, q1->z, q1->w },
+		{ q2->x, q2->y, q2->z, q2->w },
+		NULL, 0.0f,
+		amount, amountStride, NULL
+	};
+
+	SoARun(&job, count);
+}
+
+void QuaternionSoANlerp(QuaternionSoA *result, const QuaternionSoA *q1, const QuaternionSoA *q2, float amount)
+{
+	QuaternionSoARun(SOA_NLERP, result, q1, q2, &amount, 0);
+}
+
+void QuaternionSoANlerpEach(QuaternionSoA *result, const QuaternionSoA *q1, const QuaternionSoA *q2, const float *amount)
+{
+	QuaternionSoARun(SOA_NLERP, result, q1, q2, amount, 1);
+}
+
+void QuaternionSoASlerp(QuaternionSoA *result, const QuaternionSoA *q1, const QuaternionSoA *q2, float amount)
+{
+	QuaternionSoARun(SOA_SLERP, result, q1, q2, &amount, 0);
+}
+
+void QuaternionSoASlerpEach(QuaternionSoA *result, const QuaternionSoA *q1, const QuaternionSoA *q2, const float *amount)
+{
+	QuaternionSoARun(SOA_SLERP, result, q1, q2, amount, 1);
+}
+
+void QuaternionSoAToMatrix(Mat4x4 *result, const QuaternionSoA *q)
+{
+	SoAJob job = { SOA_TO_MATRIX, 4, { 0 }, { q->x, q->y, q->z, q->w }, { 0 }, NULL, 0.0f, NULL, 0, result };
+
+	SoARun(&job, q->count);
+}
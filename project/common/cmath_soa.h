@@ -0,0 +1,172 @@
+#ifndef __CMATH_SOA_H__
+#define __CMATH_SOA_H__
+
+#include <stdbool.h>
+
+#include "cmath.h"
+
+/*
+	Structure-of-arrays vector streams.
+
+	Every component lives in its own 64-byte aligned array, so the kernels can
+	work 4 (SSE2) or 8 (AVX) elements per instruction. They go through the
+	same kernel table as the Mat4x4 family and give bit-identical results to
+	the matching scalar cmath function on every backend.
+
+	result may be one of the inputs, it is grown to the input count if needed.
+
+	Quaternions use the Vec4SoA layout (x, y, z, w streams). Their nlerp and
+	slerp always take the short way round: q2 is negated where the dot
+	product with q1 is negative, with a per lane select instead of a branch.
+*/
+
+typedef struct Vec3SoA {
+	float *x;
+	float *y;
+	float *z;
+	size_t count;
+	size_t capacity;
+} Vec3SoA;
+
+typedef struct Vec4SoA {
+	float *x;
+	float *y;
+	float *z;
+	float *w;
+	size_t count;
+	size_t capacity;
+} Vec4SoA;
+
+typedef Vec4SoA QuaternionSoA;
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Vec3SoA
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// allocate a stream with room for capacity elements, count starts at 0
+Vec3SoA Vec3SoAAlloc(size_t capacity);
+
+// release the stream memory
+void Vec3SoAFree(Vec3SoA *soa);
+
+// set count, growing the storage if needed (existing elements are kept).
+// false when the storage cannot grow, count and capacity are left as they were
+bool Vec3SoAResize(Vec3SoA *soa, size_t count);
+
+// copy an array of Vec3 into the stream, false when it does not fit
+bool Vec3SoAFromArray(Vec3SoA *soa, const Vec3 *v, size_t count);
+
+// copy the stream out into an array of soa->count Vec3
+void Vec3SoAToArray(const Vec3SoA *soa, Vec3 *v);
+
+// element i as Vec3
+Vec3 Vec3SoAGet(const Vec3SoA *soa, size_t i);
+
+// store a Vec3 in element i
+void Vec3SoASet(Vec3SoA *soa, size_t i, Vec3 v);
+
+// element wise addition, v1 and v2 must have the same count
+void Vec3SoAAdd(Vec3SoA *result, const Vec3SoA *v1, const Vec3SoA *v2);
+
+// multiply every element by f
+void Vec3SoAScale(Vec3SoA *result, const Vec3SoA *v, float f);
+
+// element wise dot product into result[v1->count]
+void Vec3SoADotProduct(float *result, const Vec3SoA *v1, const Vec3SoA *v2);
+
+// element wise cross product
+void Vec3SoACrossProduct(Vec3SoA *result, const Vec3SoA *v1, const Vec3SoA *v2);
+
+// normalize every element, zero length elements are left as they are
+void Vec3SoANormalize(Vec3SoA *result, const Vec3SoA *v);
+
+// element wise linear interpolation by amount
+void Vec3SoALerp(Vec3SoA *result, const Vec3SoA *v1, const Vec3SoA *v2, float amount);
+
+// length of every element into result[v->count]
+void Vec3SoALength(float *result, const Vec3SoA *v);
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	Vec4SoA
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// allocate a stream with room for capacity elements, count starts at 0
+Vec4SoA Vec4SoAAlloc(size_t capacity);
+
+// release the stream memory
+void Vec4SoAFree(Vec4SoA *soa);
+
+// set count, growing the storage if needed (existing elements are kept).
+// false when the storage cannot grow, count and capacity are left as they were
+bool Vec4SoAResize(Vec4SoA *soa, size_t count);
+
+// copy an array of Vec4 into the stream, false when it does not fit
+bool Vec4SoAFromArray(Vec4SoA *soa, const Vec4 *v, size_t count);
+
+// copy the stream out into an array of soa->count Vec4
+void Vec4SoAToArray(const Vec4SoA *soa, Vec4 *v);
+
+// element i as Vec4
+Vec4 Vec4SoAGet(const Vec4SoA *soa, size_t i);
+
+// store a Vec4 in element i
+void Vec4SoASet(Vec4SoA *soa, size_t i, Vec4 v);
+
+// element wise addition, v1 and v2 must have the same count
+void Vec4SoAAdd(Vec4SoA *result, const Vec4SoA *v1, const Vec4SoA *v2);
+
+// multiply every element by f
+void Vec4SoAScale(Vec4SoA *result, const Vec4SoA *v, float f);
+
+// element wise dot product into result[v1->count]
+void Vec4SoADotProduct(float *result, const Vec4SoA *v1, const Vec4SoA *v2);
+
+// normalize every element, zero length elements become zero
+void Vec4SoANormalize(Vec4SoA *result, const Vec4SoA *v);
+
+// element wise linear interpolation by amount
+void Vec4SoALerp(Vec4SoA *result, const Vec4SoA *v1, const Vec4SoA *v2, float amount);
+
+// length of every element into result[v->count]
+void Vec4SoALength(float *result, const Vec4SoA *v);
+
+/*
+	/////////////////////////////////////////////////////////
+	///
+	///	QuaternionSoA
+	///
+	///	Use the Vec4SoA functions to allocate and fill.
+	///
+	///	Nlerp is bit-identical to QuaternionNlerp on the flipped
+	///	pair. Slerp follows QuaternionSlerp (q1 at cos >= 1, nlerp
+	///	above 0.95) with polynomial acos/sin, every backend gives
+	///	the same bits and stays within 3.0e-7 of QuaternionSlerp.
+	///
+	/////////////////////////////////////////////////////////
+*/
+
+// element wise nlerp by one shared amount, q1 and q2 must have the same count
+void QuaternionSoANlerp(QuaternionSoA *result, const QuaternionSoA *q1, const QuaternionSoA *q2, float amount);
+
+// element wise nlerp, element i blends by amount[i]
+void QuaternionSoANlerpEach(QuaternionSoA *result, const QuaternionSoA *q1, const QuaternionSoA *q2, const float *amount);
+
+// element wise slerp by one shared amount, q1 and q2 must have the same count
+void QuaternionSoASlerp(QuaternionSoA *result, const QuaternionSoA *q1, const QuaternionSoA *q2, float amount);
+
+// element wise slerp, element i blends by amount[i]
+void QuaternionSoASlerpEach(QuaternionSoA *result, const QuaternionSoA *q1, const QuaternionSoA *q2, const float *amount);
+
+// rotation matrix of every element into result[q->count], bit-identical to
+// QuaternionToMatrixScalar
+void QuaternionSoAToMatrix(Mat4x4 *result, const QuaternionSoA *q);
+
+#endif // __CMATH_SOA_H__